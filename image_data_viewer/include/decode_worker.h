@@ -0,0 +1,386 @@
+/**
+ * @file decode_worker.h
+ * @brief Image Data Decode Worker Interface.
+ *
+ * A worker drains the image data message queue of one stream, skips ahead to
+ * the newest decodable frame when it falls behind, and hands decoded frames to
+ * the GUI thread through a lock-free latest-value triple buffer.
+ *
+ * A worker either runs on its own thread, or, for many streams, is scheduled
+ * on a shared thread pool whenever messages are pushed to it.
+ *
+ */
+
+
+
+
+#ifndef DECODE_WORKER_H
+#define	DECODE_WORKER_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+#include "polysync_video.h"
+#include "image_queue.h"
+
+
+
+
+/**
+ * @brief Number of decoded frame slots in the triple buffer.
+ *
+ */
+#define     DECODE_WORKER_FRAME_SLOTS       (3)
+
+
+/**
+ * @brief Flag set in \ref decode_worker_s.ready when it holds a frame the GUI thread has not taken.
+ *
+ */
+#define     DECODE_WORKER_FRAME_DIRTY       (0x4)
+
+
+/**
+ * @brief Mask of the slot index in \ref decode_worker_s.ready.
+ *
+ */
+#define     DECODE_WORKER_FRAME_INDEX_MASK  (0x3)
+
+
+/**
+ * @brief Longest the worker waits for a message before checking for exit. [microseconds]
+ *
+ */
+#define     DECODE_WORKER_IDLE_WAIT         (100000ULL)
+
+
+/**
+ * @brief Default number of decode pool threads, see \ref decode_worker_pool_new.
+ *
+ */
+#define     DECODE_WORKER_DEFAULT_POOL_THREADS  (2)
+
+
+/**
+ * @brief Weight of the newest sample in the filtered decode statistics.
+ *
+ */
+#define     DECODE_WORKER_STATS_FILTER      (0.1)
+
+
+
+
+/**
+ * @brief Decoded frame.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned char           *buffer; /*!< Frame data in the decoder output pixel format. */
+    //
+    //
+    unsigned long           size; /*!< Number of valid bytes in buffer. [bytes] */
+    //
+    //
+    ps_timestamp            rx_time; /*!< Receive timestamp of the message the frame was decoded from. [microseconds] */
+    //
+    //
+    ps_timestamp            decoded_time; /*!< Decode completion timestamp. [microseconds] */
+} decoded_frame_s;
+
+
+/**
+ * @brief Decode statistics.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long long      decoded_frames; /*!< Number of frames decoded. */
+    //
+    //
+    unsigned long long      dropped_frames; /*!< Number of messages skipped without decoding. */
+    //
+    //
+    unsigned long long      rate_limited_frames; /*!< Number of H264 frames decoded to keep the reference chain but not shown because of the frame-rate limit. */
+    //
+    //
+    unsigned long           queue_depth; /*!< Messages left in the queue after the worker's last pass. */
+    //
+    //
+    unsigned long long      queue_dropped; /*!< Number of messages discarded by the drop policy of the worker's own queue. */
+    //
+    //
+    double                  decode_time; /*!< Filtered time spent decoding a frame. [milliseconds] */
+    //
+    //
+    double                  latency; /*!< Filtered time from receive to decoded frame. [milliseconds] */
+} decode_stats_s;
+
+
+/**
+ * @brief Decode worker thread pool.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GThreadPool             *pool; /*!< Thread pool running worker passes. */
+    //
+    //
+    GMutex                  lock; /*!< Serializes scheduling with \ref decode_worker_pool_free. */
+    //
+    //
+    unsigned int            quit; /*!< Non-zero once no more passes are scheduled. */
+} decode_worker_pool_s;
+
+
+/**
+ * @brief Decode worker.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GThread                 *thread; /*!< Worker thread, NULL if scheduled on a thread pool. */
+    //
+    //
+    decode_worker_pool_s    *pool; /*!< Thread pool the worker is scheduled on, NULL if it has its own thread. */
+    //
+    //
+    volatile gint           quit; /*!< Non-zero requests the worker thread to exit. */
+    //
+    //
+    ps_node_ref             node_ref; /*!< Node reference used to free messages. */
+    //
+    //
+    image_queue_s           *msg_queue; /*!< Message queue, only popped by the worker while running. */
+    //
+    //
+    unsigned int            owns_queue; /*!< Non-zero if msg_queue was created by and is freed with the worker. */
+    //
+    //
+    volatile gint           scheduled; /*!< Non-zero while a thread pool pass of the worker is queued or running. */
+    //
+    //
+    ps_guid                 publisher_guid; /*!< Publisher GUID to decode, other publishers are discarded. */
+    //
+    //
+    ps_pixel_format_kind    publisher_format; /*!< Publisher pixel format. */
+    //
+    //
+    ps_video_decoder        decoder; /*!< Video decoder, only used by the worker while running. */
+    //
+    //
+    GPtrArray               *batch; /*!< Messages drained in one pass, oldest first. */
+    //
+    //
+    unsigned long           frame_size; /*!< Size of a decoded frame. [bytes] */
+    //
+    //
+    ps_timestamp            min_interval; /*!< Shortest time between shown frames, zero if not limited. [microseconds] */
+    //
+    //
+    ps_timestamp            last_accepted_time; /*!< Receive timestamp of the last frame let through the frame-rate limit. [microseconds] */
+    //
+    //
+    unsigned int            resync; /*!< Non-zero while H264 messages are discarded up to the next keyframe, after a message was dropped. */
+    //
+    //
+    decoded_frame_s         frames[ DECODE_WORKER_FRAME_SLOTS ]; /*!< Decoded frame slots. */
+    //
+    //
+    unsigned char           *frame_storage[ DECODE_WORKER_FRAME_SLOTS ]; /*!< Frame buffers allocated by the worker, slots may hold buffers of the GUI instead. */
+    //
+    //
+    volatile gint           ready; /*!< Ready slot index, ORed with \ref DECODE_WORKER_FRAME_DIRTY when newly published. */
+    //
+    //
+    unsigned int            write; /*!< Slot the worker decodes into. */
+    //
+    //
+    unsigned int            read; /*!< Slot the GUI thread uploads from. */
+    //
+    //
+    unsigned int            read_valid; /*!< Non-zero once the read slot holds a published frame. */
+    //
+    //
+    GMutex                  stats_lock; /*!< Protects stats. */
+    //
+    //
+    decode_stats_s          stats; /*!< Decode statistics. */
+} decode_worker_s;
+
+
+
+
+/**
+ * @brief Start a decode worker.
+ *
+ * Initializes the decoder and spawns the worker thread, which from then on is
+ * the only consumer of the message queue.
+ *
+ * @param [in] node_ref Node reference used to free messages.
+ * @param [in] msg_queue A pointer to \ref image_queue_s which specifies the message queue.
+ * @param [in] publisher_guid Publisher GUID to decode.
+ * @param [in] publisher_format Publisher pixel format, H264 or MJPEG.
+ * @param [in] width Image width. [pixels]
+ * @param [in] height Image height. [pixels]
+ * @param [in] decoder_format Decoder output pixel format.
+ * @param [in] frame_size Size of a decoded frame. [bytes]
+ * @param [in] max_fps Frame-rate limit, zero for none. [Hz]
+ *
+ * @return A newly created worker on success, NULL on failure.
+ *
+ */
+decode_worker_s *decode_worker_start(
+        ps_node_ref node_ref,
+        image_queue_s * const msg_queue,
+        const ps_guid publisher_guid,
+        const ps_pixel_format_kind publisher_format,
+        const unsigned long width,
+        const unsigned long height,
+        const ps_pixel_format_kind decoder_format,
+        const unsigned long frame_size,
+        const double max_fps );
+
+
+/**
+ * @brief Create a decode worker scheduled on a thread pool.
+ *
+ * Initializes the decoder and a bounded message queue of its own, messages are
+ * given to the worker with \ref decode_worker_push. Each pass drains the queue once,
+ * so streams take turns on the pool threads.
+ *
+ * MJPEG frames inside the frame-rate limit are dropped without decoding. H264
+ * frames are always decoded to keep the reference chain intact, only showing them is limited.
+ * After a queue drop, H264 frames are discarded without decoding up to the next keyframe.
+ *
+ * @param [in] pool A pointer to \ref decode_worker_pool_s which specifies the thread pool.
+ * @param [in] node_ref Node reference used to free messages.
+ * @param [in] publisher_guid Publisher GUID to decode.
+ * @param [in] publisher_format Publisher pixel format, H264 or MJPEG.
+ * @param [in] width Image width. [pixels]
+ * @param [in] height Image height. [pixels]
+ * @param [in] decoder_format Decoder output pixel format.
+ * @param [in] frame_size Size of a decoded frame. [bytes]
+ * @param [in] max_fps Frame-rate limit, zero for none. [Hz]
+ * @param [in] queue_capacity Message queue capacity. [messages]
+ * @param [in] queue_policy Message queue drop policy.
+ *
+ * @return A newly created worker on success, NULL on failure.
+ *
+ */
+decode_worker_s *decode_worker_new(
+        decode_worker_pool_s * const pool,
+        ps_node_ref node_ref,
+        const ps_guid publisher_guid,
+        const ps_pixel_format_kind publisher_format,
+        const unsigned long width,
+        const unsigned long height,
+        const ps_pixel_format_kind decoder_format,
+        const unsigned long frame_size,
+        const double max_fps,
+        const unsigned long queue_capacity,
+        const image_queue_policy_kind queue_policy );
+
+
+/**
+ * @brief Push a message to a worker created with \ref decode_worker_new and schedule a pass.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [in] queued A pointer to \ref queued_image_s which specifies the message, owned by the worker afterwards.
+ *
+ */
+void decode_worker_push( decode_worker_s * const worker, queued_image_s * const queued );
+
+
+/**
+ * @brief Create a thread pool for decode workers.
+ *
+ * A worker runs on at most one pool thread at a time, so the thread count
+ * caps the CPU spent decoding across all streams.
+ *
+ * @param [in] max_threads Number of pool threads.
+ *
+ * @return A newly created thread pool on success, NULL on failure.
+ *
+ */
+decode_worker_pool_s *decode_worker_pool_new( const unsigned int max_threads );
+
+
+/**
+ * @brief Free a decode worker thread pool.
+ *
+ * Stops scheduling passes and waits for running ones. Must be called before
+ * stopping the workers scheduled on it, messages not yet decoded stay in their queues.
+ *
+ * @param [in] pool A pointer to \ref decode_worker_pool_s which specifies the thread pool to free. NULL is acceptable.
+ *
+ */
+void decode_worker_pool_free( decode_worker_pool_s * const pool );
+
+
+/**
+ * @brief Stop a decode worker.
+ *
+ * Joins the worker thread, releases the decoder and frees the frames allocated by the worker.
+ * Frames returned by \ref decode_worker_acquire are invalid afterwards.
+ * Free the thread pool of workers created with \ref decode_worker_new first.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker to free. NULL is acceptable.
+ *
+ */
+void decode_worker_stop( decode_worker_s * const worker );
+
+
+/**
+ * @brief Acquire the latest decoded frame.
+ *
+ * GUI thread only. The returned frame stays valid until the next call.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [out] updated A pointer to unsigned int which receives one if a newer frame was taken, zero otherwise.
+ *
+ * @return A pointer to the latest frame, NULL if none has been decoded yet.
+ *
+ */
+const decoded_frame_s *decode_worker_acquire( decode_worker_s * const worker, unsigned int * const updated );
+
+
+/**
+ * @brief Swap the buffer of the frame last returned by \ref decode_worker_acquire.
+ *
+ * GUI thread only. Lets the GUI take the decoded frame buffer without copying it,
+ * the given buffer is decoded into once the slot is handed back to the worker.
+ * It must hold \ref decode_worker_s.frame_size bytes and stay valid until it is swapped
+ * out again or the worker is stopped. Buffers of the worker stay valid until it is stopped.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [in] buffer A pointer to unsigned char which specifies the new buffer of the frame.
+ *
+ * @return A pointer to the previous buffer, holding the frame, NULL if no frame has been acquired.
+ *
+ */
+unsigned char *decode_worker_exchange_buffer( decode_worker_s * const worker, unsigned char * const buffer );
+
+
+/**
+ * @brief Get decode statistics.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [out] stats A pointer to \ref decode_stats_s which receives the statistics.
+ *
+ */
+void decode_worker_get_stats( decode_worker_s * const worker, decode_stats_s * const stats );
+
+
+
+#endif	/* DECODE_WORKER_H */
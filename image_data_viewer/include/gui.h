@@ -13,6 +13,7 @@
 
 
 
+#include <glib-2.0/glib.h>
 #include "polysync_core.h"
 #include "gl_headers.h"
 
@@ -75,6 +76,57 @@
 #define         GUI_DEFAULT_MAX_FPS         (33)
 
 
+/**
+ * @brief Default mosaic window width. [pixels]
+ *
+ */
+#define         GUI_MOSAIC_DEFAULT_WIDTH    (1280)
+
+
+/**
+ * @brief Default mosaic window height. [pixels]
+ *
+ */
+#define         GUI_MOSAIC_DEFAULT_HEIGHT   (720)
+
+
+/**
+ * @brief Number of pixel buffer objects image data uploads rotate through.
+ *
+ */
+#define         GUI_IMAGE_PBO_COUNT         (3)
+
+
+/**
+ * @brief Number of pixel buffer objects an image lends to its decoder, one per decoded frame slot plus the one being uploaded.
+ *
+ */
+#define         GUI_IMAGE_LEND_COUNT        (4)
+
+
+/**
+ * @brief Pixel layout of image data given to the GUI, must match the decoder output format.
+ *
+ * Use GL_BGRA with 4 bytes per pixel for decoders that output 32-bit pixels.
+ *
+ */
+#define         GUI_IMAGE_FORMAT            (GL_RGB)
+
+
+/**
+ * @brief Bytes per pixel of \ref GUI_IMAGE_FORMAT.
+ *
+ */
+#define         GUI_IMAGE_BYTES_PER_PIXEL   (3)
+
+
+/**
+ * @brief Weight of the newest sample in \ref gui_image_s.upload_time.
+ *
+ */
+#define         GUI_UPLOAD_TIME_FILTER      (0.1)
+
+
 
 
 /**
@@ -103,6 +155,75 @@ typedef struct
 } gui_configuration_s;
 
 
+/**
+ * @brief GUI image data, one per stream.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_guid                     publisher_guid; /*!< Publisher GUID. */
+    //
+    //
+    unsigned long               width; /*!< Image data width. [pixels] */
+    //
+    //
+    unsigned long               height; /*!< Image data height. [pixels] */
+    //
+    //
+    GLuint                      texture; /*!< Image data texture. */
+    //
+    //
+    GLuint                      pbos[ GUI_IMAGE_PBO_COUNT ]; /*!< Pixel buffer objects the image data is uploaded from. */
+    //
+    //
+    unsigned int                pbo_index; /*!< Index of the last mapped pixel buffer object. */
+    //
+    //
+    unsigned long               pbo_size; /*!< Size of each pixel buffer object, one image. [bytes] */
+    //
+    //
+    unsigned int                pbo_mapped; /*!< Non-zero while a pixel buffer object is mapped. */
+    //
+    //
+    ps_timestamp                pbo_map_time; /*!< Time spent mapping the mapped pixel buffer object. [microseconds] */
+    //
+    //
+    GLuint                      lend_pbos[ GUI_IMAGE_LEND_COUNT ]; /*!< Pixel buffer objects lent mapped to the decoder. */
+    //
+    //
+    unsigned char               *lend_buffers[ GUI_IMAGE_LEND_COUNT ]; /*!< Mapping of each lent pixel buffer object, NULL while not lent. */
+    //
+    //
+    double                      upload_time; /*!< Filtered render thread time spent per image upload. [milliseconds] */
+    //
+    //
+    unsigned long               frame_cnt; /*!< Frame counter. */
+    //
+    //
+    double                      rx_fps; /*!< Received/decoded image FPS. */
+    //
+    //
+    ps_timestamp                last_rx_time; /*!< Last received/decoded frame timestamp. [microseconds] */
+    //
+    //
+    double                      decode_latency; /*!< Filtered time from receive to decoded frame. [milliseconds] */
+    //
+    //
+    unsigned long long          dropped_frames; /*!< Number of frames skipped without decoding. */
+    //
+    //
+    unsigned long long          rate_limited_frames; /*!< Number of H264 frames decoded but not shown because of the frame-rate limit. */
+    //
+    //
+    unsigned long               queue_depth; /*!< Number of messages waiting to be decoded. */
+    //
+    //
+    unsigned long long          queue_dropped; /*!< Number of messages discarded by the queue drop policy. */
+} gui_image_s;
+
+
 /**
  * @brief GUI context data.
  *
@@ -157,22 +278,7 @@ typedef struct
     gui_configuration_s         config; /*!< Configuration data. */
     //
     //
-    unsigned long               frame_cnt; /*!< Frame counter. */
-    //
-    //
-    double                      rx_fps; /*!< Received/decoded image FPS. */
-    //
-    //
-    ps_guid                     image_publisher_guid; /*!< Publisher GUID. */
-    //
-    //
-    unsigned long               image_width; /*!< Image data width. [pixels] */
-    //
-    //
-    unsigned long               image_height; /*!< Image data height. [pixels] */
-    //
-    //
-    GLuint                      image_texture; /*!< Image data texture. */
+    GPtrArray                   *images; /*!< Images (\ref gui_image_s) drawn as a mosaic of tiles, in order. */
 } gui_context_s;
 
 
@@ -202,8 +308,92 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
 void gui_release( gui_context_s * const gui );
 
 
-//
-void gui_update_image_data( gui_context_s * const gui, const unsigned char * buffer, const unsigned long buffer_len );
+/**
+ * @brief Add an image to the mosaic.
+ *
+ * Creates the image texture and pixel buffer objects. Images are tiled in a grid
+ * in the order they were added, a single image fills the window.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] publisher_guid Publisher GUID shown with the image.
+ * @param [in] width Image data width. [pixels]
+ * @param [in] height Image data height. [pixels]
+ *
+ * @return A pointer to the new image on success, NULL on failure.
+ *
+ */
+gui_image_s *gui_add_image( gui_context_s * const gui, const ps_guid publisher_guid, const unsigned long width, const unsigned long height );
+
+
+/**
+ * @brief Upload image data to an image texture.
+ *
+ * Copies the data into the next pixel buffer object, the texture is updated from there
+ * asynchronously. Prefer \ref gui_map_image_buffer to have the data written in place.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] buffer A pointer to unsigned char which specifies the image data in \ref GUI_IMAGE_FORMAT.
+ * @param [in] buffer_len Size of the image data. [bytes]
+ *
+ */
+void gui_update_image_data( gui_context_s * const gui, gui_image_s * const image, const unsigned char * buffer, const unsigned long buffer_len );
+
+
+/**
+ * @brief Map the next pixel buffer object of an image for writing image data in place.
+ *
+ * Must be followed by \ref gui_unmap_image_buffer before any other GUI call.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [out] buffer_size A pointer to unsigned long which receives the size of the mapped buffer. [bytes]
+ *
+ * @return A pointer to the mapped buffer on success, NULL on failure.
+ *
+ */
+unsigned char *gui_map_image_buffer( gui_context_s * const gui, gui_image_s * const image, unsigned long * const buffer_size );
+
+
+/**
+ * @brief Unmap the pixel buffer object mapped by \ref gui_map_image_buffer and upload it to the image texture.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] buffer_len Number of bytes written to the mapped buffer, nothing is uploaded unless it holds a full image. [bytes]
+ *
+ */
+void gui_unmap_image_buffer( gui_context_s * const gui, gui_image_s * const image, const unsigned long buffer_len );
+
+
+/**
+ * @brief Lend a mapped pixel buffer object of an image, for another thread to write a frame into.
+ *
+ * The buffer stays mapped, and valid, until it is handed back to
+ * \ref gui_return_image_buffer or the image is destroyed. Other GUI calls may be made meanwhile.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [out] buffer_size A pointer to unsigned long which receives the size of the buffer. [bytes]
+ *
+ * @return A pointer to the mapped buffer on success, NULL if all are lent or the map failed.
+ *
+ */
+unsigned char *gui_lend_image_buffer( gui_context_s * const gui, gui_image_s * const image, unsigned long * const buffer_size );
+
+
+/**
+ * @brief Hand back a buffer lent by \ref gui_lend_image_buffer and upload it to the image texture.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] buffer A pointer to unsigned char which specifies the buffer.
+ * @param [in] buffer_len Number of bytes written to the buffer, nothing is uploaded unless it holds a full image. [bytes]
+ *
+ * @return One if the buffer was lent by the image, zero otherwise, nothing is done then.
+ *
+ */
+unsigned int gui_return_image_buffer( gui_context_s * const gui, gui_image_s * const image, const unsigned char * const buffer, const unsigned long buffer_len );
 
 
 /**
@@ -0,0 +1,281 @@
+/**
+ * @file image_queue.h
+ * @brief Bounded Image Data Message Queue Interface.
+ *
+ * A fixed capacity queue of received image data messages. When full, a drop
+ * policy picks which message is discarded, and drops are counted per publisher.
+ *
+ */
+
+
+
+
+#ifndef IMAGE_QUEUE_H
+#define	IMAGE_QUEUE_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+#include "polysync_message.h"
+
+
+
+
+/**
+ * @brief Default queue capacity. [messages]
+ *
+ */
+#define     IMAGE_QUEUE_DEFAULT_CAPACITY    (8)
+
+
+
+
+/**
+ * @brief Drop policy applied when a message is pushed to a full queue.
+ *
+ */
+typedef enum
+{
+    //
+    //
+    IMAGE_QUEUE_DROP_OLDEST = 0, /*!< Discard the oldest queued message. */
+    //
+    //
+    IMAGE_QUEUE_DROP_NEWEST, /*!< Discard the pushed message. */
+    //
+    //
+    IMAGE_QUEUE_KEEP_KEYFRAMES, /*!< Discard pushed non-keyframes, pushed keyframes replace the oldest queued non-keyframe, or the oldest message if none. */
+    //
+    //
+    IMAGE_QUEUE_POLICY_COUNT /*!< Number of policies. */
+} image_queue_policy_kind;
+
+
+/**
+ * @brief Queued image data message.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_msg_ref              msg; /*!< Copy of the received "ps_image_data_msg". */
+    //
+    //
+    ps_timestamp            rx_time; /*!< Receive timestamp. [microseconds] */
+    //
+    //
+    unsigned int            keyframe; /*!< Non-zero if the image can be decoded on its own. */
+    //
+    //
+    unsigned int            discontinuity; /*!< Non-zero if an earlier message of the publisher was dropped, for H264 nothing up to the next keyframe can be decoded. */
+} queued_image_s;
+
+
+/**
+ * @brief Per-publisher queue statistics.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_guid                 publisher_guid; /*!< Publisher GUID. */
+    //
+    //
+    unsigned long long      pushed; /*!< Number of messages pushed, including dropped ones. */
+    //
+    //
+    unsigned long long      dropped; /*!< Number of messages discarded by the drop policy. */
+    //
+    //
+    unsigned int            discontinuity; /*!< Non-zero if a message was dropped with no later message queued to flag, the next pushed one is flagged. */
+} image_queue_stats_s;
+
+
+/**
+ * @brief Bounded image data message queue.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_node_ref             node_ref; /*!< Node reference used to free messages. */
+    //
+    //
+    image_queue_policy_kind policy; /*!< Drop policy. */
+    //
+    //
+    queued_image_s          **elements; /*!< Message ring. */
+    //
+    //
+    unsigned long           capacity; /*!< Ring capacity. [messages] */
+    //
+    //
+    unsigned long           head; /*!< Index of the oldest message. */
+    //
+    //
+    unsigned long           count; /*!< Number of queued messages. */
+    //
+    //
+    GHashTable              *stats; /*!< Statistics (\ref image_queue_stats_s) by publisher GUID. */
+    //
+    //
+    GMutex                  lock; /*!< Protects the ring and statistics. */
+    //
+    //
+    GCond                   cond; /*!< Signaled when a message is pushed. */
+} image_queue_s;
+
+
+
+
+/**
+ * @brief Check if an image data message can be decoded on its own.
+ *
+ * Every MJPEG image is a keyframe. H264 access units are scanned for an IDR slice
+ * or a sequence parameter set.
+ *
+ * @param [in] image_data_msg A pointer to ps_image_data_msg which specifies the message.
+ *
+ * @return One if a keyframe, zero otherwise.
+ *
+ */
+unsigned int image_queue_is_keyframe( const ps_image_data_msg * const image_data_msg );
+
+
+/**
+ * @brief Get a drop policy by name.
+ *
+ * @param [in] name Policy name, "oldest", "newest" or "keyframes".
+ * @param [out] policy A pointer to \ref image_queue_policy_kind which receives the policy.
+ *
+ * @return Zero on success, one if the name is unknown.
+ *
+ */
+int image_queue_get_policy_by_name( const char * const name, image_queue_policy_kind * const policy );
+
+
+/**
+ * @brief Get the name of a drop policy.
+ *
+ * @param [in] policy Drop policy.
+ *
+ * @return Policy name.
+ *
+ */
+const char *image_queue_get_policy_name( const image_queue_policy_kind policy );
+
+
+/**
+ * @brief Create a queue.
+ *
+ * @param [in] node_ref Node reference used to free messages.
+ * @param [in] capacity Queue capacity, at least one. [messages]
+ * @param [in] policy Drop policy.
+ *
+ * @return A newly created queue on success, NULL on failure.
+ *
+ */
+image_queue_s *image_queue_new( ps_node_ref node_ref, const unsigned long capacity, const image_queue_policy_kind policy );
+
+
+/**
+ * @brief Free a queue and the messages still in it.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue to free. NULL is acceptable.
+ *
+ */
+void image_queue_free( image_queue_s * const queue );
+
+
+/**
+ * @brief Check if the drop policy rejects a message before it is copied.
+ *
+ * Counts the drop if so. Lets the receive handler skip the message copy, the
+ * answer holds as long as the caller is the only producer.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] publisher_guid Publisher GUID of the message.
+ * @param [in] keyframe Non-zero if the message is a keyframe.
+ *
+ * @return One if the message would be discarded, zero otherwise.
+ *
+ */
+unsigned int image_queue_reject( image_queue_s * const queue, const ps_guid publisher_guid, const unsigned int keyframe );
+
+
+/**
+ * @brief Push a message, applying the drop policy if the queue is full.
+ *
+ * When a message is dropped, the next message of the same publisher is flagged
+ * with \ref queued_image_s.discontinuity so an H264 decoder can wait for a keyframe.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] queued A pointer to \ref queued_image_s which specifies the message, owned by the queue afterwards.
+ *
+ */
+void image_queue_push( image_queue_s * const queue, queued_image_s * const queued );
+
+
+/**
+ * @brief Pop the oldest message if any.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ *
+ * @return A pointer to the message, owned by the caller, NULL if the queue is empty.
+ *
+ */
+queued_image_s *image_queue_try_pop( image_queue_s * const queue );
+
+
+/**
+ * @brief Pop the oldest message, waiting for one up to a timeout.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] timeout Maximum time to wait. [microseconds]
+ *
+ * @return A pointer to the message, owned by the caller, NULL on timeout.
+ *
+ */
+queued_image_s *image_queue_timeout_pop( image_queue_s * const queue, const ps_timestamp timeout );
+
+
+/**
+ * @brief Get the number of queued messages.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ *
+ * @return Number of queued messages.
+ *
+ */
+unsigned long image_queue_length( image_queue_s * const queue );
+
+
+/**
+ * @brief Get the statistics of a publisher.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] publisher_guid Publisher GUID.
+ * @param [out] stats A pointer to \ref image_queue_stats_s which receives the statistics, zero if nothing was pushed by the publisher.
+ *
+ */
+void image_queue_get_stats( image_queue_s * const queue, const ps_guid publisher_guid, image_queue_stats_s * const stats );
+
+
+/**
+ * @brief Free a queued image data message.
+ *
+ * @param [in] node_ref Node reference used to free the message.
+ * @param [in] queued A pointer to \ref queued_image_s which specifies the queued message to free. NULL is acceptable.
+ *
+ */
+void image_queue_free_queued( ps_node_ref node_ref, queued_image_s * const queued );
+
+
+
+
+#endif	/* IMAGE_QUEUE_H */
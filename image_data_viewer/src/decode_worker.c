@@ -0,0 +1,866 @@
+/**
+ * @file decode_worker.c
+ * @brief Image Data Decode Worker Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <glib-2.0/glib.h>
+
+// API headers
+#include "polysync_core.h"
+#include "polysync_message.h"
+#include "polysync_video.h"
+
+#include "decode_worker.h"
+
+
+
+
+// *****************************************************
+// static global types/macros
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Publish the write slot as the ready slot.
+ *
+ * Worker thread only. Takes the previous ready slot as the new write slot.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ *
+ */
+static void frame_publish( decode_worker_s * const worker );
+
+
+/**
+ * @brief Check a message against the frame-rate limit.
+ *
+ * Messages let through become the start of the next interval.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [in] queued A pointer to \ref queued_image_s which specifies the message.
+ *
+ * @return One if the message falls inside the limit, zero otherwise.
+ *
+ */
+static unsigned int is_rate_limited( decode_worker_s * const worker, const queued_image_s * const queued );
+
+
+/**
+ * @brief Decode a message into the write slot and publish it.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [in] queued A pointer to \ref queued_image_s which specifies the message.
+ * @param [in] publish Non-zero to publish the frame, zero to only feed the decoder.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+static int decode_message( decode_worker_s * const worker, const queued_image_s * const queued, const unsigned int publish );
+
+
+/**
+ * @brief Decode one batch of messages.
+ *
+ * Drains the message queue, drops messages older than the newest frame
+ * (MJPEG) or the newest keyframe (H264), and decodes the rest in order.
+ * H264 messages following a queue drop are discarded up to the next keyframe,
+ * they reference a frame the decoder never saw.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ * @param [in] first A pointer to \ref queued_image_s which specifies the first message of the batch.
+ *
+ */
+static void decode_pass( decode_worker_s * const worker, queued_image_s * const first );
+
+
+/**
+ * @brief Worker thread entry.
+ *
+ * @param [in] user_data A pointer to \ref decode_worker_s.
+ *
+ * @return NULL.
+ *
+ */
+static gpointer worker_thread( gpointer user_data );
+
+
+/**
+ * @brief Thread pool task, runs one pass of a worker.
+ *
+ * @param [in] data A pointer to \ref decode_worker_s.
+ * @param [in] user_data A pointer to \ref decode_worker_pool_s.
+ *
+ */
+static void pool_task( gpointer data, gpointer user_data );
+
+
+/**
+ * @brief Schedule a pass of a worker on its thread pool, unless one is already queued or running.
+ *
+ * @param [in] worker A pointer to \ref decode_worker_s which specifies the worker.
+ *
+ */
+static void schedule_pass( decode_worker_s * const worker );
+
+
+/**
+ * @brief Create a decode worker without starting it.
+ *
+ * @param [in] node_ref Node reference used to free messages.
+ * @param [in] publisher_guid Publisher GUID to decode.
+ * @param [in] publisher_format Publisher pixel format, H264 or MJPEG.
+ * @param [in] width Image width. [pixels]
+ * @param [in] height Image height. [pixels]
+ * @param [in] decoder_format Decoder output pixel format.
+ * @param [in] frame_size Size of a decoded frame. [bytes]
+ * @param [in] max_fps Frame-rate limit, zero for none. [Hz]
+ *
+ * @return A newly created worker on success, NULL on failure.
+ *
+ */
+static decode_worker_s *worker_new(
+        ps_node_ref node_ref,
+        const ps_guid publisher_guid,
+        const ps_pixel_format_kind publisher_format,
+        const unsigned long width,
+        const unsigned long height,
+        const ps_pixel_format_kind decoder_format,
+        const unsigned long frame_size,
+        const double max_fps );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static void frame_publish( decode_worker_s * const worker )
+{
+    // local vars
+    gint old_ready = 0;
+    const gint new_ready = (gint) worker->write | DECODE_WORKER_FRAME_DIRTY;
+
+
+    // swap the write slot in as ready, dirty
+    do
+    {
+        old_ready = g_atomic_int_get( &worker->ready );
+    }
+    while( g_atomic_int_compare_and_exchange( &worker->ready, old_ready, new_ready ) == FALSE );
+
+    // previous ready slot is free to decode into, whether or not it was taken
+    worker->write = (unsigned int) (old_ready & DECODE_WORKER_FRAME_INDEX_MASK);
+}
+
+
+//
+static unsigned int is_rate_limited( decode_worker_s * const worker, const queued_image_s * const queued )
+{
+    if( worker->min_interval == 0 )
+    {
+        return 0;
+    }
+
+    // out of order receive times restart the interval
+    if( (worker->last_accepted_time != 0)
+            && (queued->rx_time >= worker->last_accepted_time)
+            && ((queued->rx_time - worker->last_accepted_time) < worker->min_interval) )
+    {
+        return 1;
+    }
+
+    worker->last_accepted_time = queued->rx_time;
+
+
+    return 0;
+}
+
+
+//
+static int decode_message( decode_worker_s * const worker, const queued_image_s * const queued, const unsigned int publish )
+{
+    // local vars
+    int ret = DTC_NONE;
+    const ps_image_data_msg * const image_data_msg = (const ps_image_data_msg*) queued->msg;
+    decoded_frame_s * const frame = &worker->frames[ worker->write ];
+    ps_timestamp start_time = 0;
+    ps_timestamp now = 0;
+
+
+    (void) psync_get_timestamp( &start_time );
+
+    // decode the data
+    ret = psync_video_decoder_decode(
+            &worker->decoder,
+            image_data_msg->timestamp,
+            image_data_msg->data_buffer._buffer,
+            image_data_msg->data_buffer._length );
+
+    // error check
+    if( ret != DTC_NONE )
+    {
+        psync_log_message(
+                LOG_LEVEL_ERROR,
+                "%s : (%u) -- psync_video_decoder_decode returned DTC %d",
+                __FILE__,
+                __LINE__,
+                ret );
+        return 1;
+    }
+
+    // reference frame only
+    if( publish == 0 )
+    {
+        return 0;
+    }
+
+    // copy the decoded bytes into the write slot,
+    // this is the raw frame is our desired pixel format
+    ret = psync_video_decoder_copy_bytes(
+            &worker->decoder,
+            frame->buffer,
+            worker->frame_size,
+            &frame->size );
+
+    // error check
+    if( ret != DTC_NONE )
+    {
+        psync_log_message(
+                LOG_LEVEL_ERROR,
+                "%s : (%u) -- psync_video_decoder_copy_bytes returned DTC %d",
+                __FILE__,
+                __LINE__,
+                ret );
+        return 1;
+    }
+
+    // decoder may not have a frame yet
+    if( frame->size == 0 )
+    {
+        return 0;
+    }
+
+    (void) psync_get_timestamp( &now );
+
+    frame->rx_time = queued->rx_time;
+    frame->decoded_time = now;
+
+    frame_publish( worker );
+
+    // update stats
+    g_mutex_lock( &worker->stats_lock );
+
+    if( worker->stats.decoded_frames == 0 )
+    {
+        worker->stats.decode_time = (double) (now - start_time) / 1000.0;
+        worker->stats.latency = (double) (now - queued->rx_time) / 1000.0;
+    }
+    else
+    {
+        worker->stats.decode_time += DECODE_WORKER_STATS_FILTER * (((double) (now - start_time) / 1000.0) - worker->stats.decode_time);
+        worker->stats.latency += DECODE_WORKER_STATS_FILTER * (((double) (now - queued->rx_time) / 1000.0) - worker->stats.latency);
+    }
+
+    worker->stats.decoded_frames += 1;
+
+    g_mutex_unlock( &worker->stats_lock );
+
+
+    return 0;
+}
+
+
+//
+static void decode_pass( decode_worker_s * const worker, queued_image_s * const first )
+{
+    // local vars
+    queued_image_s *queued = first;
+    const ps_image_data_msg *image_data_msg = NULL;
+    guint start = 0;
+    guint idx = 0;
+    unsigned int publish = 0;
+    unsigned long long dropped = 0;
+    unsigned long long rate_limited = 0;
+
+
+    // drain everything that is already waiting, keeping the stream we decode
+    g_ptr_array_set_size( worker->batch, 0 );
+    do
+    {
+        image_data_msg = (const ps_image_data_msg*) queued->msg;
+
+        if( (image_data_msg->header.src_guid == worker->publisher_guid)
+                && (image_data_msg->pixel_format == worker->publisher_format) )
+        {
+            g_ptr_array_add( worker->batch, queued );
+        }
+        else
+        {
+            image_queue_free_queued( worker->node_ref, queued );
+        }
+    }
+    while( (queued = image_queue_try_pop( worker->msg_queue )) != NULL );
+
+    // skip ahead, every MJPEG frame stands alone, H264 can only restart at a keyframe
+    start = 0;
+    if( worker->batch->len > 1 )
+    {
+        if( worker->publisher_format == PIXEL_FORMAT_H264 )
+        {
+            for( idx = worker->batch->len; idx > 1; idx-- )
+            {
+                queued = (queued_image_s*) g_ptr_array_index( worker->batch, idx - 1 );
+
+                if( queued->keyframe != 0 )
+                {
+                    start = idx - 1;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            start = worker->batch->len - 1;
+        }
+    }
+
+    dropped = 0;
+    for( idx = 0; idx < worker->batch->len; idx++ )
+    {
+        queued = (queued_image_s*) g_ptr_array_index( worker->batch, idx );
+
+        // a queue drop broke the reference chain, a keyframe restarts it
+        if( worker->publisher_format == PIXEL_FORMAT_H264 )
+        {
+            if( queued->keyframe != 0 )
+            {
+                worker->resync = 0;
+            }
+            else if( queued->discontinuity != 0 )
+            {
+                worker->resync = 1;
+            }
+        }
+
+        if( (idx < start) || (worker->resync != 0) || (g_atomic_int_get( &worker->quit ) != 0) )
+        {
+            dropped += 1;
+        }
+        else if( worker->publisher_format == PIXEL_FORMAT_H264 )
+        {
+            // every frame feeds the reference chain, only showing it is limited
+            publish = (is_rate_limited( worker, queued ) == 0) ? 1 : 0;
+
+            // decoded anyway, not a drop
+            if( publish == 0 )
+            {
+                rate_limited += 1;
+            }
+
+            if( decode_message( worker, queued, publish ) != 0 )
+            {
+                // decoder failure, exit like the single threaded example does
+                g_atomic_int_set( &worker->quit, 1 );
+                raise( SIGINT );
+            }
+        }
+        else if( is_rate_limited( worker, queued ) != 0 )
+        {
+            dropped += 1;
+        }
+        else if( decode_message( worker, queued, 1 ) != 0 )
+        {
+            // decoder failure, exit like the single threaded example does
+            g_atomic_int_set( &worker->quit, 1 );
+            raise( SIGINT );
+        }
+
+        image_queue_free_queued( worker->node_ref, queued );
+    }
+
+    // update stats
+    g_mutex_lock( &worker->stats_lock );
+    worker->stats.dropped_frames += dropped;
+    worker->stats.rate_limited_frames += rate_limited;
+    worker->stats.queue_depth = image_queue_length( worker->msg_queue );
+    g_mutex_unlock( &worker->stats_lock );
+}
+
+
+//
+static gpointer worker_thread( gpointer user_data )
+{
+    // local vars
+    decode_worker_s * const worker = (decode_worker_s*) user_data;
+    queued_image_s *queued = NULL;
+
+
+    while( g_atomic_int_get( &worker->quit ) == 0 )
+    {
+        // wait for a message
+        if( (queued = image_queue_timeout_pop( worker->msg_queue, DECODE_WORKER_IDLE_WAIT )) != NULL )
+        {
+            decode_pass( worker, queued );
+        }
+    }
+
+
+    return NULL;
+}
+
+
+//
+static void pool_task( gpointer data, gpointer user_data )
+{
+    // local vars
+    decode_worker_s * const worker = (decode_worker_s*) data;
+    queued_image_s *queued = NULL;
+
+
+    // one pass per task so busy streams take turns with the others
+    if( (queued = image_queue_try_pop( worker->msg_queue )) != NULL )
+    {
+        decode_pass( worker, queued );
+    }
+
+    g_atomic_int_set( &worker->scheduled, 0 );
+
+    // messages pushed during the pass found it still scheduled
+    if( image_queue_length( worker->msg_queue ) > 0 )
+    {
+        schedule_pass( worker );
+    }
+}
+
+
+//
+static void schedule_pass( decode_worker_s * const worker )
+{
+    // already queued or running
+    if( g_atomic_int_compare_and_exchange( &worker->scheduled, 0, 1 ) == FALSE )
+    {
+        return;
+    }
+
+    g_mutex_lock( &worker->pool->lock );
+
+    // left scheduled once the pool is shutting down, nothing runs it anymore
+    if( worker->pool->quit == 0 )
+    {
+        (void) g_thread_pool_push( worker->pool->pool, worker, NULL );
+    }
+
+    g_mutex_unlock( &worker->pool->lock );
+}
+
+
+//
+static decode_worker_s *worker_new(
+        ps_node_ref node_ref,
+        const ps_guid publisher_guid,
+        const ps_pixel_format_kind publisher_format,
+        const unsigned long width,
+        const unsigned long height,
+        const ps_pixel_format_kind decoder_format,
+        const unsigned long frame_size,
+        const double max_fps )
+{
+    // local vars
+    int ret = DTC_NONE;
+    unsigned int idx = 0;
+    decode_worker_s *worker = NULL;
+
+
+    // create
+    if( (worker = malloc( sizeof(*worker) )) == NULL )
+    {
+        return NULL;
+    }
+
+    // zero
+    memset( worker, 0, sizeof(*worker) );
+
+    worker->node_ref = node_ref;
+    worker->publisher_guid = publisher_guid;
+    worker->publisher_format = publisher_format;
+    worker->frame_size = frame_size;
+    worker->batch = g_ptr_array_new();
+
+    if( max_fps > 0.0 )
+    {
+        worker->min_interval = (ps_timestamp) (1000000.0 / max_fps);
+    }
+
+    g_mutex_init( &worker->stats_lock );
+
+    // frame slots, write 0, ready 1 (not dirty), read 2
+    worker->write = 0;
+    worker->ready = 1;
+    worker->read = 2;
+
+    for( idx = 0; idx < DECODE_WORKER_FRAME_SLOTS; idx++ )
+    {
+        if( (worker->frame_storage[ idx ] = malloc( frame_size )) == NULL )
+        {
+            psync_log_message(
+                    LOG_LEVEL_ERROR,
+                    "%s : (%u) -- failed to allocate decoder buffer - size %lu bytes",
+                    __FILE__,
+                    __LINE__,
+                    frame_size );
+            decode_worker_stop( worker );
+            return NULL;
+        }
+
+        worker->frames[ idx ].buffer = worker->frame_storage[ idx ];
+    }
+
+    // initialize decoder, frame-rate will be determined by stream if possible, otherwise use default
+    ret = psync_video_decoder_init(
+            &worker->decoder,
+            publisher_format,
+            width,
+            height,
+            decoder_format,
+            width,
+            height,
+            PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND );
+
+    // error check
+    if( ret != DTC_NONE )
+    {
+        psync_log_message(
+                LOG_LEVEL_ERROR,
+                "%s : (%u) -- psync_video_decoder_init returned DTC %d",
+                __FILE__,
+                __LINE__,
+                ret );
+        decode_worker_stop( worker );
+        return NULL;
+    }
+
+
+    return worker;
+}
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+decode_worker_s *decode_worker_start(
+        ps_node_ref node_ref,
+        image_queue_s * const msg_queue,
+        const ps_guid publisher_guid,
+        const ps_pixel_format_kind publisher_format,
+        const unsigned long width,
+        const unsigned long height,
+        const ps_pixel_format_kind decoder_format,
+        const unsigned long frame_size,
+        const double max_fps )
+{
+    if( (msg_queue == NULL) || (frame_size == 0) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    decode_worker_s *worker = NULL;
+
+
+    if( (worker = worker_new( node_ref, publisher_guid, publisher_format, width, height, decoder_format, frame_size, max_fps )) == NULL )
+    {
+        return NULL;
+    }
+
+    worker->msg_queue = msg_queue;
+
+    // start worker thread
+    if( (worker->thread = g_thread_try_new( "decode", worker_thread, worker, NULL )) == NULL )
+    {
+        decode_worker_stop( worker );
+        return NULL;
+    }
+
+
+    return worker;
+}
+
+
+//
+decode_worker_s *decode_worker_new(
+        decode_worker_pool_s * const pool,
+        ps_node_ref node_ref,
+        const ps_guid publisher_guid,
+        const ps_pixel_format_kind publisher_format,
+        const unsigned long width,
+        const unsigned long height,
+        const ps_pixel_format_kind decoder_format,
+        const unsigned long frame_size,
+        const double max_fps,
+        const unsigned long queue_capacity,
+        const image_queue_policy_kind queue_policy )
+{
+    if( (pool == NULL) || (frame_size == 0) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    decode_worker_s *worker = NULL;
+
+
+    if( (worker = worker_new( node_ref, publisher_guid, publisher_format, width, height, decoder_format, frame_size, max_fps )) == NULL )
+    {
+        return NULL;
+    }
+
+    worker->pool = pool;
+    worker->owns_queue = 1;
+
+    if( (worker->msg_queue = image_queue_new( node_ref, queue_capacity, queue_policy )) == NULL )
+    {
+        decode_worker_stop( worker );
+        return NULL;
+    }
+
+
+    return worker;
+}
+
+
+//
+void decode_worker_push( decode_worker_s * const worker, queued_image_s * const queued )
+{
+    if( (worker == NULL) || (worker->pool == NULL) || (queued == NULL) )
+    {
+        return;
+    }
+
+
+    image_queue_push( worker->msg_queue, queued );
+
+    schedule_pass( worker );
+}
+
+
+//
+decode_worker_pool_s *decode_worker_pool_new( const unsigned int max_threads )
+{
+    if( max_threads == 0 )
+    {
+        return NULL;
+    }
+
+    // local vars
+    decode_worker_pool_s *pool = NULL;
+    GError *error = NULL;
+
+
+    // create
+    if( (pool = malloc( sizeof(*pool) )) == NULL )
+    {
+        return NULL;
+    }
+
+    // zero
+    memset( pool, 0, sizeof(*pool) );
+
+    g_mutex_init( &pool->lock );
+
+    if( (pool->pool = g_thread_pool_new( pool_task, pool, (gint) max_threads, FALSE, &error )) == NULL )
+    {
+        psync_log_message(
+                LOG_LEVEL_ERROR,
+                "%s : (%u) -- g_thread_pool_new failed - %s",
+                __FILE__,
+                __LINE__,
+                (error != NULL) ? error->message : "unknown error" );
+        g_clear_error( &error );
+        g_mutex_clear( &pool->lock );
+        free( pool );
+        return NULL;
+    }
+
+
+    return pool;
+}
+
+
+//
+void decode_worker_pool_free( decode_worker_pool_s * const pool )
+{
+    if( pool == NULL )
+    {
+        return;
+    }
+
+
+    // no more passes, running passes may still try to reschedule
+    g_mutex_lock( &pool->lock );
+    pool->quit = 1;
+    g_mutex_unlock( &pool->lock );
+
+    // drop queued passes, wait for running ones
+    g_thread_pool_free( pool->pool, TRUE, TRUE );
+
+    g_mutex_clear( &pool->lock );
+
+    free( pool );
+}
+
+
+//
+void decode_worker_stop( decode_worker_s * const worker )
+{
+    if( worker == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+
+
+    // signal exit and wait for the worker thread
+    if( worker->thread != NULL )
+    {
+        g_atomic_int_set( &worker->quit, 1 );
+        g_thread_join( worker->thread );
+    }
+
+    // release video decoder
+    (void) psync_video_decoder_release( &worker->decoder );
+
+    for( idx = 0; idx < DECODE_WORKER_FRAME_SLOTS; idx++ )
+    {
+        free( worker->frame_storage[ idx ] );
+    }
+
+    // frees undecoded messages of our own queue
+    if( worker->owns_queue != 0 )
+    {
+        image_queue_free( worker->msg_queue );
+    }
+
+    g_ptr_array_free( worker->batch, TRUE );
+
+    g_mutex_clear( &worker->stats_lock );
+
+    free( worker );
+}
+
+
+//
+const decoded_frame_s *decode_worker_acquire( decode_worker_s * const worker, unsigned int * const updated )
+{
+    if( worker == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    gint old_ready = 0;
+
+
+    if( updated != NULL )
+    {
+        (*updated) = 0;
+    }
+
+    // take the ready slot if it holds a newer frame, hand back the read slot
+    do
+    {
+        old_ready = g_atomic_int_get( &worker->ready );
+
+        if( (old_ready & DECODE_WORKER_FRAME_DIRTY) == 0 )
+        {
+            break;
+        }
+    }
+    while( g_atomic_int_compare_and_exchange( &worker->ready, old_ready, (gint) worker->read ) == FALSE );
+
+    if( (old_ready & DECODE_WORKER_FRAME_DIRTY) != 0 )
+    {
+        worker->read = (unsigned int) (old_ready & DECODE_WORKER_FRAME_INDEX_MASK);
+        worker->read_valid = 1;
+
+        if( updated != NULL )
+        {
+            (*updated) = 1;
+        }
+    }
+
+    if( worker->read_valid == 0 )
+    {
+        return NULL;
+    }
+
+
+    return &worker->frames[ worker->read ];
+}
+
+
+//
+unsigned char *decode_worker_exchange_buffer( decode_worker_s * const worker, unsigned char * const buffer )
+{
+    if( (worker == NULL) || (buffer == NULL) || (worker->read_valid == 0) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    decoded_frame_s * const frame = &worker->frames[ worker->read ];
+    unsigned char * const previous = frame->buffer;
+
+
+    // the read slot is ours until the next acquire hands it back
+    frame->buffer = buffer;
+
+
+    return previous;
+}
+
+
+//
+void decode_worker_get_stats( decode_worker_s * const worker, decode_stats_s * const stats )
+{
+    if( (worker == NULL) || (stats == NULL) )
+    {
+        return;
+    }
+
+
+    // local vars
+    image_queue_stats_s queue_stats;
+
+
+    g_mutex_lock( &worker->stats_lock );
+    (*stats) = worker->stats;
+    g_mutex_unlock( &worker->stats_lock );
+
+    // drops before the messages reached the worker
+    if( worker->owns_queue != 0 )
+    {
+        image_queue_get_stats( worker->msg_queue, worker->publisher_guid, &queue_stats );
+        stats->queue_dropped = queue_stats.dropped;
+    }
+}
@@ -149,6 +149,77 @@ static void on_resize( int w, int h );
 static void on_draw( void );
 
 
+/**
+ * @brief Draw an image as a textured quad.
+ *
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] left Left edge of the quad.
+ * @param [in] top Top edge of the quad.
+ * @param [in] right Right edge of the quad.
+ * @param [in] bottom Bottom edge of the quad.
+ *
+ */
+static void draw_image( const gui_image_s * const image, const GLdouble left, const GLdouble top, const GLdouble right, const GLdouble bottom );
+
+
+/**
+ * @brief Draw the statistics label of an image in the bottom left corner of its tile.
+ *
+ * Screen coordinate system.
+ *
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] x Left edge of the tile.
+ * @param [in] y Bottom edge of the tile.
+ *
+ */
+static void draw_image_label( const gui_image_s * const image, const GLdouble x, const GLdouble y );
+
+
+/**
+ * @brief Get the mosaic grid size.
+ *
+ * Columns are added before rows so tiles stay close to the window aspect ratio.
+ *
+ * @param [in] num_images Number of images.
+ * @param [out] cols A pointer to unsigned int which receives the number of columns.
+ * @param [out] rows A pointer to unsigned int which receives the number of rows.
+ *
+ */
+static void get_grid_size( const unsigned int num_images, unsigned int * const cols, unsigned int * const rows );
+
+
+/**
+ * @brief Update the image texture.
+ *
+ * Sets the unpack alignment from the image row size so rows that aren't
+ * 4-byte multiples upload correctly.
+ *
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] data Image data, an offset into the bound pixel unpack buffer if any.
+ *
+ */
+static void upload_image( const gui_image_s * const image, const GLvoid * const data );
+
+
+/**
+ * @brief Add an upload duration to the filtered upload time.
+ *
+ * @param [in] image A pointer to \ref gui_image_s which specifies the image.
+ * @param [in] duration Render thread time spent on the upload. [microseconds]
+ *
+ */
+static void update_upload_time( gui_image_s * const image, const gint64 duration );
+
+
+/**
+ * @brief Destroy an image texture and pixel buffer objects and free it.
+ *
+ * @param [in] data A pointer to \ref gui_image_s.
+ *
+ */
+static void image_free( gpointer data );
+
+
 
 
 // *****************************************************
@@ -391,6 +462,12 @@ static void on_draw( void )
     const GLdouble height = (GLdouble) global_gui_context->win_height;
     const GLdouble text_delta = 20.0;
     GLdouble text_y = 0.0;
+    GLdouble tile_width = width;
+    GLdouble tile_height = height;
+    unsigned int cols = 1;
+    unsigned int rows = 1;
+    guint idx = 0;
+    const gui_image_s *image = NULL;
     char string[PSYNC_DEFAULT_STRING_LEN];
 
 
@@ -445,29 +522,25 @@ static void on_draw( void )
     // disable blending
     glDisable( GL_BLEND );
 
-    // wait for first frame before drawing anything
-    if( global_gui_context->frame_cnt != 0 )
-    {
-        // enable 2D texturing
-        glEnable( GL_TEXTURE_2D );
-
-        // bind to image data texture
-        glBindTexture( GL_TEXTURE_2D, global_gui_context->image_texture );
+    // tile the window, a single image fills it
+    get_grid_size( global_gui_context->images->len, &cols, &rows );
+    tile_width = width / (GLdouble) cols;
+    tile_height = height / (GLdouble) rows;
 
-        // draw image data textured quad
-        glBegin( GL_QUADS );
-        glTexCoord2d( 0.0, 1.0 );
-        glVertex2d( -width/2.0, height/2.0 );
-        glTexCoord2d( 0.0, 0.0 );
-        glVertex2d( -width/2.0, -height/2.0 );
-        glTexCoord2d( 1.0, 0.0 );
-        glVertex2d( width/2.0, -height/2.0 );
-        glTexCoord2d( 1.0, 1.0 );
-        glVertex2d( width/2.0, height/2.0 );
-        glEnd();
+    for( idx = 0; idx < global_gui_context->images->len; idx++ )
+    {
+        image = (const gui_image_s*) g_ptr_array_index( global_gui_context->images, idx );
 
-        // unbind
-        glBindTexture( GL_TEXTURE_2D, 0 );
+        // wait for first frame before drawing anything
+        if( image->frame_cnt != 0 )
+        {
+            draw_image(
+                    image,
+                    -width/2.0 + (GLdouble) (idx % cols) * tile_width,
+                    height/2.0 - (GLdouble) (idx / cols) * tile_height,
+                    -width/2.0 + (GLdouble) ((idx % cols) + 1) * tile_width,
+                    height/2.0 - (GLdouble) ((idx / cols) + 1) * tile_height );
+        }
     }
 
     // restore state
@@ -518,21 +591,18 @@ static void on_draw( void )
         text_y -= text_delta;
         text_y -= text_delta;
 
-        snprintf( string, sizeof(string), "publisher GUID: 0x%016llX", global_gui_context->image_publisher_guid );
-        render_text_2d( 5.0, text_y, string, NULL );
-        text_y -= text_delta;
-        snprintf( string, sizeof(string), "image width: %lu - height: %lu", global_gui_context->image_width, global_gui_context->image_height );
-        render_text_2d( 5.0, text_y, string, NULL );
-        text_y -= text_delta;
-        snprintf( string, sizeof(string), "frame count: %lu", global_gui_context->frame_cnt );
-        render_text_2d( 5.0, text_y, string, NULL );
-        text_y -= text_delta;
-        snprintf( string, sizeof(string), "received FPS: %.0f", global_gui_context->rx_fps );
-        render_text_2d( 5.0, text_y, string, NULL );
-        text_y -= text_delta;
         snprintf( string, sizeof(string), "rendered FPS: %.0f", global_gui_context->rendered_fps );
         render_text_2d( 5.0, text_y, string, NULL );
         text_y -= text_delta;
+
+        // per image statistics
+        for( idx = 0; idx < global_gui_context->images->len; idx++ )
+        {
+            draw_image_label(
+                    (const gui_image_s*) g_ptr_array_index( global_gui_context->images, idx ),
+                    (GLdouble) (idx % cols) * tile_width,
+                    height - (GLdouble) ((idx / cols) + 1) * tile_height );
+        }
     }
 
     // swap buffers
@@ -540,6 +610,141 @@ static void on_draw( void )
 }
 
 
+//
+static void draw_image( const gui_image_s * const image, const GLdouble left, const GLdouble top, const GLdouble right, const GLdouble bottom )
+{
+    // enable 2D texturing
+    glEnable( GL_TEXTURE_2D );
+
+    // bind to image data texture
+    glBindTexture( GL_TEXTURE_2D, image->texture );
+
+    // draw image data textured quad
+    glBegin( GL_QUADS );
+    glTexCoord2d( 0.0, 1.0 );
+    glVertex2d( left, top );
+    glTexCoord2d( 0.0, 0.0 );
+    glVertex2d( left, bottom );
+    glTexCoord2d( 1.0, 0.0 );
+    glVertex2d( right, bottom );
+    glTexCoord2d( 1.0, 1.0 );
+    glVertex2d( right, top );
+    glEnd();
+
+    // unbind
+    glBindTexture( GL_TEXTURE_2D, 0 );
+}
+
+
+//
+static void draw_image_label( const gui_image_s * const image, const GLdouble x, const GLdouble y )
+{
+    // local vars
+    const GLdouble text_delta = 20.0;
+    GLdouble text_y = y + 10.0;
+    char string[PSYNC_DEFAULT_STRING_LEN];
+
+
+    // bottom up
+    snprintf( string, sizeof(string), "dropped frames: %llu - queue depth: %lu - queue drops: %llu", image->dropped_frames, image->queue_depth, image->queue_dropped );
+    render_text_2d( x + 5.0, text_y, string, NULL );
+    text_y += text_delta;
+    snprintf( string, sizeof(string), "rate limited frames: %llu", image->rate_limited_frames );
+    render_text_2d( x + 5.0, text_y, string, NULL );
+    text_y += text_delta;
+    snprintf( string, sizeof(string), "decode latency: %.1f ms - upload time: %.3f ms", image->decode_latency, image->upload_time );
+    render_text_2d( x + 5.0, text_y, string, NULL );
+    text_y += text_delta;
+    snprintf( string, sizeof(string), "frame count: %lu - received FPS: %.0f", image->frame_cnt, image->rx_fps );
+    render_text_2d( x + 5.0, text_y, string, NULL );
+    text_y += text_delta;
+    snprintf( string, sizeof(string), "publisher GUID: 0x%016llX - %lux%lu", image->publisher_guid, image->width, image->height );
+    render_text_2d( x + 5.0, text_y, string, NULL );
+}
+
+
+//
+static void get_grid_size( const unsigned int num_images, unsigned int * const cols, unsigned int * const rows )
+{
+    (*cols) = 1;
+    (*rows) = 1;
+
+    while( ((*cols) * (*rows)) < num_images )
+    {
+        if( (*cols) <= (*rows) )
+        {
+            (*cols) += 1;
+        }
+        else
+        {
+            (*rows) += 1;
+        }
+    }
+}
+
+
+//
+static void upload_image( const gui_image_s * const image, const GLvoid * const data )
+{
+    // bind the image data texture
+    glBindTexture( GL_TEXTURE_2D, image->texture );
+
+    // rows are tightly packed
+    glPixelStorei( GL_UNPACK_ALIGNMENT, (((image->width * GUI_IMAGE_BYTES_PER_PIXEL) % 4) == 0) ? 4 : 1 );
+
+    // update texture data
+    glTexSubImage2D(
+            GL_TEXTURE_2D,      // target
+            0,                  // level of detail
+            0,                  // x offset
+            0,                  // y offset
+            image->width,       // width
+            image->height,      // height
+            GUI_IMAGE_FORMAT,   // format
+            GL_UNSIGNED_BYTE,   // type
+            data                // data
+    );
+
+    // unbind
+    glBindTexture( GL_TEXTURE_2D, 0 );
+}
+
+
+//
+static void update_upload_time( gui_image_s * const image, const gint64 duration )
+{
+    // local vars
+    const double duration_ms = (double) duration / 1000.0;
+
+
+    if( image->upload_time == 0.0 )
+    {
+        image->upload_time = duration_ms;
+    }
+    else
+    {
+        image->upload_time += GUI_UPLOAD_TIME_FILTER * (duration_ms - image->upload_time);
+    }
+}
+
+
+//
+static void image_free( gpointer data )
+{
+    // local vars
+    gui_image_s * const image = (gui_image_s*) data;
+
+
+    // destroy pixel buffer objects, lent ones are unmapped with them
+    glDeleteBuffers( GUI_IMAGE_PBO_COUNT, image->pbos );
+    glDeleteBuffers( GUI_IMAGE_LEND_COUNT, image->lend_pbos );
+
+    // destroy texture
+    glDeleteTextures( 1, &image->texture );
+
+    g_free( image );
+}
+
 
 
 // *****************************************************
@@ -567,6 +772,9 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     // zero
     memset( gui, 0, sizeof(*gui) );
 
+    // images are added once their publishers are known
+    gui->images = g_ptr_array_new_with_free_func( image_free );
+
     // default configurations
     gui->config.freeze_frame = 0;
     gui->config.help_visible = 1;
@@ -583,10 +791,6 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     gui->win_width = win_width;
     gui->win_height = win_height;
 
-    // set image data w/h
-    gui->image_width = (unsigned long) win_width;
-    gui->image_height = (unsigned long) win_height;
-
     // FPS max
     gui->max_fps = GUI_DEFAULT_MAX_FPS;
 
@@ -602,6 +806,7 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     // create display window
     if( (gui->win_id = glutCreateWindow( gui->win_title )) < 0 )
     {
+        g_ptr_array_free( gui->images, TRUE );
         free( gui );
         return NULL;
     }
@@ -642,21 +847,87 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     // enable texture 2D
     glEnable( GL_TEXTURE_2D );
 
+    // set global reference
+    global_gui_context = gui;
+
+    // signal redraw
+    glutPostRedisplay();
+
+    // process glut events
+    glutMainLoopEvent();
+
+    // return new memory
+    return gui;
+}
+
+
+//
+void gui_release( gui_context_s * const gui )
+{
+    if( gui == NULL )
+    {
+        return;
+    }
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    // destroy image textures and pixel buffer objects
+    g_ptr_array_free( gui->images, TRUE );
+    gui->images = NULL;
+
+    // signal GL exit
+    glutExit();
+
+    // de-ref
+    global_gui_context = NULL;
+}
+
+
+//
+gui_image_s *gui_add_image( gui_context_s * const gui, const ps_guid publisher_guid, const unsigned long width, const unsigned long height )
+{
+    if( (gui == NULL) || (width < 1) || (height < 1) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    gui_image_s *image = NULL;
+    unsigned int idx = 0;
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    if( (image = g_try_new0( gui_image_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    image->publisher_guid = publisher_guid;
+    image->width = width;
+    image->height = height;
+
+    // enable texture 2D
+    glEnable( GL_TEXTURE_2D );
+
     // create image data texture
-    glGenTextures( 1, &gui->image_texture );
+    glGenTextures( 1, &image->texture );
 
     // bind the image data texture
-    glBindTexture( GL_TEXTURE_2D, gui->image_texture );
+    glBindTexture( GL_TEXTURE_2D, image->texture );
 
-    // create texture
+    // create texture, 32-bit texels whatever the upload format
     glTexImage2D(
             GL_TEXTURE_2D,      // target
             0,                  // level of detail
-            GL_RGB,             // internal image format
-            win_width,          // width
-            win_height,         // height
+            GL_RGBA8,           // internal image format
+            width,              // width
+            height,             // height
             0,                  // border
-            GL_RGB,             // format
+            GUI_IMAGE_FORMAT,   // format
             GL_UNSIGNED_BYTE,   // type
             NULL   // data
     );
@@ -667,78 +938,251 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     glTexParameterf( GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR );
     glTexParameterf( GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT );
     glTexParameterf( GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT );
-    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
 
     // unbind
     glBindTexture( GL_TEXTURE_2D, 0 );
 
-    // set global reference
-    global_gui_context = gui;
+    // create pixel buffer objects, one image each
+    image->pbo_size = width * height * GUI_IMAGE_BYTES_PER_PIXEL;
+    glGenBuffers( GUI_IMAGE_PBO_COUNT, image->pbos );
 
-    // signal redraw
+    for( idx = 0; idx < GUI_IMAGE_PBO_COUNT; idx++ )
+    {
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, image->pbos[ idx ] );
+        glBufferData( GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) image->pbo_size, NULL, GL_STREAM_DRAW );
+    }
+
+    // storage is allocated when first lent
+    glGenBuffers( GUI_IMAGE_LEND_COUNT, image->lend_pbos );
+
+    // unbind
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    g_ptr_array_add( gui->images, image );
+
+    // tiles changed
     glutPostRedisplay();
 
-    // process glut events
-    glutMainLoopEvent();
 
-    // return new memory
-    return gui;
+    return image;
 }
 
 
 //
-void gui_release( gui_context_s * const gui )
+void gui_update_image_data( gui_context_s * const gui, gui_image_s * const image, const unsigned char * buffer, const unsigned long buffer_len )
 {
-    if( gui == NULL )
+    if( (gui == NULL) || (image == NULL) || (buffer == NULL) || (buffer_len == 0) )
     {
         return;
     }
 
+    // local vars
+    unsigned char *pbo_buffer = NULL;
+    unsigned long pbo_buffer_size = 0;
+    gint64 start_time = 0;
+
 
     // update global reference
     global_gui_context = gui;
 
-    // destroy texture
-    glDeleteTextures( 1, &gui->image_texture );
+    // copy into the next pixel buffer object
+    if( (pbo_buffer = gui_map_image_buffer( gui, image, &pbo_buffer_size )) != NULL )
+    {
+        memcpy( pbo_buffer, buffer, MIN( buffer_len, pbo_buffer_size ) );
 
-    // signal GL exit
-    glutExit();
+        gui_unmap_image_buffer( gui, image, MIN( buffer_len, pbo_buffer_size ) );
+    }
+    else if( buffer_len >= image->pbo_size )
+    {
+        // no pixel buffer, upload from client memory
+        start_time = g_get_monotonic_time();
 
-    // de-ref
-    global_gui_context = NULL;
+        upload_image( image, buffer );
+
+        update_upload_time( image, g_get_monotonic_time() - start_time );
+    }
+}
+
+
+//
+unsigned char *gui_map_image_buffer( gui_context_s * const gui, gui_image_s * const image, unsigned long * const buffer_size )
+{
+    if( (gui == NULL) || (image == NULL) || (buffer_size == NULL) || (image->pbo_mapped != 0) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    const unsigned int index = (image->pbo_index + 1) % GUI_IMAGE_PBO_COUNT;
+    const gint64 start_time = g_get_monotonic_time();
+    unsigned char *buffer = NULL;
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, image->pbos[ index ] );
+
+    // orphan, the driver hands back fresh storage instead of waiting on a pending upload
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) image->pbo_size, NULL, GL_STREAM_DRAW );
+
+    buffer = (unsigned char*) glMapBuffer( GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY );
+
+    // unbind
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    if( buffer == NULL )
+    {
+        return NULL;
+    }
+
+    image->pbo_index = index;
+    image->pbo_mapped = 1;
+    (*buffer_size) = image->pbo_size;
+
+    // mapping is part of the upload, writing the data isn't
+    image->pbo_map_time = (ps_timestamp) (g_get_monotonic_time() - start_time);
+
+
+    return buffer;
 }
 
 
 //
-void gui_update_image_data( gui_context_s * const gui, const unsigned char * buffer, const unsigned long buffer_len )
+void gui_unmap_image_buffer( gui_context_s * const gui, gui_image_s * const image, const unsigned long buffer_len )
 {
-    if( (gui == NULL) || (buffer == NULL) || (buffer_len == 0) )
+    if( (gui == NULL) || (image == NULL) || (image->pbo_mapped == 0) )
     {
         return;
     }
 
+    // local vars
+    const gint64 start_time = g_get_monotonic_time();
+    GLboolean valid = GL_FALSE;
+
 
     // update global reference
     global_gui_context = gui;
 
-    // bind the image data texture
-    glBindTexture( GL_TEXTURE_2D, gui->image_texture );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, image->pbos[ image->pbo_index ] );
 
-    // update texture data
-    glTexSubImage2D(
-            GL_TEXTURE_2D,      // target
-            0,                  // level of detail
-            0,                  // x offset
-            0,                  // y offset
-            gui->image_width,   // width
-            gui->image_height,  // height
-            GL_RGB,             // format
-            GL_UNSIGNED_BYTE,   // type
-            buffer              // data
-    );
+    // contents are undefined if the mapping was lost
+    valid = glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+    image->pbo_mapped = 0;
+
+    // texture update from the pixel buffer returns without waiting on the copy
+    if( (valid == GL_TRUE) && (buffer_len >= image->pbo_size) )
+    {
+        upload_image( image, (const GLvoid*) 0 );
+    }
 
     // unbind
-    glBindTexture( GL_TEXTURE_2D, 0 );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    update_upload_time( image, (gint64) image->pbo_map_time + (g_get_monotonic_time() - start_time) );
+}
+
+
+//
+unsigned char *gui_lend_image_buffer( gui_context_s * const gui, gui_image_s * const image, unsigned long * const buffer_size )
+{
+    if( (gui == NULL) || (image == NULL) || (buffer_size == NULL) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    const gint64 start_time = g_get_monotonic_time();
+    unsigned int idx = 0;
+    unsigned char *buffer = NULL;
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    // find one not lent
+    while( (idx < GUI_IMAGE_LEND_COUNT) && (image->lend_buffers[ idx ] != NULL) )
+    {
+        idx += 1;
+    }
+
+    if( idx == GUI_IMAGE_LEND_COUNT )
+    {
+        return NULL;
+    }
+
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, image->lend_pbos[ idx ] );
+
+    // orphan, the driver hands back fresh storage instead of waiting on a pending upload
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) image->pbo_size, NULL, GL_STREAM_DRAW );
+
+    buffer = (unsigned char*) glMapBuffer( GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY );
+
+    // unbind
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    if( buffer == NULL )
+    {
+        return NULL;
+    }
+
+    image->lend_buffers[ idx ] = buffer;
+    (*buffer_size) = image->pbo_size;
+
+    // mapping is part of the upload, writing the data isn't
+    image->pbo_map_time = (ps_timestamp) (g_get_monotonic_time() - start_time);
+
+
+    return buffer;
+}
+
+
+//
+unsigned int gui_return_image_buffer( gui_context_s * const gui, gui_image_s * const image, const unsigned char * const buffer, const unsigned long buffer_len )
+{
+    if( (gui == NULL) || (image == NULL) || (buffer == NULL) )
+    {
+        return 0;
+    }
+
+    // local vars
+    const gint64 start_time = g_get_monotonic_time();
+    unsigned int idx = 0;
+    GLboolean valid = GL_FALSE;
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    while( (idx < GUI_IMAGE_LEND_COUNT) && (image->lend_buffers[ idx ] != buffer) )
+    {
+        idx += 1;
+    }
+
+    if( idx == GUI_IMAGE_LEND_COUNT )
+    {
+        return 0;
+    }
+
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, image->lend_pbos[ idx ] );
+
+    // contents are undefined if the mapping was lost
+    valid = glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+    image->lend_buffers[ idx ] = NULL;
+
+    // texture update from the pixel buffer returns without waiting on the copy
+    if( (valid == GL_TRUE) && (buffer_len >= image->pbo_size) )
+    {
+        upload_image( image, (const GLvoid*) 0 );
+    }
+
+    // unbind
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    update_upload_time( image, (gint64) image->pbo_map_time + (g_get_monotonic_time() - start_time) );
+
+
+    return 1;
 }
 
 
@@ -29,6 +29,8 @@
  * Image Data Viewer Example.
  *
  * Shows how to decode and view encoded image data received over the PolySync bus.
+ * Decoding runs on a worker thread that skips ahead when it falls behind, see \ref decode_worker_s.
+ * In mosaic mode every H264/MJPEG publisher is decoded on a shared thread pool and tiled into one window.
  *
  */
 
@@ -40,6 +42,7 @@
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <glib-2.0/glib.h>
 
 // API headers
@@ -50,6 +53,8 @@
 
 // GUI headers
 #include "gui.h"
+#include "image_queue.h"
+#include "decode_worker.h"
 
 
 
@@ -58,6 +63,34 @@
 // static global types/macros
 // *****************************************************
 
+/**
+ * @brief Image data stream.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_guid                 publisher_guid; /*!< Publisher GUID. */
+    //
+    //
+    decode_worker_s         *worker; /*!< Decode worker of the stream. */
+    //
+    //
+    gui_image_s             *image; /*!< GUI image the stream is drawn to. */
+    //
+    //
+    unsigned long long      reported_dropped; /*!< Queue drops already logged as diagnostics. */
+} image_stream_s;
+
+
+/**
+ * @brief Interval queue drops are logged as diagnostics at. [microseconds]
+ *
+ */
+#define         DIAGNOSTICS_INTERVAL        (5000000ULL)
+
+
 /**
  * @brief Node reference used by the example.
  *
@@ -101,21 +134,11 @@ static const char IMAGE_DATA_MSG_NAME[] = "ps_image_data_msg";
 static void sig_handler( int signal );
 
 
-/**
- * @brief Flush message queue.
- *
- * Frees message elements in a queue.
- *
- * @param [in] msg_queue Message queue to flush.
- *
- */
-static void flush_queue( GAsyncQueue * const msg_queue );
-
-
 /**
  * @brief Message "ps_image_data_msg" handler.
  *
- * Enqueues new messages for processing by the main loop.
+ * Enqueues new messages for processing by the decode worker. Messages the
+ * queue drop policy rejects are not copied.
  *
  * @param [in] msg_type Message type identifier for the message, as seen by the data model.
  * @param [in] message Message reference to be handled by the function.
@@ -128,6 +151,51 @@ static void ps_image_data_msg__handler(
         void * const user_data );
 
 
+/**
+ * @brief Create a mosaic stream for a new publisher.
+ *
+ * Creates a decode worker scheduled on the thread pool and a GUI image tile.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] pool A pointer to \ref decode_worker_pool_s which specifies the decode thread pool.
+ * @param [in] image_data_msg A pointer to ps_image_data_msg which specifies the first message of the publisher.
+ * @param [in] max_fps Per-stream frame-rate limit, zero for none. [Hz]
+ * @param [in] msg_queue A pointer to \ref image_queue_s which specifies the received message queue, its capacity and policy are used for the stream queue.
+ *
+ * @return A newly created stream on success, NULL on failure.
+ *
+ */
+static image_stream_s *mosaic_stream_new(
+        gui_context_s * const gui,
+        decode_worker_pool_s * const pool,
+        const ps_image_data_msg * const image_data_msg,
+        const double max_fps,
+        const image_queue_s * const msg_queue );
+
+
+/**
+ * @brief Show the latest decoded frame of a stream and update its statistics.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] msg_queue A pointer to \ref image_queue_s which specifies the received message queue.
+ * @param [in] stream A pointer to \ref image_stream_s which specifies the stream.
+ *
+ * @return One if a newer frame was decoded, zero otherwise.
+ *
+ */
+static unsigned int update_stream( gui_context_s * const gui, image_queue_s * const msg_queue, image_stream_s * const stream );
+
+
+/**
+ * @brief Log the queue drops of each stream since the last report as diagnostics.
+ *
+ * @param [in] streams A pointer to GPtrArray of \ref image_stream_s.
+ * @param [in] policy Queue drop policy.
+ *
+ */
+static void report_queue_drops( GPtrArray * const streams, const image_queue_policy_kind policy );
+
+
 
 
 // *****************************************************
@@ -146,56 +214,210 @@ static void sig_handler( int sig )
 
 
 //
-static void flush_queue( GAsyncQueue * const msg_queue )
+static void ps_image_data_msg__handler( const ps_msg_type msg_type, const ps_msg_ref const message, void * const user_data )
 {
-    if( msg_queue == NULL )
+    if( user_data == NULL )
     {
         return;
     }
 
     // local vars
-    ps_msg_ref msg = PSYNC_MSG_REF_INVALID;
+    int ret = DTC_NONE;
+    image_queue_s *msg_queue = NULL;
+    queued_image_s *queued = NULL;
+    const ps_image_data_msg * const image_data_msg = (const ps_image_data_msg*) message;
+    const unsigned int keyframe = image_queue_is_keyframe( image_data_msg );
+
+
+    // cast
+    msg_queue = (image_queue_s*) user_data;
 
+    // skip the copy if it would be dropped
+    if( image_queue_reject( msg_queue, image_data_msg->header.src_guid, keyframe ) != 0 )
+    {
+        return;
+    }
+
+    // create queue element
+    if( (queued = malloc( sizeof(*queued) )) == NULL )
+    {
+        return;
+    }
+
+    queued->msg = PSYNC_MSG_REF_INVALID;
+    queued->keyframe = keyframe;
+    queued->discontinuity = 0;
+    (void) psync_get_timestamp( &queued->rx_time );
+
+    // create copy
+    ret = psync_message_alloc( global_node_ref, msg_type, &queued->msg );
+
+    // copy if succeeded
+    if( ret == DTC_NONE )
+    {
+        ret = psync_message_copy( global_node_ref, message, queued->msg );
+    }
 
-    // flush
-    while( (msg = g_async_queue_try_pop(msg_queue)) != NULL )
+    // enqueue
+    if( queued->msg != PSYNC_MSG_REF_INVALID )
+    {
+        image_queue_push( msg_queue, queued );
+    }
+    else
     {
-        // release
-        (void) psync_message_free( global_node_ref, &msg );
+        free( queued );
     }
 }
 
 
 //
-static void ps_image_data_msg__handler( const ps_msg_type msg_type, const ps_msg_ref const message, void * const user_data )
+static image_stream_s *mosaic_stream_new(
+        gui_context_s * const gui,
+        decode_worker_pool_s * const pool,
+        const ps_image_data_msg * const image_data_msg,
+        const double max_fps,
+        const image_queue_s * const msg_queue )
 {
-    if( user_data == NULL )
+    // local vars
+    image_stream_s *stream = NULL;
+
+
+    if( (stream = malloc( sizeof(*stream) )) == NULL )
     {
-        return;
+        return NULL;
     }
 
-    // local vars
-    int ret = DTC_NONE;
-    GAsyncQueue *msg_queue = NULL;
-    ps_msg_ref msg_copy = PSYNC_MSG_REF_INVALID;
+    stream->publisher_guid = image_data_msg->header.src_guid;
+    stream->reported_dropped = 0;
 
+    // decoder output is RGB, sized to the publisher
+    stream->worker = decode_worker_new(
+            pool,
+            global_node_ref,
+            image_data_msg->header.src_guid,
+            image_data_msg->pixel_format,
+            image_data_msg->width,
+            image_data_msg->height,
+            PIXEL_FORMAT_RGB24,
+            image_data_msg->width * image_data_msg->height * GUI_IMAGE_BYTES_PER_PIXEL,
+            max_fps,
+            msg_queue->capacity,
+            msg_queue->policy );
+
+    if( stream->worker == NULL )
+    {
+        free( stream );
+        return NULL;
+    }
 
-    // cast
-    msg_queue = (GAsyncQueue*) user_data;
+    if( (stream->image = gui_add_image( gui, image_data_msg->header.src_guid, image_data_msg->width, image_data_msg->height )) == NULL )
+    {
+        decode_worker_stop( stream->worker );
+        free( stream );
+        return NULL;
+    }
 
-    // create copy
-    ret = psync_message_alloc( global_node_ref, msg_type, &msg_copy );
 
-    // copy if succeeded
-    if( ret == DTC_NONE )
+    return stream;
+}
+
+
+//
+static unsigned int update_stream( gui_context_s * const gui, image_queue_s * const msg_queue, image_stream_s * const stream )
+{
+    // local vars
+    gui_image_s * const image = stream->image;
+    const decoded_frame_s *frame = NULL;
+    unsigned int frame_updated = 0;
+    unsigned char *lent_buffer = NULL;
+    unsigned long lent_buffer_size = 0;
+    const unsigned char *frame_buffer = NULL;
+    decode_stats_s decode_stats;
+    image_queue_stats_s queue_stats;
+
+
+    // take the latest decoded frame
+    frame = decode_worker_acquire( stream->worker, &frame_updated );
+
+    // if decoder has a new frame available
+    if( (frame != NULL) && (frame_updated != 0) )
     {
-        ret = psync_message_copy( global_node_ref, message, msg_copy );
+        // update frame counter
+        image->frame_cnt += 1;
+
+        // get rx FPS
+        image->rx_fps = (double) (frame->decoded_time - image->last_rx_time) / 1000000.0;
+        image->rx_fps = 1.0 / image->rx_fps;
+
+        // update last timestamp
+        image->last_rx_time = frame->decoded_time;
+
+        // update texture with new data and we're not in freeze-frame
+        if( gui->config.freeze_frame == 0 )
+        {
+            // take the frame buffer, the worker decodes the next frames into mapped pixel buffers
+            if( ((lent_buffer = gui_lend_image_buffer( gui, image, &lent_buffer_size )) != NULL)
+                    && (lent_buffer_size >= stream->worker->frame_size) )
+            {
+                frame_buffer = decode_worker_exchange_buffer( stream->worker, lent_buffer );
+            }
+            else
+            {
+                (void) gui_return_image_buffer( gui, image, lent_buffer, 0 );
+                frame_buffer = frame->buffer;
+            }
+
+            // frames decoded into worker memory are copied, until those buffers are swapped out
+            if( gui_return_image_buffer( gui, image, frame_buffer, frame->size ) == 0 )
+            {
+                gui_update_image_data( gui, image, frame_buffer, frame->size );
+            }
+        }
     }
 
-    // enqueue
-    if( msg_copy != PSYNC_MSG_REF_INVALID )
+    // update decode statistics
+    memset( &decode_stats, 0, sizeof(decode_stats) );
+    decode_worker_get_stats( stream->worker, &decode_stats );
+    image->decode_latency = decode_stats.latency;
+    image->dropped_frames = decode_stats.dropped_frames;
+    image->rate_limited_frames = decode_stats.rate_limited_frames;
+    image->queue_depth = decode_stats.queue_depth;
+
+    // drops on receive and, in mosaic mode, in the stream queue
+    image_queue_get_stats( msg_queue, stream->publisher_guid, &queue_stats );
+    image->queue_dropped = queue_stats.dropped + decode_stats.queue_dropped;
+
+
+    return (frame_updated != 0) ? 1 : 0;
+}
+
+
+//
+static void report_queue_drops( GPtrArray * const streams, const image_queue_policy_kind policy )
+{
+    // local vars
+    image_stream_s *stream = NULL;
+    guint idx = 0;
+
+
+    for( idx = 0; idx < streams->len; idx++ )
     {
-        g_async_queue_push( msg_queue, (gpointer) msg_copy );
+        stream = (image_stream_s*) g_ptr_array_index( streams, idx );
+
+        if( (stream->image != NULL) && (stream->image->queue_dropped != stream->reported_dropped) )
+        {
+            psync_log_message(
+                    LOG_LEVEL_WARN,
+                    "%s : (%u) -- publisher GUID 0x%016llX - queue dropped %llu messages (%llu total) - policy '%s'",
+                    __FILE__,
+                    __LINE__,
+                    (unsigned long long) stream->publisher_guid,
+                    stream->image->queue_dropped - stream->reported_dropped,
+                    stream->image->queue_dropped,
+                    image_queue_get_policy_name( policy ) );
+
+            stream->reported_dropped = stream->image->queue_dropped;
+        }
     }
 }
 
@@ -205,11 +427,43 @@ static void ps_image_data_msg__handler( const ps_msg_type msg_type, const ps_msg
 // *****************************************************
 // main
 // *****************************************************
+/**
+ * @brief Main entry function.
+ *
+ * Options:
+ * \li -m Mosaic mode, view every H264/MJPEG publisher tiled in one window.
+ * \li -r <fps> Per-stream frame-rate limit, zero for none (default).
+ * \li -j <threads> Mosaic mode decode threads, caps the CPU spent decoding, see \ref DECODE_WORKER_DEFAULT_POOL_THREADS.
+ * \li -q <depth> Message queue capacity, see \ref IMAGE_QUEUE_DEFAULT_CAPACITY.
+ * \li -d <policy> Message queue drop policy, "oldest" (default), "newest" or "keyframes", see \ref image_queue_policy_kind.
+ *
+ * @param [in] argc Number of arguments in the argv argument list.
+ * @param [in] argv Argument list.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
 int main( int argc, char **argv )
 {
     // polysync return status
     int ret = DTC_NONE;
 
+    // option parser return
+    int optret = 0;
+
+    // non-zero in mosaic mode
+    unsigned int mosaic_mode = 0;
+
+    // per-stream frame-rate limit, zero for none
+    double max_fps = 0.0;
+
+    // mosaic mode decode threads
+    unsigned int decode_threads = DECODE_WORKER_DEFAULT_POOL_THREADS;
+
+    // message queue capacity and drop policy
+    unsigned long queue_capacity = IMAGE_QUEUE_DEFAULT_CAPACITY;
+    image_queue_policy_kind queue_policy = IMAGE_QUEUE_DROP_OLDEST;
+
     // GUI data
     gui_context_s *gui = NULL;
 
@@ -217,7 +471,7 @@ int main( int argc, char **argv )
     ps_guid publisher_guid = PSYNC_GUID_INVALID;
 
     // subscriber message queue
-    GAsyncQueue *msg_queue = NULL;
+    image_queue_s *msg_queue = NULL;
 
     // image data message type
     ps_msg_type image_data_msg_type = PSYNC_MSG_TYPE_INVALID;
@@ -232,18 +486,36 @@ int main( int argc, char **argv )
     // publisher pixel format
     ps_pixel_format_kind publisher_format = PIXEL_FORMAT_INVALID;
 
-    // video decoder - converts compressed stream into raw image
-    ps_video_decoder video_decoder;
+    // decode thread pool - shared by the mosaic streams
+    decode_worker_pool_s *decode_pool = NULL;
+
+    // streams being viewed (image_stream_s), in tile order
+    GPtrArray *streams = NULL;
 
-    // local decoder data buffer - filled by the decoder
-    unsigned char *decoder_buffer = NULL;
+    // streams by publisher GUID
+    GHashTable *streams_by_guid = NULL;
+
+    // publisher GUIDs a stream could not be created for, their messages are freed
+    GHashTable *rejected_guids = NULL;
+
+    // rejected publisher GUID
+    ps_guid *rejected_guid = NULL;
+
+    // stream
+    image_stream_s *stream = NULL;
+
+    // message being routed to its stream
+    queued_image_s *queued = NULL;
+
+    // stream index
+    guint idx = 0;
+
+    // non-zero if a newer frame was decoded
+    unsigned int frame_updated = 0;
 
     // size in bytes of the decoded image data
     unsigned long decoded_frame_size = 0;
 
-    // number of bytes decoded per frame
-    unsigned long bytes_decoded = 0;
-
     // current time
     ps_timestamp timestamp = 0;
 
@@ -253,12 +525,44 @@ int main( int argc, char **argv )
     // sleep counter
     unsigned long sleep_tick = 0;
 
-    // last image rx/decoded timestamp
-    ps_timestamp last_rx_time = 0;
+    // last time queue drops were logged
+    ps_timestamp last_report_time = 0;
 
 
-    // zero
-    memset( &video_decoder, 0, sizeof(video_decoder) );
+    // parse options
+    while( (optret = getopt( argc, argv, "mr:j:q:d:" )) != -1 )
+    {
+        if( optret == 'm' )
+        {
+            mosaic_mode = 1;
+        }
+        else if( (optret == 'r') && (atof( optarg ) >= 0.0) )
+        {
+            max_fps = atof( optarg );
+        }
+        else if( (optret == 'j') && (atoi( optarg ) > 0) )
+        {
+            decode_threads = (unsigned int) atoi( optarg );
+        }
+        else if( (optret == 'q') && (atoi( optarg ) > 0) )
+        {
+            queue_capacity = (unsigned long) atoi( optarg );
+        }
+        else if( (optret == 'd') && (image_queue_get_policy_by_name( optarg, &queue_policy ) == 0) )
+        {
+            // set by lookup
+        }
+        else
+        {
+            printf( "usage: %s [-m] [-r <fps>] [-j <threads>] [-q <depth>] [-d oldest|newest|keyframes]\n", argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    // streams, the table only references them
+    streams = g_ptr_array_new();
+    streams_by_guid = g_hash_table_new( g_int64_hash, g_int64_equal );
+    rejected_guids = g_hash_table_new_full( g_int64_hash, g_int64_equal, g_free, NULL );
 
 	// init core API
     ret = psync_init(
@@ -282,7 +586,7 @@ int main( int argc, char **argv )
     }
 
     // create message queue
-    if( (msg_queue = g_async_queue_new()) == NULL )
+    if( (msg_queue = image_queue_new( global_node_ref, queue_capacity, queue_policy )) == NULL )
     {
         psync_log_message(
                 LOG_LEVEL_ERROR,
@@ -336,19 +640,25 @@ int main( int argc, char **argv )
         goto GRACEFUL_EXIT_STMNT;
     }
 
+    // mosaic streams are created as their publishers are found
+    if( mosaic_mode != 0 )
+    {
+        goto MOSAIC_STMNT;
+    }
+
     printf( "waiting for first image data publisher\n" );
 
     // while we haven't seen a valid image data publisher
     while( publisher_guid == PSYNC_GUID_INVALID )
     {
         // get message if one exist
-        ps_msg_ref msg = g_async_queue_try_pop( msg_queue );
+        queued_image_s *queued = image_queue_try_pop( msg_queue );
 
         // check if valid
-        if( msg != PSYNC_MSG_REF_INVALID )
+        if( queued != NULL )
         {
             // cast
-            const ps_image_data_msg * const image_data_msg = (ps_image_data_msg*) msg;
+            const ps_image_data_msg * const image_data_msg = (ps_image_data_msg*) queued->msg;
 
             // check for supported pixel format
             if( (image_data_msg->pixel_format == PIXEL_FORMAT_H264)
@@ -370,6 +680,9 @@ int main( int argc, char **argv )
                 publisher_width = image_data_msg->width;
                 publisher_height = image_data_msg->height;
             }
+
+            // free
+            image_queue_free_queued( global_node_ref, queued );
         }
 
         // check for exit
@@ -379,46 +692,87 @@ int main( int argc, char **argv )
         }
     }
 
-    // initialize decoder, frame-rate will be determined by stream if possible, otherwise use default
-    ret = psync_video_decoder_init(
-            &video_decoder,
+    // set the decoded frame size, RGB
+    decoded_frame_size = publisher_width * publisher_height * GUI_IMAGE_BYTES_PER_PIXEL;
+
+    // create stream
+    if( (stream = malloc( sizeof(*stream) )) == NULL )
+    {
+        goto GRACEFUL_EXIT_STMNT;
+    }
+
+    stream->publisher_guid = publisher_guid;
+    stream->image = NULL;
+    stream->reported_dropped = 0;
+
+    // start decoding on a worker thread, it takes over the message queue
+    stream->worker = decode_worker_start(
+            global_node_ref,
+            msg_queue,
+            publisher_guid,
             publisher_format,
             publisher_width,
             publisher_height,
             desired_decoder_format,
-            publisher_width,
-            publisher_height,
-            PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND );
+            decoded_frame_size,
+            max_fps );
 
     // error check
-    if( ret!= DTC_NONE )
+    if( stream->worker == NULL )
     {
         psync_log_message(
                 LOG_LEVEL_ERROR,
-                "%s : (%u) -- psync_video_decoder_init returned DTC %d",
+                "%s : (%u) -- failed to start decode worker",
                 __FILE__,
-                __LINE__,
-                ret );
+                __LINE__ );
+        free( stream );
         goto GRACEFUL_EXIT_STMNT;
     }
 
-    // set the decoded frame size, RGB
-    decoded_frame_size = publisher_width * publisher_height * 3;
+    g_ptr_array_add( streams, stream );
 
-    // allocate decoder buffer, enough space for a full raw frame in the desired pixel format which is RGB in this example
-    if( (decoder_buffer = malloc( decoded_frame_size )) == NULL )
+    // create GUI
+    if( (gui = gui_init( NODE_NAME, publisher_width, publisher_height )) == NULL )
     {
         psync_log_message(
                 LOG_LEVEL_ERROR,
-                "%s : (%u) -- failed to allocate decoder buffer - size %lu bytes",
+                "%s : (%u) -- failed to create GUI context",
                 __FILE__,
-                __LINE__,
-                decoded_frame_size );
+                __LINE__ );
+        goto GRACEFUL_EXIT_STMNT;
+    }
+
+    // single image filling the window
+    if( (stream->image = gui_add_image( gui, publisher_guid, publisher_width, publisher_height )) == NULL )
+    {
+        psync_log_message(
+                LOG_LEVEL_ERROR,
+                "%s : (%u) -- failed to create GUI image",
+                __FILE__,
+                __LINE__ );
+        goto GRACEFUL_EXIT_STMNT;
+    }
+
+    goto MAIN_LOOP_STMNT;
+
+
+    // mosaic mode, decode threads are shared by all streams
+    MOSAIC_STMNT:
+    printf( "waiting for image data publishers\n" );
+
+    // create decode thread pool
+    if( (decode_pool = decode_worker_pool_new( decode_threads )) == NULL )
+    {
+        psync_log_message(
+                LOG_LEVEL_ERROR,
+                "%s : (%u) -- failed to create decode thread pool",
+                __FILE__,
+                __LINE__ );
         goto GRACEFUL_EXIT_STMNT;
     }
 
     // create GUI
-    if( (gui = gui_init( NODE_NAME, publisher_width, publisher_height )) == NULL )
+    if( (gui = gui_init( NODE_NAME, GUI_MOSAIC_DEFAULT_WIDTH, GUI_MOSAIC_DEFAULT_HEIGHT )) == NULL )
     {
         psync_log_message(
                 LOG_LEVEL_ERROR,
@@ -428,117 +782,85 @@ int main( int argc, char **argv )
         goto GRACEFUL_EXIT_STMNT;
     }
 
-    // set the publisher node GUID that were listening for
-    gui->image_publisher_guid = publisher_guid;
-
 
     // main event loop
     // loop until signaled (control-c)
+    MAIN_LOOP_STMNT:
     while( global_exit_signal == 0 )
     {
-        // zero
-        bytes_decoded = 0;
-
-        // get message if one exist
-        ps_msg_ref msg = g_async_queue_try_pop( msg_queue );
-
-        // check if valid
-        if( msg != PSYNC_MSG_REF_INVALID )
+        // route messages to their streams, the single stream worker pops the queue itself
+        while( (decode_pool != NULL) && ((queued = image_queue_try_pop( msg_queue )) != NULL) )
         {
             // cast
-            const ps_image_data_msg * const image_data_msg = (ps_image_data_msg*) msg;
+            const ps_image_data_msg * const image_data_msg = (ps_image_data_msg*) queued->msg;
 
-            // check if publisher is what we've initialized to using its GUID and pixel format
-            if(
-                    (image_data_msg->header.src_guid == publisher_guid) &&
-                    (image_data_msg->pixel_format == publisher_format) )
+            // check for a new publisher with a supported pixel format
+            if( ((stream = g_hash_table_lookup( streams_by_guid, &image_data_msg->header.src_guid )) == NULL)
+                    && (g_hash_table_lookup( rejected_guids, &image_data_msg->header.src_guid ) == NULL)
+                    && ((image_data_msg->pixel_format == PIXEL_FORMAT_H264)
+                        || (image_data_msg->pixel_format == PIXEL_FORMAT_MJPEG)) )
             {
-                // decode the data
-                ret = psync_video_decoder_decode(
-                        &video_decoder,
-                        image_data_msg->timestamp,
-                        image_data_msg->data_buffer._buffer,
-                        image_data_msg->data_buffer._length );
-
-                // error check
-                if( ret!= DTC_NONE )
+                // found
+                printf( "found publisher GUID 0x%016llX (%llu) - pixel_format: '%s'\n",
+                        (unsigned long long) image_data_msg->header.src_guid,
+                        (unsigned long long) image_data_msg->header.src_guid,
+                        (image_data_msg->pixel_format == PIXEL_FORMAT_H264) ? "H264" : "MJPEG" );
+
+                if( (stream = mosaic_stream_new( gui, decode_pool, image_data_msg, max_fps, msg_queue )) != NULL )
                 {
-                    psync_log_message(
-                            LOG_LEVEL_ERROR,
-                            "%s : (%u) -- psync_video_decoder_decode returned DTC %d",
-                            __FILE__,
-                            __LINE__,
-                            ret );
-                    goto GRACEFUL_EXIT_STMNT;
+                    g_ptr_array_add( streams, stream );
+                    g_hash_table_insert( streams_by_guid, &stream->publisher_guid, stream );
                 }
-
-                // copy the decoded bytes into our local buffer,
-                // this is the raw frame is our desired pixel format
-                ret = psync_video_decoder_copy_bytes(
-                        &video_decoder,
-                        decoder_buffer,
-                        decoded_frame_size,
-                        &bytes_decoded );
-
-                // error check
-                if( ret!= DTC_NONE )
+                else
                 {
                     psync_log_message(
                             LOG_LEVEL_ERROR,
-                            "%s : (%u) -- psync_video_decoder_copy_bytes returned DTC %d",
+                            "%s : (%u) -- failed to create stream for publisher GUID 0x%016llX, ignoring it",
                             __FILE__,
                             __LINE__,
-                            ret );
-                    goto GRACEFUL_EXIT_STMNT;
-                }
-
-                // if decoder has data available
-                if( bytes_decoded != 0 )
-                {
-                    // update frame counter
-                    gui->frame_cnt += 1;
-
-                    // get timestamp
-                    ps_timestamp now = 0;
-                    (void) psync_get_timestamp( &now );
-
-                    // get rx FPS
-                    gui->rx_fps = (double) (now - last_rx_time) / 1000000.0;
-                    gui->rx_fps = 1.0 / gui->rx_fps;
-
-                    // update last timestamp
-                    last_rx_time = now;
+                            (unsigned long long) image_data_msg->header.src_guid );
 
-                    // update texture with new data and we're not in freeze-frame
-                    if( gui->config.freeze_frame == 0 )
-                    {
-                        gui_update_image_data( gui, decoder_buffer, bytes_decoded );
-                    }
-
-                    // reset sleep ticker
-                    sleep_tick = 0;
+                    // don't retry on every message
+                    rejected_guid = g_new( ps_guid, 1 );
+                    (*rejected_guid) = image_data_msg->header.src_guid;
+                    g_hash_table_insert( rejected_guids, rejected_guid, rejected_guid );
                 }
             }
 
-            // free
-            ret = psync_message_free( global_node_ref, &msg );
+            if( stream != NULL )
+            {
+                // worker frees it
+                decode_worker_push( stream->worker, queued );
+            }
+            else
+            {
+                // free
+                image_queue_free_queued( global_node_ref, queued );
+            }
+        }
 
-            // error check
-            if( ret!= DTC_NONE )
+        // show the latest decoded frames
+        for( idx = 0; idx < streams->len; idx++ )
+        {
+            frame_updated = update_stream( gui, msg_queue, (image_stream_s*) g_ptr_array_index( streams, idx ) );
+
+            // reset sleep ticker
+            if( frame_updated != 0 )
             {
-                psync_log_message(
-                        LOG_LEVEL_ERROR,
-                        "%s : (%u) -- psync_message_free returned DTC %d",
-                        __FILE__,
-                        __LINE__,
-                        ret );
-                goto GRACEFUL_EXIT_STMNT;
+                sleep_tick = 0;
             }
         }
 
         // get timestamp
         ret = psync_get_timestamp( &timestamp );
 
+        // publish queue drops as diagnostics
+        if( (timestamp - last_report_time) >= DIAGNOSTICS_INTERVAL )
+        {
+            report_queue_drops( streams, queue_policy );
+            last_report_time = timestamp;
+        }
+
         // update gui
         gui_update( gui, timestamp, &time_to_draw );
 
@@ -571,6 +893,19 @@ int main( int argc, char **argv )
     // unregister listener
     ret = psync_message_unregister_listener( global_node_ref, image_data_msg_type );
 
+    // wait for running mosaic decode passes
+    decode_worker_pool_free( decode_pool );
+
+    // stop decode workers before the GUI, they decode into its pixel buffers
+    for( idx = 0; idx < streams->len; idx++ )
+    {
+        stream = (image_stream_s*) g_ptr_array_index( streams, idx );
+
+        decode_worker_stop( stream->worker );
+
+        free( stream );
+    }
+
     // release GUI
     if( gui != NULL )
     {
@@ -580,21 +915,16 @@ int main( int argc, char **argv )
         gui = NULL;
     }
 
-    // release video decoder
-    ret = psync_video_decoder_release( &video_decoder );
+    g_hash_table_destroy( streams_by_guid );
+    g_hash_table_destroy( rejected_guids );
+    g_ptr_array_free( streams, TRUE );
 
-    // flush queue
-    flush_queue( msg_queue );
+    // free queue and the messages left in it
+    image_queue_free( msg_queue );
 
 	// release core API
     ret = psync_release( &global_node_ref );
 
-    // free decoder buffer
-    if( decoder_buffer != NULL )
-    {
-        free(decoder_buffer);
-    }
-
 
 	return EXIT_SUCCESS;
 }
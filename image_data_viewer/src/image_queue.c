@@ -0,0 +1,653 @@
+/**
+ * @file image_queue.c
+ * @brief Bounded Image Data Message Queue Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+// API headers
+#include "polysync_core.h"
+#include "polysync_message.h"
+
+#include "image_queue.h"
+
+
+
+
+// *****************************************************
+// static global types/macros
+// *****************************************************
+
+/**
+ * @brief H264 NAL unit type of an IDR slice.
+ *
+ */
+#define         H264_NAL_TYPE_IDR           (5)
+
+
+/**
+ * @brief H264 NAL unit type of a sequence parameter set, sent ahead of IDR slices.
+ *
+ */
+#define         H264_NAL_TYPE_SPS           (7)
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+/**
+ * @brief Drop policy names, indexed by \ref image_queue_policy_kind.
+ *
+ */
+static const char * const POLICY_NAMES[ IMAGE_QUEUE_POLICY_COUNT ] =
+{
+    "oldest",
+    "newest",
+    "keyframes"
+};
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Get the statistics of a publisher, creating them if needed.
+ *
+ * Called with the queue lock held.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] publisher_guid Publisher GUID.
+ *
+ * @return A pointer to the statistics, NULL on failure.
+ *
+ */
+static image_queue_stats_s *get_stats( image_queue_s * const queue, const ps_guid publisher_guid );
+
+
+/**
+ * @brief Check if the queue holds a non-keyframe.
+ *
+ * Called with the queue lock held.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ *
+ * @return One if a non-keyframe is queued, zero otherwise.
+ *
+ */
+static unsigned int has_non_keyframe( const image_queue_s * const queue );
+
+
+/**
+ * @brief Remove a message from the ring, keeping the order of the others.
+ *
+ * Called with the queue lock held.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] offset Position of the message from the oldest one.
+ *
+ * @return A pointer to the removed message.
+ *
+ */
+static queued_image_s *remove_at( image_queue_s * const queue, const unsigned long offset );
+
+
+/**
+ * @brief Count a dropped message.
+ *
+ * Called with the queue lock held.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] queued A pointer to \ref queued_image_s which specifies the dropped message.
+ *
+ */
+static void count_drop( image_queue_s * const queue, const queued_image_s * const queued );
+
+
+/**
+ * @brief Flag the message following a dropped message of the same publisher.
+ *
+ * Flags the oldest queued message of the publisher, or the next one pushed if none is queued.
+ * Called with the queue lock held, after the dropped message was removed.
+ *
+ * @param [in] queue A pointer to \ref image_queue_s which specifies the queue.
+ * @param [in] publisher_guid Publisher GUID of the dropped message.
+ * @param [in] offset Position the dropped message had from the oldest one, messages from there on are newer.
+ *
+ */
+static void flag_discontinuity( image_queue_s * const queue, const ps_guid publisher_guid, const unsigned long offset );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static image_queue_stats_s *get_stats( image_queue_s * const queue, const ps_guid publisher_guid )
+{
+    // local vars
+    image_queue_stats_s *stats = NULL;
+
+
+    if( (stats = g_hash_table_lookup( queue->stats, &publisher_guid )) == NULL )
+    {
+        if( (stats = g_try_new0( image_queue_stats_s, 1 )) == NULL )
+        {
+            return NULL;
+        }
+
+        stats->publisher_guid = publisher_guid;
+        g_hash_table_insert( queue->stats, &stats->publisher_guid, stats );
+    }
+
+
+    return stats;
+}
+
+
+//
+static unsigned int has_non_keyframe( const image_queue_s * const queue )
+{
+    // local vars
+    unsigned long idx = 0;
+
+
+    for( idx = 0; idx < queue->count; idx++ )
+    {
+        if( queue->elements[ (queue->head + idx) % queue->capacity ]->keyframe == 0 )
+        {
+            return 1;
+        }
+    }
+
+
+    return 0;
+}
+
+
+//
+static queued_image_s *remove_at( image_queue_s * const queue, const unsigned long offset )
+{
+    // local vars
+    queued_image_s * const queued = queue->elements[ (queue->head + offset) % queue->capacity ];
+    unsigned long idx = 0;
+
+
+    // close the gap, newer messages move towards the head
+    for( idx = offset; (idx + 1) < queue->count; idx++ )
+    {
+        queue->elements[ (queue->head + idx) % queue->capacity ] = queue->elements[ (queue->head + idx + 1) % queue->capacity ];
+    }
+
+    queue->count -= 1;
+
+
+    return queued;
+}
+
+
+//
+static void count_drop( image_queue_s * const queue, const queued_image_s * const queued )
+{
+    // local vars
+    image_queue_stats_s *stats = NULL;
+
+
+    if( (stats = get_stats( queue, ((const ps_image_data_msg*) queued->msg)->header.src_guid )) != NULL )
+    {
+        stats->dropped += 1;
+    }
+}
+
+
+//
+static void flag_discontinuity( image_queue_s * const queue, const ps_guid publisher_guid, const unsigned long offset )
+{
+    // local vars
+    unsigned long idx = 0;
+    queued_image_s *next = NULL;
+    image_queue_stats_s *stats = NULL;
+
+
+    for( idx = offset; idx < queue->count; idx++ )
+    {
+        next = queue->elements[ (queue->head + idx) % queue->capacity ];
+
+        if( ((const ps_image_data_msg*) next->msg)->header.src_guid == publisher_guid )
+        {
+            next->discontinuity = 1;
+            return;
+        }
+    }
+
+    if( (stats = get_stats( queue, publisher_guid )) != NULL )
+    {
+        stats->discontinuity = 1;
+    }
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+unsigned int image_queue_is_keyframe( const ps_image_data_msg * const image_data_msg )
+{
+    if( image_data_msg == NULL )
+    {
+        return 0;
+    }
+
+    // local vars
+    const unsigned char * const data = image_data_msg->data_buffer._buffer;
+    const unsigned long data_len = image_data_msg->data_buffer._length;
+    unsigned long idx = 0;
+    unsigned int nal_type = 0;
+
+
+    // every MJPEG frame stands alone
+    if( image_data_msg->pixel_format != PIXEL_FORMAT_H264 )
+    {
+        return 1;
+    }
+
+    // NAL units follow 0x000001 start codes, four byte codes end in the same three bytes
+    for( idx = 0; (idx + 3) < data_len; idx++ )
+    {
+        if( (data[ idx ] == 0x00) && (data[ idx + 1 ] == 0x00) && (data[ idx + 2 ] == 0x01) )
+        {
+            nal_type = data[ idx + 3 ] & 0x1F;
+
+            if( (nal_type == H264_NAL_TYPE_IDR) || (nal_type == H264_NAL_TYPE_SPS) )
+            {
+                return 1;
+            }
+
+            idx += 3;
+        }
+    }
+
+
+    return 0;
+}
+
+
+//
+int image_queue_get_policy_by_name( const char * const name, image_queue_policy_kind * const policy )
+{
+    if( (name == NULL) || (policy == NULL) )
+    {
+        return 1;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+
+
+    for( idx = 0; idx < IMAGE_QUEUE_POLICY_COUNT; idx++ )
+    {
+        if( strcmp( name, POLICY_NAMES[ idx ] ) == 0 )
+        {
+            (*policy) = (image_queue_policy_kind) idx;
+            return 0;
+        }
+    }
+
+
+    return 1;
+}
+
+
+//
+const char *image_queue_get_policy_name( const image_queue_policy_kind policy )
+{
+    if( policy >= IMAGE_QUEUE_POLICY_COUNT )
+    {
+        return "unknown";
+    }
+
+
+    return POLICY_NAMES[ policy ];
+}
+
+
+//
+image_queue_s *image_queue_new( ps_node_ref node_ref, const unsigned long capacity, const image_queue_policy_kind policy )
+{
+    if( (capacity == 0) || (policy >= IMAGE_QUEUE_POLICY_COUNT) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    image_queue_s *queue = NULL;
+
+
+    // create
+    if( (queue = malloc( sizeof(*queue) )) == NULL )
+    {
+        return NULL;
+    }
+
+    // zero
+    memset( queue, 0, sizeof(*queue) );
+
+    if( (queue->elements = calloc( capacity, sizeof(*queue->elements) )) == NULL )
+    {
+        free( queue );
+        return NULL;
+    }
+
+    queue->node_ref = node_ref;
+    queue->capacity = capacity;
+    queue->policy = policy;
+    queue->stats = g_hash_table_new_full( g_int64_hash, g_int64_equal, NULL, g_free );
+
+    g_mutex_init( &queue->lock );
+    g_cond_init( &queue->cond );
+
+
+    return queue;
+}
+
+
+//
+void image_queue_free( image_queue_s * const queue )
+{
+    if( queue == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    queued_image_s *queued = NULL;
+
+
+    // free messages still queued
+    while( (queued = image_queue_try_pop( queue )) != NULL )
+    {
+        image_queue_free_queued( queue->node_ref, queued );
+    }
+
+    g_hash_table_destroy( queue->stats );
+
+    g_cond_clear( &queue->cond );
+    g_mutex_clear( &queue->lock );
+
+    free( queue->elements );
+
+    free( queue );
+}
+
+
+//
+unsigned int image_queue_reject( image_queue_s * const queue, const ps_guid publisher_guid, const unsigned int keyframe )
+{
+    if( queue == NULL )
+    {
+        return 0;
+    }
+
+    // local vars
+    unsigned int reject = 0;
+    image_queue_stats_s *stats = NULL;
+
+
+    g_mutex_lock( &queue->lock );
+
+    if( queue->count == queue->capacity )
+    {
+        if( queue->policy == IMAGE_QUEUE_DROP_NEWEST )
+        {
+            reject = 1;
+        }
+        else if( (queue->policy == IMAGE_QUEUE_KEEP_KEYFRAMES) && (keyframe == 0) )
+        {
+            reject = 1;
+        }
+    }
+
+    // the next message pushed follows the gap
+    if( (reject != 0) && ((stats = get_stats( queue, publisher_guid )) != NULL) )
+    {
+        stats->pushed += 1;
+        stats->dropped += 1;
+        stats->discontinuity = 1;
+    }
+
+    g_mutex_unlock( &queue->lock );
+
+
+    return reject;
+}
+
+
+//
+void image_queue_push( image_queue_s * const queue, queued_image_s * const queued )
+{
+    if( (queue == NULL) || (queued == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    queued_image_s *dropped = NULL;
+    image_queue_stats_s *stats = NULL;
+    unsigned long idx = 0;
+    const ps_guid publisher_guid = ((const ps_image_data_msg*) queued->msg)->header.src_guid;
+
+
+    g_mutex_lock( &queue->lock );
+
+    if( (stats = get_stats( queue, publisher_guid )) != NULL )
+    {
+        stats->pushed += 1;
+    }
+
+    // make room
+    if( queue->count == queue->capacity )
+    {
+        if( queue->policy == IMAGE_QUEUE_DROP_NEWEST )
+        {
+            dropped = queued;
+        }
+        else if( (queue->policy == IMAGE_QUEUE_KEEP_KEYFRAMES) && (queued->keyframe == 0) )
+        {
+            dropped = queued;
+        }
+        else if( (queue->policy == IMAGE_QUEUE_KEEP_KEYFRAMES) && (has_non_keyframe( queue ) != 0) )
+        {
+            // oldest non-keyframe
+            for( idx = 0; queue->elements[ (queue->head + idx) % queue->capacity ]->keyframe != 0; idx++ )
+            {
+                // find
+            }
+
+            dropped = remove_at( queue, idx );
+        }
+        else
+        {
+            dropped = remove_at( queue, 0 );
+        }
+
+        count_drop( queue, dropped );
+    }
+
+    if( dropped != queued )
+    {
+        // follows a message dropped earlier
+        if( (stats != NULL) && (stats->discontinuity != 0) )
+        {
+            queued->discontinuity = 1;
+            stats->discontinuity = 0;
+        }
+
+        queue->elements[ (queue->head + queue->count) % queue->capacity ] = queued;
+        queue->count += 1;
+
+        g_cond_signal( &queue->cond );
+    }
+
+    // the messages after the dropped one lost what came before it
+    if( dropped == queued )
+    {
+        if( stats != NULL )
+        {
+            stats->discontinuity = 1;
+        }
+    }
+    else if( dropped != NULL )
+    {
+        flag_discontinuity( queue, ((const ps_image_data_msg*) dropped->msg)->header.src_guid, idx );
+    }
+
+    g_mutex_unlock( &queue->lock );
+
+    // free outside the lock
+    image_queue_free_queued( queue->node_ref, dropped );
+}
+
+
+//
+queued_image_s *image_queue_try_pop( image_queue_s * const queue )
+{
+    if( queue == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    queued_image_s *queued = NULL;
+
+
+    g_mutex_lock( &queue->lock );
+
+    if( queue->count > 0 )
+    {
+        queued = queue->elements[ queue->head ];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count -= 1;
+    }
+
+    g_mutex_unlock( &queue->lock );
+
+
+    return queued;
+}
+
+
+//
+queued_image_s *image_queue_timeout_pop( image_queue_s * const queue, const ps_timestamp timeout )
+{
+    if( queue == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    const gint64 end_time = g_get_monotonic_time() + (gint64) timeout;
+    queued_image_s *queued = NULL;
+
+
+    g_mutex_lock( &queue->lock );
+
+    // wait for a message, spurious wake ups go around again
+    while( queue->count == 0 )
+    {
+        if( g_cond_wait_until( &queue->cond, &queue->lock, end_time ) == FALSE )
+        {
+            break;
+        }
+    }
+
+    if( queue->count > 0 )
+    {
+        queued = queue->elements[ queue->head ];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count -= 1;
+    }
+
+    g_mutex_unlock( &queue->lock );
+
+
+    return queued;
+}
+
+
+//
+unsigned long image_queue_length( image_queue_s * const queue )
+{
+    if( queue == NULL )
+    {
+        return 0;
+    }
+
+    // local vars
+    unsigned long count = 0;
+
+
+    g_mutex_lock( &queue->lock );
+    count = queue->count;
+    g_mutex_unlock( &queue->lock );
+
+
+    return count;
+}
+
+
+//
+void image_queue_get_stats( image_queue_s * const queue, const ps_guid publisher_guid, image_queue_stats_s * const stats )
+{
+    if( (queue == NULL) || (stats == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    const image_queue_stats_s *found = NULL;
+
+
+    memset( stats, 0, sizeof(*stats) );
+    stats->publisher_guid = publisher_guid;
+
+    g_mutex_lock( &queue->lock );
+
+    if( (found = g_hash_table_lookup( queue->stats, &publisher_guid )) != NULL )
+    {
+        (*stats) = (*found);
+    }
+
+    g_mutex_unlock( &queue->lock );
+}
+
+
+//
+void image_queue_free_queued( ps_node_ref node_ref, queued_image_s * const queued )
+{
+    if( queued == NULL )
+    {
+        return;
+    }
+
+
+    (void) psync_message_free( node_ref, &queued->msg );
+
+    free( queued );
+}
@@ -75,6 +75,20 @@
 #define         GUI_DEFAULT_MAX_FPS         (33)
 
 
+/**
+ * @brief Number of pixel buffer objects the image data is uploaded from.
+ *
+ */
+#define         GUI_IMAGE_PBO_COUNT         (3)
+
+
+/**
+ * @brief Image data bytes per pixel, RGB.
+ *
+ */
+#define         GUI_IMAGE_BYTES_PER_PIXEL   (3)
+
+
 
 
 /**
@@ -173,6 +187,18 @@ typedef struct
     //
     //
     GLuint                      image_texture; /*!< Image data texture. */
+    //
+    //
+    GLuint                      image_pbos[ GUI_IMAGE_PBO_COUNT ]; /*!< Pixel buffer objects the image data is uploaded from. */
+    //
+    //
+    unsigned int                image_pbo_index; /*!< Index of the last mapped pixel buffer object. */
+    //
+    //
+    unsigned long               image_pbo_size; /*!< Size of the last mapped pixel buffer object. [bytes] */
+    //
+    //
+    unsigned int                image_pbo_mapped; /*!< Non-zero while a pixel buffer object is mapped. */
 } gui_context_s;
 
 
@@ -202,10 +228,47 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
 void gui_release( gui_context_s * const gui );
 
 
-//
+/**
+ * @brief Upload image data from client memory.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] buffer A pointer to unsigned char which specifies the RGB image data.
+ * @param [in] buffer_len Number of bytes in buffer. [bytes]
+ *
+ */
 void gui_update_image_data( gui_context_s * const gui, const unsigned char * buffer, const unsigned long buffer_len );
 
 
+/**
+ * @brief Map the next pixel buffer object for reading and writing.
+ *
+ * The buffer is orphaned and resized first, so the caller gets fresh storage
+ * instead of waiting on a pending upload. It stays mapped across \ref gui_update
+ * until \ref gui_unmap_image_buffer is called. Messages popped into it have their
+ * header read back, so the mapping is readable.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] buffer_size Size to map, the image data may start at an offset. [bytes]
+ *
+ * @return A pointer to the mapped buffer on success, NULL on failure or if a buffer is already mapped.
+ *
+ */
+unsigned char *gui_map_image_buffer( gui_context_s * const gui, const unsigned long buffer_size );
+
+
+/**
+ * @brief Unmap the pixel buffer object mapped by \ref gui_map_image_buffer and upload its image data.
+ *
+ * Nothing is uploaded if the data is shorter than a full RGB frame.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] data_offset Offset of the RGB image data in the buffer. [bytes]
+ * @param [in] data_len Number of image data bytes written, zero to discard. [bytes]
+ *
+ */
+void gui_unmap_image_buffer( gui_context_s * const gui, const unsigned long data_offset, const unsigned long data_len );
+
+
 /**
  * @brief Update GUI and possibly redraw.
  *
@@ -0,0 +1,125 @@
+/**
+ * @file shdmem_wait.h
+ * @brief Shared Memory Queue Timed Pop Interface.
+ *
+ * The shared memory queue only offers a non-blocking pop and no notification
+ * from the producer. A waiter learns the producer's message interval and sleeps
+ * until shortly before the next message is due, backing off exponentially while
+ * nothing arrives, so an idle reader stays off the CPU.
+ *
+ */
+
+
+
+
+#ifndef SHDMEM_WAIT_H
+#define	SHDMEM_WAIT_H
+
+
+
+
+#include "polysync_core.h"
+#include "polysync_shdmem.h"
+
+
+
+
+/**
+ * @brief Shortest sleep between pop attempts. [microseconds]
+ *
+ */
+#define     SHDMEM_WAIT_MIN_SLEEP           (50ULL)
+
+
+/**
+ * @brief Default longest sleep between pop attempts. [microseconds]
+ *
+ */
+#define     SHDMEM_WAIT_DEFAULT_MAX_SLEEP   (2000ULL)
+
+
+/**
+ * @brief How long before the predicted next message the waiter starts polling. [microseconds]
+ *
+ */
+#define     SHDMEM_WAIT_EARLY_WAKE          (500ULL)
+
+
+/**
+ * @brief Longest message interval that is learned, longer gaps are treated as a stalled producer. [microseconds]
+ *
+ */
+#define     SHDMEM_WAIT_MAX_INTERVAL        (1000000ULL)
+
+
+/**
+ * @brief Weight of the newest sample in the filtered message interval.
+ *
+ */
+#define     SHDMEM_WAIT_INTERVAL_FILTER     (0.1)
+
+
+
+
+/**
+ * @brief Shared memory queue waiter.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    psync_shdmem_queue          *queue; /*!< Shared memory queue to pop from. */
+    //
+    //
+    ps_timestamp                max_sleep; /*!< Longest sleep between pop attempts. [microseconds] */
+    //
+    //
+    ps_timestamp                last_pop_time; /*!< Monotonic time of the last message, zero if none. [microseconds] */
+    //
+    //
+    double                      interval; /*!< Filtered interval between messages, zero if unknown. [microseconds] */
+    //
+    //
+    unsigned long long          polls; /*!< Number of pop attempts. */
+    //
+    //
+    unsigned long long          messages; /*!< Number of messages popped. */
+} shdmem_wait_s;
+
+
+
+
+/**
+ * @brief Initialize a waiter.
+ *
+ * @param [out] wait A pointer to \ref shdmem_wait_s which receives the waiter.
+ * @param [in] queue A pointer to psync_shdmem_queue which specifies the attached queue.
+ * @param [in] max_sleep Longest sleep between pop attempts, bounds the wake-up delay when no interval is known. [microseconds]
+ *
+ */
+void shdmem_wait_init( shdmem_wait_s * const wait, psync_shdmem_queue * const queue, const ps_timestamp max_sleep );
+
+
+/**
+ * @brief Pop a message, waiting for one up to a timeout.
+ *
+ * @param [in] wait A pointer to \ref shdmem_wait_s which specifies the waiter.
+ * @param [out] buffer A pointer to unsigned char which receives the message.
+ * @param [in] buffer_size Size of buffer. [bytes]
+ * @param [in] timeout Maximum time to wait, zero tries once. [microseconds]
+ *
+ * @return DTC_NONE if a message was popped, DTC_UNAVAILABLE on timeout,
+ * otherwise the DTC returned by psync_shdmem_queue_try_pop.
+ *
+ */
+int shdmem_wait_timed_pop(
+        shdmem_wait_s * const wait,
+        unsigned char * const buffer,
+        const unsigned long buffer_size,
+        const ps_timestamp timeout );
+
+
+
+
+#endif	/* SHDMEM_WAIT_H */
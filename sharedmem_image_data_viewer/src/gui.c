@@ -149,6 +149,17 @@ static void on_resize( int w, int h );
 static void on_draw( void );
 
 
+/**
+ * @brief Upload image data to the texture.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] data A pointer to the RGB image data, or an offset into the bound pixel unpack buffer.
+ * @param [in] data_offset Offset of the image data, used to pick the unpack alignment. [bytes]
+ *
+ */
+static void upload_image( const gui_context_s * const gui, const GLvoid * const data, const unsigned long data_offset );
+
+
 
 
 // *****************************************************
@@ -540,6 +551,37 @@ static void on_draw( void )
 }
 
 
+//
+static void upload_image( const gui_context_s * const gui, const GLvoid * const data, const unsigned long data_offset )
+{
+    // local vars
+    const unsigned long row_size = gui->image_width * GUI_IMAGE_BYTES_PER_PIXEL;
+
+
+    // bind the image data texture
+    glBindTexture( GL_TEXTURE_2D, gui->image_texture );
+
+    // rows are tightly packed
+    glPixelStorei( GL_UNPACK_ALIGNMENT, (((row_size % 4) == 0) && ((data_offset % 4) == 0)) ? 4 : 1 );
+
+    // update texture data
+    glTexSubImage2D(
+            GL_TEXTURE_2D,      // target
+            0,                  // level of detail
+            0,                  // x offset
+            0,                  // y offset
+            gui->image_width,   // width
+            gui->image_height,  // height
+            GL_RGB,             // format
+            GL_UNSIGNED_BYTE,   // type
+            data                // data
+    );
+
+    // unbind
+    glBindTexture( GL_TEXTURE_2D, 0 );
+}
+
+
 
 
 // *****************************************************
@@ -672,6 +714,9 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     // unbind
     glBindTexture( GL_TEXTURE_2D, 0 );
 
+    // create pixel buffer objects, storage is allocated when mapped
+    glGenBuffers( GUI_IMAGE_PBO_COUNT, gui->image_pbos );
+
     // set global reference
     global_gui_context = gui;
 
@@ -698,6 +743,18 @@ void gui_release( gui_context_s * const gui )
     // update global reference
     global_gui_context = gui;
 
+    // release a mapping still held
+    if( gui->image_pbo_mapped != 0 )
+    {
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, gui->image_pbos[ gui->image_pbo_index ] );
+        (void) glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+        gui->image_pbo_mapped = 0;
+    }
+
+    // destroy pixel buffer objects
+    glDeleteBuffers( GUI_IMAGE_PBO_COUNT, gui->image_pbos );
+
     // destroy texture
     glDeleteTextures( 1, &gui->image_texture );
 
@@ -721,24 +778,89 @@ void gui_update_image_data( gui_context_s * const gui, const unsigned char * buf
     // update global reference
     global_gui_context = gui;
 
-    // bind the image data texture
-    glBindTexture( GL_TEXTURE_2D, gui->image_texture );
+    // ignore partial frames
+    if( buffer_len < (gui->image_width * gui->image_height * GUI_IMAGE_BYTES_PER_PIXEL) )
+    {
+        return;
+    }
 
-    // update texture data
-    glTexSubImage2D(
-            GL_TEXTURE_2D,      // target
-            0,                  // level of detail
-            0,                  // x offset
-            0,                  // y offset
-            gui->image_width,   // width
-            gui->image_height,  // height
-            GL_RGB,             // format
-            GL_UNSIGNED_BYTE,   // type
-            buffer              // data
-    );
+    upload_image( gui, buffer, 0 );
+}
+
+
+//
+unsigned char *gui_map_image_buffer( gui_context_s * const gui, const unsigned long buffer_size )
+{
+    if( (gui == NULL) || (buffer_size == 0) || (gui->image_pbo_mapped != 0) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    const unsigned int index = (gui->image_pbo_index + 1) % GUI_IMAGE_PBO_COUNT;
+    unsigned char *buffer = NULL;
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, gui->image_pbos[ index ] );
+
+    // orphan, the driver hands back fresh storage instead of waiting on a pending upload
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) buffer_size, NULL, GL_STREAM_DRAW );
+
+    // the caller reads the message header and fields back, reading a write-only mapping is undefined
+    buffer = (unsigned char*) glMapBuffer( GL_PIXEL_UNPACK_BUFFER, GL_READ_WRITE );
 
     // unbind
-    glBindTexture( GL_TEXTURE_2D, 0 );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    if( buffer == NULL )
+    {
+        return NULL;
+    }
+
+    gui->image_pbo_index = index;
+    gui->image_pbo_size = buffer_size;
+    gui->image_pbo_mapped = 1;
+
+
+    return buffer;
+}
+
+
+//
+void gui_unmap_image_buffer( gui_context_s * const gui, const unsigned long data_offset, const unsigned long data_len )
+{
+    if( (gui == NULL) || (gui->image_pbo_mapped == 0) )
+    {
+        return;
+    }
+
+    // local vars
+    const unsigned long frame_size = gui->image_width * gui->image_height * GUI_IMAGE_BYTES_PER_PIXEL;
+    GLboolean valid = GL_FALSE;
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, gui->image_pbos[ gui->image_pbo_index ] );
+
+    // contents are undefined if the mapping was lost
+    valid = glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+    gui->image_pbo_mapped = 0;
+
+    // texture update from the pixel buffer returns without waiting on the copy
+    if( (valid == GL_TRUE)
+            && (data_len >= frame_size)
+            && ((data_offset + frame_size) <= gui->image_pbo_size) )
+    {
+        upload_image( gui, (const GLvoid*) data_offset, data_offset );
+    }
+
+    // unbind
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
 }
 
 
@@ -53,6 +53,8 @@
 // GUI headers
 #include "gui.h"
 
+#include "shdmem_wait.h"
+
 
 
 
@@ -82,6 +84,27 @@ static sig_atomic_t global_exit_signal = 0;
 static const char NODE_NAME[] = "polysync-sharedmem-image-data-viewer";
 
 
+/**
+ * @brief Size of the buffer used to find the producer, before its image dimensions are known. [bytes]
+ *
+ */
+static const unsigned long DISCOVERY_BUFFER_SIZE = (1980 * 1400 * 4);
+
+
+/**
+ * @brief Longest sleep between pop attempts while waiting for a producer. [microseconds]
+ *
+ */
+static const ps_timestamp DISCOVERY_MAX_SLEEP = 20000ULL;
+
+
+/**
+ * @brief Longest wait for a producer before checking for exit. [microseconds]
+ *
+ */
+static const ps_timestamp DISCOVERY_TIMEOUT = 100000ULL;
+
+
 
 
 // *****************************************************
@@ -133,6 +156,9 @@ int main( int argc, char **argv )
     // shared memory queue
     psync_shdmem_queue shdmem_queue = PSYNC_SHDMEM_QUEUE_INVALID;
 
+    // shared memory queue waiter
+    shdmem_wait_s shdmem_wait;
+
     // desired decoder output pixel format, RGB
     ps_pixel_format_kind desired_decoder_format = PIXEL_FORMAT_RGB24;
 
@@ -161,6 +187,21 @@ int main( int argc, char **argv )
     // size in bytes of the shared memory buffer
     unsigned long shdmem_buffer_size = 0;
 
+    // size in bytes of a raw frame message, and of the mapped pixel buffer object it is popped into
+    unsigned long frame_msg_size = 0;
+
+    // buffer the current message is popped into, either the shared memory buffer or a mapped pixel buffer object
+    unsigned char *msg_buffer = NULL;
+
+    // mapped GUI pixel buffer object, NULL if none
+    unsigned char *pbo_buffer = NULL;
+
+    // raw frame to upload
+    unsigned char *frame_buffer = NULL;
+
+    // offset of the raw frame in the mapped pixel buffer object
+    unsigned long frame_offset = 0;
+
     // shared memory key
     unsigned long shdmem_key = 0;
 
@@ -170,15 +211,13 @@ int main( int argc, char **argv )
     // time to redraw
     ps_timestamp time_to_draw = 0;
 
-    // sleep counter
-    unsigned long sleep_tick = 0;
-
     // last image rx/decoded timestamp
     ps_timestamp last_rx_time = 0;
 
 
     // zero
     memset( &video_decoder, 0, sizeof(video_decoder) );
+    memset( &shdmem_wait, 0, sizeof(shdmem_wait) );
 
     // check for shared memory key argument
     if( (argc < 2) || (strlen(argv[1]) <= 0) )
@@ -237,10 +276,10 @@ int main( int argc, char **argv )
         goto GRACEFUL_EXIT_STMNT;
     }
 
-    // arbitrary large size
-    shdmem_buffer_size = (1980 * 1400 * 4);
+    // the producer's image dimensions aren't known yet, use an arbitrary large size to find it
+    shdmem_buffer_size = DISCOVERY_BUFFER_SIZE;
 
-    // allocate shared memory buffer, enough space for a full raw frame
+    // allocate discovery buffer
     if( (shdmem_buffer = malloc( shdmem_buffer_size )) == NULL )
     {
         psync_log_message(
@@ -256,11 +295,14 @@ int main( int argc, char **argv )
             shdmem_key,
             shdmem_key );
 
+    // no producer yet, poll slowly
+    shdmem_wait_init( &shdmem_wait, &shdmem_queue, DISCOVERY_MAX_SLEEP );
+
     // while we haven't seen a valid image data message
     while( publisher_format == PIXEL_FORMAT_INVALID )
     {
-        // check for data
-        if( psync_shdmem_queue_try_pop( &shdmem_queue, shdmem_buffer, shdmem_buffer_size ) == DTC_NONE )
+        // wait for data
+        if( shdmem_wait_timed_pop( &shdmem_wait, shdmem_buffer, shdmem_buffer_size, DISCOVERY_TIMEOUT ) == DTC_NONE )
         {
             // cast header
             ps_shdmem_message_header * const header =
@@ -343,8 +385,35 @@ int main( int argc, char **argv )
         }
     }
 
+    // a raw frame message of the producer's image dimensions, what a pixel buffer object is mapped for
+    frame_msg_size = sizeof(ps_shdmem_message_header)
+            + sizeof(ps_shdmem_image_data_msg)
+            + (publisher_width * publisher_height * GUI_IMAGE_BYTES_PER_PIXEL);
+
+    // the discovery-sized buffer is kept as the fallback for encoded frames, unmapped pixel buffer objects
+    // and messages that don't fit a pixel buffer object, like a producer restarted at a larger size,
+    // those are popped into it and ignored, only messages larger than it stop the loop
+    if( frame_msg_size > shdmem_buffer_size )
+    {
+        // release discovery buffer
+        free( shdmem_buffer );
+
+        shdmem_buffer_size = frame_msg_size;
+
+        if( (shdmem_buffer = malloc( shdmem_buffer_size )) == NULL )
+        {
+            psync_log_message(
+                    LOG_LEVEL_ERROR,
+                    "%s : (%u) -- failed to allocate shared memory frame buffer - size %lu bytes",
+                    __FILE__,
+                    __LINE__,
+                    shdmem_buffer_size );
+            goto GRACEFUL_EXIT_STMNT;
+        }
+    }
+
     // set the decoded frame size, RGB
-    decoded_frame_size = (publisher_width * publisher_height * 3);
+    decoded_frame_size = (publisher_width * publisher_height * GUI_IMAGE_BYTES_PER_PIXEL);
 
     // allocate decoder buffer, enough space for a full raw frame in the desired pixel format which is RGB in this example
     if( (decoder_buffer = malloc( decoded_frame_size )) == NULL )
@@ -372,6 +441,9 @@ int main( int argc, char **argv )
     // enabled help
     gui->config.help_visible = 1;
 
+    // producer found, the waiter learns its message interval from here on
+    shdmem_wait_init( &shdmem_wait, &shdmem_queue, SHDMEM_WAIT_DEFAULT_MAX_SLEEP );
+
 
     // main event loop
     // loop until signaled (control-c)
@@ -380,27 +452,52 @@ int main( int argc, char **argv )
         // zero
         bytes_decoded = 0;
 
-        // pointer to the default image buffer
-        const unsigned char * buffer_ptr = decoder_buffer;
+        // raw frames are popped straight into a pixel buffer object, which stays mapped until a frame is uploaded
+        if( (publisher_format == PIXEL_FORMAT_RGB24)
+                && (pbo_buffer == NULL)
+                && (gui->config.freeze_frame == 0) )
+        {
+            pbo_buffer = gui_map_image_buffer( gui, frame_msg_size );
+        }
+
+        // fall back to the shared memory buffer
+        msg_buffer = (pbo_buffer != NULL) ? pbo_buffer : shdmem_buffer;
+
+        // wait for data until the next redraw is due
+        ret = shdmem_wait_timed_pop(
+                &shdmem_wait,
+                msg_buffer,
+                (pbo_buffer != NULL) ? frame_msg_size : shdmem_buffer_size,
+                time_to_draw );
+
+        // message doesn't fit the pixel buffer object, pop it into the shared memory buffer instead
+        if( (ret != DTC_NONE) && (ret != DTC_UNAVAILABLE) && (pbo_buffer != NULL) )
+        {
+            // discard
+            gui_unmap_image_buffer( gui, 0, 0 );
+            pbo_buffer = NULL;
 
-        // check for data
-        ret = psync_shdmem_queue_try_pop( &shdmem_queue, shdmem_buffer, shdmem_buffer_size );
+            msg_buffer = shdmem_buffer;
+            ret = shdmem_wait_timed_pop( &shdmem_wait, msg_buffer, shdmem_buffer_size, 0 );
+        }
 
 		if( ret == DTC_NONE )
         {
             // cast header
             ps_shdmem_message_header * const header =
-                    (ps_shdmem_message_header*) &shdmem_buffer[ 0 ];
+                    (ps_shdmem_message_header*) &msg_buffer[ 0 ];
 
             // cast message
             ps_shdmem_image_data_msg * const message =
-                    (ps_shdmem_image_data_msg*) &shdmem_buffer[ sizeof(*header) ];
+                    (ps_shdmem_image_data_msg*) &msg_buffer[ sizeof(*header) ];
 
             // check for supported image data message type
             if( header->msg_type == PSYNC_SHDMEM_MSG_TYPE_IMAGE_DATA )
             {
-                // check if publisher is what we've initialized to using its and pixel format
-                if( message->pixel_format == publisher_format )
+                // check if publisher is what we've initialized to using its pixel format and dimensions, buffers are sized from them
+                if( (message->pixel_format == publisher_format)
+                        && ((unsigned long) message->width == publisher_width)
+                        && ((unsigned long) message->height == publisher_height) )
                 {
                     // if receiving an encoded pixel format
                     if( publisher_format != PIXEL_FORMAT_RGB24 )
@@ -409,7 +506,7 @@ int main( int argc, char **argv )
                         ret = psync_video_decoder_decode(
                                 &video_decoder,
                                 message->timestamp,
-                                &shdmem_buffer[ sizeof(*header) + sizeof(*message) ],
+                                &msg_buffer[ sizeof(*header) + sizeof(*message) ],
                                 message->data_size );
 
                         // error check
@@ -424,10 +521,20 @@ int main( int argc, char **argv )
                             goto GRACEFUL_EXIT_STMNT;
                         }
 
-                        // copy the decoded bytes into our local buffer, this is the raw frame is our desired pixel format
+                        // decode straight into a pixel buffer object unless in freeze-frame
+                        if( gui->config.freeze_frame == 0 )
+                        {
+                            pbo_buffer = gui_map_image_buffer( gui, decoded_frame_size );
+                        }
+
+                        // fall back to the local buffer
+                        frame_buffer = (pbo_buffer != NULL) ? pbo_buffer : decoder_buffer;
+                        frame_offset = 0;
+
+                        // copy the decoded bytes, this is the raw frame is our desired pixel format
                         ret = psync_video_decoder_copy_bytes(
                                 &video_decoder,
-                                decoder_buffer,
+                                frame_buffer,
                                 decoded_frame_size,
                                 &bytes_decoded );
 
@@ -446,7 +553,8 @@ int main( int argc, char **argv )
                     else
                     {
                         // point buffer to the raw image data, no decoding needed
-                        buffer_ptr = &shdmem_buffer[ sizeof(*header) + sizeof(*message) ];
+                        frame_offset = sizeof(*header) + sizeof(*message);
+                        frame_buffer = &msg_buffer[ frame_offset ];
                         bytes_decoded = (unsigned long) message->data_size;
                     }
 
@@ -478,11 +586,17 @@ int main( int argc, char **argv )
                         // update texture with new data and we're not in freeze-frame
                         if( gui->config.freeze_frame == 0 )
                         {
-                            gui_update_image_data( gui, buffer_ptr, bytes_decoded );
+                            if( pbo_buffer != NULL )
+                            {
+                                // frame is already in the pixel buffer object
+                                gui_unmap_image_buffer( gui, frame_offset, bytes_decoded );
+                                pbo_buffer = NULL;
+                            }
+                            else
+                            {
+                                gui_update_image_data( gui, frame_buffer, bytes_decoded );
+                            }
                         }
-
-                        // reset sleep ticker
-                        sleep_tick = 0;
                     }
                 }
             }
@@ -492,31 +606,19 @@ int main( int argc, char **argv )
             global_exit_signal = 1;
         }
 
+        // decoded frames don't keep a pixel buffer object mapped
+        if( (publisher_format != PIXEL_FORMAT_RGB24) && (pbo_buffer != NULL) )
+        {
+            // discard
+            gui_unmap_image_buffer( gui, 0, 0 );
+            pbo_buffer = NULL;
+        }
+
         // get timestamp
         ret = psync_get_timestamp( &timestamp );
 
         // update gui
         gui_update( gui, timestamp, &time_to_draw );
-
-        // disable sleep ticker if redraw time is less than 5 ms
-        if( time_to_draw < 5000 )
-        {
-            // reset ticker
-            sleep_tick = 0;
-        }
-
-        // check sleep ticker
-        if( sleep_tick >= 10 )
-        {
-            // sleep ~1 ms
-            usleep( 1000 );
-
-            // reset to enabled
-            sleep_tick = 10;
-        }
-
-        // increment sleep ticker
-        sleep_tick++;
     }
 
 
@@ -524,7 +626,7 @@ int main( int argc, char **argv )
     GRACEFUL_EXIT_STMNT:
     global_exit_signal = 1;
 
-    // release GUI
+    // release GUI, unmaps a pixel buffer object still mapped
     if( gui != NULL )
     {
         // free GUI
@@ -0,0 +1,184 @@
+/**
+ * @file shdmem_wait.c
+ * @brief Shared Memory Queue Timed Pop Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib-2.0/glib.h>
+
+// API headers
+#include "polysync_core.h"
+#include "polysync_shdmem.h"
+
+#include "shdmem_wait.h"
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Update the filtered message interval with a popped message.
+ *
+ * @param [in] wait A pointer to \ref shdmem_wait_s which specifies the waiter.
+ * @param [in] pop_time Monotonic time of the message. [microseconds]
+ *
+ */
+static void update_interval( shdmem_wait_s * const wait, const ps_timestamp pop_time );
+
+
+/**
+ * @brief Get the time to sleep before the next pop attempt.
+ *
+ * Sleeps until shortly before the next message is due if the interval is known,
+ * otherwise, or once it is overdue, backs off exponentially.
+ *
+ * @param [in] wait A pointer to \ref shdmem_wait_s which specifies the waiter.
+ * @param [in] now Current monotonic time. [microseconds]
+ * @param [in,out] backoff A pointer to \ref ps_timestamp which specifies the backoff sleep, doubled when used. [microseconds]
+ *
+ * @return Time to sleep. [microseconds]
+ *
+ */
+static ps_timestamp get_sleep_time( const shdmem_wait_s * const wait, const ps_timestamp now, ps_timestamp * const backoff );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static void update_interval( shdmem_wait_s * const wait, const ps_timestamp pop_time )
+{
+    // local vars
+    const ps_timestamp interval = pop_time - wait->last_pop_time;
+
+
+    // gaps after a stall or the first message say nothing about the producer rate
+    if( (wait->last_pop_time != 0) && (interval <= SHDMEM_WAIT_MAX_INTERVAL) )
+    {
+        if( wait->interval == 0.0 )
+        {
+            wait->interval = (double) interval;
+        }
+        else
+        {
+            wait->interval += SHDMEM_WAIT_INTERVAL_FILTER * ((double) interval - wait->interval);
+        }
+    }
+
+    wait->last_pop_time = pop_time;
+    wait->messages += 1;
+}
+
+
+//
+static ps_timestamp get_sleep_time( const shdmem_wait_s * const wait, const ps_timestamp now, ps_timestamp * const backoff )
+{
+    // local vars
+    ps_timestamp sleep_time = (*backoff);
+    ps_timestamp expected_time = 0;
+
+
+    if( wait->interval > 0.0 )
+    {
+        expected_time = wait->last_pop_time + (ps_timestamp) wait->interval;
+
+        // sleep through most of the interval in one go
+        if( expected_time > (now + SHDMEM_WAIT_EARLY_WAKE + sleep_time) )
+        {
+            return expected_time - SHDMEM_WAIT_EARLY_WAKE - now;
+        }
+    }
+
+    // poll at increasing intervals
+    (*backoff) = MIN( (*backoff) * 2, wait->max_sleep );
+
+
+    return sleep_time;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+void shdmem_wait_init( shdmem_wait_s * const wait, psync_shdmem_queue * const queue, const ps_timestamp max_sleep )
+{
+    if( (wait == NULL) || (queue == NULL) )
+    {
+        return;
+    }
+
+
+    // zero
+    memset( wait, 0, sizeof(*wait) );
+
+    wait->queue = queue;
+    wait->max_sleep = MAX( max_sleep, SHDMEM_WAIT_MIN_SLEEP );
+}
+
+
+//
+int shdmem_wait_timed_pop(
+        shdmem_wait_s * const wait,
+        unsigned char * const buffer,
+        const unsigned long buffer_size,
+        const ps_timestamp timeout )
+{
+    if( (wait == NULL) || (buffer == NULL) )
+    {
+        return DTC_USAGE;
+    }
+
+    // local vars
+    int ret = DTC_NONE;
+    const ps_timestamp deadline = (ps_timestamp) g_get_monotonic_time() + timeout;
+    ps_timestamp now = 0;
+    ps_timestamp backoff = SHDMEM_WAIT_MIN_SLEEP;
+
+
+    while( 1 )
+    {
+        wait->polls += 1;
+
+        ret = psync_shdmem_queue_try_pop( wait->queue, buffer, buffer_size );
+
+        now = (ps_timestamp) g_get_monotonic_time();
+
+        if( ret != DTC_UNAVAILABLE )
+        {
+            if( ret == DTC_NONE )
+            {
+                update_interval( wait, now );
+            }
+
+            return ret;
+        }
+
+        if( now >= deadline )
+        {
+            return DTC_UNAVAILABLE;
+        }
+
+        // a signal cuts the sleep short, the caller checks for exit on return
+        if( usleep( (useconds_t) MIN( get_sleep_time( wait, now, &backoff ), deadline - now ) ) != 0 )
+        {
+            return DTC_UNAVAILABLE;
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * @file byte_arena.h
+ * @brief Growable Byte Arena Interface.
+ *
+ * Variable sized slices carved one after the other out of large blocks, for
+ * data whose size is only known once it has been written, like encoder output.
+ * A slice is reserved at the largest size it could have, written, then
+ * committed at its actual size, so the arena grows with the data actually
+ * produced rather than the worst case. Blocks are reference counted by their
+ * slices and recycled once all of them are released. One thread reserves and
+ * commits, any thread may release.
+ *
+ */
+
+
+
+
+#ifndef BYTE_ARENA_H
+#define	BYTE_ARENA_H
+
+
+
+
+#include <glib-2.0/glib.h>
+
+
+
+
+/**
+ * @brief Arena block.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    void                    *arena; /*!< Arena the block belongs to, \ref byte_arena_s. */
+    //
+    //
+    unsigned char           *data; /*!< Block storage. */
+    //
+    //
+    unsigned long           size; /*!< Size of data. [bytes] */
+    //
+    //
+    unsigned long           used; /*!< Number of bytes committed, producer only. [bytes] */
+    //
+    //
+    volatile gint           refs; /*!< One per committed slice, plus one while the block is being filled. */
+} byte_arena_block_s;
+
+
+/**
+ * @brief Growable byte arena.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    byte_arena_block_s      *current; /*!< Block being filled, NULL if none. Producer only. */
+    //
+    //
+    unsigned long           block_slices; /*!< Number of largest slices a new block has room for, on top of the reservation. */
+    //
+    //
+    unsigned long           largest_slice; /*!< Largest committed slice. Producer only. [bytes] */
+    //
+    //
+    GPtrArray               *spare_blocks; /*!< Released blocks kept for reuse. */
+    //
+    //
+    unsigned long           allocated_bytes; /*!< Size of all allocated blocks. [bytes] */
+    //
+    //
+    unsigned long           peak_bytes; /*!< Largest value of allocated_bytes. [bytes] */
+    //
+    //
+    unsigned long long      block_allocations; /*!< Number of blocks allocated. */
+    //
+    //
+    GMutex                  lock; /*!< Protects spare_blocks, allocated_bytes, peak_bytes and block_allocations. */
+} byte_arena_s;
+
+
+
+
+/**
+ * @brief Create an arena.
+ *
+ * No memory is allocated for slices until the first reservation.
+ *
+ * @param [in] block_slices Number of largest slices a new block has room for, on top of the reservation.
+ *
+ * @return A newly created arena on success, NULL on failure.
+ *
+ */
+byte_arena_s *byte_arena_new( const unsigned long block_slices );
+
+
+/**
+ * @brief Free an arena.
+ *
+ * All slices must have been released.
+ *
+ * @param [in] arena A pointer to \ref byte_arena_s which specifies the arena to free. NULL is acceptable.
+ *
+ */
+void byte_arena_free( byte_arena_s * const arena );
+
+
+/**
+ * @brief Reserve contiguous space for the next slice.
+ *
+ * Starts a new block if the current one does not have room. Producer only.
+ *
+ * @param [in] arena A pointer to \ref byte_arena_s which specifies the arena.
+ * @param [in] size Largest size the slice can have. [bytes]
+ *
+ * @return A pointer to the reserved space, NULL if a block could not be allocated.
+ *
+ */
+unsigned char *byte_arena_reserve( byte_arena_s * const arena, const unsigned long size );
+
+
+/**
+ * @brief Keep the first bytes of the last reservation as a slice.
+ *
+ * Producer only.
+ *
+ * @param [in] arena A pointer to \ref byte_arena_s which specifies the arena.
+ * @param [in] len Size of the slice, at most the reserved size. [bytes]
+ *
+ * @return A pointer to the block holding the slice, with a reference for the slice.
+ *
+ */
+byte_arena_block_s *byte_arena_commit( byte_arena_s * const arena, const unsigned long len );
+
+
+/**
+ * @brief Release a slice, recycles its block once all of its slices are released.
+ *
+ * @param [in] block A pointer to \ref byte_arena_block_s which specifies the block holding the slice. NULL is acceptable.
+ *
+ */
+void byte_arena_release( byte_arena_block_s * const block );
+
+
+/**
+ * @brief Get the largest amount of memory the arena has held.
+ *
+ * @param [in] arena A pointer to \ref byte_arena_s which specifies the arena.
+ *
+ * @return Peak allocated size. [bytes]
+ *
+ */
+unsigned long byte_arena_get_peak_bytes( byte_arena_s * const arena );
+
+
+
+
+#endif	/* BYTE_ARENA_H */
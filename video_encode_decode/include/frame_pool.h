@@ -0,0 +1,168 @@
+/**
+ * @file frame_pool.h
+ * @brief Video Frame Buffer Pool Interface.
+ *
+ * A fixed set of equally sized frame buffers, allocated once and recycled
+ * between the pipeline stages instead of allocating per frame. Frames are
+ * reference counted, so one frame can be read by several stages at once and
+ * returns to its pool when the last of them releases it. A pool can also hold
+ * frames without buffers, whose data is attached from a \ref byte_arena_s.
+ *
+ */
+
+
+
+
+#ifndef FRAME_POOL_H
+#define	FRAME_POOL_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+#include "byte_arena.h"
+
+
+
+
+/**
+ * @brief Video frame.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    void                    *pool; /*!< Pool the frame belongs to, \ref frame_pool_s. */
+    //
+    //
+    volatile gint           refs; /*!< Number of references, the frame is read-only while more than one. */
+    //
+    //
+    unsigned char           *buffer; /*!< Frame data. */
+    //
+    //
+    byte_arena_block_s      *arena_block; /*!< Arena block holding buffer, released with the frame. NULL if the pool owns buffer. */
+    //
+    //
+    unsigned long           size; /*!< Size of buffer. [bytes] */
+    //
+    //
+    unsigned long           len; /*!< Number of valid bytes in buffer. [bytes] */
+    //
+    //
+    unsigned long long      frame_id; /*!< Frame counter value of the captured frame. */
+    //
+    //
+    ps_timestamp            rx_timestamp; /*!< Video device receive timestamp. [microseconds] */
+    //
+    //
+    unsigned long           source_len; /*!< Size of the raw frame this frame was encoded from, zero if raw. [bytes] */
+    //
+    //
+    ps_timestamp            capture_time; /*!< Monotonic time the frame was returned by the video device. [microseconds] */
+    //
+    //
+    ps_timestamp            queued_time; /*!< Monotonic time the raw frame was queued for encoding. [microseconds] */
+    //
+    //
+    ps_timestamp            encode_start_time; /*!< Monotonic time encoding started. [microseconds] */
+    //
+    //
+    ps_timestamp            encoded_time; /*!< Monotonic time encoding was done. [microseconds] */
+    //
+    //
+    ps_timestamp            decode_start_time; /*!< Monotonic time decoding started. [microseconds] */
+    //
+    //
+    ps_timestamp            decoded_time; /*!< Monotonic time decoding was done. [microseconds] */
+} video_frame_s;
+
+
+/**
+ * @brief Video frame buffer pool.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    video_frame_s           *frames; /*!< Frame storage. */
+    //
+    //
+    unsigned long           count; /*!< Number of frames. */
+    //
+    //
+    unsigned long           buffer_size; /*!< Size of each frame buffer, zero if the data comes from an arena. [bytes] */
+    //
+    //
+    GPtrArray               *available; /*!< Frames not in use. */
+    //
+    //
+    unsigned long long      exhausted; /*!< Number of times a frame was requested while none were available. */
+    //
+    //
+    GMutex                  lock; /*!< Protects available and exhausted. */
+} frame_pool_s;
+
+
+
+
+/**
+ * @brief Create a frame pool.
+ *
+ * @param [in] count Number of frames.
+ * @param [in] buffer_size Size of each frame buffer, zero for frames whose data is attached from an arena. [bytes]
+ *
+ * @return A newly created pool on success, NULL on failure.
+ *
+ */
+frame_pool_s *frame_pool_new( const unsigned long count, const unsigned long buffer_size );
+
+
+/**
+ * @brief Free a frame pool.
+ *
+ * All frames must have been released.
+ *
+ * @param [in] pool A pointer to \ref frame_pool_s which specifies the pool to free. NULL is acceptable.
+ *
+ */
+void frame_pool_free( frame_pool_s * const pool );
+
+
+/**
+ * @brief Take a frame from the pool.
+ *
+ * @param [in] pool A pointer to \ref frame_pool_s which specifies the pool.
+ *
+ * @return A pointer to the frame holding one reference, NULL if none are available.
+ *
+ */
+video_frame_s *frame_pool_acquire( frame_pool_s * const pool );
+
+
+/**
+ * @brief Add a reference to a frame.
+ *
+ * @param [in] frame A pointer to \ref video_frame_s which specifies the frame.
+ *
+ */
+void frame_pool_ref( video_frame_s * const frame );
+
+
+/**
+ * @brief Release a reference to a frame, the last one returns it to its pool.
+ *
+ * Data attached from an arena is released with the last reference.
+ *
+ * @param [in] frame A pointer to \ref video_frame_s which specifies the frame. NULL is acceptable.
+ *
+ */
+void frame_pool_release( video_frame_s * const frame );
+
+
+
+
+#endif	/* FRAME_POOL_H */
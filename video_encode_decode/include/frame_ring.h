@@ -0,0 +1,132 @@
+/**
+ * @file frame_ring.h
+ * @brief Single-Producer Single-Consumer Frame Ring Interface.
+ *
+ * A bounded ring of frames handed from one pipeline stage thread to the next.
+ * Pushing and popping are lock-free, a lock is only taken to sleep when the ring
+ * is full or empty, and to wake the other side up.
+ *
+ */
+
+
+
+
+#ifndef FRAME_RING_H
+#define	FRAME_RING_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "frame_pool.h"
+
+
+
+
+/**
+ * @brief Frame ring.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    video_frame_s           **slots; /*!< Frame slots. */
+    //
+    //
+    guint                   mask; /*!< Slot index mask, capacity minus one. */
+    //
+    //
+    volatile gint           head; /*!< Count of frames popped, only written by the consumer. */
+    //
+    //
+    volatile gint           tail; /*!< Count of frames pushed, only written by the producer. */
+    //
+    //
+    volatile gint           waiters; /*!< Number of threads sleeping on cond. */
+    //
+    //
+    volatile gint           closed; /*!< Non-zero once the producer is done. */
+    //
+    //
+    GMutex                  lock; /*!< Taken to sleep and wake up. */
+    //
+    //
+    GCond                   cond; /*!< Signaled when a frame is pushed or popped while a thread sleeps, or when closed. */
+} frame_ring_s;
+
+
+
+
+/**
+ * @brief Create a frame ring.
+ *
+ * @param [in] capacity Minimum number of frames, rounded up to a power of two.
+ *
+ * @return A newly created ring on success, NULL on failure.
+ *
+ */
+frame_ring_s *frame_ring_new( const unsigned long capacity );
+
+
+/**
+ * @brief Free a frame ring.
+ *
+ * Frames still in the ring are released to their pools.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring to free. NULL is acceptable.
+ *
+ */
+void frame_ring_free( frame_ring_s * const ring );
+
+
+/**
+ * @brief Push a frame if there is room. Producer only.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ * @param [in] frame A pointer to \ref video_frame_s which specifies the frame, owned by the ring on success.
+ *
+ * @return Zero on success, one if the ring is full.
+ *
+ */
+int frame_ring_try_push( frame_ring_s * const ring, video_frame_s * const frame );
+
+
+/**
+ * @brief Push a frame, waiting for room. Producer only.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ * @param [in] frame A pointer to \ref video_frame_s which specifies the frame, owned by the ring on success.
+ *
+ * @return Zero on success, one if the ring was closed.
+ *
+ */
+int frame_ring_push( frame_ring_s * const ring, video_frame_s * const frame );
+
+
+/**
+ * @brief Pop a frame, waiting for one. Consumer only.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ *
+ * @return A pointer to the oldest frame, owned by the caller, NULL once the ring is closed and empty.
+ *
+ */
+video_frame_s *frame_ring_pop( frame_ring_s * const ring );
+
+
+/**
+ * @brief Close the ring.
+ *
+ * The consumer drains the frames left and then gets NULL, a producer waiting
+ * for room gives up.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ *
+ */
+void frame_ring_close( frame_ring_s * const ring );
+
+
+
+
+#endif	/* FRAME_RING_H */
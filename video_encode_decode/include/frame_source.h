@@ -0,0 +1,219 @@
+/**
+ * @file frame_source.h
+ * @brief YUYV Frame Source Interface.
+ *
+ * Where the pipeline gets its raw frames from: a video device, a generated
+ * test pattern, or image data replayed from a logfile. The synthetic sources
+ * pace themselves to the requested frame rate, or produce frames as fast as
+ * they are polled when the rate is zero, so the encoder can be benchmarked on
+ * machines without a camera.
+ *
+ */
+
+
+
+
+#ifndef FRAME_SOURCE_H
+#define	FRAME_SOURCE_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+#include "polysync_video.h"
+
+
+
+
+/**
+ * @brief Largest amount of logfile image data loaded for replay. [bytes]
+ *
+ */
+#define     FRAME_SOURCE_MAX_LOGFILE_BYTES      (256UL * 1024UL * 1024UL)
+
+
+
+
+/**
+ * @brief Frame source kind.
+ *
+ */
+typedef enum
+{
+    FRAME_SOURCE_DEVICE = 0, /*!< Video device, like '/dev/video0'. */
+    FRAME_SOURCE_GRADIENT, /*!< Diagonal luma and chroma gradients moving every frame. */
+    FRAME_SOURCE_NOISE, /*!< New uniform noise every frame, the worst case for the encoder. */
+    FRAME_SOURCE_STATIC, /*!< Color bars that never change, the best case for the encoder. */
+    FRAME_SOURCE_LOGFILE, /*!< YUYV image data messages replayed from a logfile, looping. */
+    FRAME_SOURCE_KIND_COUNT
+} frame_source_kind;
+
+
+/**
+ * @brief Frame source.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    frame_source_kind       kind; /*!< Source kind. */
+    //
+    //
+    unsigned long           width; /*!< Frame width. [pixels] */
+    //
+    //
+    unsigned long           height; /*!< Frame height. [pixels] */
+    //
+    //
+    unsigned long           frame_rate; /*!< Frame rate, zero if a synthetic source is not paced. [Hz] */
+    //
+    //
+    unsigned long           frame_size; /*!< Largest frame returned by \ref frame_source_poll. [bytes] */
+    //
+    //
+    const unsigned char     *buffer; /*!< Current frame, valid until the next poll. */
+    //
+    //
+    unsigned long           buffer_len; /*!< Size of the current frame. [bytes] */
+    //
+    //
+    ps_video_device         video_device; /*!< Video device, \ref FRAME_SOURCE_DEVICE only. */
+    //
+    //
+    unsigned char           *pattern_buffer; /*!< Generated frame, test patterns only. */
+    //
+    //
+    guint32                 noise_state; /*!< Noise generator state, never zero. */
+    //
+    //
+    GPtrArray               *logfile_frames; /*!< Frames loaded from the logfile, \ref FRAME_SOURCE_LOGFILE only. */
+    //
+    //
+    unsigned long long      frame_index; /*!< Number of frames returned. */
+    //
+    //
+    ps_timestamp            next_frame_time; /*!< Monotonic time the next synthetic frame is due. [microseconds] */
+} frame_source_s;
+
+
+
+
+/**
+ * @brief Get a source kind by name.
+ *
+ * @param [in] name Kind name, one of "device", "gradient", "noise", "static" or "logfile".
+ *
+ * @return Source kind, \ref FRAME_SOURCE_KIND_COUNT if the name is unknown.
+ *
+ */
+frame_source_kind frame_source_get_kind( const char * const name );
+
+
+/**
+ * @brief Open a video device and start streaming.
+ *
+ * @param [out] source A pointer to \ref frame_source_s which receives the source.
+ * @param [in] path Video device path.
+ * @param [in] width Frame width. [pixels]
+ * @param [in] height Frame height. [pixels]
+ * @param [in] frame_rate Frame rate. [Hz]
+ *
+ * @return DTC code:
+ * \li \ref DTC_NONE (zero) if success.
+ * \li The video API DTC of the step that failed otherwise.
+ *
+ */
+int frame_source_open_device(
+        frame_source_s * const source,
+        const char * const path,
+        const unsigned long width,
+        const unsigned long height,
+        const unsigned long frame_rate );
+
+
+/**
+ * @brief Open a test pattern source.
+ *
+ * @param [out] source A pointer to \ref frame_source_s which receives the source.
+ * @param [in] kind \ref FRAME_SOURCE_GRADIENT, \ref FRAME_SOURCE_NOISE or \ref FRAME_SOURCE_STATIC.
+ * @param [in] width Frame width, even. [pixels]
+ * @param [in] height Frame height. [pixels]
+ * @param [in] frame_rate Frame rate, zero for as fast as polled. [Hz]
+ *
+ * @return DTC code:
+ * \li \ref DTC_NONE (zero) if success.
+ * \li \ref DTC_USAGE if the kind or size is invalid.
+ * \li \ref DTC_MEMERR if the frame could not be allocated.
+ *
+ */
+int frame_source_open_pattern(
+        frame_source_s * const source,
+        const frame_source_kind kind,
+        const unsigned long width,
+        const unsigned long height,
+        const unsigned long frame_rate );
+
+
+/**
+ * @brief Open a logfile replay source.
+ *
+ * Loads the YUYV image data messages of the logfile into memory so replay
+ * does not depend on disk speed. The first YUYV frame sets the frame size,
+ * frames of another size are skipped, and loading stops at
+ * \ref FRAME_SOURCE_MAX_LOGFILE_BYTES.
+ *
+ * @param [out] source A pointer to \ref frame_source_s which receives the source.
+ * @param [in] node_ref Node reference used to read the logfile.
+ * @param [in] path Logfile path.
+ * @param [in] frame_rate Frame rate, zero for as fast as polled. [Hz]
+ *
+ * @return DTC code:
+ * \li \ref DTC_NONE (zero) if success.
+ * \li \ref DTC_UNAVAILABLE if the logfile has no YUYV image data.
+ * \li \ref DTC_MEMERR if the frames could not be allocated.
+ * \li The logfile API DTC of the step that failed otherwise.
+ *
+ */
+int frame_source_open_logfile(
+        frame_source_s * const source,
+        ps_node_ref node_ref,
+        const char * const path,
+        const unsigned long frame_rate );
+
+
+/**
+ * @brief Wait for the next frame.
+ *
+ * On success the frame is in \ref frame_source_s.buffer, which the source reuses on
+ * the next poll.
+ *
+ * @param [in] source A pointer to \ref frame_source_s which specifies the source.
+ * @param [in] timeout Longest time to wait. [microseconds]
+ * @param [out] rx_timestamp A pointer to ps_timestamp which receives the frame timestamp.
+ *
+ * @return DTC code:
+ * \li \ref DTC_NONE (zero) if a frame is available.
+ * \li \ref DTC_UNAVAILABLE if no frame was due within the timeout.
+ * \li The video API DTC otherwise.
+ *
+ */
+int frame_source_poll(
+        frame_source_s * const source,
+        const unsigned long timeout,
+        ps_timestamp * const rx_timestamp );
+
+
+/**
+ * @brief Close a source and free its frames.
+ *
+ * @param [in] source A pointer to \ref frame_source_s which specifies the source.
+ *
+ */
+void frame_source_close( frame_source_s * const source );
+
+
+
+
+#endif	/* FRAME_SOURCE_H */
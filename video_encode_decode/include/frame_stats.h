@@ -0,0 +1,170 @@
+/**
+ * @file frame_stats.h
+ * @brief Pipeline Frame Statistics Interface.
+ *
+ * Per-stage latency histograms, throughput and compression ratio, built from
+ * the timestamps each frame collects on its way through the pipeline. Updated
+ * by the last stage only, so no locking is needed.
+ *
+ */
+
+
+
+
+#ifndef FRAME_STATS_H
+#define	FRAME_STATS_H
+
+
+
+
+#include <stdio.h>
+#include "polysync_core.h"
+#include "frame_pool.h"
+#include "latency_histogram.h"
+
+
+
+
+/**
+ * @brief Pipeline frame statistics.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_timestamp            start_time; /*!< Monotonic time the statistics were reset. [microseconds] */
+    //
+    //
+    unsigned long long      frames; /*!< Number of encoded frames that reached the decode stage. */
+    //
+    //
+    unsigned long long      decoded_frames; /*!< Number of frames decoded. */
+    //
+    //
+    unsigned long long      raw_bytes; /*!< Sum of the raw frame sizes. [bytes] */
+    //
+    //
+    unsigned long long      encoded_bytes; /*!< Sum of the encoded frame sizes. [bytes] */
+    //
+    //
+    latency_histogram_s     capture; /*!< Video device to queued for encoding, the capture copy. */
+    //
+    //
+    latency_histogram_s     encode_wait; /*!< Queued for encoding to encode start. */
+    //
+    //
+    latency_histogram_s     encode; /*!< Encode start to encoded. */
+    //
+    //
+    latency_histogram_s     decode_wait; /*!< Encoded to decode start. */
+    //
+    //
+    latency_histogram_s     decode; /*!< Decode start to decoded. */
+    //
+    //
+    latency_histogram_s     total; /*!< Video device to decoded. */
+} frame_stats_s;
+
+
+
+
+/**
+ * @brief Remove all samples.
+ *
+ * @param [in] stats A pointer to \ref frame_stats_s which specifies the statistics.
+ * @param [in] start_time Current monotonic time. [microseconds]
+ *
+ */
+void frame_stats_reset( frame_stats_s * const stats, const ps_timestamp start_time );
+
+
+/**
+ * @brief Add a frame that went through the decode stage.
+ *
+ * @param [in] stats A pointer to \ref frame_stats_s which specifies the statistics.
+ * @param [in] frame A pointer to \ref video_frame_s which specifies the encoded frame, with all timestamps set.
+ * @param [in] bytes_decoded Number of bytes the decoder returned for the frame. [bytes]
+ *
+ */
+void frame_stats_add( frame_stats_s * const stats, const video_frame_s * const frame, const unsigned long bytes_decoded );
+
+
+/**
+ * @brief Get the decoded frame rate since the last reset.
+ *
+ * @param [in] stats A pointer to \ref frame_stats_s which specifies the statistics.
+ * @param [in] now Current monotonic time. [microseconds]
+ *
+ * @return Frame rate. [Hz]
+ *
+ */
+double frame_stats_get_fps( const frame_stats_s * const stats, const ps_timestamp now );
+
+
+/**
+ * @brief Get the compression ratio, encoded size over raw size.
+ *
+ * @param [in] stats A pointer to \ref frame_stats_s which specifies the statistics.
+ *
+ * @return Compression ratio, zero if nothing was encoded.
+ *
+ */
+double frame_stats_get_compression_ratio( const frame_stats_s * const stats );
+
+
+/**
+ * @brief Print a one line summary.
+ *
+ * @param [in] stats A pointer to \ref frame_stats_s which specifies the statistics.
+ * @param [in] now Current monotonic time. [microseconds]
+ * @param [in] dropped_frames Number of captured frames dropped in the same period.
+ * @param [in] stream A pointer to FILE which specifies the output stream.
+ *
+ */
+void frame_stats_print_summary(
+        const frame_stats_s * const stats,
+        const ps_timestamp now,
+        const unsigned long long dropped_frames,
+        FILE * const stream );
+
+
+/**
+ * @brief Print the summary followed by the percentile table of each stage.
+ *
+ * @param [in] stats A pointer to \ref frame_stats_s which specifies the statistics.
+ * @param [in] now Current monotonic time. [microseconds]
+ * @param [in] dropped_frames Number of captured frames dropped in the same period.
+ * @param [in] stream A pointer to FILE which specifies the output stream.
+ *
+ */
+void frame_stats_print(
+        const frame_stats_s * const stats,
+        const ps_timestamp now,
+        const unsigned long long dropped_frames,
+        FILE * const stream );
+
+
+/**
+ * @brief Write the CSV column names.
+ *
+ * @param [in] stream A pointer to FILE which specifies the output stream.
+ *
+ */
+void frame_stats_write_csv_header( FILE * const stream );
+
+
+/**
+ * @brief Write a CSV row with the timestamps and sizes of a frame.
+ *
+ * @param [in] stream A pointer to FILE which specifies the output stream.
+ * @param [in] frame A pointer to \ref video_frame_s which specifies the encoded frame, with all timestamps set.
+ * @param [in] bytes_decoded Number of bytes the decoder returned for the frame. [bytes]
+ *
+ */
+void frame_stats_write_csv( FILE * const stream, const video_frame_s * const frame, const unsigned long bytes_decoded );
+
+
+
+
+#endif	/* FRAME_STATS_H */
@@ -0,0 +1,141 @@
+/**
+ * @file latency_histogram.h
+ * @brief Latency Histogram Interface.
+ *
+ * High dynamic range histogram of microsecond latencies. Latencies below
+ * 2^\ref LATENCY_HISTOGRAM_SUB_BUCKET_BITS are counted exactly, each power of
+ * two above is split into linear sub-buckets, so any recorded value is within
+ * about 3% of the sample from 1 us up to over an hour. Adding a sample is a few
+ * instructions, so it can be done for every frame. Not thread safe, each
+ * histogram has a single writer.
+ *
+ */
+
+
+
+
+#ifndef LATENCY_HISTOGRAM_H
+#define	LATENCY_HISTOGRAM_H
+
+
+
+
+#include <stdio.h>
+#include "polysync_core.h"
+
+
+
+
+/**
+ * @brief Number of bits resolved exactly, sets the precision.
+ *
+ */
+#define     LATENCY_HISTOGRAM_SUB_BUCKET_BITS   (6)
+
+
+/**
+ * @brief Number of sub-buckets each power of two is split into.
+ *
+ */
+#define     LATENCY_HISTOGRAM_SUB_BUCKETS       (1 << (LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1))
+
+
+/**
+ * @brief Number of bits of the largest trackable latency, larger samples are clamped.
+ *
+ */
+#define     LATENCY_HISTOGRAM_MAX_BITS          (32)
+
+
+/**
+ * @brief Number of buckets.
+ *
+ */
+#define     LATENCY_HISTOGRAM_BUCKETS           ((LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 2) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+
+
+
+/**
+ * @brief Latency histogram.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long long      buckets[ LATENCY_HISTOGRAM_BUCKETS ]; /*!< Sample counts. */
+    //
+    //
+    unsigned long long      count; /*!< Number of samples. */
+    //
+    //
+    ps_timestamp            sum; /*!< Sum of the samples. [microseconds] */
+    //
+    //
+    ps_timestamp            min; /*!< Smallest sample. [microseconds] */
+    //
+    //
+    ps_timestamp            max; /*!< Largest sample. [microseconds] */
+} latency_histogram_s;
+
+
+
+
+/**
+ * @brief Remove all samples.
+ *
+ * @param [in] histogram A pointer to \ref latency_histogram_s which specifies the histogram.
+ *
+ */
+void latency_histogram_reset( latency_histogram_s * const histogram );
+
+
+/**
+ * @brief Add a sample.
+ *
+ * @param [in] histogram A pointer to \ref latency_histogram_s which specifies the histogram.
+ * @param [in] latency Sample value. [microseconds]
+ *
+ */
+void latency_histogram_add( latency_histogram_s * const histogram, const ps_timestamp latency );
+
+
+/**
+ * @brief Get the mean of the samples.
+ *
+ * @param [in] histogram A pointer to \ref latency_histogram_s which specifies the histogram.
+ *
+ * @return Mean, zero if there are no samples. [microseconds]
+ *
+ */
+double latency_histogram_get_mean( const latency_histogram_s * const histogram );
+
+
+/**
+ * @brief Get a percentile.
+ *
+ * @param [in] histogram A pointer to \ref latency_histogram_s which specifies the histogram.
+ * @param [in] percentile Percentile, 0.0 to 100.0.
+ *
+ * @return Largest latency counted in the bucket holding the percentile, clamped to the
+ * sample range, zero if there are no samples. [microseconds]
+ *
+ */
+ps_timestamp latency_histogram_get_percentile( const latency_histogram_s * const histogram, const double percentile );
+
+
+/**
+ * @brief Print a percentile table.
+ *
+ * @param [in] histogram A pointer to \ref latency_histogram_s which specifies the histogram.
+ * @param [in] name Name printed first.
+ * @param [in] stream A pointer to FILE which specifies the output stream.
+ *
+ */
+void latency_histogram_print( const latency_histogram_s * const histogram, const char * const name, FILE * const stream );
+
+
+
+
+#endif	/* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,303 @@
+/**
+ * @file byte_arena.c
+ * @brief Growable Byte Arena Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+#include "byte_arena.h"
+
+
+
+
+// *****************************************************
+// static global types/macros
+// *****************************************************
+
+/**
+ * @brief Number of released blocks kept for reuse, others are freed.
+ *
+ */
+#define         MAX_SPARE_BLOCKS            (1)
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Get an empty block, reusing a spare one if it is large enough.
+ *
+ * @param [in] arena A pointer to \ref byte_arena_s which specifies the arena.
+ * @param [in] size Smallest block size. [bytes]
+ *
+ * @return A pointer to the block holding the reference of the current block, NULL on failure.
+ *
+ */
+static byte_arena_block_s *get_block( byte_arena_s * const arena, const unsigned long size );
+
+
+/**
+ * @brief Free a block.
+ *
+ * @param [in] block A pointer to \ref byte_arena_block_s which specifies the block. NULL is acceptable.
+ *
+ */
+static void free_block( byte_arena_block_s * const block );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static byte_arena_block_s *get_block( byte_arena_s * const arena, const unsigned long size )
+{
+    // local vars
+    byte_arena_block_s *block = NULL;
+    byte_arena_block_s *too_small = NULL;
+
+
+    g_mutex_lock( &arena->lock );
+
+    if( arena->spare_blocks->len != 0 )
+    {
+        block = (byte_arena_block_s*) g_ptr_array_remove_index_fast( arena->spare_blocks, arena->spare_blocks->len - 1 );
+
+        // slices grew since the block was allocated
+        if( block->size < size )
+        {
+            arena->allocated_bytes -= block->size;
+            too_small = block;
+            block = NULL;
+        }
+    }
+
+    g_mutex_unlock( &arena->lock );
+
+    free_block( too_small );
+
+    if( block == NULL )
+    {
+        if( (block = g_try_new0( byte_arena_block_s, 1 )) == NULL )
+        {
+            return NULL;
+        }
+
+        if( (block->data = g_try_malloc( size )) == NULL )
+        {
+            g_free( block );
+            return NULL;
+        }
+
+        block->arena = arena;
+        block->size = size;
+
+        g_mutex_lock( &arena->lock );
+
+        arena->allocated_bytes += size;
+        arena->peak_bytes = MAX( arena->peak_bytes, arena->allocated_bytes );
+        arena->block_allocations += 1;
+
+        g_mutex_unlock( &arena->lock );
+    }
+
+    block->used = 0;
+    g_atomic_int_set( &block->refs, 1 );
+
+
+    return block;
+}
+
+
+//
+static void free_block( byte_arena_block_s * const block )
+{
+    if( block == NULL )
+    {
+        return;
+    }
+
+
+    g_free( block->data );
+    g_free( block );
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+byte_arena_s *byte_arena_new( const unsigned long block_slices )
+{
+    // local vars
+    byte_arena_s *arena = NULL;
+
+
+    if( (arena = g_try_new0( byte_arena_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    g_mutex_init( &arena->lock );
+    arena->spare_blocks = g_ptr_array_sized_new( MAX_SPARE_BLOCKS );
+    arena->block_slices = block_slices;
+
+
+    return arena;
+}
+
+
+//
+void byte_arena_free( byte_arena_s * const arena )
+{
+    if( arena == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+
+
+    // with all slices released, this moves the current block to the spares or frees it
+    byte_arena_release( arena->current );
+    arena->current = NULL;
+
+    for( idx = 0; idx < arena->spare_blocks->len; ++idx )
+    {
+        free_block( (byte_arena_block_s*) g_ptr_array_index( arena->spare_blocks, idx ) );
+    }
+
+    g_ptr_array_free( arena->spare_blocks, TRUE );
+    g_mutex_clear( &arena->lock );
+    g_free( arena );
+}
+
+
+//
+unsigned char *byte_arena_reserve( byte_arena_s * const arena, const unsigned long size )
+{
+    if( arena == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    byte_arena_block_s * const current = arena->current;
+
+
+    if( (current != NULL) && ((current->size - current->used) >= size) )
+    {
+        return current->data + current->used;
+    }
+
+    // the full block lives on until its slices are released
+    arena->current = NULL;
+    byte_arena_release( current );
+
+    // room for the reservation and for the slices that typically follow it
+    if( (arena->current = get_block( arena, size + (arena->block_slices * arena->largest_slice) )) == NULL )
+    {
+        return NULL;
+    }
+
+
+    return arena->current->data;
+}
+
+
+//
+byte_arena_block_s *byte_arena_commit( byte_arena_s * const arena, const unsigned long len )
+{
+    if( (arena == NULL) || (arena->current == NULL) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    byte_arena_block_s * const block = arena->current;
+
+
+    g_atomic_int_inc( &block->refs );
+
+    block->used += len;
+    arena->largest_slice = MAX( arena->largest_slice, len );
+
+
+    return block;
+}
+
+
+//
+void byte_arena_release( byte_arena_block_s * const block )
+{
+    if( block == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    byte_arena_s * const arena = (byte_arena_s*) block->arena;
+    byte_arena_block_s *unused = NULL;
+
+
+    // full barrier, the slice readers are done before the block is reused
+    if( g_atomic_int_dec_and_test( &block->refs ) == FALSE )
+    {
+        return;
+    }
+
+    g_mutex_lock( &arena->lock );
+
+    if( arena->spare_blocks->len < MAX_SPARE_BLOCKS )
+    {
+        g_ptr_array_add( arena->spare_blocks, block );
+    }
+    else
+    {
+        arena->allocated_bytes -= block->size;
+        unused = block;
+    }
+
+    g_mutex_unlock( &arena->lock );
+
+    free_block( unused );
+}
+
+
+//
+unsigned long byte_arena_get_peak_bytes( byte_arena_s * const arena )
+{
+    if( arena == NULL )
+    {
+        return 0;
+    }
+
+    // local vars
+    unsigned long peak_bytes = 0;
+
+
+    g_mutex_lock( &arena->lock );
+
+    peak_bytes = arena->peak_bytes;
+
+    g_mutex_unlock( &arena->lock );
+
+
+    return peak_bytes;
+}
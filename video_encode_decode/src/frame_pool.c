@@ -0,0 +1,192 @@
+/**
+ * @file frame_pool.c
+ * @brief Video Frame Buffer Pool Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+// API headers
+#include "polysync_core.h"
+
+#include "frame_pool.h"
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+frame_pool_s *frame_pool_new( const unsigned long count, const unsigned long buffer_size )
+{
+    if( count == 0 )
+    {
+        return NULL;
+    }
+
+    // local vars
+    frame_pool_s *pool = NULL;
+    unsigned long idx = 0;
+
+
+    if( (pool = g_try_new0( frame_pool_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    g_mutex_init( &pool->lock );
+    pool->available = g_ptr_array_sized_new( (guint) count );
+
+    if( (pool->frames = g_try_new0( video_frame_s, count )) == NULL )
+    {
+        frame_pool_free( pool );
+        return NULL;
+    }
+
+    pool->count = count;
+    pool->buffer_size = buffer_size;
+
+    for( idx = 0; idx < count; ++idx )
+    {
+        video_frame_s * const frame = &pool->frames[ idx ];
+
+        if( (buffer_size != 0) && ((frame->buffer = g_try_malloc( buffer_size )) == NULL) )
+        {
+            frame_pool_free( pool );
+            return NULL;
+        }
+
+        frame->pool = pool;
+        frame->size = buffer_size;
+
+        g_ptr_array_add( pool->available, frame );
+    }
+
+
+    return pool;
+}
+
+
+//
+void frame_pool_free( frame_pool_s * const pool )
+{
+    if( pool == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    unsigned long idx = 0;
+
+
+    if( pool->frames != NULL )
+    {
+        for( idx = 0; idx < pool->count; ++idx )
+        {
+            // arena data belongs to the arena
+            if( pool->frames[ idx ].arena_block == NULL )
+            {
+                g_free( pool->frames[ idx ].buffer );
+            }
+        }
+
+        g_free( pool->frames );
+    }
+
+    g_ptr_array_free( pool->available, TRUE );
+    g_mutex_clear( &pool->lock );
+    g_free( pool );
+}
+
+
+//
+video_frame_s *frame_pool_acquire( frame_pool_s * const pool )
+{
+    if( pool == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    video_frame_s *frame = NULL;
+
+
+    g_mutex_lock( &pool->lock );
+
+    if( pool->available->len != 0 )
+    {
+        frame = (video_frame_s*) g_ptr_array_remove_index_fast( pool->available, pool->available->len - 1 );
+    }
+    else
+    {
+        pool->exhausted += 1;
+    }
+
+    g_mutex_unlock( &pool->lock );
+
+    if( frame != NULL )
+    {
+        frame->len = 0;
+        g_atomic_int_set( &frame->refs, 1 );
+    }
+
+
+    return frame;
+}
+
+
+//
+void frame_pool_ref( video_frame_s * const frame )
+{
+    if( frame == NULL )
+    {
+        return;
+    }
+
+
+    g_atomic_int_inc( &frame->refs );
+}
+
+
+//
+void frame_pool_release( video_frame_s * const frame )
+{
+    if( frame == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    frame_pool_s * const pool = (frame_pool_s*) frame->pool;
+
+
+    // full barrier, the other holders are done reading before the frame is reused
+    if( g_atomic_int_dec_and_test( &frame->refs ) == FALSE )
+    {
+        return;
+    }
+
+    // detach arena data
+    if( frame->arena_block != NULL )
+    {
+        byte_arena_release( frame->arena_block );
+
+        frame->arena_block = NULL;
+        frame->buffer = NULL;
+        frame->size = 0;
+    }
+
+    g_mutex_lock( &pool->lock );
+
+    g_ptr_array_add( pool->available, frame );
+
+    g_mutex_unlock( &pool->lock );
+}
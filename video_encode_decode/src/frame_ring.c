@@ -0,0 +1,290 @@
+/**
+ * @file frame_ring.c
+ * @brief Single-Producer Single-Consumer Frame Ring Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+#include "frame_pool.h"
+#include "frame_ring.h"
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Get the number of frames in the ring.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ *
+ * @return Number of frames.
+ *
+ */
+static guint get_length( frame_ring_s * const ring );
+
+
+/**
+ * @brief Wake up a thread sleeping on the ring, if any.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ *
+ */
+static void wake( frame_ring_s * const ring );
+
+
+/**
+ * @brief Sleep until the ring has room or a frame, or is closed.
+ *
+ * @param [in] ring A pointer to \ref frame_ring_s which specifies the ring.
+ * @param [in] for_room Non-zero to wait for room, zero to wait for a frame.
+ *
+ */
+static void wait_ready( frame_ring_s * const ring, const unsigned int for_room );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static guint get_length( frame_ring_s * const ring )
+{
+    // counters wrap, their difference doesn't
+    return (guint) g_atomic_int_get( &ring->tail ) - (guint) g_atomic_int_get( &ring->head );
+}
+
+
+//
+static void wake( frame_ring_s * const ring )
+{
+    // the counter update before this is a full barrier, so a thread that went
+    // to sleep after missing it is always counted here
+    if( g_atomic_int_get( &ring->waiters ) != 0 )
+    {
+        g_mutex_lock( &ring->lock );
+        g_cond_broadcast( &ring->cond );
+        g_mutex_unlock( &ring->lock );
+    }
+}
+
+
+//
+static void wait_ready( frame_ring_s * const ring, const unsigned int for_room )
+{
+    g_mutex_lock( &ring->lock );
+
+    g_atomic_int_inc( &ring->waiters );
+
+    while( g_atomic_int_get( &ring->closed ) == 0 )
+    {
+        // local vars
+        const guint length = get_length( ring );
+
+
+        if( (for_room != 0) ? (length <= ring->mask) : (length != 0) )
+        {
+            break;
+        }
+
+        g_cond_wait( &ring->cond, &ring->lock );
+    }
+
+    (void) g_atomic_int_add( &ring->waiters, -1 );
+
+    g_mutex_unlock( &ring->lock );
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+frame_ring_s *frame_ring_new( const unsigned long capacity )
+{
+    if( (capacity == 0) || (capacity > (G_MAXINT / 2)) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    frame_ring_s *ring = NULL;
+    guint size = 1;
+
+
+    // power of two, so slot indices stay continuous when the counters wrap
+    while( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    if( (ring = g_try_new0( frame_ring_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    if( (ring->slots = g_try_new0( video_frame_s*, size )) == NULL )
+    {
+        g_free( ring );
+        return NULL;
+    }
+
+    ring->mask = size - 1;
+
+    g_mutex_init( &ring->lock );
+    g_cond_init( &ring->cond );
+
+
+    return ring;
+}
+
+
+//
+void frame_ring_free( frame_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    guint head = (guint) g_atomic_int_get( &ring->head );
+    const guint tail = (guint) g_atomic_int_get( &ring->tail );
+
+
+    for( ; head != tail; ++head )
+    {
+        frame_pool_release( ring->slots[ head & ring->mask ] );
+    }
+
+    g_cond_clear( &ring->cond );
+    g_mutex_clear( &ring->lock );
+    g_free( ring->slots );
+    g_free( ring );
+}
+
+
+//
+int frame_ring_try_push( frame_ring_s * const ring, video_frame_s * const frame )
+{
+    if( (ring == NULL) || (frame == NULL) )
+    {
+        return 1;
+    }
+
+    // local vars
+    const guint tail = (guint) g_atomic_int_get( &ring->tail );
+
+
+    if( (tail - (guint) g_atomic_int_get( &ring->head )) > ring->mask )
+    {
+        return 1;
+    }
+
+    ring->slots[ tail & ring->mask ] = frame;
+
+    // publish the slot
+    g_atomic_int_set( &ring->tail, (gint) (tail + 1) );
+
+    wake( ring );
+
+
+    return 0;
+}
+
+
+//
+int frame_ring_push( frame_ring_s * const ring, video_frame_s * const frame )
+{
+    if( (ring == NULL) || (frame == NULL) )
+    {
+        return 1;
+    }
+
+
+    while( frame_ring_try_push( ring, frame ) != 0 )
+    {
+        if( g_atomic_int_get( &ring->closed ) != 0 )
+        {
+            return 1;
+        }
+
+        wait_ready( ring, 1 );
+    }
+
+
+    return 0;
+}
+
+
+//
+video_frame_s *frame_ring_pop( frame_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    video_frame_s *frame = NULL;
+    guint head = 0;
+    unsigned int closed = 0;
+
+
+    while( 1 )
+    {
+        // check before looking at the frames, anything pushed before closing is still seen
+        closed = (g_atomic_int_get( &ring->closed ) != 0);
+
+        if( get_length( ring ) != 0 )
+        {
+            head = (guint) g_atomic_int_get( &ring->head );
+            frame = ring->slots[ head & ring->mask ];
+
+            // hand the slot back
+            g_atomic_int_set( &ring->head, (gint) (head + 1) );
+
+            wake( ring );
+
+            return frame;
+        }
+
+        if( closed != 0 )
+        {
+            return NULL;
+        }
+
+        wait_ready( ring, 0 );
+    }
+}
+
+
+//
+void frame_ring_close( frame_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return;
+    }
+
+
+    g_atomic_int_set( &ring->closed, 1 );
+
+    g_mutex_lock( &ring->lock );
+    g_cond_broadcast( &ring->cond );
+    g_mutex_unlock( &ring->lock );
+}
@@ -0,0 +1,649 @@
+/**
+ * @file frame_source.c
+ * @brief YUYV Frame Source Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+// API headers
+#include "polysync_core.h"
+#include "polysync_message.h"
+#include "polysync_logfile.h"
+#include "polysync_video.h"
+
+#include "frame_source.h"
+
+
+
+
+// *****************************************************
+// static global types/macros
+// *****************************************************
+
+/**
+ * @brief Number of bytes per pixel in YUYV, two pixels share one U and one V byte.
+ *
+ */
+#define         YUYV_BYTES_PER_PIXEL        (2)
+
+
+/**
+ * @brief Gradient movement per frame. [pixels]
+ *
+ */
+#define         GRADIENT_STEP               (4)
+
+
+/**
+ * @brief Number of color bars in the static pattern.
+ *
+ */
+#define         COLOR_BAR_COUNT             (8)
+
+
+/**
+ * @brief Logfile loading state, passed to the logfile iterator callback.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    frame_source_s          *source; /*!< Source being loaded. */
+    //
+    //
+    ps_msg_type             image_data_msg_type; /*!< 'ps_image_data_msg' type. */
+    //
+    //
+    unsigned long           loaded_bytes; /*!< Image data loaded so far. [bytes] */
+    //
+    //
+    unsigned long           skipped_frames; /*!< Image data messages not loaded. */
+    //
+    //
+    int                     ret; /*!< First failure while loading, \ref DTC_NONE if none. */
+} logfile_loader_s;
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+/**
+ * @brief Source kind names, indexed by \ref frame_source_kind.
+ *
+ */
+static const char * const KIND_NAMES[ FRAME_SOURCE_KIND_COUNT ] =
+{
+    "device",
+    "gradient",
+    "noise",
+    "static",
+    "logfile"
+};
+
+
+/**
+ * @brief PolySync 'ps_image_data_msg' type name.
+ *
+ */
+static const char IMAGE_DATA_MSG_NAME[] = "ps_image_data_msg";
+
+
+/**
+ * @brief 75% color bars, white to black, as Y, U, V.
+ *
+ */
+static const unsigned char COLOR_BARS[ COLOR_BAR_COUNT ][ 3 ] =
+{
+    { 180, 128, 128 },
+    { 162, 44, 142 },
+    { 131, 156, 44 },
+    { 112, 72, 58 },
+    { 84, 184, 198 },
+    { 65, 100, 212 },
+    { 35, 212, 114 },
+    { 16, 128, 128 }
+};
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Write the moving gradient for the current frame index.
+ *
+ * @param [in] source A pointer to \ref frame_source_s which specifies the source.
+ *
+ */
+static void generate_gradient( frame_source_s * const source );
+
+
+/**
+ * @brief Write a new frame of noise.
+ *
+ * Xorshift, fast enough that generating does not limit the encoder benchmark.
+ *
+ * @param [in] source A pointer to \ref frame_source_s which specifies the source.
+ *
+ */
+static void generate_noise( frame_source_s * const source );
+
+
+/**
+ * @brief Write the color bars, done once since they never change.
+ *
+ * @param [in] source A pointer to \ref frame_source_s which specifies the source.
+ *
+ */
+static void generate_color_bars( frame_source_s * const source );
+
+
+/**
+ * @brief Wait until the next synthetic frame is due.
+ *
+ * @param [in] source A pointer to \ref frame_source_s which specifies the source.
+ * @param [in] timeout Longest time to wait. [microseconds]
+ *
+ * @return DTC code:
+ * \li \ref DTC_NONE (zero) if the frame is due.
+ * \li \ref DTC_UNAVAILABLE if it is not due within the timeout.
+ *
+ */
+static int wait_frame_time( frame_source_s * const source, const unsigned long timeout );
+
+
+/**
+ * @brief Logfile iterator callback, copies YUYV image data into \ref frame_source_s.logfile_frames.
+ *
+ * @param [in] file_attributes Logfile attributes loaded by the logfile API.
+ * @param [in] msg_type Message type identifier for the message in \ref ps_rnr_log_record.data.
+ * @param [in] log_record Logfile record loaded by the logfile API, NULL if the logfile is empty.
+ * @param [in] user_data A pointer to \ref logfile_loader_s which specifies the loading state.
+ *
+ */
+static void logfile_iterator_callback(
+        const ps_logfile_attributes * const file_attributes,
+        const ps_msg_type msg_type,
+        const ps_rnr_log_record * const log_record,
+        void * const user_data );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static void generate_gradient( frame_source_s * const source )
+{
+    // local vars
+    const unsigned long shift = (unsigned long) (source->frame_index * GRADIENT_STEP);
+    unsigned char *pixel = source->pattern_buffer;
+    unsigned long x = 0;
+    unsigned long y = 0;
+
+
+    // luma moves diagonally, U horizontally and V vertically
+    for( y = 0; y < source->height; ++y )
+    {
+        for( x = 0; x < source->width; x += 2 )
+        {
+            pixel[ 0 ] = (unsigned char) (x + y + shift);
+            pixel[ 1 ] = (unsigned char) (x + shift);
+            pixel[ 2 ] = (unsigned char) (x + 1 + y + shift);
+            pixel[ 3 ] = (unsigned char) (y - shift);
+
+            pixel += 4;
+        }
+    }
+}
+
+
+//
+static void generate_noise( frame_source_s * const source )
+{
+    // local vars
+    guint32 state = source->noise_state;
+    unsigned char *byte = source->pattern_buffer;
+    unsigned char * const end = source->pattern_buffer + source->frame_size;
+
+
+    // frame size is a multiple of 4, two pixels
+    while( byte < end )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        memcpy( byte, &state, sizeof(state) );
+
+        byte += sizeof(state);
+    }
+
+    source->noise_state = state;
+}
+
+
+//
+static void generate_color_bars( frame_source_s * const source )
+{
+    // local vars
+    unsigned char *pixel = source->pattern_buffer;
+    const unsigned char *bar = NULL;
+    unsigned long x = 0;
+    unsigned long y = 0;
+
+
+    for( y = 0; y < source->height; ++y )
+    {
+        for( x = 0; x < source->width; x += 2 )
+        {
+            bar = COLOR_BARS[ (x * COLOR_BAR_COUNT) / source->width ];
+
+            pixel[ 0 ] = bar[ 0 ];
+            pixel[ 1 ] = bar[ 1 ];
+            pixel[ 2 ] = bar[ 0 ];
+            pixel[ 3 ] = bar[ 2 ];
+
+            pixel += 4;
+        }
+    }
+}
+
+
+//
+static int wait_frame_time( frame_source_s * const source, const unsigned long timeout )
+{
+    // local vars
+    ps_timestamp now = 0;
+
+
+    // not paced
+    if( source->frame_rate == 0 )
+    {
+        return DTC_NONE;
+    }
+
+    now = (ps_timestamp) g_get_monotonic_time();
+
+    if( source->next_frame_time > now )
+    {
+        if( (source->next_frame_time - now) > timeout )
+        {
+            g_usleep( timeout );
+            return DTC_UNAVAILABLE;
+        }
+
+        g_usleep( (unsigned long) (source->next_frame_time - now) );
+        now = source->next_frame_time;
+    }
+
+    source->next_frame_time += 1000000 / source->frame_rate;
+
+    // more than a frame behind, a camera does not catch up on the frames it missed
+    if( source->next_frame_time <= now )
+    {
+        source->next_frame_time = now + (1000000 / source->frame_rate);
+    }
+
+
+    return DTC_NONE;
+}
+
+
+//
+static void logfile_iterator_callback(
+        const ps_logfile_attributes * const file_attributes,
+        const ps_msg_type msg_type,
+        const ps_rnr_log_record * const log_record,
+        void * const user_data )
+{
+    // local vars
+    logfile_loader_s * const loader = (logfile_loader_s*) user_data;
+    frame_source_s *source = NULL;
+    const ps_image_data_msg *image_data_msg = NULL;
+    unsigned char *frame = NULL;
+
+
+    // if logfile is empty, only attributes are provided
+    if( (log_record == NULL) || (loader == NULL) || (msg_type != loader->image_data_msg_type) || (loader->ret != DTC_NONE) )
+    {
+        return;
+    }
+
+    source = loader->source;
+    image_data_msg = (const ps_image_data_msg*) log_record->data;
+
+    if( image_data_msg->pixel_format != PIXEL_FORMAT_YUYV )
+    {
+        loader->skipped_frames += 1;
+        return;
+    }
+
+    // first frame sets the size
+    if( source->frame_size == 0 )
+    {
+        source->width = image_data_msg->width;
+        source->height = image_data_msg->height;
+        source->frame_size = source->width * source->height * YUYV_BYTES_PER_PIXEL;
+    }
+
+    if( (image_data_msg->width != source->width)
+            || (image_data_msg->height != source->height)
+            || (image_data_msg->data_buffer._length < source->frame_size)
+            || ((loader->loaded_bytes + source->frame_size) > FRAME_SOURCE_MAX_LOGFILE_BYTES) )
+    {
+        loader->skipped_frames += 1;
+        return;
+    }
+
+    if( (frame = g_try_malloc( source->frame_size )) == NULL )
+    {
+        loader->ret = DTC_MEMERR;
+        return;
+    }
+
+    memcpy( frame, image_data_msg->data_buffer._buffer, source->frame_size );
+
+    g_ptr_array_add( source->logfile_frames, frame );
+    loader->loaded_bytes += source->frame_size;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+frame_source_kind frame_source_get_kind( const char * const name )
+{
+    // local vars
+    unsigned int kind = 0;
+
+
+    if( name == NULL )
+    {
+        return FRAME_SOURCE_KIND_COUNT;
+    }
+
+    for( kind = 0; kind < FRAME_SOURCE_KIND_COUNT; ++kind )
+    {
+        if( strcmp( name, KIND_NAMES[ kind ] ) == 0 )
+        {
+            break;
+        }
+    }
+
+
+    return (frame_source_kind) kind;
+}
+
+
+//
+int frame_source_open_device(
+        frame_source_s * const source,
+        const char * const path,
+        const unsigned long width,
+        const unsigned long height,
+        const unsigned long frame_rate )
+{
+    // local vars
+    int ret = DTC_NONE;
+
+
+    memset( source, 0, sizeof(*source) );
+
+    source->kind = FRAME_SOURCE_DEVICE;
+    source->width = width;
+    source->height = height;
+    source->frame_rate = frame_rate;
+
+    // open video device
+    ret = psync_video_open( &source->video_device, path );
+
+    if( ret != DTC_NONE )
+    {
+        return ret;
+    }
+
+    // check if desired configuration is available
+    ret = psync_video_check_format( &source->video_device, PIXEL_FORMAT_YUYV, width, height );
+
+    // set configuration
+    if( ret == DTC_NONE )
+    {
+        ret = psync_video_set_format( &source->video_device, PIXEL_FORMAT_YUYV, width, height );
+    }
+
+    // set frame rate
+    if( ret == DTC_NONE )
+    {
+        ret = psync_video_set_frame_rate( &source->video_device, frame_rate );
+    }
+
+    // enable streaming, this starts the capturing of data
+    if( ret == DTC_NONE )
+    {
+        ret = psync_video_enable_streaming( &source->video_device );
+    }
+
+    if( ret != DTC_NONE )
+    {
+        (void) psync_video_close( &source->video_device );
+        return ret;
+    }
+
+    source->frame_size = source->video_device.buffer_len;
+
+
+    return DTC_NONE;
+}
+
+
+//
+int frame_source_open_pattern(
+        frame_source_s * const source,
+        const frame_source_kind kind,
+        const unsigned long width,
+        const unsigned long height,
+        const unsigned long frame_rate )
+{
+    memset( source, 0, sizeof(*source) );
+
+    if( ((kind != FRAME_SOURCE_GRADIENT) && (kind != FRAME_SOURCE_NOISE) && (kind != FRAME_SOURCE_STATIC))
+            || (width == 0) || ((width % 2) != 0) || (height == 0) )
+    {
+        return DTC_USAGE;
+    }
+
+    source->kind = kind;
+    source->width = width;
+    source->height = height;
+    source->frame_rate = frame_rate;
+    source->frame_size = width * height * YUYV_BYTES_PER_PIXEL;
+    source->noise_state = 0x9E3779B9;
+    source->next_frame_time = (ps_timestamp) g_get_monotonic_time();
+
+    if( (source->pattern_buffer = g_try_malloc( source->frame_size )) == NULL )
+    {
+        return DTC_MEMERR;
+    }
+
+    if( kind == FRAME_SOURCE_STATIC )
+    {
+        generate_color_bars( source );
+    }
+
+
+    return DTC_NONE;
+}
+
+
+//
+int frame_source_open_logfile(
+        frame_source_s * const source,
+        ps_node_ref node_ref,
+        const char * const path,
+        const unsigned long frame_rate )
+{
+    // local vars
+    int ret = DTC_NONE;
+    logfile_loader_s loader;
+
+
+    memset( source, 0, sizeof(*source) );
+    memset( &loader, 0, sizeof(loader) );
+
+    source->kind = FRAME_SOURCE_LOGFILE;
+    source->frame_rate = frame_rate;
+    source->logfile_frames = g_ptr_array_new_with_free_func( g_free );
+
+    loader.source = source;
+
+    // get the message type for 'ps_image_data_msg'
+    ret = psync_message_get_type_by_name( node_ref, IMAGE_DATA_MSG_NAME, &loader.image_data_msg_type );
+
+    // initialize logfile API resources
+    if( ret == DTC_NONE )
+    {
+        ret = psync_logfile_init( node_ref );
+    }
+
+    // load the frames
+    if( ret == DTC_NONE )
+    {
+        ret = psync_logfile_foreach_iterator( node_ref, path, logfile_iterator_callback, &loader );
+
+        // release logfile API resources
+        (void) psync_logfile_release( node_ref );
+    }
+
+    if( ret == DTC_NONE )
+    {
+        ret = loader.ret;
+    }
+
+    if( (ret == DTC_NONE) && (source->logfile_frames->len == 0) )
+    {
+        ret = DTC_UNAVAILABLE;
+    }
+
+    if( ret != DTC_NONE )
+    {
+        frame_source_close( source );
+        return ret;
+    }
+
+    psync_log_message(
+            LOG_LEVEL_INFO,
+            "loaded %u YUYV frames of %lux%lu from '%s', skipped %lu image data messages",
+            source->logfile_frames->len,
+            source->width,
+            source->height,
+            path,
+            loader.skipped_frames );
+
+    source->next_frame_time = (ps_timestamp) g_get_monotonic_time();
+
+
+    return DTC_NONE;
+}
+
+
+//
+int frame_source_poll(
+        frame_source_s * const source,
+        const unsigned long timeout,
+        ps_timestamp * const rx_timestamp )
+{
+    // local vars
+    int ret = DTC_NONE;
+
+
+    if( source->kind == FRAME_SOURCE_DEVICE )
+    {
+        ret = psync_video_poll( &source->video_device, timeout, rx_timestamp );
+
+        if( ret == DTC_NONE )
+        {
+            source->buffer = source->video_device.buffer;
+            source->buffer_len = source->video_device.buffer_len;
+            source->frame_index += 1;
+        }
+
+        return ret;
+    }
+
+    if( (ret = wait_frame_time( source, timeout )) != DTC_NONE )
+    {
+        return ret;
+    }
+
+    if( source->kind == FRAME_SOURCE_GRADIENT )
+    {
+        generate_gradient( source );
+    }
+    else if( source->kind == FRAME_SOURCE_NOISE )
+    {
+        generate_noise( source );
+    }
+
+    if( source->kind == FRAME_SOURCE_LOGFILE )
+    {
+        source->buffer = g_ptr_array_index( source->logfile_frames, source->frame_index % source->logfile_frames->len );
+    }
+    else
+    {
+        source->buffer = source->pattern_buffer;
+    }
+
+    source->buffer_len = source->frame_size;
+    source->frame_index += 1;
+
+
+    return psync_get_timestamp( rx_timestamp );
+}
+
+
+//
+void frame_source_close( frame_source_s * const source )
+{
+    if( source == NULL )
+    {
+        return;
+    }
+
+
+    if( source->kind == FRAME_SOURCE_DEVICE )
+    {
+        (void) psync_video_close( &source->video_device );
+    }
+
+    if( source->pattern_buffer != NULL )
+    {
+        g_free( source->pattern_buffer );
+    }
+
+    if( source->logfile_frames != NULL )
+    {
+        (void) g_ptr_array_free( source->logfile_frames, TRUE );
+    }
+
+    memset( source, 0, sizeof(*source) );
+}
@@ -0,0 +1,217 @@
+/**
+ * @file frame_stats.c
+ * @brief Pipeline Frame Statistics Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// API headers
+#include "polysync_core.h"
+
+#include "frame_pool.h"
+#include "latency_histogram.h"
+#include "frame_stats.h"
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Get the time between two timestamps, zero if out of order.
+ *
+ * @param [in] start Earlier timestamp. [microseconds]
+ * @param [in] end Later timestamp. [microseconds]
+ *
+ * @return Elapsed time. [microseconds]
+ *
+ */
+static ps_timestamp get_elapsed( const ps_timestamp start, const ps_timestamp end );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static ps_timestamp get_elapsed( const ps_timestamp start, const ps_timestamp end )
+{
+    return (end > start) ? (end - start) : 0;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+void frame_stats_reset( frame_stats_s * const stats, const ps_timestamp start_time )
+{
+    if( stats == NULL )
+    {
+        return;
+    }
+
+
+    memset( stats, 0, sizeof(*stats) );
+
+    stats->start_time = start_time;
+}
+
+
+//
+void frame_stats_add( frame_stats_s * const stats, const video_frame_s * const frame, const unsigned long bytes_decoded )
+{
+    if( (stats == NULL) || (frame == NULL) )
+    {
+        return;
+    }
+
+
+    stats->frames += 1;
+    stats->raw_bytes += frame->source_len;
+    stats->encoded_bytes += frame->len;
+
+    latency_histogram_add( &stats->capture, get_elapsed( frame->capture_time, frame->queued_time ) );
+    latency_histogram_add( &stats->encode_wait, get_elapsed( frame->queued_time, frame->encode_start_time ) );
+    latency_histogram_add( &stats->encode, get_elapsed( frame->encode_start_time, frame->encoded_time ) );
+    latency_histogram_add( &stats->decode_wait, get_elapsed( frame->encoded_time, frame->decode_start_time ) );
+    latency_histogram_add( &stats->decode, get_elapsed( frame->decode_start_time, frame->decoded_time ) );
+
+    // only frames that came out of the decoder made it through
+    if( bytes_decoded != 0 )
+    {
+        stats->decoded_frames += 1;
+
+        latency_histogram_add( &stats->total, get_elapsed( frame->capture_time, frame->decoded_time ) );
+    }
+}
+
+
+//
+double frame_stats_get_fps( const frame_stats_s * const stats, const ps_timestamp now )
+{
+    if( (stats == NULL) || (now <= stats->start_time) )
+    {
+        return 0.0;
+    }
+
+
+    return (double) stats->decoded_frames / ((double) (now - stats->start_time) / 1000000.0);
+}
+
+
+//
+double frame_stats_get_compression_ratio( const frame_stats_s * const stats )
+{
+    if( (stats == NULL) || (stats->raw_bytes == 0) )
+    {
+        return 0.0;
+    }
+
+
+    return (double) stats->encoded_bytes / (double) stats->raw_bytes;
+}
+
+
+//
+void frame_stats_print_summary(
+        const frame_stats_s * const stats,
+        const ps_timestamp now,
+        const unsigned long long dropped_frames,
+        FILE * const stream )
+{
+    if( (stats == NULL) || (stream == NULL) )
+    {
+        return;
+    }
+
+
+    fprintf( stream,
+            "decoded: %llu - dropped: %llu - fps: %.1f - compression: %.4f - p50/p99 [ms] encode: %.2f/%.2f - decode: %.2f/%.2f - total: %.2f/%.2f\n",
+            stats->decoded_frames,
+            dropped_frames,
+            frame_stats_get_fps( stats, now ),
+            frame_stats_get_compression_ratio( stats ),
+            (double) latency_histogram_get_percentile( &stats->encode, 50.0 ) / 1000.0,
+            (double) latency_histogram_get_percentile( &stats->encode, 99.0 ) / 1000.0,
+            (double) latency_histogram_get_percentile( &stats->decode, 50.0 ) / 1000.0,
+            (double) latency_histogram_get_percentile( &stats->decode, 99.0 ) / 1000.0,
+            (double) latency_histogram_get_percentile( &stats->total, 50.0 ) / 1000.0,
+            (double) latency_histogram_get_percentile( &stats->total, 99.0 ) / 1000.0 );
+}
+
+
+//
+void frame_stats_print(
+        const frame_stats_s * const stats,
+        const ps_timestamp now,
+        const unsigned long long dropped_frames,
+        FILE * const stream )
+{
+    if( (stats == NULL) || (stream == NULL) )
+    {
+        return;
+    }
+
+
+    frame_stats_print_summary( stats, now, dropped_frames, stream );
+
+    fprintf( stream, "raw bytes: %llu - encoded bytes: %llu\n", stats->raw_bytes, stats->encoded_bytes );
+
+    latency_histogram_print( &stats->capture, "capture", stream );
+    latency_histogram_print( &stats->encode_wait, "encode wait", stream );
+    latency_histogram_print( &stats->encode, "encode", stream );
+    latency_histogram_print( &stats->decode_wait, "decode wait", stream );
+    latency_histogram_print( &stats->decode, "decode", stream );
+    latency_histogram_print( &stats->total, "total", stream );
+}
+
+
+//
+void frame_stats_write_csv_header( FILE * const stream )
+{
+    if( stream == NULL )
+    {
+        return;
+    }
+
+
+    fprintf( stream, "frame_id,rx_timestamp,capture_time,queued_time,encode_start_time,encoded_time,decode_start_time,decoded_time,raw_bytes,encoded_bytes,decoded_bytes\n" );
+}
+
+
+//
+void frame_stats_write_csv( FILE * const stream, const video_frame_s * const frame, const unsigned long bytes_decoded )
+{
+    if( (stream == NULL) || (frame == NULL) )
+    {
+        return;
+    }
+
+
+    fprintf( stream, "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%lu,%lu,%lu\n",
+            frame->frame_id,
+            frame->rx_timestamp,
+            frame->capture_time,
+            frame->queued_time,
+            frame->encode_start_time,
+            frame->encoded_time,
+            frame->decode_start_time,
+            frame->decoded_time,
+            frame->source_len,
+            frame->len,
+            bytes_decoded );
+}
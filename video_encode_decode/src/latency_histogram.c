@@ -0,0 +1,248 @@
+/**
+ * @file latency_histogram.c
+ * @brief Latency Histogram Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+// API headers
+#include "polysync_core.h"
+
+#include "latency_histogram.h"
+
+
+
+
+// *****************************************************
+// static global types/macros
+// *****************************************************
+
+/**
+ * @brief Largest trackable latency. [microseconds]
+ *
+ */
+#define         MAX_LATENCY                 ((((ps_timestamp) 1) << LATENCY_HISTOGRAM_MAX_BITS) - 1)
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+/**
+ * @brief Percentiles printed by \ref latency_histogram_print.
+ *
+ */
+static const double PRINTED_PERCENTILES[] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Get the bucket index of a latency.
+ *
+ * @param [in] latency Sample value, at most \ref MAX_LATENCY. [microseconds]
+ *
+ * @return Bucket index.
+ *
+ */
+static unsigned int get_bucket( const ps_timestamp latency );
+
+
+/**
+ * @brief Get the largest latency counted in a bucket.
+ *
+ * @param [in] bucket Bucket index.
+ *
+ * @return Largest latency. [microseconds]
+ *
+ */
+static ps_timestamp get_bucket_limit( const unsigned int bucket );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static unsigned int get_bucket( const ps_timestamp latency )
+{
+    // local vars
+    unsigned int shift = 0;
+
+
+    // exact below the sub-bucket range
+    if( latency < (2 * LATENCY_HISTOGRAM_SUB_BUCKETS) )
+    {
+        return (unsigned int) latency;
+    }
+
+    // drop the bits below the sub-bucket resolution of this power of two
+    shift = (unsigned int) (63 - __builtin_clzll( latency )) - (LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1);
+
+
+    return (shift * LATENCY_HISTOGRAM_SUB_BUCKETS) + (unsigned int) (latency >> shift);
+}
+
+
+//
+static ps_timestamp get_bucket_limit( const unsigned int bucket )
+{
+    // local vars
+    unsigned int shift = 0;
+
+
+    if( bucket < (2 * LATENCY_HISTOGRAM_SUB_BUCKETS) )
+    {
+        return (ps_timestamp) bucket;
+    }
+
+    shift = (bucket / LATENCY_HISTOGRAM_SUB_BUCKETS) - 1;
+
+
+    return ((((ps_timestamp) (bucket - (shift * LATENCY_HISTOGRAM_SUB_BUCKETS))) + 1) << shift) - 1;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+void latency_histogram_reset( latency_histogram_s * const histogram )
+{
+    if( histogram == NULL )
+    {
+        return;
+    }
+
+
+    memset( histogram, 0, sizeof(*histogram) );
+}
+
+
+//
+void latency_histogram_add( latency_histogram_s * const histogram, const ps_timestamp latency )
+{
+    if( histogram == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    const ps_timestamp value = MIN( latency, MAX_LATENCY );
+
+
+    histogram->buckets[ get_bucket( value ) ] += 1;
+
+    if( (histogram->count == 0) || (value < histogram->min) )
+    {
+        histogram->min = value;
+    }
+
+    if( value > histogram->max )
+    {
+        histogram->max = value;
+    }
+
+    histogram->count += 1;
+    histogram->sum += value;
+}
+
+
+//
+double latency_histogram_get_mean( const latency_histogram_s * const histogram )
+{
+    if( (histogram == NULL) || (histogram->count == 0) )
+    {
+        return 0.0;
+    }
+
+
+    return (double) histogram->sum / (double) histogram->count;
+}
+
+
+//
+ps_timestamp latency_histogram_get_percentile( const latency_histogram_s * const histogram, const double percentile )
+{
+    if( (histogram == NULL) || (histogram->count == 0) )
+    {
+        return 0;
+    }
+
+    // local vars
+    const double rank = (percentile / 100.0) * (double) histogram->count;
+    unsigned long long seen = 0;
+    unsigned int bucket = 0;
+
+
+    for( bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; ++bucket )
+    {
+        seen += histogram->buckets[ bucket ];
+
+        if( ((double) seen >= rank) && (seen != 0) )
+        {
+            break;
+        }
+    }
+
+    if( bucket >= LATENCY_HISTOGRAM_BUCKETS )
+    {
+        return histogram->max;
+    }
+
+
+    return MAX( MIN( get_bucket_limit( bucket ), histogram->max ), histogram->min );
+}
+
+
+//
+void latency_histogram_print( const latency_histogram_s * const histogram, const char * const name, FILE * const stream )
+{
+    if( (histogram == NULL) || (name == NULL) || (stream == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+
+
+    if( histogram->count == 0 )
+    {
+        fprintf( stream, "%-12s no samples\n", name );
+        return;
+    }
+
+    fprintf( stream, "%-12s count: %llu - min: %.3f - mean: %.3f",
+            name,
+            histogram->count,
+            (double) histogram->min / 1000.0,
+            latency_histogram_get_mean( histogram ) / 1000.0 );
+
+    for( idx = 0; idx < (sizeof(PRINTED_PERCENTILES) / sizeof(PRINTED_PERCENTILES[ 0 ])); ++idx )
+    {
+        fprintf( stream, " - p%g: %.3f",
+                PRINTED_PERCENTILES[ idx ],
+                (double) latency_histogram_get_percentile( histogram, PRINTED_PERCENTILES[ idx ] ) / 1000.0 );
+    }
+
+    fprintf( stream, " - max: %.3f [ms]\n", (double) histogram->max / 1000.0 );
+}
@@ -29,6 +29,17 @@
  * Shows how to use the Video API routines to communicate with a video device,
  * and encode/decode the data.
  *
+ * Capture, encode and decode run on their own threads, connected by bounded
+ * frame rings, so throughput is limited by the slowest stage rather than by
+ * the sum of all stages.
+ *
+ * Frames come from a video device by default, or from a generated test pattern
+ * or a logfile replay, so the encoder can be benchmarked without a camera.
+ *
+ * In simulcast mode each captured frame is encoded by several encoders, each
+ * on its own thread with its own output resolution and frame rate. They all
+ * read the same reference counted capture buffer, nothing is copied per encoder.
+ *
  */
 
 
@@ -36,14 +47,26 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <glib-2.0/glib.h>
 
 // API headers
 #include "polysync_core.h"
 #include "polysync_sdf.h"
 #include "polysync_video.h"
 
+#include "byte_arena.h"
+#include "frame_pool.h"
+#include "frame_ring.h"
+#include "frame_source.h"
+#include "frame_stats.h"
+#include "latency_histogram.h"
+
 
 
 
@@ -52,6 +75,124 @@
 // *****************************************************
 
 
+/**
+ * @brief Maximum number of simulcast encoder streams.
+ *
+ */
+#define SIMULCAST_MAX_STREAMS (8)
+
+
+/**
+ * @brief Simulcast encoder stream, one encode thread.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    void                        *pipeline; /*!< Pipeline the stream belongs to, \ref pipeline_s. */
+    //
+    //
+    unsigned long               index; /*!< Stream index, the first stream is decoded. */
+    //
+    //
+    unsigned long               width; /*!< Output width. [pixels] */
+    //
+    //
+    unsigned long               height; /*!< Output height. [pixels] */
+    //
+    //
+    unsigned long               frame_divisor; /*!< Encode every n-th captured frame, lowers the frame rate and bitrate. */
+    //
+    //
+    ps_video_encoder            video_encoder; /*!< Video encoder, only used by the encode thread while running. */
+    //
+    //
+    unsigned long               max_encoded_size; /*!< Largest encoded frame, the raw size at the output resolution. [bytes] */
+    //
+    //
+    byte_arena_s                *arena; /*!< Encoded frame data, sized by the actual encoder output. */
+    //
+    //
+    frame_ring_s                *encode_ring; /*!< Captured frames waiting to be encoded. */
+    //
+    //
+    GThread                     *thread; /*!< Encode thread. */
+    //
+    //
+    volatile gint               dropped_frames; /*!< Captured frames dropped because this stream fell behind. */
+    //
+    //
+    unsigned long long          encoded_frames; /*!< Number of frames encoded, encode thread only. */
+    //
+    //
+    unsigned long long          source_bytes; /*!< Sum of the raw frame sizes, encode thread only. [bytes] */
+    //
+    //
+    unsigned long long          encoded_bytes; /*!< Sum of the encoded frame sizes, encode thread only. [bytes] */
+    //
+    //
+    latency_histogram_s         encode; /*!< Encode start to encoded, encode thread only. */
+    //
+    //
+    ps_timestamp                cpu_time; /*!< CPU time used by the encode thread, set when it exits. [microseconds] */
+} encoder_stream_s;
+
+
+/**
+ * @brief Encode/decode pipeline shared by the stage threads.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    encoder_stream_s            streams[ SIMULCAST_MAX_STREAMS ]; /*!< Encoder streams. */
+    //
+    //
+    unsigned long               stream_count; /*!< Number of encoder streams. */
+    //
+    //
+    ps_video_decoder            video_decoder; /*!< Video decoder, only used by the decode thread while running. */
+    //
+    //
+    frame_pool_s                *raw_pool; /*!< Captured frame buffers. */
+    //
+    //
+    frame_pool_s                *encoded_pool; /*!< Encoded frames, their data is attached from the stream arenas. */
+    //
+    //
+    frame_pool_s                *decoded_pool; /*!< Decoded frame buffers, the decoder writes into them. */
+    //
+    //
+    frame_ring_s                *decode_ring; /*!< Encoded frames waiting to be decoded. */
+    //
+    //
+    unsigned long               decoded_frame_size; /*!< Size of a decoded frame. [bytes] */
+    //
+    //
+    GThread                     *decode_thread; /*!< Decode stage thread. */
+    //
+    //
+    ps_timestamp                summary_interval; /*!< Time between summary lines, zero to disable. [microseconds] */
+    //
+    //
+    FILE                        *csv_file; /*!< Per-frame CSV output, NULL if disabled. Decode thread only. */
+    //
+    //
+    frame_stats_s               stats; /*!< Statistics since start, decode thread only. */
+    //
+    //
+    frame_stats_s               interval_stats; /*!< Statistics since the last summary line, decode thread only. */
+    //
+    //
+    unsigned long long          reported_dropped; /*!< Dropped frame count at the last summary line, decode thread only. */
+    //
+    //
+    ps_timestamp                decode_cpu_time; /*!< CPU time used by the decode thread, set when it exits. [microseconds] */
+} pipeline_s;
+
+
 /**
  * @brief Flag indicating exit signal was caught.
  *
@@ -73,6 +214,13 @@ static const char NODE_NAME[] = "polysync-video-encode-decode-c";
 static const char DEFAULT_VIDEO_DEVICE_PATH[] = "/dev/video0";
 
 
+/**
+ * @brief Default frame source.
+ *
+ */
+static const char DEFAULT_FRAME_SOURCE[] = "device";
+
+
 /**
  * @brief Default video width.
  *
@@ -87,6 +235,41 @@ static unsigned long DEFAULT_VIDEO_WIDTH = 640;
 static unsigned long DEFAULT_VIDEO_HEIGHT = 480;
 
 
+/**
+ * @brief Number of frames each ring holds between two stages.
+ *
+ */
+static const unsigned long PIPELINE_RING_CAPACITY = 4;
+
+
+/**
+ * @brief Number of frames in each pool for a single stream, a full ring plus the frames held by the stages on either side.
+ *
+ */
+static const unsigned long PIPELINE_POOL_FRAMES = 4 + 2;
+
+
+/**
+ * @brief Number of decoded frames, one being written plus one held by a consumer.
+ *
+ */
+static const unsigned long DECODED_POOL_FRAMES = 2;
+
+
+/**
+ * @brief Number of typical encoded frames each arena block has room for.
+ *
+ */
+static const unsigned long ARENA_BLOCK_FRAMES = 16;
+
+
+/**
+ * @brief Default time between summary lines. [seconds]
+ *
+ */
+static const double DEFAULT_SUMMARY_INTERVAL = 1.0;
+
+
 
 
 // *****************************************************
@@ -112,6 +295,74 @@ static void error_exit(
         const unsigned int line_num );
 
 
+/**
+ * @brief Encode stage thread, one per stream.
+ *
+ * Encodes captured frames until the stream's encode ring is closed and drained.
+ * The captured frames are shared with the other streams and only read. The
+ * first stream feeds the decode ring and closes it when done, waiting for room
+ * rather than dropping encoded frames, which would break the decoder's reference
+ * chain. The other streams' output is where a node would publish it, here it
+ * is only counted.
+ *
+ * @param [in] user_data A pointer to \ref encoder_stream_s which specifies the stream.
+ *
+ * @return NULL.
+ *
+ */
+static gpointer encode_thread( gpointer user_data );
+
+
+/**
+ * @brief Decode stage thread.
+ *
+ * Decodes encoded frames until the decode ring is closed and drained. Being the
+ * last stage, it also owns the statistics, prints the periodic summary line and
+ * writes the per-frame CSV rows.
+ *
+ * @param [in] user_data A pointer to \ref pipeline_s which specifies the pipeline.
+ *
+ * @return NULL.
+ *
+ */
+static gpointer decode_thread( gpointer user_data );
+
+
+/**
+ * @brief Get the CPU time used so far.
+ *
+ * @param [in] clock_id CLOCK_THREAD_CPUTIME_ID for the calling thread, CLOCK_PROCESS_CPUTIME_ID for all threads.
+ *
+ * @return CPU time. [microseconds]
+ *
+ */
+static ps_timestamp get_cpu_time( const clockid_t clock_id );
+
+
+/**
+ * @brief Get the average time per frame.
+ *
+ * @param [in] time Total time. [microseconds]
+ * @param [in] frames Number of frames.
+ *
+ * @return Time per frame, zero if there are no frames. [milliseconds]
+ *
+ */
+static double get_time_per_frame( const ps_timestamp time, const unsigned long long frames );
+
+
+/**
+ * @brief Check if a stream encodes a captured frame.
+ *
+ * @param [in] stream A pointer to \ref encoder_stream_s which specifies the stream.
+ * @param [in] frame_id Captured frame counter value, starting at one.
+ *
+ * @return Non-zero if the stream encodes the frame, zero otherwise.
+ *
+ */
+static int is_stream_frame( const encoder_stream_s * const stream, const unsigned long long frame_id );
+
+
 
 
 // *****************************************************
@@ -152,6 +403,230 @@ static void error_exit(
 }
 
 
+//
+static gpointer encode_thread( gpointer user_data )
+{
+    // local vars
+    encoder_stream_s * const stream = (encoder_stream_s*) user_data;
+    pipeline_s * const pipeline = (pipeline_s*) stream->pipeline;
+    video_frame_s *raw_frame = NULL;
+    video_frame_s *encoded_frame = NULL;
+    ps_timestamp encode_start_time = 0;
+    unsigned long bytes_encoded = 0;
+    int ret = DTC_NONE;
+
+
+    while( (raw_frame = frame_ring_pop( stream->encode_ring )) != NULL )
+    {
+        // the captured frame is shared with the other streams, it is only read
+        encode_start_time = (ps_timestamp) g_get_monotonic_time();
+
+        // encode the captured raw image data
+        ret = psync_video_encoder_encode(
+                &stream->video_encoder,
+                raw_frame->rx_timestamp,
+                raw_frame->buffer,
+                raw_frame->len );
+
+        // exit if failed
+        error_exit( "psync_video_encoder_encode", ret, __FILE__, __LINE__ );
+
+        // the decode stage returns its frames before waiting on the first stream, and the
+        // pool has one extra frame per other stream, so a frame is always available
+        // room for the largest possible output at the end of the arena
+        if( ((encoded_frame = frame_pool_acquire( pipeline->encoded_pool )) == NULL)
+                || ((encoded_frame->buffer = byte_arena_reserve( stream->arena, stream->max_encoded_size )) == NULL) )
+        {
+            ret = DTC_MEMERR;
+        }
+
+        // exit if failed
+        error_exit( "byte_arena_reserve", ret, __FILE__, __LINE__ );
+
+        // copy the encoded bytes into the arena, this is the encoded byte stream
+        ret = psync_video_encoder_copy_bytes(
+                &stream->video_encoder,
+                encoded_frame->buffer,
+                stream->max_encoded_size,
+                &bytes_encoded );
+
+        // exit if failed
+        error_exit( "psync_video_encoder_copy_bytes", ret, __FILE__, __LINE__ );
+
+        // keep only what the encoder wrote, the next frame follows it
+        encoded_frame->arena_block = byte_arena_commit( stream->arena, bytes_encoded );
+        encoded_frame->size = bytes_encoded;
+
+        encoded_frame->encoded_time = (ps_timestamp) g_get_monotonic_time();
+        encoded_frame->len = bytes_encoded;
+        encoded_frame->source_len = raw_frame->len;
+        encoded_frame->frame_id = raw_frame->frame_id;
+        encoded_frame->rx_timestamp = raw_frame->rx_timestamp;
+        encoded_frame->capture_time = raw_frame->capture_time;
+        encoded_frame->queued_time = raw_frame->queued_time;
+        encoded_frame->encode_start_time = encode_start_time;
+
+        // raw frame is no longer needed by this stream
+        frame_pool_release( raw_frame );
+
+        stream->encoded_frames += 1;
+        stream->source_bytes += encoded_frame->source_len;
+        stream->encoded_bytes += bytes_encoded;
+        latency_histogram_add( &stream->encode, encoded_frame->encoded_time - encode_start_time );
+
+        // if encoder has data available, only the first stream is decoded
+        if( (bytes_encoded != 0) && (stream->index == 0) )
+        {
+            if( frame_ring_push( pipeline->decode_ring, encoded_frame ) != 0 )
+            {
+                frame_pool_release( encoded_frame );
+            }
+        }
+        else
+        {
+            frame_pool_release( encoded_frame );
+        }
+    }
+
+    // no more frames
+    if( stream->index == 0 )
+    {
+        frame_ring_close( pipeline->decode_ring );
+    }
+
+    stream->cpu_time = get_cpu_time( CLOCK_THREAD_CPUTIME_ID );
+
+
+    return NULL;
+}
+
+
+//
+static gpointer decode_thread( gpointer user_data )
+{
+    // local vars
+    pipeline_s * const pipeline = (pipeline_s*) user_data;
+    video_frame_s *encoded_frame = NULL;
+    video_frame_s *decoded_frame = NULL;
+    unsigned long bytes_decoded = 0;
+    unsigned long long dropped_frames = 0;
+    int ret = DTC_NONE;
+
+
+    while( (encoded_frame = frame_ring_pop( pipeline->decode_ring )) != NULL )
+    {
+        // zero
+        bytes_decoded = 0;
+
+        encoded_frame->decode_start_time = (ps_timestamp) g_get_monotonic_time();
+
+        // decode the newly encoded data
+        ret = psync_video_decoder_decode(
+                &pipeline->video_decoder,
+                encoded_frame->rx_timestamp,
+                encoded_frame->buffer,
+                encoded_frame->len );
+
+        // exit if failed
+        error_exit( "psync_video_decoder_decode", ret, __FILE__, __LINE__ );
+
+        // the decoded frames are released before the next one is decoded, so a frame is always available
+        if( (decoded_frame = frame_pool_acquire( pipeline->decoded_pool )) == NULL )
+        {
+            ret = DTC_MEMERR;
+        }
+
+        // exit if failed
+        error_exit( "frame_pool_acquire", ret, __FILE__, __LINE__ );
+
+        // copy the decoded bytes into the pooled buffer, this is the raw frame is our desired pixel format
+        ret = psync_video_decoder_copy_bytes(
+                &pipeline->video_decoder,
+                decoded_frame->buffer,
+                decoded_frame->size,
+                &bytes_decoded );
+
+        // exit if failed
+        error_exit( "psync_video_decoder_copy_bytes", ret, __FILE__, __LINE__ );
+
+        encoded_frame->decoded_time = (ps_timestamp) g_get_monotonic_time();
+
+        decoded_frame->len = bytes_decoded;
+        decoded_frame->frame_id = encoded_frame->frame_id;
+        decoded_frame->rx_timestamp = encoded_frame->rx_timestamp;
+
+        // a consumer would take the decoded frame here and release it when done
+        frame_pool_release( decoded_frame );
+
+        frame_stats_add( &pipeline->stats, encoded_frame, bytes_decoded );
+        frame_stats_add( &pipeline->interval_stats, encoded_frame, bytes_decoded );
+
+        // buffered, unlike printing to a terminal this costs next to nothing per frame
+        frame_stats_write_csv( pipeline->csv_file, encoded_frame, bytes_decoded );
+
+        // print and restart the interval statistics
+        if( (pipeline->summary_interval != 0)
+                && ((encoded_frame->decoded_time - pipeline->interval_stats.start_time) >= pipeline->summary_interval) )
+        {
+            dropped_frames = (unsigned long long) g_atomic_int_get( &pipeline->streams[ 0 ].dropped_frames );
+
+            frame_stats_print_summary(
+                    &pipeline->interval_stats,
+                    encoded_frame->decoded_time,
+                    dropped_frames - pipeline->reported_dropped,
+                    stdout );
+
+            frame_stats_reset( &pipeline->interval_stats, encoded_frame->decoded_time );
+            pipeline->reported_dropped = dropped_frames;
+        }
+
+        frame_pool_release( encoded_frame );
+    }
+
+    pipeline->decode_cpu_time = get_cpu_time( CLOCK_THREAD_CPUTIME_ID );
+
+
+    return NULL;
+}
+
+
+//
+static ps_timestamp get_cpu_time( const clockid_t clock_id )
+{
+    // local vars
+    struct timespec now;
+
+
+    if( clock_gettime( clock_id, &now ) != 0 )
+    {
+        return 0;
+    }
+
+
+    return ((ps_timestamp) now.tv_sec * 1000000) + ((ps_timestamp) now.tv_nsec / 1000);
+}
+
+
+//
+static double get_time_per_frame( const ps_timestamp time, const unsigned long long frames )
+{
+    if( frames == 0 )
+    {
+        return 0.0;
+    }
+
+
+    return ((double) time / 1000.0) / (double) frames;
+}
+
+
+//
+static int is_stream_frame( const encoder_stream_s * const stream, const unsigned long long frame_id )
+{
+    return ((frame_id - 1) % stream->frame_divisor) == 0;
+}
+
+
 
 
 // *****************************************************
@@ -166,97 +641,241 @@ int main( int argc, char **argv )
     // timestamp for the incoming raw image data
     ps_timestamp rx_timestamp = 0;
 
-    // desired video device pixel format, also known as YUY2
-    ps_pixel_format_kind desired_device_format = PIXEL_FORMAT_YUYV;
-
     // desired decoder output pixel format, RGB
     ps_pixel_format_kind desired_decoder_format = PIXEL_FORMAT_RGB24;
 
-    // size in bytes of the decoded image data
-    unsigned long decoded_frame_size = 0;
+    // frame counter
+    unsigned long frame_counter = 0;
 
-    // number of bytes encoded per frame
-    unsigned long bytes_encoded = 0;
+    // node reference, only needed to read a logfile
+    ps_node_ref node_ref = PSYNC_NODE_REF_INVALID;
 
-    // number of bytes decoded per frame
-    unsigned long bytes_decoded = 0;
+    // frame source - video device like '/dev/video0', test pattern or logfile
+    frame_source_s frame_source;
 
-    // frame counter
-    unsigned long frame_counter = 0;
+    // frame source kind name
+    const char *source_name = DEFAULT_FRAME_SOURCE;
+
+    // logfile to replay, NULL if not replaying
+    const char *logfile_path = NULL;
+
+    // frame size
+    unsigned long video_width = DEFAULT_VIDEO_WIDTH;
+    unsigned long video_height = DEFAULT_VIDEO_HEIGHT;
+
+    // frame rate, zero lets synthetic sources run unpaced
+    long frame_rate = PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND;
+
+    // number of frames to capture, zero runs until control-c
+    long max_frames = 0;
+
+    // unpaced synthetic sources wait for the encoder instead of dropping, to measure its throughput
+    int wait_for_encoder = 0;
+
+    // CPU time used by the capture stage, and by the process while running
+    ps_timestamp capture_cpu_time = 0;
+    ps_timestamp process_cpu_time = 0;
+
+    // time the capture loop ran
+    ps_timestamp elapsed_time = 0;
+
+    // encode/decode pipeline
+    pipeline_s pipeline;
 
-    // video device - provides access to device like '/dev/video0'
-    ps_video_device video_device;
+    // simulcast stream being set up, parsed or fed
+    encoder_stream_s *stream = NULL;
+    unsigned long idx = 0;
 
-    // video encoder - converts raw image device data into compressed stream
-    ps_video_encoder video_encoder;
+    // encode CPU time of all streams
+    ps_timestamp encode_cpu_time = 0;
 
-    // video decoder - converts compressed stream into raw image
-    ps_video_decoder video_decoder;
+    // peak memory of the encoded frame arenas, and of the process
+    unsigned long encoded_peak_bytes = 0;
+    struct rusage usage;
 
-    // local encoder data buffer - filled by the encoder
-    unsigned char *encoder_buffer = NULL;
+    // captured frame
+    video_frame_s *raw_frame = NULL;
 
-    // local decoder data buffer - filled by the decoder
-    unsigned char *decoder_buffer = NULL;
+    // time between summary lines
+    double summary_interval = DEFAULT_SUMMARY_INTERVAL;
+
+    // per-frame CSV output path, NULL if disabled
+    const char *csv_path = NULL;
+
+    // getopt return
+    int optret = 0;
 
 
     // zero
-    memset( &video_device, 0, sizeof(video_device) );
-    memset( &video_encoder, 0, sizeof(video_encoder) );
-    memset( &video_decoder, 0, sizeof(video_decoder) );
+    memset( &frame_source, 0, sizeof(frame_source) );
+    memset( &pipeline, 0, sizeof(pipeline) );
+    memset( &usage, 0, sizeof(usage) );
 
-    // nodes typically should shutdown after handling SIGINT
-    // hook up the control-c signal handler, sets exit signaled flag
-    signal( SIGINT, sig_handler );
+    // parse options
+    while( (optret = getopt( argc, argv, "i:c:s:l:W:H:f:n:e:" )) != -1 )
+    {
+        if( (optret == 'i') && (atof( optarg ) >= 0.0) )
+        {
+            summary_interval = atof( optarg );
+        }
+        else if( optret == 'c' )
+        {
+            csv_path = optarg;
+        }
+        else if( (optret == 's') && (frame_source_get_kind( optarg ) != FRAME_SOURCE_KIND_COUNT) )
+        {
+            source_name = optarg;
+        }
+        else if( optret == 'l' )
+        {
+            source_name = "logfile";
+            logfile_path = optarg;
+        }
+        else if( (optret == 'W') && (atol( optarg ) > 0) )
+        {
+            video_width = (unsigned long) atol( optarg );
+        }
+        else if( (optret == 'H') && (atol( optarg ) > 0) )
+        {
+            video_height = (unsigned long) atol( optarg );
+        }
+        else if( (optret == 'f') && (atol( optarg ) >= 0) )
+        {
+            frame_rate = atol( optarg );
+        }
+        else if( (optret == 'n') && (atol( optarg ) >= 0) )
+        {
+            max_frames = atol( optarg );
+        }
+        else if( (optret == 'e') && (pipeline.stream_count < SIMULCAST_MAX_STREAMS) )
+        {
+            stream = &pipeline.streams[ pipeline.stream_count ];
+            stream->frame_divisor = 1;
 
-    // allow signals to interrupt
-    siginterrupt( SIGINT, 1 );
+            // <width>x<height>[:<frame divisor>], YUYV needs an even width
+            if( (sscanf( optarg, "%lux%lu:%lu", &stream->width, &stream->height, &stream->frame_divisor ) < 2)
+                    || (stream->width == 0) || ((stream->width % 2) != 0)
+                    || (stream->height == 0) || (stream->frame_divisor == 0) )
+            {
+                printf( "invalid stream '%s', expected <width>x<height>[:<frame divisor>]\n", optarg );
+                return EXIT_FAILURE;
+            }
 
-    // open video device
-    ret = psync_video_open( &video_device, DEFAULT_VIDEO_DEVICE_PATH );
+            pipeline.stream_count += 1;
+        }
+        else
+        {
+            printf( "usage: %s [-s <device|gradient|noise|static>] [-l <logfile to replay>] "
+                    "[-W <width>] [-H <height>] [-f <frames per second, 0 is unpaced>] "
+                    "[-n <frames to capture, 0 runs until control-c>] "
+                    "[-e <width>x<height>[:<frame divisor>], repeat for simulcast, the first is decoded] "
+                    "[-i <summary interval seconds, 0 disables>] [-c <per-frame csv file>]\n",
+                    argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+    }
 
-    // exit if failed
-    error_exit( "psync_video_open", ret, __FILE__, __LINE__ );
+    if( (frame_source_get_kind( source_name ) == FRAME_SOURCE_LOGFILE) && (logfile_path == NULL) )
+    {
+        printf( "a logfile source needs -l <logfile to replay>\n" );
+        return EXIT_FAILURE;
+    }
 
-    // check if desired configuration is available
-    ret = psync_video_check_format(
-            &video_device,
-            desired_device_format,
-            DEFAULT_VIDEO_WIDTH,
-            DEFAULT_VIDEO_HEIGHT );
+    pipeline.summary_interval = (ps_timestamp) (summary_interval * 1000000.0);
 
-    // exit if failed
-    error_exit( "psync_video_check_format", ret, __FILE__, __LINE__ );
+    // open per-frame CSV output
+    if( csv_path != NULL )
+    {
+        if( (pipeline.csv_file = fopen( csv_path, "w" )) == NULL )
+        {
+            ret = DTC_IOERR;
+        }
 
-    // set configuration
-    ret = psync_video_set_format(
-            &video_device,
-            desired_device_format,
-            DEFAULT_VIDEO_WIDTH,
-            DEFAULT_VIDEO_HEIGHT );
+        // exit if failed
+        error_exit( "fopen", ret, __FILE__, __LINE__ );
 
-    // exit if failed
-    error_exit( "psync_video_set_format", ret, __FILE__, __LINE__ );
+        frame_stats_write_csv_header( pipeline.csv_file );
+    }
 
-    // set frame rate
-    ret = psync_video_set_frame_rate(
-            &video_device,
-            PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND );
+    // nodes typically should shutdown after handling SIGINT
+    // hook up the control-c signal handler, sets exit signaled flag
+    signal( SIGINT, sig_handler );
 
-    // exit if failed
-    error_exit( "psync_video_set_frame_rate", ret, __FILE__, __LINE__ );
+    // allow signals to interrupt
+    siginterrupt( SIGINT, 1 );
 
-    // enable streaming, this starts the capturing of data
-    ret = psync_video_enable_streaming( &video_device );
+    // open the frame source
+    if( frame_source_get_kind( source_name ) == FRAME_SOURCE_DEVICE )
+    {
+        // a video device is always paced by the device
+        if( frame_rate == 0 )
+        {
+            frame_rate = PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND;
+        }
+
+        ret = frame_source_open_device(
+                &frame_source,
+                DEFAULT_VIDEO_DEVICE_PATH,
+                video_width,
+                video_height,
+                (unsigned long) frame_rate );
+    }
+    else if( frame_source_get_kind( source_name ) == FRAME_SOURCE_LOGFILE )
+    {
+        // init core API, the logfile API needs a node
+        ret = psync_init(
+                NODE_NAME,
+                PSYNC_NODE_TYPE_API_USER,
+                PSYNC_DEFAULT_DOMAIN,
+                PSYNC_SDF_ID_INVALID,
+                PSYNC_INIT_FLAG_STDOUT_LOGGING,
+                &node_ref );
+
+        // exit if failed
+        error_exit( "psync_init", ret, __FILE__, __LINE__ );
+
+        ret = frame_source_open_logfile( &frame_source, node_ref, logfile_path, (unsigned long) frame_rate );
+
+        // the frames are in memory, release core API so it does not run during the benchmark
+        (void) psync_release( &node_ref );
+    }
+    else
+    {
+        ret = frame_source_open_pattern(
+                &frame_source,
+                frame_source_get_kind( source_name ),
+                video_width,
+                video_height,
+                (unsigned long) frame_rate );
+    }
 
     // exit if failed
-    error_exit( "psync_video_enable_streaming", ret, __FILE__, __LINE__ );
+    error_exit( "frame_source_open", ret, __FILE__, __LINE__ );
+
+    wait_for_encoder = (frame_source.frame_rate == 0);
 
-    // set the decoded frame size, RGB
-    decoded_frame_size = DEFAULT_VIDEO_WIDTH * DEFAULT_VIDEO_HEIGHT * 3;
+    // without simulcast, a single stream encodes at the source resolution
+    if( pipeline.stream_count == 0 )
+    {
+        pipeline.streams[ 0 ].width = frame_source.width;
+        pipeline.streams[ 0 ].height = frame_source.height;
+        pipeline.streams[ 0 ].frame_divisor = 1;
+        pipeline.stream_count = 1;
+    }
 
-    // allocate encoder buffer, enough space for a full raw frame
-    if( (encoder_buffer = malloc( video_device.buffer_len )) == NULL )
+    // set the decoded frame size of the first stream, RGB
+    pipeline.decoded_frame_size = pipeline.streams[ 0 ].width * pipeline.streams[ 0 ].height * 3;
+
+    // allocate captured frame pool, enough space for a full raw frame each, the
+    // streams share the frames but each may hold a different full ring of them
+    // allocate encoded frame pool, plus one for each stream that is not decoded, the
+    // data is attached from the stream arenas so the frames have no buffers
+    // allocate decoded frame pool, enough space for a full raw frame in the desired pixel format which is RGB in this example
+    if( ((pipeline.raw_pool = frame_pool_new(
+                    PIPELINE_POOL_FRAMES + ((pipeline.stream_count - 1) * (PIPELINE_RING_CAPACITY + 1)),
+                    frame_source.frame_size )) == NULL)
+            || ((pipeline.encoded_pool = frame_pool_new( PIPELINE_POOL_FRAMES + (pipeline.stream_count - 1), 0 )) == NULL)
+            || ((pipeline.decoded_pool = frame_pool_new( DECODED_POOL_FRAMES, pipeline.decoded_frame_size )) == NULL) )
     {
         ret = DTC_MEMERR;
     }
@@ -264,144 +883,265 @@ int main( int argc, char **argv )
     // exit if failed
     error_exit( "malloc", ret, __FILE__, __LINE__ );
 
-    // allocate decoder buffer, enough space for a full raw frame in the desired pixel format which is RGB in this example
-    if( (decoder_buffer = malloc( decoded_frame_size )) == NULL )
+    // create the ring between the encode and decode stages
+    if( (pipeline.decode_ring = frame_ring_new( PIPELINE_RING_CAPACITY )) == NULL )
     {
         ret = DTC_MEMERR;
     }
 
     // exit if failed
-    error_exit( "malloc", ret, __FILE__, __LINE__ );
+    error_exit( "frame_ring_new", ret, __FILE__, __LINE__ );
 
-    // initialize h264 encoder
-    ret = psync_video_encoder_init(
-            &video_encoder,
-            desired_device_format,
-            DEFAULT_VIDEO_WIDTH,
-            DEFAULT_VIDEO_HEIGHT,
-            PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND,
-            PIXEL_FORMAT_H264,
-            DEFAULT_VIDEO_WIDTH,
-            DEFAULT_VIDEO_HEIGHT );
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
+    {
+        stream = &pipeline.streams[ idx ];
+        stream->pipeline = &pipeline;
+        stream->index = idx;
 
-    // exit if failed
-    error_exit( "psync_video_encoder_init", ret, __FILE__, __LINE__ );
+        // the encoder never outputs more than a raw frame at the output resolution
+        stream->max_encoded_size = stream->width * stream->height * 2;
 
-    // initialize h264 decoder, frame-rate will be determined by stream if possible, otherwise use default
+        // create the ring between the capture and encode stages
+        // create the arena holding the encoded frames, it grows to fit what the encoder outputs
+        if( ((stream->encode_ring = frame_ring_new( PIPELINE_RING_CAPACITY )) == NULL)
+                || ((stream->arena = byte_arena_new( ARENA_BLOCK_FRAMES )) == NULL) )
+        {
+            ret = DTC_MEMERR;
+        }
+
+        // exit if failed
+        error_exit( "frame_ring_new", ret, __FILE__, __LINE__ );
+
+        // initialize h264 encoder, scaling to the stream resolution
+        ret = psync_video_encoder_init(
+                &stream->video_encoder,
+                PIXEL_FORMAT_YUYV,
+                frame_source.width,
+                frame_source.height,
+                MAX( ((frame_rate != 0) ? (unsigned long) frame_rate : PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND) / stream->frame_divisor, 1 ),
+                PIXEL_FORMAT_H264,
+                stream->width,
+                stream->height );
+
+        // exit if failed
+        error_exit( "psync_video_encoder_init", ret, __FILE__, __LINE__ );
+    }
+
+    // initialize h264 decoder for the first stream, frame-rate will be determined by stream if possible, otherwise use default
     ret = psync_video_decoder_init(
-            &video_decoder,
+            &pipeline.video_decoder,
             PIXEL_FORMAT_H264,
-            DEFAULT_VIDEO_WIDTH,
-            DEFAULT_VIDEO_HEIGHT,
+            pipeline.streams[ 0 ].width,
+            pipeline.streams[ 0 ].height,
             desired_decoder_format,
-            DEFAULT_VIDEO_WIDTH,
-            DEFAULT_VIDEO_HEIGHT,
+            pipeline.streams[ 0 ].width,
+            pipeline.streams[ 0 ].height,
             PSYNC_VIDEO_DEFAULT_FRAMES_PER_SECOND );
 
     // exit if failed
     error_exit( "psync_video_decoder_init", ret, __FILE__, __LINE__ );
 
+    // statistics start now
+    frame_stats_reset( &pipeline.stats, (ps_timestamp) g_get_monotonic_time() );
+    frame_stats_reset( &pipeline.interval_stats, pipeline.stats.start_time );
+    capture_cpu_time = get_cpu_time( CLOCK_THREAD_CPUTIME_ID );
+    process_cpu_time = get_cpu_time( CLOCK_PROCESS_CPUTIME_ID );
 
-    // main event loop
-    // loop until signaled (control-c)
-    while( global_exit_signal == 0 )
+    // start the encode and decode stages
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
     {
-        // zero
-        bytes_encoded = 0;
-        bytes_decoded = 0;
+        if( (pipeline.streams[ idx ].thread = g_thread_try_new( "encode", encode_thread, &pipeline.streams[ idx ], NULL )) == NULL )
+        {
+            ret = DTC_OSERR;
+        }
+    }
+
+    if( (pipeline.decode_thread = g_thread_try_new( "decode", decode_thread, &pipeline, NULL )) == NULL )
+    {
+        ret = DTC_OSERR;
+    }
 
+    // exit if failed
+    error_exit( "g_thread_try_new", ret, __FILE__, __LINE__ );
+
+
+    // main event loop, this is the capture stage
+    // loop until signaled (control-c) or enough frames were captured
+    while( (global_exit_signal == 0) && ((max_frames == 0) || (frame_counter < (unsigned long) max_frames)) )
+    {
         // wait up to 20 ms for image data
-        ret = psync_video_poll( &video_device, 20000, &rx_timestamp );
+        ret = frame_source_poll( &frame_source, 20000, &rx_timestamp );
 
         // error check
         if( ret == DTC_NONE )
         {
             // data is available
-            // we can access the data in \ref ps_video_device.buffer
+            // we can access the data in \ref frame_source_s.buffer
             frame_counter += 1;
 
-            printf( "frame[%lu] - rx: %llu\n", frame_counter, rx_timestamp );
+            // the source buffer is reused by the next poll, copy the frame out
+            if( (raw_frame = frame_pool_acquire( pipeline.raw_pool )) == NULL )
+            {
+                // every stream misses this frame
+                for( idx = 0; idx < pipeline.stream_count; ++idx )
+                {
+                    if( is_stream_frame( &pipeline.streams[ idx ], frame_counter ) != 0 )
+                    {
+                        g_atomic_int_inc( &pipeline.streams[ idx ].dropped_frames );
+                    }
+                }
 
-            // encode the raw image data stored in the video device handle
-            ret = psync_video_encoder_encode(
-                    &video_encoder,
-                    rx_timestamp,
-                    video_device.buffer,
-                    video_device.buffer_len );
+                continue;
+            }
 
-            // exit if failed
-            error_exit( "psync_video_encoder_encode", ret, __FILE__, __LINE__ );
+            raw_frame->capture_time = (ps_timestamp) g_get_monotonic_time();
+            raw_frame->frame_id = frame_counter;
+            raw_frame->rx_timestamp = rx_timestamp;
+            raw_frame->len = MIN( frame_source.buffer_len, raw_frame->size );
 
-            // copy the encoded bytes into our local buffer, this is the encoded byte stream
-            ret = psync_video_encoder_copy_bytes(
-                    &video_encoder,
-                    encoder_buffer,
-                    video_device.buffer_len,
-                    &bytes_encoded );
+            memcpy( raw_frame->buffer, frame_source.buffer, raw_frame->len );
 
-            // exit if failed
-            error_exit( "psync_video_encoder_copy_bytes", ret, __FILE__, __LINE__ );
+            raw_frame->queued_time = (ps_timestamp) g_get_monotonic_time();
 
-            // if encoder has data available
-            if( bytes_encoded != 0 )
+            // the frame is read-only from here, each stream it is queued to holds a reference
+            for( idx = 0; idx < pipeline.stream_count; ++idx )
             {
-                printf( "    number of bytes in encoder buffer: %lu\n", bytes_encoded );
-
-                // decode the newly encoded data
-                ret = psync_video_decoder_decode(
-                        &video_decoder,
-                        rx_timestamp,
-                        encoder_buffer,
-                        bytes_encoded );
-
-                // exit if failed
-                error_exit( "psync_video_decoder_decode", ret, __FILE__, __LINE__ );
-
-                // copy the decoded bytes into our local buffer, this is the raw frame is our desired pixel format
-                ret = psync_video_decoder_copy_bytes(
-                        &video_decoder,
-                        decoder_buffer,
-                        decoded_frame_size,
-                        &bytes_decoded );
-
-                // exit if failed
-                error_exit( "psync_video_decoder_copy_bytes", ret, __FILE__, __LINE__ );
-
-                // if decoder has data available
-                if( bytes_decoded != 0 )
+                stream = &pipeline.streams[ idx ];
+
+                if( is_stream_frame( stream, frame_counter ) == 0 )
+                {
+                    continue;
+                }
+
+                frame_pool_ref( raw_frame );
+
+                if( wait_for_encoder != 0 )
                 {
-                    printf( "    number of bytes in encoder buffer: %lu\n", bytes_decoded );
+                    // the ring is only closed by this thread, the push always succeeds
+                    (void) frame_ring_push( stream->encode_ring, raw_frame );
+                }
+                else if( frame_ring_try_push( stream->encode_ring, raw_frame ) != 0 )
+                {
+                    // drop rather than stall the video device when the stream falls behind
+                    frame_pool_release( raw_frame );
+                    g_atomic_int_inc( &stream->dropped_frames );
                 }
             }
+
+            // the streams hold their own references
+            frame_pool_release( raw_frame );
         }
         else if( ret != DTC_UNAVAILABLE )
         {
             // not no-data/timeout, this is an error
             // exit if failed
-            error_exit( "psync_video_poll", ret, __FILE__, __LINE__ );
+            error_exit( "frame_source_poll", ret, __FILE__, __LINE__ );
         }
     }
 
+    capture_cpu_time = get_cpu_time( CLOCK_THREAD_CPUTIME_ID ) - capture_cpu_time;
 
-    // release and close video device
-    (void) psync_video_close( &video_device );
 
-    // release video encoder
-    (void) psync_video_encoder_release( &video_encoder );
+    // let the stages drain the frames in flight and exit
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
+    {
+        frame_ring_close( pipeline.streams[ idx ].encode_ring );
+    }
+
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
+    {
+        (void) g_thread_join( pipeline.streams[ idx ].thread );
+        encode_cpu_time += pipeline.streams[ idx ].cpu_time;
+    }
+
+    (void) g_thread_join( pipeline.decode_thread );
+
+    process_cpu_time = get_cpu_time( CLOCK_PROCESS_CPUTIME_ID ) - process_cpu_time;
+    elapsed_time = (ps_timestamp) g_get_monotonic_time() - pipeline.stats.start_time;
+
+    // achieved frame rates, per-stage latency since start
+    printf( "source: %s %lux%lu - captured frames: %lu - capture fps: %.1f\n",
+            source_name,
+            frame_source.width,
+            frame_source.height,
+            frame_counter,
+            (elapsed_time != 0) ? ((double) frame_counter / ((double) elapsed_time / 1000000.0)) : 0.0 );
+    frame_stats_print(
+            &pipeline.stats,
+            pipeline.stats.start_time + elapsed_time,
+            (unsigned long long) g_atomic_int_get( &pipeline.streams[ 0 ].dropped_frames ),
+            stdout );
+
+    // each stream's output, the first one is the one decoded above
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
+    {
+        stream = &pipeline.streams[ idx ];
+
+        encoded_peak_bytes += byte_arena_get_peak_bytes( stream->arena );
+
+        printf( "stream %lu: %lux%lu every %lu frames - encoded: %llu - dropped: %d - compression: %.4f - cpu per frame [ms]: %.3f - arena peak [bytes]: %lu\n",
+                idx,
+                stream->width,
+                stream->height,
+                stream->frame_divisor,
+                stream->encoded_frames,
+                g_atomic_int_get( &stream->dropped_frames ),
+                (stream->source_bytes != 0) ? ((double) stream->encoded_bytes / (double) stream->source_bytes) : 0.0,
+                get_time_per_frame( stream->cpu_time, stream->encoded_frames ),
+                byte_arena_get_peak_bytes( stream->arena ) );
+
+        latency_histogram_print( &stream->encode, "encode", stdout );
+    }
+
+    // CPU per captured frame for capture, per frame that reached the decoder for the rest, encode sums all streams
+    printf( "cpu per frame [ms] - capture: %.3f - encode: %.3f - decode: %.3f - process: %.3f\n",
+            get_time_per_frame( capture_cpu_time, frame_counter ),
+            get_time_per_frame( encode_cpu_time, pipeline.stats.frames ),
+            get_time_per_frame( pipeline.decode_cpu_time, pipeline.stats.frames ),
+            get_time_per_frame( process_cpu_time, pipeline.stats.frames ) );
+
+    // frame memory, encoded is the sum of the arena peaks, and the resident set peak of the whole process
+    (void) getrusage( RUSAGE_SELF, &usage );
+
+    printf( "peak memory [bytes] - raw frames: %lu - encoded frames: %lu - decoded frames: %lu - process: %ld\n",
+            pipeline.raw_pool->count * pipeline.raw_pool->buffer_size,
+            encoded_peak_bytes,
+            pipeline.decoded_pool->count * pipeline.decoded_pool->buffer_size,
+            usage.ru_maxrss * 1024 );
+
+    // close per-frame CSV output
+    if( pipeline.csv_file != NULL )
+    {
+        fclose( pipeline.csv_file );
+    }
+
+    // close frame source, this releases the video device
+    frame_source_close( &frame_source );
+
+    // release video encoders
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
+    {
+        (void) psync_video_encoder_release( &pipeline.streams[ idx ].video_encoder );
+    }
 
     // release video decoder
-    (void) psync_video_decoder_release( &video_decoder );
+    (void) psync_video_decoder_release( &pipeline.video_decoder );
 
-    // free encoder buffer
-    if( encoder_buffer != NULL )
+    // free rings, then the pools their frames belong to
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
     {
-        free(encoder_buffer);
+        frame_ring_free( pipeline.streams[ idx ].encode_ring );
     }
 
-    // free decoder buffer
-    if( decoder_buffer != NULL )
+    frame_ring_free( pipeline.decode_ring );
+    frame_pool_free( pipeline.raw_pool );
+    frame_pool_free( pipeline.encoded_pool );
+    frame_pool_free( pipeline.decoded_pool );
+
+    // free the arenas, the encoded frames holding their data are back in the pool
+    for( idx = 0; idx < pipeline.stream_count; ++idx )
     {
-        free(decoder_buffer);
+        byte_arena_free( pipeline.streams[ idx ].arena );
     }
 
 
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2016 PolySync
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file drawable_ring.h
+ * @brief Drawable Record Ring Interface.
+ *
+ * Preallocated ring of compact drawable records filled by the PolySync message
+ * handler and consumed by \ref ps_process_message. Records and their item/point
+ * storage are recycled, so steady-state handoff doesn't allocate or deep copy messages.
+ * When the consumer falls behind, the oldest waiting record is overwritten so the
+ * newest data is always drawn. Point storage of released records is kept in a few
+ * spare buffers rather than in every record.
+ *
+ */
+
+
+
+
+#ifndef DRAWABLE_RING_H
+#define	DRAWABLE_RING_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+
+#include "gl_headers.h"
+
+
+
+
+/**
+ * @brief Number of released point buffers kept for reuse, others are freed.
+ *
+ */
+#define         DRAWABLE_RING_SPARE_POINTS          (8)
+
+
+
+
+/**
+ * @brief Drawable record kinds, one per handled message type.
+ *
+ */
+typedef enum
+{
+    //
+    //
+    DRAWABLE_RECORD_RADAR_TARGETS = 0, /*!< Radar targets, from ps_radar_targets_msg. */
+    //
+    //
+    DRAWABLE_RECORD_LIDAR_POINTS, /*!< LiDAR points, from ps_lidar_points_msg. */
+    //
+    //
+    DRAWABLE_RECORD_OBJECTS, /*!< Objects, from ps_objects_msg. */
+    //
+    //
+    DRAWABLE_RECORD_KIND_COUNT, /*!< Number of \ref drawable_record_kind values. */
+} drawable_record_kind;
+
+
+/**
+ * @brief Drawable record states.
+ *
+ */
+typedef enum
+{
+    //
+    //
+    DRAWABLE_RECORD_FREE = 0, /*!< Not in use. */
+    //
+    //
+    DRAWABLE_RECORD_WRITING, /*!< Reserved by the handler, being filled. */
+    //
+    //
+    DRAWABLE_RECORD_READY, /*!< Committed, ready to be consumed. */
+} drawable_record_state;
+
+
+/**
+ * @brief Compact drawable item.
+ *
+ * The fields of a radar target or object the viewer needs, unavailable values are zero.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long long      id; /*!< Track/object identifier. */
+    //
+    //
+    GLdouble                position[ 3 ]; /*!< Position. [meters] */
+    //
+    //
+    GLdouble                size[ 3 ]; /*!< Length, width, height. [meters] */
+    //
+    //
+    GLdouble                velocity[ 3 ]; /*!< Velocity. [meters/second] */
+    //
+    //
+    GLdouble                orientation; /*!< Orientation. [radians] */
+    //
+    //
+    GLdouble                adjusted_radius; /*!< Radar amplitude mapped radius. [meters] */
+} drawable_item_s;
+
+
+/**
+ * @brief Drawable record.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    drawable_record_state   state; /*!< Record state, guarded by \ref drawable_ring_s.lock. */
+    //
+    //
+    drawable_record_kind    kind; /*!< Record kind. */
+    //
+    //
+    ps_guid                 src_guid; /*!< Source node GUID. */
+    //
+    //
+    unsigned long long      sensor_id; /*!< Sensor identifier. */
+    //
+    //
+    GArray                  *items; /*!< Items (\ref drawable_item_s) of radar target and object records. */
+    //
+    //
+    ps_lidar_point          *points; /*!< Points of LiDAR records. */
+    //
+    //
+    unsigned long           num_points; /*!< Number of points. */
+    //
+    //
+    unsigned long           point_capacity; /*!< Capacity of points. [points] */
+} drawable_record_s;
+
+
+/**
+ * @brief Drawable record ring.
+ *
+ * Records are reserved and committed in order at the tail by the handler(s),
+ * acquired and released in order at the head by the consumer.
+ * The ring holds pointers to the records so a record overwritten when the ring
+ * is full can be moved from the middle of the ring to the tail.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GMutex                  lock; /*!< Guards the indices, slots, record states and spare point buffers. */
+    //
+    //
+    drawable_record_s       *records; /*!< Record storage. */
+    //
+    //
+    drawable_record_s       **slots; /*!< Records in ring order. */
+    //
+    //
+    guint                   capacity; /*!< Number of records. */
+    //
+    //
+    guint                   head; /*!< Index of the slot holding the oldest record in use. */
+    //
+    //
+    guint                   count; /*!< Number of records in use, reserved or ready. */
+    //
+    //
+    guint                   acquired; /*!< Number of records at the head handed to the consumer. */
+    //
+    //
+    unsigned long long      overflows; /*!< Waiting records overwritten, or records not reserved, because the ring was full. */
+    //
+    //
+    ps_lidar_point          *spare_points[ DRAWABLE_RING_SPARE_POINTS ]; /*!< Point storage of released records. */
+    //
+    //
+    unsigned long           spare_point_capacity[ DRAWABLE_RING_SPARE_POINTS ]; /*!< Capacity of each spare point buffer. [points] */
+    //
+    //
+    guint                   spare_count; /*!< Number of spare point buffers. */
+    //
+    //
+    int                     notify_fd; /*!< Event file descriptor, readable while committed records wait to be acquired. */
+    //
+    //
+    unsigned int            notified; /*!< Non-zero while \ref drawable_ring_s.notify_fd is signaled. */
+} drawable_ring_s;
+
+
+
+
+/**
+ * @brief Create a drawable record ring.
+ *
+ * @param [in] capacity Number of records.
+ *
+ * @return A newly created ring on success, NULL on failure.
+ *
+ */
+drawable_ring_s *drawable_ring_new( const guint capacity );
+
+
+/**
+ * @brief Free a drawable record ring.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring to free. NULL is acceptable.
+ *
+ */
+void drawable_ring_free( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Reserve the next free record.
+ *
+ * If the ring is full, the oldest committed record not yet acquired is
+ * overwritten instead and moved to the tail.
+ * The record's items and points are emptied, storage is kept.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ * @return A pointer to the reserved record, NULL if every record is being written or was acquired.
+ *
+ */
+drawable_record_s *drawable_ring_reserve( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Commit a reserved record, making it available to the consumer.
+ *
+ * Signals \ref drawable_ring_s.notify_fd if it isn't already.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the record returned by \ref drawable_ring_reserve.
+ *
+ */
+void drawable_ring_commit( drawable_ring_s * const ring, drawable_record_s * const record );
+
+
+/**
+ * @brief Acquire ready records from the head of the ring.
+ *
+ * Stops at the first record still being written. Acquired records must be
+ * released with \ref drawable_ring_release before acquiring again.
+ * Clears \ref drawable_ring_s.notify_fd once no ready records are left.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ * @param [out] records A pointer to GPtrArray which receives the records, oldest first.
+ * @param [in] max_records Maximum number of records to acquire.
+ *
+ * @return Number of records acquired.
+ *
+ */
+guint drawable_ring_acquire( drawable_ring_s * const ring, GPtrArray * const records, const guint max_records );
+
+
+/**
+ * @brief Release all acquired records back to the handler(s).
+ *
+ * Their point storage goes to the spare buffers, or is freed if there are enough spares.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ */
+void drawable_ring_release( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Make sure a record can hold a number of points.
+ *
+ * Takes a spare point buffer if the record has no storage large enough,
+ * storage is only reallocated if the spare is too small.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring holding the record.
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the record.
+ * @param [in] num_points Number of points.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+int drawable_record_reserve_points( drawable_ring_s * const ring, drawable_record_s * const record, const unsigned long num_points );
+
+
+/**
+ * @brief Get ring statistics.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ * @param [out] depth A pointer to guint which receives the number of records in use.
+ * @param [out] overflows A pointer to unsigned long long which receives the total number of records overwritten or not reserved because the ring was full.
+ *
+ */
+void drawable_ring_get_stats( drawable_ring_s * const ring, guint * const depth, unsigned long long * const overflows );
+
+
+
+/**
+ * @brief Get the file descriptor signaled when records are committed.
+ *
+ * Poll it for reading to wait for records instead of polling the ring.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ * @return File descriptor on success, -1 on failure.
+ *
+ */
+int drawable_ring_get_notify_fd( const drawable_ring_s * const ring );
+
+
+/**
+ * @brief Wake the consumer without committing a record.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ */
+void drawable_ring_notify( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Wait for committed records.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ * @param [in] timeout Maximum time to wait. [microseconds]
+ *
+ * @return One if records are ready or the consumer was woken, zero on timeout.
+ *
+ */
+int drawable_ring_wait( const drawable_ring_s * const ring, const ps_timestamp timeout );
+
+
+
+
+#endif	/* DRAWABLE_RING_H */
@@ -41,10 +41,50 @@
 #include <glib-2.0/glib.h>
 #include "polysync_core.h"
 #include "gl_headers.h"
+#include "entity_pool.h"
 
 
 
 
+/**
+ * @brief Largest number of segments a cached unit circle mesh can have.
+ *
+ * Circles needing more segments, see \ref render_get_circle_segments, are clamped.
+ *
+ */
+#define     RENDER_MAX_CIRCLE_SEGMENTS      (256)
+
+
+/**
+ * @brief Value of \ref entity_timeout_s.heap_index when not queued.
+ *
+ */
+#define     ENTITY_TIMEOUT_NOT_QUEUED       (0xFFFFFFFFU)
+
+
+
+
+/**
+ * @brief Entity kinds.
+ *
+ */
+typedef enum
+{
+    //
+    //
+    ENTITY_KIND_OBJECT = 0, /*!< Entity is an \ref object_s. */
+    //
+    //
+    ENTITY_KIND_CONTAINER, /*!< Entity is an \ref object_container_s. */
+    //
+    //
+    ENTITY_KIND_PARENT, /*!< Entity is an \ref object_container_parent_s. */
+    //
+    //
+    ENTITY_KIND_COUNT /*!< Number of \ref entity_kind values. */
+} entity_kind;
+
+
 /**
  * @brief Color mode kinds.
  *
@@ -117,6 +157,27 @@ typedef enum
 } view_mode_kind;
 
 
+/**
+ * @brief LiDAR point display downsampling kinds.
+ *
+ */
+typedef enum
+{
+    //
+    //
+    POINTS_DOWNSAMPLE_OFF = 0, /*!< All points are displayed. */
+    //
+    //
+    POINTS_DOWNSAMPLE_MAX_INTENSITY, /*!< One point per grid cell, the one with the highest intensity. */
+    //
+    //
+    POINTS_DOWNSAMPLE_CENTROID, /*!< One point per grid cell at the centroid of the cell's points, with their mean intensity. */
+    //
+    //
+    POINTS_DOWNSAMPLE_KIND_COUNT, /*!< Number of \ref points_downsample_kind values. */
+} points_downsample_kind;
+
+
 
 
 /**
@@ -170,6 +231,231 @@ typedef struct
 } ruler_data_s;
 
 
+/**
+ * @brief Entity timeout queue data.
+ *
+ * Embedded in each entity and referenced by the store's deadline heap.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_timestamp            deadline; /*!< Expiry time, update time plus timeout interval. [microseconds] */
+    //
+    //
+    unsigned int            heap_index; /*!< Index in the deadline heap.
+                                         * Value \ref ENTITY_TIMEOUT_NOT_QUEUED means not queued. */
+    //
+    //
+    entity_kind             kind; /*!< Kind of the entity that owns this record. */
+    //
+    //
+    void                    *entity; /*!< Entity that owns this record. */
+    //
+    //
+    void                    *owner; /*!< Container or parent holding the entity, NULL for parents. */
+} entity_timeout_s;
+
+
+/**
+ * @brief Axis-aligned X/Y bounding box.
+ *
+ * Empty when min is greater than max, see \ref entity_bounds_clear.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GLdouble                min_x; /*!< Minimum X coordinate. [meters] */
+    //
+    //
+    GLdouble                min_y; /*!< Minimum Y coordinate. [meters] */
+    //
+    //
+    GLdouble                max_x; /*!< Maximum X coordinate. [meters] */
+    //
+    //
+    GLdouble                max_y; /*!< Maximum Y coordinate. [meters] */
+} entity_bounds_s;
+
+
+/**
+ * @brief Entity culling statistics of a drawn frame.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long           containers_drawn; /*!< Containers overlapping the visible region. */
+    //
+    //
+    unsigned long           containers_culled; /*!< Containers outside the visible region. */
+    //
+    //
+    unsigned long           objects_drawn; /*!< Objects in drawn containers. */
+    //
+    //
+    unsigned long           objects_culled; /*!< Objects in culled containers. */
+} cull_stats_s;
+
+
+/**
+ * @brief Batched primitive kinds.
+ *
+ * Each kind is a unit mesh drawn with one call per frame, see \ref render_batch_s.
+ *
+ */
+typedef enum
+{
+    //
+    //
+    RENDER_BATCH_CIRCLE = 0, /*!< Unit radius circle outline, drawn as lines. */
+    //
+    //
+    RENDER_BATCH_CROSS, /*!< Unit cross, drawn as lines. */
+    //
+    //
+    RENDER_BATCH_RECTANGLE, /*!< Unit rectangle, drawn as quads. */
+    //
+    //
+    RENDER_BATCH_TRIANGLE, /*!< Unit triangle, drawn as triangles. */
+    //
+    //
+    RENDER_BATCH_VECTOR, /*!< Line from the instance position to position + size, not rotated. */
+    //
+    //
+    RENDER_BATCH_KIND_COUNT, /*!< Number of \ref render_batch_kind values. */
+} render_batch_kind;
+
+
+/**
+ * @brief Batched primitive instance.
+ *
+ * The unit mesh of the batch kind is scaled by length/width, rotated by orientation,
+ * and translated to x/y.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GLfloat                 x; /*!< Center X coordinate. [meters] */
+    //
+    //
+    GLfloat                 y; /*!< Center Y coordinate. [meters] */
+    //
+    //
+    GLfloat                 orientation; /*!< Orientation about the Z axis. [radians] */
+    //
+    //
+    GLfloat                 length; /*!< X scale of the unit mesh. [meters] */
+    //
+    //
+    GLfloat                 width; /*!< Y scale of the unit mesh. [meters] */
+    //
+    //
+    GLuint                  segments; /*!< Circle segments, only used by \ref RENDER_BATCH_CIRCLE. */
+    //
+    //
+    GLfloat                 color_rgba[ 4 ]; /*!< Color. */
+} render_instance_s;
+
+
+/**
+ * @brief Batched primitive renderer.
+ *
+ * Instances are collected per kind while walking the entities and then
+ * expanded into one vertex/color array per kind and drawn with a single call.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GArray                  *instances[ RENDER_BATCH_KIND_COUNT ]; /*!< Instances of each kind (\ref render_instance_s) queued this frame. */
+    //
+    //
+    GArray                  *vertices; /*!< Expanded vertex scratch array, GLfloat xy. */
+    //
+    //
+    GArray                  *colors; /*!< Expanded color scratch array, GLfloat rgba. */
+    //
+    //
+    GLfloat                 *circle_meshes[ RENDER_MAX_CIRCLE_SEGMENTS + 1 ]; /*!< Unit circle meshes indexed by segment count, built on first use. */
+} render_batch_s;
+
+
+/**
+ * @brief Point cloud vertex buffer data.
+ *
+ * Retained GPU copy of a point cloud, each vertex is float32 xyz plus intensity.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GLuint                  vbo; /*!< GL buffer object name, zero means not created. */
+    //
+    //
+    unsigned long           num_points; /*!< Number of points uploaded. */
+    //
+    //
+    unsigned long           capacity; /*!< Number of points the buffer object can hold. */
+    //
+    //
+    unsigned long long      generation; /*!< Point generation the upload corresponds to. */
+} point_cloud_buffer_s;
+
+
+/**
+ * @brief Vertex buffer of a container drawn from snapshots.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long long      parent_id; /*!< Parent identifier, first half of the hash table key. */
+    //
+    //
+    unsigned long long      container_id; /*!< Container identifier, second half of the hash table key. */
+    //
+    //
+    point_cloud_buffer_s    gpu; /*!< Vertex buffer, its generation is the uploaded \ref entity_point_set_s.id. */
+    //
+    //
+    unsigned long long      sequence; /*!< Sequence of the last snapshot holding the container. */
+} snapshot_points_gpu_s;
+
+
+/**
+ * @brief Message ingest statistics.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long           queue_depth; /*!< Records left in the ring after the last drain. */
+    //
+    //
+    unsigned long           last_batch; /*!< Records dequeued by the last drain. */
+    //
+    //
+    unsigned long long      parsed; /*!< Total messages parsed into entities. */
+    //
+    //
+    unsigned long long      dropped; /*!< Total messages dropped because a newer message from the same sensor was in the batch. */
+    //
+    //
+    unsigned long long      overflowed; /*!< Total waiting messages overwritten by newer ones, or dropped if none could be, because the record ring was full. */
+} ingest_stats_s;
+
+
 /**
  * @brief Platform data.
  *
@@ -319,10 +605,44 @@ typedef struct
     unsigned long           num_points;
     //
     //
-    ps_lidar_point          *points_3d;
+    ps_lidar_point          *points_3d; /*!< Points, a view into the owning container's point buffers. */
+    //
+    //
+    unsigned int            store_index; /*!< Index in the owning container's object array. */
+    //
+    //
+    entity_timeout_s        timeout; /*!< Timeout queue data. */
 } object_s;
 
 
+/**
+ * @brief Shared copy of a container's displayed points.
+ *
+ * Immutable once built. Held by the container that built it and by every
+ * snapshot drawing it, so points are only copied when new ones are swapped in.
+ * Ingest thread only, except for reading the points of a published snapshot.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    guint                   refs; /*!< Number of holders, freed when it drops to zero. */
+    //
+    //
+    unsigned long long      id; /*!< Unique set identifier, never reused. */
+    //
+    //
+    unsigned long long      generation; /*!< Container point generation the points were copied at. */
+    //
+    //
+    ps_lidar_point          *points; /*!< Points. */
+    //
+    //
+    unsigned long           num_points; /*!< Number of points. */
+} entity_point_set_s;
+
+
 /**
  * @brief Object container data.
  *
@@ -343,7 +663,43 @@ typedef struct
     GLdouble                color_rgba[4];
     //
     //
-    GList                   *objects;
+    GPtrArray               *objects; /*!< Dense array of \ref object_s. */
+    //
+    //
+    GHashTable              *object_index; /*!< Object identifier to \ref object_s map. */
+    //
+    //
+    unsigned int            store_index; /*!< Index in the owning parent's container array. */
+    //
+    //
+    entity_timeout_s        timeout; /*!< Timeout queue data. */
+    //
+    //
+    ps_lidar_point          *point_buffers[ 2 ]; /*!< Double-buffered point storage for the container's objects. */
+    //
+    //
+    unsigned long           point_capacity[ 2 ]; /*!< Capacity of each point buffer. [points] */
+    //
+    //
+    unsigned int            point_front; /*!< Index of the point buffer being displayed, the other is filled by the next update. */
+    //
+    //
+    unsigned long long      points_generation; /*!< Incremented each time new points are swapped in. */
+    //
+    //
+    point_cloud_buffer_s    points_gpu; /*!< Vertex buffer holding the displayed points. */
+    //
+    //
+    entity_point_set_s      *point_set; /*!< Snapshot copy of the displayed points, NULL until a snapshot needs one. */
+    //
+    //
+    entity_bounds_s         bounds; /*!< Bounding box of the container's objects, grown on update. */
+    //
+    //
+    entity_bounds_s         points_bounds; /*!< Bounding box of the displayed points. */
+    //
+    //
+    unsigned int            bounds_stale; /*!< Non-zero when bounds may be larger than needed after an object moved or was removed. */
 } object_container_s;
 
 
@@ -367,10 +723,101 @@ typedef struct
     GLdouble                color_rgba[4];
     //
     //
-    GList                   *containers;
+    GPtrArray               *containers; /*!< Dense array of \ref object_container_s. */
+    //
+    //
+    GHashTable              *container_index; /*!< Container identifier to \ref object_container_s map. */
+    //
+    //
+    unsigned int            store_index; /*!< Index in the owning store's parent array. */
+    //
+    //
+    entity_timeout_s        timeout; /*!< Timeout queue data. */
 } object_container_parent_s;
 
 
+/**
+ * @brief Entity store data.
+ *
+ * Keyed store of parents, their containers and objects.
+ * Each level keeps a hash table index for lookup and a dense array for iteration.
+ * Entities with a timeout are queued in a deadline heap so expiry only visits
+ * the entities that are due. Entity memory is recycled through per-kind pools.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GPtrArray               *parents; /*!< Dense array of \ref object_container_parent_s. */
+    //
+    //
+    GHashTable              *parent_index; /*!< Parent identifier to \ref object_container_parent_s map. */
+    //
+    //
+    GPtrArray               *timeouts; /*!< Min-heap of \ref entity_timeout_s ordered by deadline. */
+    //
+    //
+    entity_pool_s           pools[ ENTITY_KIND_COUNT ]; /*!< Entity memory pools, indexed by \ref entity_kind. */
+} entity_store_s;
+
+
+/**
+ * @brief Entity snapshot object.
+ *
+ * Draw-only copy of an object and the colors of its container and parent.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    object_s                object; /*!< Object copy, \ref object_s.points_3d is NULL, see point_set. */
+    //
+    //
+    const entity_point_set_s *point_set; /*!< Points of the object's container, NULL if the object has none. */
+    //
+    //
+    unsigned long           point_offset; /*!< Index of the object's first point in point_set. */
+    //
+    //
+    unsigned long long      points_generation; /*!< Point generation of the object's container. */
+    //
+    //
+    entity_bounds_s         bounds; /*!< Bounding box of the object. */
+    //
+    //
+    GLdouble                container_color_rgba[ 4 ]; /*!< Color of the object's container. */
+    //
+    //
+    GLdouble                parent_color_rgba[ 4 ]; /*!< Color of the object's parent. */
+} entity_snapshot_object_s;
+
+
+/**
+ * @brief Entity snapshot.
+ *
+ * Immutable flattened copy of an \ref entity_store_s, built by the ingest thread
+ * and drawn by the render thread.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GArray                  *objects; /*!< Objects (\ref entity_snapshot_object_s) in parent, container order. */
+    //
+    //
+    GPtrArray               *point_sets; /*!< Point sets (\ref entity_point_set_s) of the objects, one reference each. */
+    //
+    //
+    unsigned long long      sequence; /*!< Snapshot sequence number, starts at one. */
+    //
+    //
+    ingest_stats_s          stats; /*!< Message ingest statistics at the time of the snapshot. */
+} entity_snapshot_s;
+
+
 
 
 #endif	/* DRAWABLE_TYPE_H */
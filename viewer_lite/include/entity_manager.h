@@ -77,6 +77,27 @@
 #define     DEFAULT_PARENT_TIMEOUT      (500000ULL)
 
 
+/**
+ * @brief Number of objects reserved each time the object pool grows.
+ *
+ */
+#define     ENTITY_OBJECT_SLAB_SIZE     (256)
+
+
+/**
+ * @brief Number of containers reserved each time the container pool grows.
+ *
+ */
+#define     ENTITY_CONTAINER_SLAB_SIZE  (16)
+
+
+/**
+ * @brief Number of parents reserved each time the parent pool grows.
+ *
+ */
+#define     ENTITY_PARENT_SLAB_SIZE     (8)
+
+
 // no timeouts
 
 
@@ -89,25 +110,34 @@
 
 
 
-object_s *entity_object_new( const unsigned long long id );
+entity_store_s *entity_store_new( void );
+
 
+void entity_store_get_pool_stats( const entity_store_s * const store, const entity_kind kind, entity_pool_stats_s * const stats );
 
-object_s *entity_object_new_copy( const object_s * const copy );
+
+object_s *entity_object_new( entity_store_s * const store, const unsigned long long id );
+
+
+object_s *entity_object_new_copy( entity_store_s * const store, const object_s * const copy );
 
 
 void entity_object_init( const unsigned long long id, object_s * const object );
 
 
-object_container_s *entity_container_new( const unsigned long long id );
+object_container_s *entity_container_new( entity_store_s * const store, const unsigned long long id );
+
+
+object_container_parent_s *entity_parent_new( entity_store_s * const store, const unsigned long long id );
 
 
-object_container_parent_s *entity_parent_new( const unsigned long long id );
+void entity_release_all( entity_store_s * const store );
 
 
-void entity_release_all( GList * const parent_list );
+unsigned int entity_update_timeouts( entity_store_s * const store, const unsigned long long compare_time );
 
 
-GList *entity_update_timeouts( GList * const parent_list, const unsigned long long compare_time );
+ps_timestamp entity_store_get_next_deadline( const entity_store_s * const store );
 
 
 object_s *entity_container_search_by_id( const object_container_s * const container, const unsigned long long obj_id );
@@ -116,10 +146,37 @@ object_s *entity_container_search_by_id( const object_container_s * const contai
 object_container_s *entity_parent_search_by_id( const object_container_parent_s * const parent, const unsigned long long container_id );
 
 
-object_container_parent_s *entity_parent_list_search_by_id( const GList * const parent_list, const unsigned long long parent_id );
+object_container_parent_s *entity_store_search_by_id( const entity_store_s * const store, const unsigned long long parent_id );
 
 
-GList *entity_object_update_copy( GList * const parent_list, const unsigned long long parent_id, const unsigned long long container_id, const object_s * const object );
+ps_lidar_point *entity_container_get_point_buffer( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, const unsigned long num_points );
+
+
+ps_lidar_point *entity_container_exchange_point_buffer( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, ps_lidar_point ** const points, unsigned long * const capacity );
+
+
+object_s *entity_object_update_copy( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, const object_s * const object );
+
+
+void entity_object_push_trail( const gui_context_s * const gui, const entity_store_s * const store, const object_s * const object );
+
+
+void entity_bounds_clear( entity_bounds_s * const bounds );
+
+
+int entity_bounds_overlap( const entity_bounds_s * const a, const entity_bounds_s * const b );
+
+
+void entity_snapshot_init( entity_snapshot_s * const snapshot );
+
+
+void entity_snapshot_release( entity_snapshot_s * const snapshot );
+
+
+void entity_snapshot_build( entity_store_s * const store, entity_snapshot_s * const snapshot );
+
+
+GHashTable *entity_snapshot_points_new( void );
 
 
 // removed
@@ -129,13 +186,16 @@ GList *entity_object_update_copy( GList * const parent_list, const unsigned long
 void entity_draw_object( const gui_context_s * const gui, const object_s * const object, const GLdouble * const color_rgba );
 
 
-void entity_draw_container( const gui_context_s * const gui, const object_container_s * const container, const GLdouble * const color_rgba );
+void entity_draw_container( const gui_context_s * const gui, object_container_s * const container, const GLdouble * const color_rgba );
+
+
+void entity_draw_parent( const gui_context_s * const gui, object_container_parent_s * const parent, const entity_bounds_s * const visible, cull_stats_s * const stats );
 
 
-void entity_draw_parent( const gui_context_s * const gui, const object_container_parent_s * const parent );
+void entity_draw_all( const gui_context_s * const gui, entity_store_s * const store, cull_stats_s * const stats );
 
 
-void entity_draw_all( const gui_context_s * const gui, const GList * const parent_list );
+void entity_draw_snapshot( const gui_context_s * const gui, const entity_snapshot_s * const snapshot, GHashTable * const points_gpu, cull_stats_s * const stats );
 
 
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2016 PolySync
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file entity_pool.h
+ * @brief Entity Slab Pool Interface.
+ *
+ * Fixed size element pools backed by slabs with a free list, used by the
+ * entity manager to recycle entity memory instead of going through the heap
+ * for every new track.
+ *
+ */
+
+
+
+
+#ifndef ENTITY_POOL_H
+#define	ENTITY_POOL_H
+
+
+
+
+#include <stddef.h>
+#include <glib-2.0/glib.h>
+
+
+
+
+/**
+ * @brief Entity pool statistics.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long           in_use; /*!< Number of elements currently allocated. */
+    //
+    //
+    unsigned long           capacity; /*!< Number of elements backed by slabs. */
+    //
+    //
+    unsigned long           high_water; /*!< Largest value \ref entity_pool_stats_s.in_use has reached. */
+    //
+    //
+    unsigned long           slabs; /*!< Number of slabs allocated. */
+    //
+    //
+    unsigned long long      allocations; /*!< Total number of allocations served. */
+} entity_pool_stats_s;
+
+
+/**
+ * @brief Entity pool data.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    size_t                  element_size; /*!< Size of each element, rounded up to pointer alignment. [bytes] */
+    //
+    //
+    unsigned long           slab_elements; /*!< Number of elements per slab. */
+    //
+    //
+    GPtrArray               *slabs; /*!< Slab memory blocks. */
+    //
+    //
+    void                    *free_list; /*!< Singly linked list of free elements, linked through their first word. */
+    //
+    //
+    entity_pool_stats_s     stats; /*!< Pool statistics. */
+} entity_pool_s;
+
+
+
+
+/**
+ * @brief Initialize an entity pool.
+ *
+ * No memory is reserved until the first allocation.
+ *
+ * @param [out] pool A pointer to \ref entity_pool_s which receives the initialized pool.
+ * @param [in] element_size Size of each element. [bytes]
+ * @param [in] slab_elements Number of elements to reserve each time the pool grows.
+ *
+ */
+void entity_pool_init( entity_pool_s * const pool, const size_t element_size, const unsigned long slab_elements );
+
+
+/**
+ * @brief Release an entity pool.
+ *
+ * Frees all slabs, any elements still in use become invalid.
+ *
+ * @param [in] pool A pointer to \ref entity_pool_s which specifies the pool to release.
+ *
+ */
+void entity_pool_release( entity_pool_s * const pool );
+
+
+/**
+ * @brief Allocate a zeroed element from an entity pool.
+ *
+ * @param [in] pool A pointer to \ref entity_pool_s which specifies the pool.
+ *
+ * @return A pointer to the element on success, NULL on failure.
+ *
+ */
+void *entity_pool_alloc( entity_pool_s * const pool );
+
+
+/**
+ * @brief Return an element to an entity pool.
+ *
+ * @param [in] pool A pointer to \ref entity_pool_s which specifies the pool.
+ * @param [in] element A pointer to the element, previously returned by \ref entity_pool_alloc. NULL is acceptable.
+ *
+ */
+void entity_pool_free( entity_pool_s * const pool, void * const element );
+
+
+/**
+ * @brief Get entity pool statistics.
+ *
+ * @param [in] pool A pointer to \ref entity_pool_s which specifies the pool.
+ * @param [out] stats A pointer to \ref entity_pool_stats_s which receives the statistics.
+ *
+ */
+void entity_pool_get_stats( const entity_pool_s * const pool, entity_pool_stats_s * const stats );
+
+
+
+
+#endif	/* ENTITY_POOL_H */
@@ -44,6 +44,7 @@
 
 #include "gl_headers.h"
 #include "drawable_type.h"
+#include "point_trails.h"
 
 
 
@@ -145,6 +146,27 @@
 #define         GUI_KEY_POINTS_VISIBLE      '6'
 
 
+/**
+ * @brief Change points downsampling mode key.
+ *
+ */
+#define         GUI_KEY_POINTS_DOWNSAMPLE   '5'
+
+
+/**
+ * @brief Toggle points trails key.
+ *
+ */
+#define         GUI_KEY_POINTS_TRAILS       '4'
+
+
+/**
+ * @brief Toggle statistics visibility key.
+ *
+ */
+#define         GUI_KEY_STATS_VISIBLE       's'
+
+
 /**
  * @brief Invalid \ref gui_context_s.win_id value.
  *
@@ -180,6 +202,13 @@
 #define         GUI_DEFAULT_MAX_FPS         (33)
 
 
+/**
+ * @brief Time to wait when nothing needs redrawing. [microseconds]
+ *
+ */
+#define         GUI_IDLE_WAIT               (250000ULL)
+
+
 /**
  * @brief Default grid surface scale. [meters]
  *
@@ -201,6 +230,15 @@
 #define         GUI_DEFAULT_WIRE_LINE_WIDTH  (1.35)
 
 
+/**
+ * @brief Default LiDAR point downsampling cell size. [pixels]
+ *
+ * Converted to meters with \ref gui_configuration_s.zoom_scale.
+ *
+ */
+#define         GUI_DEFAULT_POINTS_CELL_PIXELS  (1.0)
+
+
 
 
 /**
@@ -256,10 +294,24 @@ typedef struct
                                                  * Value zero means not visible. Value one means visisble. */
     //
     //
+    points_downsample_kind      points_downsample; /*!< LiDAR point display downsampling mode. */
+    //
+    //
+    double                      points_cell_size; /*!< LiDAR point downsampling cell size, follows \ref gui_configuration_s.zoom_scale. [meters] */
+    //
+    //
+    unsigned int                points_trails_visible; /*!< LiDAR point trails visibility enabled/disabled.
+                                                 * Value zero means not visible. Value one means visisble. */
+    //
+    //
     unsigned int                help_visible; /*!< Help message visibility enabled/disabled.
                                                * Value zero means not visible. Value one means visisble. */
     //
     //
+    unsigned int                stats_visible; /*!< Statistics visibility enabled/disabled.
+                                                * Value zero means not visible. Value one means visisble. */
+    //
+    //
     unsigned int                radial_grid_visible; /*!< Radial grid lines visibility enabled/disabled.
                                                       * Value zero means not visible. Value one means visisble. */
     //
@@ -316,6 +368,10 @@ typedef struct
     ps_timestamp                last_render_time; /*!< Last render timestamp. [microseconds] */
     //
     //
+    unsigned int                scene_dirty; /*!< Non-zero when the drawn entities changed since the last redraw.
+                                              * Input redraws on its own. */
+    //
+    //
     double                      mouse_x; /*!< Last mouse X coordinate. */
     //
     //
@@ -337,7 +393,25 @@ typedef struct
     ruler_data_s                ruler; /*!< Ruler data. */
     //
     //
-    GList                       *entity_list; /*!< GList of on-bus parent entities and their children (\ref object_container_parent_s). */
+    entity_store_s              *entity_store; /*!< Store of on-bus parent entities and their children (\ref object_container_parent_s). */
+    //
+    //
+    ingest_stats_s              ingest_stats; /*!< Message ingest statistics, see \ref ps_process_message. */
+    //
+    //
+    render_batch_s              *render_batch; /*!< Batched primitive renderer used to draw the entities. */
+    //
+    //
+    const entity_snapshot_s     *snapshot; /*!< Entity snapshot to draw instead of \ref gui_context_s.entity_store in pipeline mode, NULL otherwise. */
+    //
+    //
+    GHashTable                  *snapshot_points; /*!< Vertex buffers (\ref snapshot_points_gpu_s) of the containers in \ref gui_context_s.snapshot, keyed by parent and container identifier. */
+    //
+    //
+    cull_stats_s                cull_stats; /*!< Culling statistics of the last drawn frame. */
+    //
+    //
+    point_trails_s              *point_trails; /*!< History of past LiDAR scans drawn when \ref gui_configuration_s.points_trails_visible is enabled. */
 } gui_context_s;
 
 
@@ -359,6 +433,34 @@ typedef struct
 gui_context_s *gui_init( const char *win_title, const unsigned int win_width, const unsigned int win_height, const double grid_scale );
 
 
+/**
+ * @brief Initialize GUI resources without a window.
+ *
+ * Draws into the GL context current on the calling thread, see \ref gui_render_frame.
+ * Screen text is disabled since it is drawn with GLUT.
+ *
+ * @param [in] win_width Viewport width. [pixels]
+ * @param [in] win_height Viewport height. [pixels]
+ * @param [in] grid_scale Grid surface scale, see \ref GUI_DEFAULT_GRID_SCALE. [meters]
+ *
+ * @return A newly created GUI context on success, NULL on failure.
+ *
+ */
+gui_context_s *gui_init_headless( const unsigned int win_width, const unsigned int win_height, const double grid_scale );
+
+
+/**
+ * @brief Draw a frame into the current GL context.
+ *
+ * Used with \ref gui_init_headless, does not swap buffers.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ * @param [in] update_time Current timestamp, used as the frame time.
+ *
+ */
+void gui_render_frame( gui_context_s * const gui, const ps_timestamp update_time );
+
+
 /**
  * @brief Release GUI resources.
  *
@@ -371,17 +473,32 @@ void gui_release( gui_context_s * const gui );
 /**
  * @brief Update GUI and possibly redraw.
  *
- * Triggers a redraw based on the configured frame rate (see \ref gui_context_s.max_fps).
+ * Processes pending input. Triggers a redraw when \ref gui_context_s.scene_dirty is set,
+ * limited by the configured frame rate (see \ref gui_context_s.max_fps).
  *
  * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
  * @param [in] update_time Current timestamp used to update rendering with limiter.
- * @param [out] time_to_redraw A pointer to \ref ps_timestamp which receives the time remaining until the last redraw.
+ * @param [out] time_to_redraw A pointer to \ref ps_timestamp which receives the time until the next redraw is due,
+ * \ref GUI_IDLE_WAIT if nothing needs redrawing, zero if input is still pending.
  * If set to value \ref GUI_FORCE_REDRAW, forces a redraw.
  *
  */
 void gui_update( gui_context_s * const gui, const ps_timestamp update_time, ps_timestamp * const time_to_redraw );
 
 
+/**
+ * @brief Get the file descriptor of the window system connection.
+ *
+ * Poll it for reading to wait for input.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ *
+ * @return File descriptor on success, -1 if there is no window.
+ *
+ */
+int gui_get_event_fd( const gui_context_s * const gui );
+
+
 
 
 #endif	/* GUI_H */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2016 PolySync
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file headless_bench.h
+ * @brief Headless Benchmark Interface.
+ *
+ * Feeds synthetic LiDAR, radar and object messages through the same ingest and
+ * draw path as the viewer, rendering into an offscreen EGL surfaceless context,
+ * and reports frame time, ingest rate and peak memory per scene size.
+ *
+ */
+
+
+
+
+#ifndef HEADLESS_BENCH_H
+#define	HEADLESS_BENCH_H
+
+
+
+
+#include "polysync_core.h"
+
+
+
+
+/**
+ * @brief Default number of measured frames per scene.
+ *
+ */
+#define     HEADLESS_BENCH_DEFAULT_FRAMES   (300)
+
+
+/**
+ * @brief Number of frames run before measuring each scene.
+ *
+ */
+#define     HEADLESS_BENCH_WARMUP_FRAMES    (30)
+
+
+
+
+/**
+ * @brief Benchmark scene.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    const char              *name; /*!< Scene name. */
+    //
+    //
+    unsigned long           num_points; /*!< LiDAR points per scan. */
+    //
+    //
+    unsigned long           num_targets; /*!< Radar targets per message. */
+    //
+    //
+    unsigned long           num_objects; /*!< Objects per message. */
+} headless_bench_scene_s;
+
+
+/**
+ * @brief Benchmark scene result.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_timestamp            frame_p50; /*!< Median frame time, ingest and draw. [microseconds] */
+    //
+    //
+    ps_timestamp            frame_p99; /*!< 99th percentile frame time, ingest and draw. [microseconds] */
+    //
+    //
+    ps_timestamp            draw_p50; /*!< Median draw time. [microseconds] */
+    //
+    //
+    double                  messages_per_sec; /*!< Messages processed per second of ingest time. */
+    //
+    //
+    double                  points_per_sec; /*!< LiDAR points processed per second of ingest time. */
+    //
+    //
+    long                    peak_rss; /*!< Process peak resident set size after the scene. [KiB] */
+} headless_bench_result_s;
+
+
+
+
+/**
+ * @brief Run the headless benchmark.
+ *
+ * Runs each built-in scene, smallest first, and prints one result line per scene.
+ *
+ * @param [in] num_frames Number of measured frames per scene.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+int headless_bench_run( const unsigned int num_frames );
+
+
+
+
+#endif	/* HEADLESS_BENCH_H */
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2016 PolySync
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file ingest_pipeline.h
+ * @brief Ingest Pipeline Interface.
+ *
+ * Optional pipeline mode where a worker thread drains the PolySync drawable record ring,
+ * maintains its own entity store and publishes immutable \ref entity_snapshot_s
+ * frames to the render thread through a lock-free triple buffer.
+ *
+ */
+
+
+
+
+#ifndef INGEST_PIPELINE_H
+#define	INGEST_PIPELINE_H
+
+
+
+
+#include <glib-2.0/glib.h>
+
+#include "drawable_type.h"
+#include "ps_interface.h"
+#include "gui.h"
+
+
+
+
+/**
+ * @brief Number of snapshot slots in the triple buffer.
+ *
+ */
+#define     INGEST_SNAPSHOT_SLOTS           (3)
+
+
+/**
+ * @brief Flag set in \ref snapshot_triple_buffer_s.ready when it holds a snapshot the render thread has not taken.
+ *
+ */
+#define     INGEST_SNAPSHOT_DIRTY           (0x4)
+
+
+/**
+ * @brief Mask of the slot index in \ref snapshot_triple_buffer_s.ready.
+ *
+ */
+#define     INGEST_SNAPSHOT_INDEX_MASK      (0x3)
+
+
+/**
+ * @brief Longest the ingest thread waits for records before checking for configuration changes. [microseconds]
+ *
+ */
+#define     INGEST_IDLE_WAIT                (100000ULL)
+
+
+
+
+/**
+ * @brief Lock-free snapshot triple buffer.
+ *
+ * The ingest thread owns the write slot, the render thread owns the read slot,
+ * and the ready slot is exchanged between them with atomic compare-and-exchange.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    entity_snapshot_s       slots[ INGEST_SNAPSHOT_SLOTS ]; /*!< Snapshot storage. */
+    //
+    //
+    volatile gint           ready; /*!< Ready slot index, ORed with \ref INGEST_SNAPSHOT_DIRTY when newly published. */
+    //
+    //
+    unsigned int            write; /*!< Slot the ingest thread builds into. */
+    //
+    //
+    unsigned int            read; /*!< Slot the render thread draws from. */
+    //
+    //
+    unsigned int            read_valid; /*!< Non-zero once the read slot holds a published snapshot. */
+    //
+    //
+    int                     notify_fd; /*!< Event file descriptor, readable once a snapshot is published until the render thread takes one. */
+} snapshot_triple_buffer_s;
+
+
+/**
+ * @brief Ingest pipeline.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GThread                 *thread; /*!< Ingest thread. */
+    //
+    //
+    volatile gint           quit; /*!< Non-zero requests the ingest thread to exit. */
+    //
+    //
+    GMutex                  config_lock; /*!< Protects config. */
+    //
+    //
+    gui_configuration_s     config; /*!< GUI configuration mirrored from the render thread. */
+    //
+    //
+    node_data_s             *node_data; /*!< PolySync node data, the drawable record ring is only drained by the ingest thread. */
+    //
+    //
+    entity_store_s          *store; /*!< Entity store, only accessed by the ingest thread while running. */
+    //
+    //
+    gui_context_s           ingest_gui; /*!< Ingest-side view of the GUI, only its configuration is used. */
+    //
+    //
+    unsigned long long      sequence; /*!< Last published snapshot sequence number. */
+    //
+    //
+    snapshot_triple_buffer_s snapshots; /*!< Snapshots exchanged with the render thread. */
+} ingest_pipeline_s;
+
+
+
+
+/**
+ * @brief Start the ingest pipeline.
+ *
+ * Spawns the ingest thread, which from then on is the only consumer of the drawable record ring.
+ *
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the PolySync node data.
+ *
+ * @return A newly created pipeline on success, NULL on failure.
+ *
+ */
+ingest_pipeline_s *ingest_pipeline_start( node_data_s * const node_data );
+
+
+/**
+ * @brief Stop the ingest pipeline.
+ *
+ * Joins the ingest thread and frees the pipeline's entity store and snapshots.
+ * Snapshots returned by \ref ingest_pipeline_acquire are invalid afterwards.
+ *
+ * @param [in] pipeline A pointer to \ref ingest_pipeline_s which specifies the pipeline to free. NULL is acceptable.
+ *
+ */
+void ingest_pipeline_stop( ingest_pipeline_s * const pipeline );
+
+
+/**
+ * @brief Set the GUI configuration seen by the ingest thread.
+ *
+ * Freeze-frame and point downsampling settings apply to parsing.
+ *
+ * @param [in] pipeline A pointer to \ref ingest_pipeline_s which specifies the pipeline.
+ * @param [in] config A pointer to \ref gui_configuration_s which specifies the configuration to copy.
+ *
+ */
+void ingest_pipeline_set_config( ingest_pipeline_s * const pipeline, const gui_configuration_s * const config );
+
+
+/**
+ * @brief Acquire the latest complete snapshot.
+ *
+ * Render thread only. The returned snapshot stays valid until the next call.
+ *
+ * @param [in] pipeline A pointer to \ref ingest_pipeline_s which specifies the pipeline.
+ * @param [out] updated A pointer to unsigned int which receives one if a newer snapshot was taken, zero otherwise.
+ *
+ * @return A pointer to the latest snapshot, NULL if none has been published yet.
+ *
+ */
+const entity_snapshot_s *ingest_pipeline_acquire( ingest_pipeline_s * const pipeline, unsigned int * const updated );
+
+
+/**
+ * @brief Get the file descriptor signaled when a snapshot is published.
+ *
+ * Poll it for reading to wait for snapshots, \ref ingest_pipeline_acquire clears it.
+ *
+ * @param [in] pipeline A pointer to \ref ingest_pipeline_s which specifies the pipeline.
+ *
+ * @return File descriptor on success, -1 on failure.
+ *
+ */
+int ingest_pipeline_get_notify_fd( const ingest_pipeline_s * const pipeline );
+
+
+
+
+#endif	/* INGEST_PIPELINE_H */
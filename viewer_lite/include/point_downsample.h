@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2016 PolySync
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file point_downsample.h
+ * @brief LiDAR Point Downsampling Interface.
+ *
+ * Display-side grid downsampling of LiDAR points, keeps one point per
+ * X/Y grid cell so the birdseye view doesn't draw many points into the same pixel.
+ *
+ */
+
+
+
+
+#ifndef POINT_DOWNSAMPLE_H
+#define	POINT_DOWNSAMPLE_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+
+#include "drawable_type.h"
+
+
+
+
+/**
+ * @brief Value of a \ref point_downsample_s cell slot that is not in use.
+ *
+ */
+#define     POINT_DOWNSAMPLE_EMPTY_SLOT     (G_MAXUINT)
+
+
+
+
+/**
+ * @brief Point downsampling scratch data.
+ *
+ * Open-addressed table of occupied grid cells, reused across calls.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GArray                  *keys; /*!< Packed cell coordinates (guint64) of each slot. */
+    //
+    //
+    GArray                  *slots; /*!< Output point index (guint) of each slot, \ref POINT_DOWNSAMPLE_EMPTY_SLOT if free. */
+    //
+    //
+    GArray                  *sums; /*!< Per output point position/intensity sums and count (five gdouble), centroid mode only. */
+    //
+    //
+    guint                   bits; /*!< Table size is 2^bits slots. */
+} point_downsample_s;
+
+
+
+
+/**
+ * @brief Create point downsampling scratch data.
+ *
+ * @return A newly created \ref point_downsample_s on success, NULL on failure.
+ *
+ */
+point_downsample_s *point_downsample_new( void );
+
+
+/**
+ * @brief Free point downsampling scratch data.
+ *
+ * @param [in] downsample A pointer to \ref point_downsample_s which specifies the data to free. NULL is acceptable.
+ *
+ */
+void point_downsample_free( point_downsample_s * const downsample );
+
+
+/**
+ * @brief Downsample points in place.
+ *
+ * Points are binned into square X/Y cells, the kept points are compacted
+ * to the front of the array in first-seen cell order. Points with a
+ * non-finite X or Y position are dropped.
+ *
+ * @param [in] downsample A pointer to \ref point_downsample_s which specifies the scratch data.
+ * @param [in] points A pointer to ps_lidar_point which specifies the points, receives the kept points.
+ * @param [in] num_points Number of points.
+ * @param [in] cell_size Cell edge length. [meters]
+ * @param [in] mode Downsampling mode.
+ *
+ * @return Number of points kept.
+ *
+ */
+unsigned long point_downsample_apply( point_downsample_s * const downsample, ps_lidar_point * const points, const unsigned long num_points, const double cell_size, const points_downsample_kind mode );
+
+
+
+
+#endif	/* POINT_DOWNSAMPLE_H */
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2016 PolySync
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file point_trails.h
+ * @brief LiDAR Point Trails Interface.
+ *
+ * Per-sensor history of past LiDAR scans drawn as a decaying trail behind the
+ * live points. Older scans are progressively thinned (level of detail) and the
+ * history of each sensor is held to a fixed point budget.
+ *
+ */
+
+
+
+
+#ifndef POINT_TRAILS_H
+#define	POINT_TRAILS_H
+
+
+
+
+#include <glib-2.0/glib.h>
+#include "polysync_core.h"
+
+#include "drawable_type.h"
+
+
+
+
+/**
+ * @brief Maximum number of scans kept per sensor.
+ *
+ */
+#define     POINT_TRAILS_MAX_SCANS          (64)
+
+
+/**
+ * @brief Number of level of detail steps over the trail duration.
+ *
+ * A scan at level L keeps one in 2^L of its points.
+ *
+ */
+#define     POINT_TRAILS_LOD_LEVELS         (4)
+
+
+/**
+ * @brief Default trail duration. [microseconds]
+ *
+ * 2 seconds.
+ *
+ */
+#define     POINT_TRAILS_DEFAULT_DURATION   (2000000ULL)
+
+
+/**
+ * @brief Default maximum number of points held per sensor trail.
+ *
+ * Counts host and vertex buffer copies once each, 16 bytes per point in each.
+ *
+ */
+#define     POINT_TRAILS_DEFAULT_BUDGET     (400000UL)
+
+
+
+
+/**
+ * @brief Point trail key.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    unsigned long long      parent_id; /*!< Parent identifier of the sensor's container. */
+    //
+    //
+    unsigned long long      container_id; /*!< Container identifier. */
+} point_trail_key_s;
+
+
+/**
+ * @brief Scan held by a point trail.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_lidar_point          *points; /*!< Host copy of the points, thinned in place as the level increases. */
+    //
+    //
+    unsigned long           num_points; /*!< Number of points. */
+    //
+    //
+    point_cloud_buffer_s    gpu; /*!< Vertex buffer the scan is drawn from. */
+    //
+    //
+    ps_timestamp            timestamp; /*!< Scan update time. [microseconds] */
+    //
+    //
+    unsigned int            level; /*!< Level of detail. */
+} point_trail_scan_s;
+
+
+/**
+ * @brief Point trail of one sensor.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    point_trail_key_s       key; /*!< Sensor key, also the hash table key. */
+    //
+    //
+    unsigned long long      generation; /*!< Container point generation of the newest scan. */
+    //
+    //
+    GLdouble                color_rgba[ 4 ]; /*!< Color of the newest scan. */
+    //
+    //
+    GLfloat                 point_size; /*!< Point size of the newest scan. [pixels] */
+    //
+    //
+    point_trail_scan_s      scans[ POINT_TRAILS_MAX_SCANS ]; /*!< Scan ring, oldest at head. */
+    //
+    //
+    guint                   head; /*!< Index of the oldest scan. */
+    //
+    //
+    guint                   count; /*!< Number of scans. */
+    //
+    //
+    unsigned long           total_points; /*!< Number of points over all scans. */
+} point_trail_s;
+
+
+/**
+ * @brief Point trails of all sensors.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    GHashTable              *trails; /*!< \ref point_trail_s keyed by \ref point_trail_s.key. */
+    //
+    //
+    ps_timestamp            duration; /*!< Scans older than this are dropped. [microseconds] */
+    //
+    //
+    unsigned long           point_budget; /*!< Maximum number of points per trail. */
+} point_trails_s;
+
+
+
+
+/**
+ * @brief Create point trails.
+ *
+ * @param [in] duration Trail duration. [microseconds]
+ * @param [in] point_budget Maximum number of points per sensor trail.
+ *
+ * @return A newly created \ref point_trails_s on success, NULL on failure.
+ *
+ */
+point_trails_s *point_trails_new( const ps_timestamp duration, const unsigned long point_budget );
+
+
+/**
+ * @brief Free point trails.
+ *
+ * Releases the vertex buffers, requires the GL context.
+ *
+ * @param [in] trails A pointer to \ref point_trails_s which specifies the trails to free. NULL is acceptable.
+ *
+ */
+void point_trails_free( point_trails_s * const trails );
+
+
+/**
+ * @brief Drop every trail.
+ *
+ * @param [in] trails A pointer to \ref point_trails_s which specifies the trails.
+ *
+ */
+void point_trails_clear( point_trails_s * const trails );
+
+
+/**
+ * @brief Push a scan onto the trail of its sensor.
+ *
+ * Ignored if the generation matches the newest scan. The scan is copied and
+ * uploaded once and older scans are thinned to their level of detail. While the
+ * trail is over its point budget the oldest scans are thinned further, then dropped.
+ *
+ * @param [in] trails A pointer to \ref point_trails_s which specifies the trails.
+ * @param [in] key A pointer to \ref point_trail_key_s which specifies the sensor.
+ * @param [in] generation Container point generation of the scan.
+ * @param [in] points A pointer to ps_lidar_point which specifies the points.
+ * @param [in] num_points Number of points.
+ * @param [in] timestamp Scan update time. [microseconds]
+ * @param [in] color_rgba A pointer to GLdouble which specifies the scan color.
+ * @param [in] point_size Point size. [pixels]
+ *
+ */
+void point_trails_push( point_trails_s * const trails, const point_trail_key_s * const key, const unsigned long long generation, const ps_lidar_point * const points, const unsigned long num_points, const ps_timestamp timestamp, const GLdouble * const color_rgba, const GLfloat point_size );
+
+
+/**
+ * @brief Draw the trails.
+ *
+ * Expired scans and empty trails are dropped. The newest scan of each trail
+ * is the live scan and is not drawn, older scans fade out with age.
+ *
+ * @param [in] trails A pointer to \ref point_trails_s which specifies the trails.
+ * @param [in] draw_time Current time. [microseconds]
+ *
+ */
+void point_trails_draw( point_trails_s * const trails, const ps_timestamp draw_time );
+
+
+
+
+#endif	/* POINT_TRAILS_H */
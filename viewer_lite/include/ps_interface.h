@@ -44,11 +44,61 @@
 #include "polysync_core.h"
 
 #include "gui.h"
+#include "point_downsample.h"
+#include "drawable_ring.h"
 
 
 
 
 
+/**
+ * @brief Default number of records in the subscriber to viewer ring.
+ *
+ * Messages arriving while all records are in use are dropped.
+ *
+ */
+#define         PS_DEFAULT_RING_SIZE        (64)
+
+
+/**
+ * @brief Radar targets message type used by \ref init_polysync_offline.
+ *
+ */
+#define         PS_OFFLINE_MSG_TYPE_RADAR_TARGETS   (1)
+
+
+/**
+ * @brief LiDAR points message type used by \ref init_polysync_offline.
+ *
+ */
+#define         PS_OFFLINE_MSG_TYPE_LIDAR_POINTS    (2)
+
+
+/**
+ * @brief Objects message type used by \ref init_polysync_offline.
+ *
+ */
+#define         PS_OFFLINE_MSG_TYPE_OBJECTS         (3)
+
+
+/**
+ * @brief Default maximum number of messages dequeued per batch.
+ *
+ */
+#define         PS_DEFAULT_MAX_BATCH        (256)
+
+
+/**
+ * @brief Default time budget for draining the message queue each frame. [microseconds]
+ *
+ * 10 milliseconds.
+ *
+ */
+#define         PS_DEFAULT_BATCH_BUDGET     (10000ULL)
+
+
+
+
 typedef struct
 {
     //
@@ -56,7 +106,7 @@ typedef struct
     ps_node_ref node;
     //
     //
-    GAsyncQueue *msg_queue;
+    drawable_ring_s *ring; /*!< Recycled records handed from the subscriber thread to the viewer. */
     //
     //
     ps_msg_type msg_type_radar_targets;
@@ -66,6 +116,24 @@ typedef struct
     //
     //
     ps_msg_type msg_type_objects;
+    //
+    //
+    unsigned int max_batch; /*!< Maximum number of messages dequeued per batch. */
+    //
+    //
+    ps_timestamp batch_budget; /*!< Time budget for draining the message queue per call. [microseconds] */
+    //
+    //
+    GPtrArray *batch; /*!< Reusable batch of acquired drawable records. */
+    //
+    //
+    GArray *batch_streams; /*!< Reusable list of sensor streams already parsed in the current batch. */
+    //
+    //
+    ingest_stats_s stats; /*!< Message ingest statistics. */
+    //
+    //
+    point_downsample_s *point_downsample; /*!< LiDAR point downsampling scratch data. */
 } node_data_s;
 
 
@@ -103,42 +171,68 @@ extern const char       PS_OBJECTS_MSG_NAME[];
 /**
  * @brief Initialize PolySync resources.
  *
- * Sets up data handler(s) and data queue for incoming messages.
+ * Sets up data handler(s) and the drawable record ring for incoming messages.
  *
- * @return A newly created PolySync message queue on success, NULL on failure.
+ * @return A newly created node data on success, NULL on failure.
  *
  */
 node_data_s *init_polysync( void );
 
 
+/**
+ * @brief Initialize message handling resources without a PolySync node.
+ *
+ * Messages are given with \ref ps_push_message, using the PS_OFFLINE_MSG_TYPE_ types.
+ *
+ * @return A newly created node data on success, NULL on failure.
+ *
+ */
+node_data_s *init_polysync_offline( void );
+
+
 /**
  * @brief Release PolySync resources.
  *
- * Free's any messages in the data queue.
+ * Free's the drawable record ring and any records in it.
  *
- * @param [in] msg_queue A pointer to GAsyncQueue which possibly contains PolySync messages.
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the resources to release.
  *
  */
 void release_polysync( node_data_s * const node_data );
 
 
 /**
- * @brief Process a PolySync message.
+ * @brief Hand a message to the consumer.
+ *
+ * Extracts the fields the viewer draws into the next drawable record, the message
+ * is dropped and counted if the ring is full. Called by the on-data handler.
  *
- * Dequeue a message (if any) from a data queue and process it into GUI objects
- * base on the type.
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the drawable record ring.
+ * @param [in] msg_type Message type, one of the node data message types.
+ * @param [in] message Message reference.
+ *
+ */
+void ps_push_message( node_data_s * const node_data, const ps_msg_type msg_type, const ps_msg_ref const message );
+
+
+/**
+ * @brief Process PolySync messages.
+ *
+ * Drains the drawable record ring in batches of up to \ref node_data_s.max_batch records
+ * until it is empty or \ref node_data_s.batch_budget has elapsed, and processes
+ * the records into GUI objects based on the kind.
+ * Within a batch only the newest record of each sensor (kind, source GUID and sensor identifier)
+ * is parsed, older ones are dropped and counted in \ref node_data_s.stats.
  *
  * @param [in] gui A pointer to \ref gui_context_s which specifies the configuration(s).
- * @param [in] msg_queue A pointer to GAsyncQueue which specifies the message queue to read from.
- * @param [in] parent_list A pointer to GList which specifies the parent entities list.
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the drawable record ring to read from.
+ * @param [in] store A pointer to \ref entity_store_s which specifies the entity store to update.
  * @param [in] update_time Update timestamp to give objects.
  * @param [out] msg_read A pointer to unsigned int which receives the message processed status.
- * Value one means a message was processed. Value zero means no messages were available.
- *
- * @return The (possibly new) parent entities list, NULL means empty list.
+ * Value one means at least one message was processed. Value zero means no messages were available.
  *
  */
-GList *ps_process_message( node_data_s * const node_data, const gui_context_s * const gui, GList * const parent_list, const unsigned long long update_time, unsigned int * const msg_read );
+void ps_process_message( node_data_s * const node_data, const gui_context_s * const gui, entity_store_s * const store, const unsigned long long update_time, unsigned int * const msg_read );
 
 
 
@@ -65,6 +65,36 @@ void render_ellipse_2d( const GLdouble cx, const GLdouble cy, const GLdouble maj
 void render_text_2d( const GLdouble cx, const GLdouble cy, const char * const text, const void * const font );
 
 
+int render_get_visible_bounds( entity_bounds_s * const bounds );
+
+
+void render_point_cloud_upload( point_cloud_buffer_s * const buffer, const ps_lidar_point * const points, const unsigned long num_points );
+
+
+void render_point_cloud_draw( const point_cloud_buffer_s * const buffer );
+
+
+void render_point_cloud_draw_range( const point_cloud_buffer_s * const buffer, const unsigned long first, const unsigned long count );
+
+
+void render_point_cloud_release( point_cloud_buffer_s * const buffer );
+
+
+render_batch_s *render_batch_new( void );
+
+
+void render_batch_free( render_batch_s * const batch );
+
+
+void render_batch_clear( render_batch_s * const batch );
+
+
+void render_batch_add( render_batch_s * const batch, const render_batch_kind kind, const GLdouble cx, const GLdouble cy, const GLdouble orientation, const GLdouble length, const GLdouble width, const GLdouble * const color_rgba );
+
+
+void render_batch_draw( render_batch_s * const batch, const render_batch_kind kind );
+
+
 
 
 #endif	/* RENDER_H */
@@ -0,0 +1,553 @@
+/**
+ * @file drawable_ring.c
+ * @brief Drawable Record Ring Interface Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <glib-2.0/glib.h>
+
+#include "polysync_core.h"
+#include "drawable_ring.h"
+
+
+
+
+// *****************************************************
+// static global structures
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Signal the notify file descriptor if not already signaled.
+ *
+ * Caller must hold \ref drawable_ring_s.lock.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ */
+static void notify_set( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Clear the notify file descriptor if signaled.
+ *
+ * Caller must hold \ref drawable_ring_s.lock.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ */
+static void notify_clear( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Take the oldest committed record not yet acquired out of the ring.
+ *
+ * Later slots move down by one, leaving the tail slot for the caller.
+ * Caller must hold \ref drawable_ring_s.lock.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ *
+ * @return A pointer to the record, NULL if every record is being written or was acquired.
+ *
+ */
+static drawable_record_s *take_oldest_ready( drawable_ring_s * const ring );
+
+
+/**
+ * @brief Keep a released record's point storage as a spare buffer, or free it.
+ *
+ * Caller must hold \ref drawable_ring_s.lock.
+ *
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring.
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the released record.
+ *
+ */
+static void put_spare_points( drawable_ring_s * const ring, drawable_record_s * const record );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static void notify_set( drawable_ring_s * const ring )
+{
+    // local vars
+    const uint64_t value = 1;
+
+
+    // one write per wakeup, not per record
+    if( ring->notified == 0 )
+    {
+        ring->notified = 1;
+        (void) write( ring->notify_fd, &value, sizeof(value) );
+    }
+}
+
+
+//
+static void notify_clear( drawable_ring_s * const ring )
+{
+    // local vars
+    uint64_t value = 0;
+
+
+    if( ring->notified != 0 )
+    {
+        ring->notified = 0;
+        (void) read( ring->notify_fd, &value, sizeof(value) );
+    }
+}
+
+
+//
+static drawable_record_s *take_oldest_ready( drawable_ring_s * const ring )
+{
+    // local vars
+    guint idx = 0;
+    drawable_record_s *record = NULL;
+
+
+    // acquired records are at the head, skip them and the ones still being written
+    for( idx = ring->acquired; idx < ring->count; idx++ )
+    {
+        if( ring->slots[ (ring->head + idx) % ring->capacity ]->state == DRAWABLE_RECORD_READY )
+        {
+            record = ring->slots[ (ring->head + idx) % ring->capacity ];
+            break;
+        }
+    }
+
+    if( record == NULL )
+    {
+        return NULL;
+    }
+
+    // close the gap, keeping the order of the other records
+    for( ; (idx + 1) < ring->count; idx++ )
+    {
+        ring->slots[ (ring->head + idx) % ring->capacity ] = ring->slots[ (ring->head + idx + 1) % ring->capacity ];
+    }
+
+    ring->slots[ (ring->head + ring->count - 1) % ring->capacity ] = record;
+
+
+    return record;
+}
+
+
+//
+static void put_spare_points( drawable_ring_s * const ring, drawable_record_s * const record )
+{
+    if( record->points == NULL )
+    {
+        return;
+    }
+
+    if( ring->spare_count < DRAWABLE_RING_SPARE_POINTS )
+    {
+        ring->spare_points[ ring->spare_count ] = record->points;
+        ring->spare_point_capacity[ ring->spare_count ] = record->point_capacity;
+        ring->spare_count += 1;
+    }
+    else
+    {
+        g_free( record->points );
+    }
+
+    record->points = NULL;
+    record->point_capacity = 0;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+drawable_ring_s *drawable_ring_new( const guint capacity )
+{
+    if( capacity == 0 )
+    {
+        return NULL;
+    }
+
+    // local vars
+    guint idx = 0;
+    drawable_ring_s *ring = NULL;
+
+
+    // create
+    if( (ring = g_try_new0( drawable_ring_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    if( (ring->records = g_try_new0( drawable_record_s, capacity )) == NULL )
+    {
+        g_free( ring );
+        return NULL;
+    }
+
+    if( (ring->slots = g_try_new0( drawable_record_s*, capacity )) == NULL )
+    {
+        g_free( ring->records );
+        g_free( ring );
+        return NULL;
+    }
+
+    // non-blocking so clearing never waits
+    if( (ring->notify_fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC )) < 0 )
+    {
+        g_free( ring->slots );
+        g_free( ring->records );
+        g_free( ring );
+        return NULL;
+    }
+
+    ring->capacity = capacity;
+
+    // item storage, points are allocated on first use
+    for( idx = 0; idx < capacity; idx++ )
+    {
+        ring->records[ idx ].items = g_array_new( FALSE, FALSE, sizeof(drawable_item_s) );
+        ring->slots[ idx ] = &ring->records[ idx ];
+    }
+
+    g_mutex_init( &ring->lock );
+
+
+    return ring;
+}
+
+
+//
+void drawable_ring_free( drawable_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+
+
+    for( idx = 0; idx < ring->capacity; idx++ )
+    {
+        g_array_free( ring->records[ idx ].items, TRUE );
+        g_free( ring->records[ idx ].points );
+    }
+
+    for( idx = 0; idx < ring->spare_count; idx++ )
+    {
+        g_free( ring->spare_points[ idx ] );
+    }
+
+    g_mutex_clear( &ring->lock );
+
+    (void) close( ring->notify_fd );
+
+    g_free( ring->slots );
+    g_free( ring->records );
+    g_free( ring );
+}
+
+
+//
+drawable_record_s *drawable_ring_reserve( drawable_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    drawable_record_s *record = NULL;
+
+
+    g_mutex_lock( &ring->lock );
+
+    if( ring->count < ring->capacity )
+    {
+        record = ring->slots[ (ring->head + ring->count) % ring->capacity ];
+        ring->count += 1;
+    }
+    else
+    {
+        // the consumer is behind, newer data replaces the oldest waiting record
+        record = take_oldest_ready( ring );
+        ring->overflows += 1;
+    }
+
+    if( record != NULL )
+    {
+        record->state = DRAWABLE_RECORD_WRITING;
+    }
+
+    g_mutex_unlock( &ring->lock );
+
+    // empty, keeping storage
+    if( record != NULL )
+    {
+        record->kind = DRAWABLE_RECORD_KIND_COUNT;
+        g_array_set_size( record->items, 0 );
+        record->num_points = 0;
+    }
+
+
+    return record;
+}
+
+
+//
+void drawable_ring_commit( drawable_ring_s * const ring, drawable_record_s * const record )
+{
+    if( (ring == NULL) || (record == NULL) )
+    {
+        return;
+    }
+
+
+    g_mutex_lock( &ring->lock );
+    record->state = DRAWABLE_RECORD_READY;
+    notify_set( ring );
+    g_mutex_unlock( &ring->lock );
+}
+
+
+//
+guint drawable_ring_acquire( drawable_ring_s * const ring, GPtrArray * const records, const guint max_records )
+{
+    if( (ring == NULL) || (records == NULL) )
+    {
+        return 0;
+    }
+
+    // local vars
+    guint acquired = 0;
+    drawable_record_s *record = NULL;
+
+
+    g_mutex_lock( &ring->lock );
+
+    // in order, stop at the first record still being written
+    while( (ring->acquired < ring->count) && (acquired < max_records) )
+    {
+        record = ring->slots[ (ring->head + ring->acquired) % ring->capacity ];
+
+        if( record->state != DRAWABLE_RECORD_READY )
+        {
+            break;
+        }
+
+        g_ptr_array_add( records, record );
+        ring->acquired += 1;
+        acquired += 1;
+    }
+
+    // nothing left to acquire, the next commit signals again
+    if( (ring->acquired == ring->count)
+            || (ring->slots[ (ring->head + ring->acquired) % ring->capacity ]->state != DRAWABLE_RECORD_READY) )
+    {
+        notify_clear( ring );
+    }
+
+    g_mutex_unlock( &ring->lock );
+
+
+    return acquired;
+}
+
+
+//
+void drawable_ring_release( drawable_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+    drawable_record_s *record = NULL;
+
+
+    g_mutex_lock( &ring->lock );
+
+    for( idx = 0; idx < ring->acquired; idx++ )
+    {
+        record = ring->slots[ (ring->head + idx) % ring->capacity ];
+        put_spare_points( ring, record );
+        record->state = DRAWABLE_RECORD_FREE;
+    }
+
+    ring->head = (ring->head + ring->acquired) % ring->capacity;
+    ring->count -= ring->acquired;
+    ring->acquired = 0;
+
+    g_mutex_unlock( &ring->lock );
+}
+
+
+//
+int drawable_record_reserve_points( drawable_ring_s * const ring, drawable_record_s * const record, const unsigned long num_points )
+{
+    if( (ring == NULL) || (record == NULL) )
+    {
+        return 1;
+    }
+
+    // local vars
+    guint idx = 0;
+    guint best = 0;
+    ps_lidar_point *points = NULL;
+    unsigned long capacity = 0;
+
+
+    if( num_points <= record->point_capacity )
+    {
+        return 0;
+    }
+
+    // take the smallest spare large enough, else the largest, contents aren't kept
+    g_mutex_lock( &ring->lock );
+
+    if( ring->spare_count != 0 )
+    {
+        for( idx = 1; idx < ring->spare_count; idx++ )
+        {
+            if( (ring->spare_point_capacity[ best ] < num_points)
+                    ? (ring->spare_point_capacity[ idx ] > ring->spare_point_capacity[ best ])
+                    : ((ring->spare_point_capacity[ idx ] >= num_points) && (ring->spare_point_capacity[ idx ] < ring->spare_point_capacity[ best ])) )
+            {
+                best = idx;
+            }
+        }
+
+        points = ring->spare_points[ best ];
+        capacity = ring->spare_point_capacity[ best ];
+
+        ring->spare_count -= 1;
+        ring->spare_points[ best ] = ring->spare_points[ ring->spare_count ];
+        ring->spare_point_capacity[ best ] = ring->spare_point_capacity[ ring->spare_count ];
+    }
+
+    g_mutex_unlock( &ring->lock );
+
+    // grow with headroom so scan size jitter doesn't reallocate
+    if( num_points > capacity )
+    {
+        g_free( points );
+        capacity = num_points + (num_points / 4);
+
+        if( (points = g_try_new( ps_lidar_point, capacity )) == NULL )
+        {
+            return 1;
+        }
+    }
+
+    g_free( record->points );
+    record->points = points;
+    record->point_capacity = capacity;
+
+
+    return 0;
+}
+
+
+//
+void drawable_ring_get_stats( drawable_ring_s * const ring, guint * const depth, unsigned long long * const overflows )
+{
+    if( (ring == NULL) || (depth == NULL) || (overflows == NULL) )
+    {
+        return;
+    }
+
+    g_mutex_lock( &ring->lock );
+    (*depth) = ring->count;
+    (*overflows) = ring->overflows;
+    g_mutex_unlock( &ring->lock );
+}
+
+
+
+//
+int drawable_ring_get_notify_fd( const drawable_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return -1;
+    }
+
+
+    return ring->notify_fd;
+}
+
+
+//
+void drawable_ring_notify( drawable_ring_s * const ring )
+{
+    if( ring == NULL )
+    {
+        return;
+    }
+
+
+    g_mutex_lock( &ring->lock );
+    notify_set( ring );
+    g_mutex_unlock( &ring->lock );
+}
+
+
+//
+int drawable_ring_wait( const drawable_ring_s * const ring, const ps_timestamp timeout )
+{
+    if( ring == NULL )
+    {
+        return 0;
+    }
+
+    // local vars
+    struct pollfd pfd;
+
+
+    pfd.fd = ring->notify_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    // round up so short waits don't spin, interrupted waits return early
+    if( poll( &pfd, 1, (int) ((MIN( timeout, (ps_timestamp) G_MAXINT / 1000 ) + 999) / 1000) ) <= 0 )
+    {
+        return 0;
+    }
+
+
+    return ((pfd.revents & POLLIN) != 0) ? 1 : 0;
+}
@@ -10,12 +10,15 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <float.h>
+#include <math.h>
 
 #include "gl_headers.h"
 #include "common.h"
 #include "drawable_type.h"
 #include "render.h"
 #include "color.h"
+#include "point_trails.h"
 #include "entity_manager.h"
 
 
@@ -32,6 +35,12 @@
 // static global data
 // *****************************************************
 
+/**
+ * @brief Identifier of the next point set, see \ref entity_point_set_s.id.
+ *
+ */
+static unsigned long long next_point_set_id = 1;
+
 
 
 
@@ -47,32 +56,42 @@
 // *****************************************************
 
 //
-static void object_release_function( gpointer data )
+static void point_set_unref( entity_point_set_s * const set )
 {
-    // cast
-    object_s *obj = (object_s*) data;
+    if( set == NULL )
+    {
+        return;
+    }
+
+    set->refs -= 1;
+
+    if( set->refs == 0 )
+    {
+        g_free( set->points );
+        g_free( set );
+    }
+}
 
 
+//
+static void object_release( entity_store_s * const store, object_s * const obj )
+{
     // if valid
     if( obj != NULL )
     {
-        // free points
-        if( obj->points_3d != NULL )
-        {
-            g_free( obj->points_3d );
-        }
+        // points are owned by the container
 
-        // free
-        g_free( obj );
+        // return to pool
+        entity_pool_free( &store->pools[ ENTITY_KIND_OBJECT ], obj );
     }
 }
 
 
 //
-static void container_release_function( gpointer data )
+static void container_release( entity_store_s * const store, object_container_s * const cntnr )
 {
-    // cast
-    object_container_s *cntnr = (object_container_s*) data;
+    // local vars
+    guint idx = 0;
 
 
     // if valid
@@ -82,20 +101,42 @@ static void container_release_function( gpointer data )
         if( cntnr->objects != NULL )
         {
             // free each object in container
-            g_list_free_full( cntnr->objects, object_release_function );
+            for( idx = 0; idx < cntnr->objects->len; idx++ )
+            {
+                object_release( store, (object_s*) g_ptr_array_index( cntnr->objects, idx ) );
+            }
+
+            // free array
+            (void) g_ptr_array_free( cntnr->objects, TRUE );
         }
 
-        // free
-        g_free( cntnr );
+        // free index, keys are owned by the objects
+        if( cntnr->object_index != NULL )
+        {
+            g_hash_table_destroy( cntnr->object_index );
+        }
+
+        // free point buffers
+        g_free( cntnr->point_buffers[ 0 ] );
+        g_free( cntnr->point_buffers[ 1 ] );
+
+        // free vertex buffer
+        render_point_cloud_release( &cntnr->points_gpu );
+
+        // snapshots may still hold the point set
+        point_set_unref( cntnr->point_set );
+
+        // return to pool
+        entity_pool_free( &store->pools[ ENTITY_KIND_CONTAINER ], cntnr );
     }
 }
 
 
 //
-static void parent_release_function( gpointer data )
+static void parent_release( entity_store_s * const store, object_container_parent_s * const parent )
 {
-    // cast
-    object_container_parent_s *parent = (object_container_parent_s*) data;
+    // local vars
+    guint idx = 0;
 
 
     // if valid
@@ -105,646 +146,1490 @@ static void parent_release_function( gpointer data )
         if( parent->containers != NULL )
         {
             // free each container in parent
-            g_list_free_full( parent->containers, container_release_function );
+            for( idx = 0; idx < parent->containers->len; idx++ )
+            {
+                container_release( store, (object_container_s*) g_ptr_array_index( parent->containers, idx ) );
+            }
+
+            // free array
+            (void) g_ptr_array_free( parent->containers, TRUE );
+        }
+
+        // free index, keys are owned by the containers
+        if( parent->container_index != NULL )
+        {
+            g_hash_table_destroy( parent->container_index );
         }
 
-        // free
-        g_free( parent );
+        // return to pool
+        entity_pool_free( &store->pools[ ENTITY_KIND_PARENT ], parent );
     }
 }
 
 
 //
-static gint object_id_compare_function( gconstpointer a, gconstpointer b )
+static void timeout_heap_swap( GPtrArray * const heap, const guint a, const guint b )
 {
-    // cast
-    const object_s *obj = (const object_s*) a;
-    const unsigned long long *id = (const unsigned long long*) b;
+    // local vars
+    entity_timeout_s * const ta = (entity_timeout_s*) g_ptr_array_index( heap, a );
+    entity_timeout_s * const tb = (entity_timeout_s*) g_ptr_array_index( heap, b );
 
 
-    // compare
-    if( obj->id < (*id) )
-    {
-        // a comes before b
-        return (gint) -1;
-    }
-    else if( obj->id > (*id) )
-    {
-        // a comes after b
-        return (gint) 1;
-    }
-    else
+    // swap
+    heap->pdata[ a ] = tb;
+    heap->pdata[ b ] = ta;
+
+    // update indices
+    ta->heap_index = b;
+    tb->heap_index = a;
+}
+
+
+//
+static void timeout_heap_sift_up( GPtrArray * const heap, guint index )
+{
+    // local vars
+    guint parent = 0;
+
+
+    // move towards the root while earlier than the parent
+    while( index > 0 )
     {
-        // a equals b
-        return (gint) 0;
+        parent = (index - 1) / 2;
+
+        if( ((entity_timeout_s*) g_ptr_array_index( heap, index ))->deadline
+                >= ((entity_timeout_s*) g_ptr_array_index( heap, parent ))->deadline )
+        {
+            break;
+        }
+
+        timeout_heap_swap( heap, index, parent );
+        index = parent;
     }
 }
 
 
 //
-static gint container_id_compare_function( gconstpointer a, gconstpointer b )
+static void timeout_heap_sift_down( GPtrArray * const heap, guint index )
 {
-    // cast
-    const object_container_s *cntnr = (const object_container_s*) a;
-    const unsigned long long *id = (const unsigned long long*) b;
+    // local vars
+    guint child = 0;
+    guint earliest = 0;
+
+
+    // move towards the leaves while later than a child
+    while( 1 )
+    {
+        earliest = index;
+
+        // left child
+        child = (2 * index) + 1;
+        if( (child < heap->len)
+                && (((entity_timeout_s*) g_ptr_array_index( heap, child ))->deadline
+                < ((entity_timeout_s*) g_ptr_array_index( heap, earliest ))->deadline) )
+        {
+            earliest = child;
+        }
+
+        // right child
+        child += 1;
+        if( (child < heap->len)
+                && (((entity_timeout_s*) g_ptr_array_index( heap, child ))->deadline
+                < ((entity_timeout_s*) g_ptr_array_index( heap, earliest ))->deadline) )
+        {
+            earliest = child;
+        }
+
+        if( earliest == index )
+        {
+            break;
+        }
+
+        timeout_heap_swap( heap, index, earliest );
+        index = earliest;
+    }
+}
 
 
-    // compare
-    if( cntnr->id < (*id) )
+//
+static void timeout_heap_remove( GPtrArray * const heap, entity_timeout_s * const timeout )
+{
+    // ignore if not queued
+    if( timeout->heap_index == ENTITY_TIMEOUT_NOT_QUEUED )
     {
-        // a comes before b
-        return (gint) -1;
+        return;
     }
-    else if( cntnr->id > (*id) )
+
+    // local vars
+    const guint index = timeout->heap_index;
+    const guint last = heap->len - 1;
+
+
+    // move to the end and drop
+    if( index != last )
     {
-        // a comes after b
-        return (gint) 1;
+        timeout_heap_swap( heap, index, last );
     }
-    else
+    (void) g_ptr_array_remove_index( heap, last );
+    timeout->heap_index = ENTITY_TIMEOUT_NOT_QUEUED;
+
+    // restore ordering of the element moved into the hole
+    if( index < heap->len )
     {
-        // a equals b
-        return (gint) 0;
+        timeout_heap_sift_down( heap, index );
+        timeout_heap_sift_up( heap, index );
     }
 }
 
 
 //
-static gint parent_id_compare_function( gconstpointer a, gconstpointer b )
+static void timeout_heap_schedule( GPtrArray * const heap, entity_timeout_s * const timeout, const ps_timestamp update_time, const ps_timestamp timeout_interval )
 {
-    // cast
-    const object_container_parent_s *parent = (const object_container_parent_s*) a;
-    const unsigned long long *id = (const unsigned long long*) b;
+    // dequeue if timeouts disabled
+    if( timeout_interval == ENTITY_NO_TIMEOUT )
+    {
+        timeout_heap_remove( heap, timeout );
+        return;
+    }
+
+    // local vars
+    const ps_timestamp previous = timeout->deadline;
 
 
-    // compare
-    if( parent->id < (*id) )
+    // set deadline
+    timeout->deadline = update_time + timeout_interval;
+
+    // queue or re-order
+    if( timeout->heap_index == ENTITY_TIMEOUT_NOT_QUEUED )
     {
-        // a comes before b
-        return (gint) -1;
+        timeout->heap_index = heap->len;
+        g_ptr_array_add( heap, timeout );
+        timeout_heap_sift_up( heap, timeout->heap_index );
     }
-    else if( parent->id > (*id) )
+    else if( timeout->deadline > previous )
     {
-        // a comes after b
-        return (gint) 1;
+        timeout_heap_sift_down( heap, timeout->heap_index );
     }
     else
     {
-        // a equals b
-        return (gint) 0;
+        timeout_heap_sift_up( heap, timeout->heap_index );
     }
 }
 
 
 //
-static GList *timeout_objects( GList * const object_list, const unsigned long long compare_time )
+static void timeout_init( entity_timeout_s * const timeout, const entity_kind kind, void * const entity )
 {
-    if( object_list == NULL )
-    {
-        return NULL;
-    }
+    timeout->deadline = 0;
+    timeout->heap_index = ENTITY_TIMEOUT_NOT_QUEUED;
+    timeout->kind = kind;
+    timeout->entity = entity;
+    timeout->owner = NULL;
+}
 
-    if( compare_time == 0 )
+
+//
+static void container_dequeue_all( GPtrArray * const heap, object_container_s * const container )
+{
+    // local vars
+    guint idx = 0;
+
+
+    // dequeue each object
+    for( idx = 0; idx < container->objects->len; idx++ )
     {
-        return object_list;
+        timeout_heap_remove( heap, &((object_s*) g_ptr_array_index( container->objects, idx ))->timeout );
     }
 
+    // dequeue container
+    timeout_heap_remove( heap, &container->timeout );
+}
+
+
+//
+static void container_remove_object( entity_store_s * const store, object_container_s * const container, object_s * const obj )
+{
     // local vars
-    GList   *list       = NULL;
-    GList   *element    = NULL;
-    GList   *next       = NULL;
+    const guint index = obj->store_index;
+    object_s *moved = NULL;
 
 
-    // set list
-    list = object_list;
-    element = list;
+    // dequeue timeout
+    timeout_heap_remove( store->timeouts, &obj->timeout );
 
-    // for each object
-    while( element != NULL )
+    // remove from index, key is owned by the object
+    (void) g_hash_table_remove( container->object_index, &obj->id );
+
+    // swap last element into the removed slot
+    (void) g_ptr_array_remove_index_fast( container->objects, index );
+
+    // bounds may shrink
+    container->bounds_stale = 1;
+
+    // update the moved object's index
+    if( index < container->objects->len )
     {
-        // cast
-        object_s *obj = (object_s*) element->data;
+        moved = (object_s*) g_ptr_array_index( container->objects, index );
+        moved->store_index = index;
+    }
 
-        // get next, since current may be deleted need to get next reference before
-        next = element->next;
+    // free object
+    object_release( store, obj );
+}
 
-        // if valid
-        if( obj != NULL )
-        {
-            // if timeouts enabled
-            if( obj->timeout_interval != ENTITY_NO_TIMEOUT )
-            {
-                // if object is in future or timeout exceeded
-                if( (obj->update_time > compare_time) || ((compare_time - obj->update_time) >= obj->timeout_interval) )
-                {
-                    // delete object link, update list
-                    list = g_list_remove_link( list, element );
 
-                    // free container
-                    object_release_function( element->data );
+//
+static void parent_remove_container( entity_store_s * const store, object_container_parent_s * const parent, object_container_s * const cntnr )
+{
+    // local vars
+    const guint index = cntnr->store_index;
+    object_container_s *moved = NULL;
+
 
-                    // free link
-                    g_list_free( element );
-                }
-            }
-        }
+    // dequeue container and object timeouts
+    container_dequeue_all( store->timeouts, cntnr );
 
-        // next element
-        element = next;
-    }
+    // remove from index, key is owned by the container
+    (void) g_hash_table_remove( parent->container_index, &cntnr->id );
+
+    // swap last element into the removed slot
+    (void) g_ptr_array_remove_index_fast( parent->containers, index );
 
+    // update the moved container's index
+    if( index < parent->containers->len )
+    {
+        moved = (object_container_s*) g_ptr_array_index( parent->containers, index );
+        moved->store_index = index;
+    }
 
-    // return parent list
-    return list;
+    // free container
+    container_release( store, cntnr );
 }
 
 
 //
-static GList *timeout_containers( GList * const container_list, const unsigned long long compare_time )
+static void store_remove_parent( entity_store_s * const store, object_container_parent_s * const parent )
 {
-    if( container_list == NULL )
+    // local vars
+    const guint index = parent->store_index;
+    object_container_parent_s *moved = NULL;
+    guint idx = 0;
+
+
+    // dequeue container and object timeouts
+    for( idx = 0; idx < parent->containers->len; idx++ )
     {
-        return NULL;
+        container_dequeue_all( store->timeouts, (object_container_s*) g_ptr_array_index( parent->containers, idx ) );
     }
 
-    if( compare_time == 0 )
+    // dequeue parent
+    timeout_heap_remove( store->timeouts, &parent->timeout );
+
+    // remove from index, key is owned by the parent
+    (void) g_hash_table_remove( store->parent_index, &parent->id );
+
+    // swap last element into the removed slot
+    (void) g_ptr_array_remove_index_fast( store->parents, index );
+
+    // update the moved parent's index
+    if( index < store->parents->len )
     {
-        return container_list;
+        moved = (object_container_parent_s*) g_ptr_array_index( store->parents, index );
+        moved->store_index = index;
     }
 
-    // local vars
-    GList   *list       = NULL;
-    GList   *element    = NULL;
-    GList   *next       = NULL;
+    // free parent
+    parent_release( store, parent );
+}
 
 
-    // set list
-    list = container_list;
-    element = list;
 
-    // for each container
-    while( element != NULL )
-    {
-        // cast
-        object_container_s *cntnr = (object_container_s*) element->data;
+//
+static object_container_s *store_get_container( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, object_container_parent_s ** const parent_out )
+{
+    // local vars
+    object_container_parent_s *parent = NULL;
+    object_container_s *cntnr = NULL;
 
-        // get next, since current may be deleted need to get next reference before
-        next = element->next;
 
-        // if valid
-        if( cntnr != NULL )
+    // search for parent
+    if( (parent = entity_store_search_by_id( store, parent_id )) == NULL )
+    {
+        // create new parent
+        if( (parent = entity_parent_new( store, parent_id )) == NULL )
         {
-            // if timeouts enabled
-            if( cntnr->timeout_interval != ENTITY_NO_TIMEOUT )
-            {
-                // if container is in future or timeout exceeded
-                if( (cntnr->update_time > compare_time) || ((compare_time - cntnr->update_time) >= cntnr->timeout_interval) )
-                {
-                    // delete container link, update list
-                    list = g_list_remove_link( list, element );
+            printf( "object : (%u) -- failed to create parent\n", __LINE__ );
+            return NULL;
+        }
 
-                    // free container
-                    container_release_function( element->data );
+        // add parent to store
+        parent->store_index = store->parents->len;
+        g_ptr_array_add( store->parents, parent );
+        g_hash_table_insert( store->parent_index, &parent->id, parent );
+    }
 
-                    // free link
-                    g_list_free( element );
-                }
-                else
-                {
-                    // check the container's objects
-                    cntnr->objects = timeout_objects( cntnr->objects, compare_time );
-                }
-            }
+    // search for container
+    if( (cntnr = entity_parent_search_by_id( parent, container_id )) == NULL )
+    {
+        // create new container
+        if( (cntnr = entity_container_new( store, container_id )) == NULL )
+        {
+            printf( "object : (%u) -- failed to create container\n", __LINE__ );
+            return NULL;
         }
 
-        // next element
-        element = next;
+        // add container to parent
+        cntnr->timeout.owner = parent;
+        cntnr->store_index = parent->containers->len;
+        g_ptr_array_add( parent->containers, cntnr );
+        g_hash_table_insert( parent->container_index, &cntnr->id, cntnr );
+    }
+
+    // provide parent
+    if( parent_out != NULL )
+    {
+        (*parent_out) = parent;
     }
 
 
-    // return parent list
-    return list;
+    // return container
+    return cntnr;
 }
 
 
+//
+static void bounds_add_box( entity_bounds_s * const bounds, const entity_bounds_s * const box )
+{
+    bounds->min_x = (box->min_x < bounds->min_x) ? box->min_x : bounds->min_x;
+    bounds->min_y = (box->min_y < bounds->min_y) ? box->min_y : bounds->min_y;
+    bounds->max_x = (box->max_x > bounds->max_x) ? box->max_x : bounds->max_x;
+    bounds->max_y = (box->max_y > bounds->max_y) ? box->max_y : bounds->max_y;
+}
 
 
-// *****************************************************
-// public definitions
-// *****************************************************
+//
+static void bounds_add_point( entity_bounds_s * const bounds, const GLdouble x, const GLdouble y )
+{
+    bounds->min_x = (x < bounds->min_x) ? x : bounds->min_x;
+    bounds->min_y = (y < bounds->min_y) ? y : bounds->min_y;
+    bounds->max_x = (x > bounds->max_x) ? x : bounds->max_x;
+    bounds->max_y = (y > bounds->max_y) ? y : bounds->max_y;
+}
+
 
 //
-object_s *entity_object_new( const unsigned long long id )
+static void object_get_bounds( const object_container_s * const container, const object_s * const obj, entity_bounds_s * const bounds )
 {
     // local vars
-    object_s *obj = NULL;
+    GLdouble extent = 0.0;
 
 
-    // create
-    if( (obj = g_try_new0( object_s, 1 )) == NULL)
+    entity_bounds_clear( bounds );
+
+    // points are bounded by the container's displayed points
+    if( obj->primitive == PRIMITIVE_POINTS )
     {
-        return NULL;
+        if( obj->num_points > 0 )
+        {
+            (*bounds) = container->points_bounds;
+        }
+
+        return;
     }
 
-    // init
-    entity_object_init( id, obj );
+    // circumscribed radius of any orientation
+    extent = sqrt( (obj->length * obj->length) + (obj->width * obj->width) ) / 2.0;
+    extent = (obj->radius > extent) ? obj->radius : extent;
+    extent = (obj->adjusted_radius > extent) ? obj->adjusted_radius : extent;
 
+    bounds->min_x = obj->x - extent;
+    bounds->min_y = obj->y - extent;
+    bounds->max_x = obj->x + extent;
+    bounds->max_y = obj->y + extent;
 
-    // return object memory
-    return obj;
+    // velocity vector end point
+    bounds_add_point( bounds, obj->x + obj->vx, obj->y + obj->vy );
 }
 
 
 //
-object_s *entity_object_new_copy( const object_s * const copy )
+static void container_refresh_bounds( object_container_s * const container )
 {
     // local vars
-    object_s *obj = NULL;
+    guint idx = 0;
+    entity_bounds_s box;
 
 
-    // create
-    if( (obj = g_try_new0( object_s, 1 )) == NULL)
+    if( container->bounds_stale == 0 )
     {
-        return NULL;
+        return;
     }
 
-    // zero
-    memset( obj, 0, sizeof(*obj) );
+    // rebuild tight bounds from the current objects
+    entity_bounds_clear( &container->bounds );
 
-    // copy
-    if( copy != NULL )
+    for( idx = 0; idx < container->objects->len; idx++ )
     {
-        memcpy( obj, copy, sizeof(*obj) );
+        object_get_bounds( container, (const object_s*) g_ptr_array_index( container->objects, idx ), &box );
+        bounds_add_box( &container->bounds, &box );
     }
 
-
-    // return object memory
-    return obj;
+    container->bounds_stale = 0;
 }
 
 
 //
-void entity_object_init( const unsigned long long id, object_s * const object )
+static entity_point_set_s *container_get_point_set( object_container_s * const cntnr )
 {
-    if( object == NULL )
+    // local vars
+    guint idx = 0;
+    const object_s *obj = NULL;
+    const ps_lidar_point * const front = cntnr->point_buffers[ cntnr->point_front ];
+    const unsigned long front_capacity = cntnr->point_capacity[ cntnr->point_front ];
+    unsigned long num_points = 0;
+    entity_point_set_s *set = NULL;
+
+
+    // displayed points are the part of the front buffer the objects view
+    for( idx = 0; idx < cntnr->objects->len; idx++ )
     {
-        return;
+        obj = (const object_s*) g_ptr_array_index( cntnr->objects, idx );
+
+        if( (front != NULL)
+                && (obj->points_3d >= front)
+                && (obj->num_points <= front_capacity)
+                && ((unsigned long) (obj->points_3d - front) <= (front_capacity - obj->num_points)) )
+        {
+            num_points = MAX( num_points, (unsigned long) (obj->points_3d - front) + obj->num_points );
+        }
     }
 
+    if( num_points == 0 )
+    {
+        return NULL;
+    }
 
-    // zero
-    memset( object, 0, sizeof(*object) );
+    // shared until new points are swapped in
+    if( (cntnr->point_set != NULL)
+            && (cntnr->point_set->generation == cntnr->points_generation)
+            && (cntnr->point_set->num_points >= num_points) )
+    {
+        return cntnr->point_set;
+    }
 
-    // id
-    object->id = id;
+    if( (set = g_try_new0( entity_point_set_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
 
-    // default timeout
-    object->timeout_interval = DEFAULT_OBJECT_TIMEOUT;
+    if( (set->points = g_try_new( ps_lidar_point, num_points )) == NULL )
+    {
+        g_free( set );
+        return NULL;
+    }
 
-    // defaults
-    color_get_4d( id, object->color_rgba );
-    object->length = 1.0;
-    object->width = 1.0;
-    object->height = 1.0;
-    object->radius = 1.0;
+    memcpy( set->points, front, num_points * sizeof(*set->points) );
+    set->num_points = num_points;
+    set->generation = cntnr->points_generation;
+    set->id = next_point_set_id;
+    next_point_set_id += 1;
+
+    // the container's reference
+    set->refs = 1;
+    point_set_unref( cntnr->point_set );
+    cntnr->point_set = set;
+
+
+    return set;
 }
 
 
 //
-object_container_s *entity_container_new( const unsigned long long id )
+static guint snapshot_points_hash( gconstpointer key )
 {
     // local vars
-    object_container_s *cntnr = NULL;
+    const snapshot_points_gpu_s * const points = (const snapshot_points_gpu_s*) key;
 
 
-    // create
-    if( (cntnr = g_try_new0( object_container_s, 1 )) == NULL)
-    {
-        return NULL;
-    }
+    return g_int64_hash( &points->parent_id ) ^ g_int64_hash( &points->container_id );
+}
 
-    // zero
-    memset( cntnr, 0, sizeof(*cntnr) );
 
-    // id
-    cntnr->id = id;
+//
+static gboolean snapshot_points_equal( gconstpointer a, gconstpointer b )
+{
+    // local vars
+    const snapshot_points_gpu_s * const points_a = (const snapshot_points_gpu_s*) a;
+    const snapshot_points_gpu_s * const points_b = (const snapshot_points_gpu_s*) b;
 
-    // default timeout
-    cntnr->timeout_interval = DEFAULT_CONTAINER_TIMEOUT;
 
-    // defaults
-    color_get_next_4d( cntnr->color_rgba );
+    return ((points_a->parent_id == points_b->parent_id) && (points_a->container_id == points_b->container_id)) ? TRUE : FALSE;
+}
 
 
-    // return container memory
-    return cntnr;
+//
+static void snapshot_points_free( gpointer data )
+{
+    // local vars
+    snapshot_points_gpu_s * const points = (snapshot_points_gpu_s*) data;
+
+
+    render_point_cloud_release( &points->gpu );
+    g_free( points );
 }
 
 
 //
-object_container_parent_s *entity_parent_new( const unsigned long long id )
+static gboolean snapshot_points_is_stale( gpointer key, gpointer value, gpointer user_data )
 {
     // local vars
-    object_container_parent_s *parent = NULL;
+    const snapshot_points_gpu_s * const points = (const snapshot_points_gpu_s*) value;
+
+
+    return (points->sequence != *((const unsigned long long*) user_data)) ? TRUE : FALSE;
+}
+
+
+//
+static snapshot_points_gpu_s *get_snapshot_points( GHashTable * const points_gpu, const object_s * const object )
+{
+    // local vars
+    snapshot_points_gpu_s key;
+    snapshot_points_gpu_s *points = NULL;
+
+
+    key.parent_id = object->parent_id;
+    key.container_id = object->container_id;
+
+    if( (points = g_hash_table_lookup( points_gpu, &key )) == NULL )
+    {
+        if( (points = g_try_new0( snapshot_points_gpu_s, 1 )) == NULL )
+        {
+            return NULL;
+        }
+
+        points->parent_id = object->parent_id;
+        points->container_id = object->container_id;
+        g_hash_table_insert( points_gpu, points, points );
+    }
+
+
+    return points;
+}
+
+
+//
+static void push_trail( const gui_context_s * const gui, const object_s * const object, const unsigned long long generation, const ps_lidar_point * const points, const GLdouble * const color )
+{
+    // local vars
+    point_trail_key_s key;
+
+
+    // ignore unless drawn, see draw_trails
+    if( (gui->config.points_trails_visible == 0)
+            || (gui->config.points_visible == 0)
+            || (gui->config.view_mode != VIEW_MODE_BIRDSEYE) )
+    {
+        return;
+    }
+
+    key.parent_id = object->parent_id;
+    key.container_id = object->container_id;
+
+    point_trails_push(
+            gui->point_trails,
+            &key,
+            generation,
+            points,
+            object->num_points,
+            object->update_time,
+            color,
+            (GLfloat) (object->radius * 2.0) );
+}
+
+
+//
+static const GLdouble *get_snapshot_color( const gui_context_s * const gui, const entity_snapshot_object_s * const entry )
+{
+    // check color mode
+    if( gui->config.color_mode == COLOR_MODE_PARENT_ID )
+    {
+        return entry->parent_color_rgba;
+    }
+    else if( gui->config.color_mode == COLOR_MODE_CONTAINER_ID )
+    {
+        return entry->container_color_rgba;
+    }
+
+
+    return entry->object.color_rgba;
+}
+
+
+//
+static void draw_trails( const gui_context_s * const gui )
+{
+    // drawn in birdseye while points are visible, history is dropped otherwise
+    if( (gui->config.points_trails_visible != 0)
+            && (gui->config.points_visible != 0)
+            && (gui->config.view_mode == VIEW_MODE_BIRDSEYE) )
+    {
+        point_trails_draw( gui->point_trails, gui->last_render_time );
+    }
+    else
+    {
+        point_trails_clear( gui->point_trails );
+    }
+}
+
+
+//
+static void draw_container_points( const gui_context_s * const gui, object_container_s * const container, const object_s * const object, const GLdouble * const color )
+{
+    // ignore if disabled
+    if( gui->config.points_visible == 0 )
+    {
+        return;
+    }
+
+    // only drawn in birdseye
+    if( gui->config.view_mode != VIEW_MODE_BIRDSEYE )
+    {
+        return;
+    }
+
+    // upload only if new points were swapped in since the last upload
+    if( container->points_gpu.generation != container->points_generation )
+    {
+        render_point_cloud_upload( &container->points_gpu, object->points_3d, object->num_points );
+        container->points_gpu.generation = container->points_generation;
+    }
+
+    // set color
+    glColor4dv( color );
+
+    // set point size
+    glPointSize( (GLfloat) (object->radius * 2.0) );
+
+    // draw
+    render_point_cloud_draw( &container->points_gpu );
+}
+
+//
+static void batch_object( const gui_context_s * const gui, const object_s * const object, const GLdouble * const color )
+{
+    // local vars
+    render_batch_s * const batch = gui->render_batch;
+
+
+    // ignore if disabled
+    if( (gui->config.circle_visible == 0) && (object->primitive == PRIMITIVE_CIRCLE) )
+    {
+        return;
+    }
+    else if( (gui->config.rectangle_visible == 0) && (object->primitive == PRIMITIVE_RECTANGLE) )
+    {
+        return;
+    }
+    else if( (gui->config.ellipse_visible == 0) && (object->primitive == PRIMITIVE_ELLIPSE) )
+    {
+        return;
+    }
+    else if( (gui->config.points_visible == 0) && (object->primitive == PRIMITIVE_POINTS) )
+    {
+        return;
+    }
+
+    // only drawn in birdseye
+    if( gui->config.view_mode != VIEW_MODE_BIRDSEYE )
+    {
+        return;
+    }
+
+    // if velocity vectors visible
+    if( gui->config.velocity_vectors_visible != 0 )
+    {
+        // relative vector with alpha
+        const GLdouble vector_color[ 4 ] = { color[ 0 ], color[ 1 ], color[ 2 ], 0.6 };
+
+        render_batch_add( batch, RENDER_BATCH_VECTOR, object->x, object->y, 0.0, object->vx, object->vy, vector_color );
+    }
+
+    // check primitive
+    if( object->primitive == PRIMITIVE_CIRCLE )
+    {
+        // check for adjusted radius usage
+        const GLdouble radius = (gui->config.adjusted_circle_radius != 0) ? object->adjusted_radius : object->radius;
+
+        render_batch_add( batch, RENDER_BATCH_CIRCLE, object->x, object->y, object->orientation, radius, radius, color );
+
+        // cross at center
+        render_batch_add( batch, RENDER_BATCH_CROSS, object->x, object->y, object->orientation, 0.5, 0.5, color );
+    }
+    else if( object->primitive == PRIMITIVE_CROSS )
+    {
+        render_batch_add( batch, RENDER_BATCH_CROSS, object->x, object->y, object->orientation, object->length, object->width, color );
+    }
+    else if( object->primitive == PRIMITIVE_RECTANGLE )
+    {
+        render_batch_add( batch, RENDER_BATCH_RECTANGLE, object->x, object->y, object->orientation, object->length, object->width, color );
+    }
+    else if( object->primitive == PRIMITIVE_TRIANGLE )
+    {
+        render_batch_add( batch, RENDER_BATCH_TRIANGLE, object->x, object->y, object->orientation, object->length, object->width, color );
+    }
+}
+
+//
+static void draw_batches( const gui_context_s * const gui )
+{
+    // velocity vectors use the default line width
+    glLineWidth( (GLfloat) GUI_DEFAULT_LINE_WIDTH );
+    render_batch_draw( gui->render_batch, RENDER_BATCH_VECTOR );
+
+    // set entity line width
+    glLineWidth( (GLfloat) gui->config.wireframe_width );
+
+    render_batch_draw( gui->render_batch, RENDER_BATCH_CIRCLE );
+    render_batch_draw( gui->render_batch, RENDER_BATCH_CROSS );
+    render_batch_draw( gui->render_batch, RENDER_BATCH_RECTANGLE );
+    render_batch_draw( gui->render_batch, RENDER_BATCH_TRIANGLE );
+}
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+entity_store_s *entity_store_new( void )
+{
+    // local vars
+    entity_store_s *store = NULL;
+
+
+    // create
+    if( (store = g_try_new0( entity_store_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    // create parent array and index, keys are owned by the parents
+    store->parents = g_ptr_array_new();
+    store->parent_index = g_hash_table_new( g_int64_hash, g_int64_equal );
+
+    // create deadline heap, elements are owned by the entities
+    store->timeouts = g_ptr_array_new();
+
+    // create entity pools
+    entity_pool_init( &store->pools[ ENTITY_KIND_OBJECT ], sizeof(object_s), ENTITY_OBJECT_SLAB_SIZE );
+    entity_pool_init( &store->pools[ ENTITY_KIND_CONTAINER ], sizeof(object_container_s), ENTITY_CONTAINER_SLAB_SIZE );
+    entity_pool_init( &store->pools[ ENTITY_KIND_PARENT ], sizeof(object_container_parent_s), ENTITY_PARENT_SLAB_SIZE );
+
+
+    // return store memory
+    return store;
+}
+
+
+//
+void entity_store_get_pool_stats( const entity_store_s * const store, const entity_kind kind, entity_pool_stats_s * const stats )
+{
+    if( (store == NULL) || (kind >= ENTITY_KIND_COUNT) || (stats == NULL) )
+    {
+        return;
+    }
+
+
+    // get pool stats
+    entity_pool_get_stats( &store->pools[ kind ], stats );
+}
+
+
+//
+object_s *entity_object_new( entity_store_s * const store, const unsigned long long id )
+{
+    if( store == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_s *obj = NULL;
+
+
+    // create
+    if( (obj = entity_pool_alloc( &store->pools[ ENTITY_KIND_OBJECT ] )) == NULL)
+    {
+        return NULL;
+    }
+
+    // init
+    entity_object_init( id, obj );
+
+
+    // return object memory
+    return obj;
+}
+
+
+//
+object_s *entity_object_new_copy( entity_store_s * const store, const object_s * const copy )
+{
+    if( store == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_s *obj = NULL;
 
 
     // create
-    if( (parent = g_try_new0( object_container_parent_s, 1 )) == NULL)
+    if( (obj = entity_pool_alloc( &store->pools[ ENTITY_KIND_OBJECT ] )) == NULL)
     {
         return NULL;
     }
 
+    // copy
+    if( copy != NULL )
+    {
+        memcpy( obj, copy, sizeof(*obj) );
+    }
+
+    // copies are not queued
+    timeout_init( &obj->timeout, ENTITY_KIND_OBJECT, obj );
+
+
+    // return object memory
+    return obj;
+}
+
+
+//
+void entity_object_init( const unsigned long long id, object_s * const object )
+{
+    if( object == NULL )
+    {
+        return;
+    }
+
+
     // zero
-    memset( parent, 0, sizeof(*parent) );
+    memset( object, 0, sizeof(*object) );
+
+    // id
+    object->id = id;
+
+    // default timeout
+    object->timeout_interval = DEFAULT_OBJECT_TIMEOUT;
+    timeout_init( &object->timeout, ENTITY_KIND_OBJECT, object );
+
+    // defaults
+    color_get_4d( id, object->color_rgba );
+    object->length = 1.0;
+    object->width = 1.0;
+    object->height = 1.0;
+    object->radius = 1.0;
+}
+
+
+//
+object_container_s *entity_container_new( entity_store_s * const store, const unsigned long long id )
+{
+    if( store == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_container_s *cntnr = NULL;
+
+
+    // create, pool memory is zeroed
+    if( (cntnr = entity_pool_alloc( &store->pools[ ENTITY_KIND_CONTAINER ] )) == NULL)
+    {
+        return NULL;
+    }
+
+    // id
+    cntnr->id = id;
+
+    // default timeout
+    cntnr->timeout_interval = DEFAULT_CONTAINER_TIMEOUT;
+    timeout_init( &cntnr->timeout, ENTITY_KIND_CONTAINER, cntnr );
+
+    // defaults
+    color_get_next_4d( cntnr->color_rgba );
+
+    // no objects, no bounds
+    entity_bounds_clear( &cntnr->bounds );
+    entity_bounds_clear( &cntnr->points_bounds );
+
+    // create object array and index, keys are owned by the objects
+    cntnr->objects = g_ptr_array_new();
+    cntnr->object_index = g_hash_table_new( g_int64_hash, g_int64_equal );
+
+
+    // return container memory
+    return cntnr;
+}
+
+
+//
+object_container_parent_s *entity_parent_new( entity_store_s * const store, const unsigned long long id )
+{
+    if( store == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_container_parent_s *parent = NULL;
+
+
+    // create, pool memory is zeroed
+    if( (parent = entity_pool_alloc( &store->pools[ ENTITY_KIND_PARENT ] )) == NULL)
+    {
+        return NULL;
+    }
+
+    // id
+    parent->id = id;
+
+    // default timeout
+    parent->timeout_interval = DEFAULT_PARENT_TIMEOUT;
+    timeout_init( &parent->timeout, ENTITY_KIND_PARENT, parent );
+
+    // defaults
+    color_get_next_4d( parent->color_rgba );
+
+    // create container array and index, keys are owned by the containers
+    parent->containers = g_ptr_array_new();
+    parent->container_index = g_hash_table_new( g_int64_hash, g_int64_equal );
+
+
+    // return parent memory
+    return parent;
+}
+
+
+//
+void entity_release_all( entity_store_s * const store )
+{
+    if( store == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+
+
+    // free each parent and its children
+    for( idx = 0; idx < store->parents->len; idx++ )
+    {
+        parent_release( store, (object_container_parent_s*) g_ptr_array_index( store->parents, idx ) );
+    }
+
+    // free arrays and index
+    (void) g_ptr_array_free( store->parents, TRUE );
+    g_hash_table_destroy( store->parent_index );
+    (void) g_ptr_array_free( store->timeouts, TRUE );
+
+    // free entity pools
+    for( idx = 0; idx < ENTITY_KIND_COUNT; idx++ )
+    {
+        entity_pool_release( &store->pools[ idx ] );
+    }
+
+    // free
+    g_free( store );
+}
+
+
+//
+unsigned int entity_update_timeouts( entity_store_s * const store, const unsigned long long compare_time )
+{
+    if( store == NULL )
+    {
+        return 0;
+    }
+
+    if( compare_time == 0 )
+    {
+        return 0;
+    }
+
+    // local vars
+    entity_timeout_s *timeout = NULL;
+    unsigned int expired = 0;
+
+
+    // expire entities in deadline order, removal dequeues them and their children
+    while( store->timeouts->len > 0 )
+    {
+        // earliest deadline
+        timeout = (entity_timeout_s*) g_ptr_array_index( store->timeouts, 0 );
+
+        // done if not yet due
+        if( timeout->deadline > compare_time )
+        {
+            break;
+        }
+
+        // remove and free entity
+        if( timeout->kind == ENTITY_KIND_OBJECT )
+        {
+            container_remove_object( store, (object_container_s*) timeout->owner, (object_s*) timeout->entity );
+        }
+        else if( timeout->kind == ENTITY_KIND_CONTAINER )
+        {
+            parent_remove_container( store, (object_container_parent_s*) timeout->owner, (object_container_s*) timeout->entity );
+        }
+        else
+        {
+            store_remove_parent( store, (object_container_parent_s*) timeout->entity );
+        }
+
+        expired += 1;
+    }
+
+
+    return expired;
+}
+
+
+//
+ps_timestamp entity_store_get_next_deadline( const entity_store_s * const store )
+{
+    if( (store == NULL) || (store->timeouts->len == 0) )
+    {
+        return 0;
+    }
+
+
+    // heap top is the earliest
+    return ((const entity_timeout_s*) g_ptr_array_index( store->timeouts, 0 ))->deadline;
+}
+
+
+//
+object_s *entity_container_search_by_id( const object_container_s * const container, const unsigned long long obj_id )
+{
+    if( container == NULL )
+    {
+        return NULL;
+    }
+
+
+    // search object index
+    return (object_s*) g_hash_table_lookup( container->object_index, &obj_id );
+}
+
+
+//
+object_container_s *entity_parent_search_by_id( const object_container_parent_s * const parent, const unsigned long long container_id )
+{
+    if( parent == NULL )
+    {
+        return NULL;
+    }
+
+
+    // search container index
+    return (object_container_s*) g_hash_table_lookup( parent->container_index, &container_id );
+}
+
+
+//
+object_container_parent_s *entity_store_search_by_id( const entity_store_s * const store, const unsigned long long parent_id )
+{
+    if( store == NULL )
+    {
+        return NULL;
+    }
+
+
+    // search parent index
+    return (object_container_parent_s*) g_hash_table_lookup( store->parent_index, &parent_id );
+}
+
+
+//
+ps_lidar_point *entity_container_get_point_buffer( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, const unsigned long num_points )
+{
+    if( (store == NULL) || (num_points == 0) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_container_s *cntnr = NULL;
+    unsigned int back = 0;
+    unsigned long capacity = 0;
+
+
+    // find or create parent and container
+    if( (cntnr = store_get_container( store, parent_id, container_id, NULL )) == NULL )
+    {
+        return NULL;
+    }
+
+    // back buffer
+    back = !cntnr->point_front;
+
+    // grow if needed, with headroom so scan size jitter doesn't reallocate
+    if( cntnr->point_capacity[ back ] < num_points )
+    {
+        capacity = num_points + (num_points / 4);
+
+        g_free( cntnr->point_buffers[ back ] );
+        cntnr->point_capacity[ back ] = 0;
+
+        if( (cntnr->point_buffers[ back ] = g_try_new( ps_lidar_point, capacity )) == NULL )
+        {
+            printf( "object : (%u) -- failed to create point buffer\n", __LINE__ );
+            return NULL;
+        }
+
+        cntnr->point_capacity[ back ] = capacity;
+    }
+
+
+    // return back buffer
+    return cntnr->point_buffers[ back ];
+}
+
+
+//
+ps_lidar_point *entity_container_exchange_point_buffer( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, ps_lidar_point ** const points, unsigned long * const capacity )
+{
+    if( (store == NULL) || (points == NULL) || (capacity == NULL) || ((*points) == NULL) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_container_s *cntnr = NULL;
+    unsigned int back = 0;
+    ps_lidar_point *buffer = NULL;
+    unsigned long buffer_capacity = 0;
+
+
+    // find or create parent and container
+    if( (cntnr = store_get_container( store, parent_id, container_id, NULL )) == NULL )
+    {
+        return NULL;
+    }
+
+    // back buffer
+    back = !cntnr->point_front;
+
+    // swap the filled buffer in, hand the old back buffer out
+    buffer = cntnr->point_buffers[ back ];
+    buffer_capacity = cntnr->point_capacity[ back ];
+
+    cntnr->point_buffers[ back ] = (*points);
+    cntnr->point_capacity[ back ] = (*capacity);
+
+    (*points) = buffer;
+    (*capacity) = buffer_capacity;
+
+
+    // return back buffer
+    return cntnr->point_buffers[ back ];
+}
+
+
+//
+object_s *entity_object_update_copy( entity_store_s * const store, const unsigned long long parent_id, const unsigned long long container_id, const object_s * const object )
+{
+    if( (store == NULL) || (object == NULL) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    object_container_parent_s *parent = NULL;
+    object_container_s *cntnr = NULL;
+    object_s *obj = NULL;
+    unsigned int store_index = 0;
+    unsigned long idx = 0;
+    entity_timeout_s timeout;
+    entity_bounds_s box;
+
+
+    // find or create parent and container
+    if( (cntnr = store_get_container( store, parent_id, container_id, &parent )) == NULL )
+    {
+        return NULL;
+    }
+
+    // search for object
+    if( (obj = entity_container_search_by_id( cntnr, object->id )) == NULL )
+    {
+        // create new object
+        if( (obj = entity_object_new( store, object->id )) == NULL )
+        {
+            printf( "object : (%u) -- failed to create object\n", __LINE__ );
+            return NULL;
+        }
+
+        // add object to container
+        obj->timeout.owner = cntnr;
+        obj->store_index = cntnr->objects->len;
+        g_ptr_array_add( cntnr->objects, obj );
+        g_hash_table_insert( cntnr->object_index, &obj->id, obj );
+    }
+    else
+    {
+        // existing object may have moved away from part of the bounds
+        cntnr->bounds_stale = 1;
+    }
+
+    // points written into the back buffer become the front buffer
+    if( (object->points_3d != NULL) && (object->points_3d == cntnr->point_buffers[ !cntnr->point_front ]) )
+    {
+        cntnr->point_front = !cntnr->point_front;
+        cntnr->points_generation += 1;
+
+        // bound the new points once here rather than every frame
+        entity_bounds_clear( &cntnr->points_bounds );
+        for( idx = 0; idx < object->num_points; idx++ )
+        {
+            bounds_add_point( &cntnr->points_bounds, object->points_3d[ idx ].position[ 0 ], object->points_3d[ idx ].position[ 1 ] );
+        }
+    }
+
+    // copy object, keeping its place in the container and timeout queue
+    store_index = obj->store_index;
+    timeout = obj->timeout;
+    memcpy( obj, object, sizeof(*obj) );
+    obj->store_index = store_index;
+    obj->timeout = timeout;
 
-    // id
-    parent->id = id;
+    // grow container bounds
+    object_get_bounds( cntnr, obj, &box );
+    bounds_add_box( &cntnr->bounds, &box );
 
-    // default timeout
-    parent->timeout_interval = DEFAULT_PARENT_TIMEOUT;
+    // update time
+    obj->update_time = object->update_time;
+    cntnr->update_time = object->update_time;
+    parent->update_time = object->update_time;
 
-    // defaults
-    color_get_next_4d( parent->color_rgba );
+    // reschedule timeouts
+    timeout_heap_schedule( store->timeouts, &obj->timeout, obj->update_time, obj->timeout_interval );
+    timeout_heap_schedule( store->timeouts, &cntnr->timeout, cntnr->update_time, cntnr->timeout_interval );
+    timeout_heap_schedule( store->timeouts, &parent->timeout, parent->update_time, parent->timeout_interval );
 
 
-    // return parent memory
-    return parent;
+    // return updated object
+    return obj;
 }
 
 
 //
-void entity_release_all( GList * const parent_list )
+void entity_object_push_trail( const gui_context_s * const gui, const entity_store_s * const store, const object_s * const object )
 {
-    if( parent_list == NULL )
+    if( (gui == NULL) || (store == NULL) || (object == NULL) || (object->points_3d == NULL) )
     {
         return;
     }
 
-    // free list and data elements
-    g_list_free_full( parent_list, parent_release_function );
-}
+    // local vars
+    const object_container_parent_s *parent = NULL;
+    const object_container_s *cntnr = NULL;
+    const GLdouble *color = object->color_rgba;
 
 
-//
-GList *entity_update_timeouts( GList * const parent_list, const unsigned long long compare_time )
-{
-    if( parent_list == NULL )
+    if( (parent = entity_store_search_by_id( store, object->parent_id )) == NULL )
     {
-        return NULL;
+        return;
     }
 
-    if( compare_time == 0 )
+    if( (cntnr = entity_parent_search_by_id( parent, object->container_id )) == NULL )
     {
-        return parent_list;
+        return;
     }
 
-    // local vars
-    GList   *list       = NULL;
-    GList   *element    = NULL;
-    GList   *next       = NULL;
-
-
-    // set list
-    list = parent_list;
-    element = list;
-
-    // for each parent
-    while( element != NULL )
+    // same color the container's points are drawn with
+    if( gui->config.color_mode == COLOR_MODE_PARENT_ID )
     {
-        // cast
-        object_container_parent_s *parent = (object_container_parent_s*) element->data;
-
-        // get next, since current may be deleted need to get next reference before
-        next = element->next;
-
-        // if valid
-        if( parent != NULL )
-        {
-            // if timeouts enabled
-            if( parent->timeout_interval != ENTITY_NO_TIMEOUT )
-            {
-                // if parent is in future or timeout exceeded
-                if( (parent->update_time > compare_time) || ((compare_time - parent->update_time) >= parent->timeout_interval) )
-                {
-                    // delete parent link, update list
-                    list = g_list_remove_link( list, element );
+        color = parent->color_rgba;
+    }
+    else if( gui->config.color_mode == COLOR_MODE_CONTAINER_ID )
+    {
+        color = cntnr->color_rgba;
+    }
 
-                    // free parent
-                    parent_release_function( element->data );
+    push_trail( gui, object, cntnr->points_generation, object->points_3d, color );
+}
 
-                    // free link
-                    g_list_free( element );
-                }
-                else
-                {
-                    // check containers and their children elements
-                    parent->containers = timeout_containers( parent->containers, compare_time );
-                }
-            }
-        }
 
-        // next element
-        element = next;
+//
+void entity_bounds_clear( entity_bounds_s * const bounds )
+{
+    if( bounds == NULL )
+    {
+        return;
     }
 
 
-    // return parent list
-    return list;
+    bounds->min_x = DBL_MAX;
+    bounds->min_y = DBL_MAX;
+    bounds->max_x = -DBL_MAX;
+    bounds->max_y = -DBL_MAX;
 }
 
 
 //
-object_s *entity_container_search_by_id( const object_container_s * const container, const unsigned long long obj_id )
+int entity_bounds_overlap( const entity_bounds_s * const a, const entity_bounds_s * const b )
 {
-    if( container == NULL )
+    if( (a == NULL) || (b == NULL) )
     {
-        return NULL;
+        return 0;
     }
 
-    // local vars
-    GList *element = NULL;
-
 
-    // check if objects exist
-    if( container->objects != NULL )
+    // empty boxes never overlap since min > max
+    if( (a->max_x < b->min_x) || (b->max_x < a->min_x) || (a->max_y < b->min_y) || (b->max_y < a->min_y) )
     {
-        // search object list
-        element = g_list_find_custom( container->objects, &obj_id, &object_id_compare_function );
+        return 0;
     }
 
-    // return object if found
-    if( (element != NULL) && (element->data != NULL) )
-    {
-        return ((object_s*) element->data);
-    }
-    else
-    {
-        // no found
-        return NULL;
-    }
+
+    return 1;
 }
 
 
 //
-object_container_s *entity_parent_search_by_id( const object_container_parent_s * const parent, const unsigned long long container_id )
+void entity_snapshot_init( entity_snapshot_s * const snapshot )
 {
-    if( parent == NULL )
+    if( snapshot == NULL )
     {
-        return NULL;
+        return;
     }
 
-    // local vars
-    GList *element = NULL;
-
 
-    // check if containers exist
-    if( parent->containers != NULL )
-    {
-        // search container list
-        element = g_list_find_custom( parent->containers, &container_id, &container_id_compare_function );
-    }
+    // zero
+    memset( snapshot, 0, sizeof(*snapshot) );
 
-    // return container if found
-    if( (element != NULL) && (element->data != NULL) )
-    {
-        return ((object_container_s*) element->data);
-    }
-    else
-    {
-        // no found
-        return NULL;
-    }
+    snapshot->objects = g_array_new( FALSE, FALSE, sizeof(entity_snapshot_object_s) );
+    snapshot->point_sets = g_ptr_array_new_with_free_func( (GDestroyNotify) point_set_unref );
 }
 
 
 //
-object_container_parent_s *entity_parent_list_search_by_id( const GList * const parent_list, const unsigned long long parent_id )
+void entity_snapshot_release( entity_snapshot_s * const snapshot )
 {
-    if( parent_list == NULL )
+    if( snapshot == NULL )
     {
-        return NULL;
+        return;
     }
 
-    // local vars
-    GList *element = NULL;
-
 
-    // search parent list
-    element = g_list_find_custom( (GList*) parent_list, &parent_id, &parent_id_compare_function );
-
-    // return parent if found
-    if( (element != NULL) && (element->data != NULL) )
+    if( snapshot->objects != NULL )
     {
-        return ((object_container_parent_s*) element->data);
+        g_array_free( snapshot->objects, TRUE );
     }
-    else
+
+    if( snapshot->point_sets != NULL )
     {
-        // no found
-        return NULL;
+        g_ptr_array_free( snapshot->point_sets, TRUE );
     }
+
+    // zero
+    memset( snapshot, 0, sizeof(*snapshot) );
 }
 
 
 //
-GList *entity_object_update_copy( GList * const parent_list, const unsigned long long parent_id, const unsigned long long container_id, const object_s * const object )
+void entity_snapshot_build( entity_store_s * const store, entity_snapshot_s * const snapshot )
 {
+    if( (store == NULL) || (snapshot == NULL) )
+    {
+        return;
+    }
+
     // local vars
-    GList *list = NULL;
-    object_container_parent_s *parent = NULL;
+    guint pdx = 0;
+    guint cdx = 0;
+    guint odx = 0;
+    const object_container_parent_s *parent = NULL;
     object_container_s *cntnr = NULL;
-    object_s *obj = NULL;
+    const object_s *obj = NULL;
+    entity_point_set_s *set = NULL;
+    entity_snapshot_object_s *entry = NULL;
 
 
-    // set list
-    list = parent_list;
+    // reuse storage from the previous snapshot held in this slot, dropping its point sets
+    g_array_set_size( snapshot->objects, 0 );
+    g_ptr_array_set_size( snapshot->point_sets, 0 );
 
-    // search for parent
-    if( (parent = entity_parent_list_search_by_id( list, parent_id )) == NULL )
+    // for each parent
+    for( pdx = 0; pdx < store->parents->len; pdx++ )
     {
-        // create new parent
-        if( (parent = entity_parent_new( parent_id )) == NULL )
-        {
-            printf( "object : (%u) -- failed to create parent\n", __LINE__ );
-            return NULL;
-        }
-
-        // create new container
-        if( (cntnr = entity_container_new( container_id )) == NULL )
-        {
-            printf( "object : (%u) -- failed to create container\n", __LINE__ );
-            return NULL;
-        }
+        parent = (const object_container_parent_s*) g_ptr_array_index( store->parents, pdx );
 
-        // create new object
-        if( (obj = entity_object_new( object->id )) == NULL )
+        // for each container
+        for( cdx = 0; cdx < parent->containers->len; cdx++ )
         {
-            printf( "object : (%u) -- failed to create object\n", __LINE__ );
-            return NULL;
-        }
-
-        // add object to container
-        cntnr->objects = g_list_append( cntnr->objects, obj );
+            cntnr = (object_container_s*) g_ptr_array_index( parent->containers, cdx );
 
-        // add container to parent
-        parent->containers = g_list_append( parent->containers, cntnr );
+            // points are only copied if new ones were swapped in since an earlier snapshot
+            if( (set = container_get_point_set( cntnr )) != NULL )
+            {
+                set->refs += 1;
+                g_ptr_array_add( snapshot->point_sets, set );
+            }
 
-        // add parent to list
-        list = g_list_append( list, parent );
-    }
-    // search for container
-    else if( (cntnr = entity_parent_search_by_id( parent, container_id )) == NULL )
-    {
-        // create new container
-        if( (cntnr = entity_container_new( container_id )) == NULL )
-        {
-            printf( "object : (%u) -- failed to create container\n", __LINE__ );
-            return NULL;
-        }
+            // for each object
+            for( odx = 0; odx < cntnr->objects->len; odx++ )
+            {
+                obj = (const object_s*) g_ptr_array_index( cntnr->objects, odx );
+
+                // append entry
+                g_array_set_size( snapshot->objects, snapshot->objects->len + 1 );
+                entry = &g_array_index( snapshot->objects, entity_snapshot_object_s, snapshot->objects->len - 1 );
+
+                // copy object, points are referenced from the container's point set
+                memcpy( &entry->object, obj, sizeof(entry->object) );
+                entry->object.points_3d = NULL;
+                entry->point_set = NULL;
+                entry->point_offset = 0;
+
+                if( (set != NULL)
+                        && (obj->num_points > 0)
+                        && (obj->points_3d >= cntnr->point_buffers[ cntnr->point_front ])
+                        && (obj->num_points <= set->num_points)
+                        && ((unsigned long) (obj->points_3d - cntnr->point_buffers[ cntnr->point_front ]) <= (set->num_points - obj->num_points)) )
+                {
+                    entry->point_set = set;
+                    entry->point_offset = (unsigned long) (obj->points_3d - cntnr->point_buffers[ cntnr->point_front ]);
+                }
+                else
+                {
+                    entry->object.num_points = 0;
+                }
 
-        // create new object
-        if( (obj = entity_object_new( object->id )) == NULL )
-        {
-            printf( "object : (%u) -- failed to create object\n", __LINE__ );
-            return NULL;
-        }
+                object_get_bounds( cntnr, obj, &entry->bounds );
 
-        // add object to container
-        cntnr->objects = g_list_append( cntnr->objects, obj );
+                entry->points_generation = cntnr->points_generation;
 
-        // add container to parent
-        parent->containers = g_list_append( parent->containers, cntnr );
-    }
-    // search for object
-    else if( (obj = entity_container_search_by_id( cntnr, object->id )) == NULL )
-    {
-        // create new object
-        if( (obj = entity_object_new( object->id )) == NULL )
-        {
-            printf( "object : (%u) -- failed to create object\n", __LINE__ );
-            return NULL;
+                memcpy( entry->container_color_rgba, cntnr->color_rgba, sizeof(entry->container_color_rgba) );
+                memcpy( entry->parent_color_rgba, parent->color_rgba, sizeof(entry->parent_color_rgba) );
+            }
         }
-
-        // add object to container
-        cntnr->objects = g_list_append( cntnr->objects, obj );
-    }
-
-    // free points if any before we overwrite
-    if( obj->points_3d != NULL )
-    {
-        g_free( obj->points_3d );
-        obj->points_3d = NULL;
     }
-
-    // copy object
-    memcpy( obj, object, sizeof(*obj) );
-
-    // update time
-    obj->update_time = object->update_time;
-    cntnr->update_time = object->update_time;
-    parent->update_time = object->update_time;
+}
 
 
-    // return parent list
-    return list;
+//
+GHashTable *entity_snapshot_points_new( void )
+{
+    return g_hash_table_new_full( snapshot_points_hash, snapshot_points_equal, NULL, snapshot_points_free );
 }
 
 
@@ -902,7 +1787,7 @@ void entity_draw_object( const gui_context_s * const gui, const object_s * const
 
 
 //
-void entity_draw_container( const gui_context_s * const gui, const object_container_s * const container, const GLdouble * const color_rgba )
+void entity_draw_container( const gui_context_s * const gui, object_container_s * const container, const GLdouble * const color_rgba )
 {
     if( (gui == NULL) || (container == NULL) )
     {
@@ -910,44 +1795,55 @@ void entity_draw_container( const gui_context_s * const gui, const object_contai
     }
 
     // local vars
-    GList *element = NULL;
+    guint idx = 0;
+    const object_s *obj = NULL;
+    const GLdouble *color = NULL;
 
 
     // for each object
-    element = container->objects;
-    while( element != NULL )
+    for( idx = 0; idx < container->objects->len; idx++ )
     {
+        // cast
+        obj = (const object_s*) g_ptr_array_index( container->objects, idx );
+
         // check if color provided
         if( color_rgba != NULL )
         {
-            // draw object using provided color
-            entity_draw_object( gui, (const object_s*) element->data, color_rgba );
+            // use provided color
+            color = color_rgba;
+        }
+        else if( gui->config.color_mode == COLOR_MODE_CONTAINER_ID )
+        {
+            // use containers color
+            color = container->color_rgba;
         }
         else
         {
-            // check color mode
-            if( gui->config.color_mode == COLOR_MODE_CONTAINER_ID )
-            {
-                // draw object using containers color
-                entity_draw_object( gui, (const object_s*) element->data, container->color_rgba );
-            }
-            else
-            {
-                // COLOR_MODE_OBJECT_ID
+            // COLOR_MODE_OBJECT_ID
 
-                // draw object using its color
-                entity_draw_object( gui, (const object_s*) element->data, ((const object_s*) element->data)->color_rgba );
-            }
+            // use its color
+            color = obj->color_rgba;
         }
 
-        // next element
-        element = element->next;
+        // points are drawn from the container's vertex buffer
+        if( (obj->primitive == PRIMITIVE_POINTS) && (obj->points_3d != NULL) )
+        {
+            draw_container_points( gui, container, obj, color );
+        }
+        else if( gui->render_batch != NULL )
+        {
+            batch_object( gui, obj, color );
+        }
+        else
+        {
+            entity_draw_object( gui, obj, color );
+        }
     }
 }
 
 
 //
-void entity_draw_parent( const gui_context_s * const gui, const object_container_parent_s * const parent )
+void entity_draw_parent( const gui_context_s * const gui, object_container_parent_s * const parent, const entity_bounds_s * const visible, cull_stats_s * const stats )
 {
     if( (gui == NULL) || (parent == NULL) )
     {
@@ -955,18 +1851,44 @@ void entity_draw_parent( const gui_context_s * const gui, const object_container
     }
 
     // local vars
-    GList *element = NULL;
+    guint idx = 0;
+    object_container_s *cntnr = NULL;
 
 
     // for each container
-    element = parent->containers;
-    while( element != NULL )
+    for( idx = 0; idx < parent->containers->len; idx++ )
     {
+        // cast
+        cntnr = (object_container_s*) g_ptr_array_index( parent->containers, idx );
+
+        // cull containers outside the visible region
+        if( visible != NULL )
+        {
+            container_refresh_bounds( cntnr );
+
+            if( entity_bounds_overlap( &cntnr->bounds, visible ) == 0 )
+            {
+                if( stats != NULL )
+                {
+                    stats->containers_culled += 1;
+                    stats->objects_culled += cntnr->objects->len;
+                }
+
+                continue;
+            }
+        }
+
+        if( stats != NULL )
+        {
+            stats->containers_drawn += 1;
+            stats->objects_drawn += cntnr->objects->len;
+        }
+
         // check color mode
         if( gui->config.color_mode == COLOR_MODE_PARENT_ID )
         {
             // draw container and children using this parents color
-            entity_draw_container( gui, (const object_container_s*) element->data, parent->color_rgba );
+            entity_draw_container( gui, cntnr, parent->color_rgba );
         }
         else
         {
@@ -974,35 +1896,170 @@ void entity_draw_parent( const gui_context_s * const gui, const object_container
             // COLOR_MODE_OBJECT_ID
 
             // draw container and children using given color mode
-            entity_draw_container( gui, (const object_container_s*) element->data, NULL );
+            entity_draw_container( gui, cntnr, NULL );
         }
-
-        // next element
-        element = element->next;
     }
 }
 
 
 //
-void entity_draw_all( const gui_context_s * const gui, const GList * const parent_list )
+void entity_draw_all( const gui_context_s * const gui, entity_store_s * const store, cull_stats_s * const stats )
 {
-    if( (gui == NULL) || (parent_list == NULL) )
+    if( (gui == NULL) || (store == NULL) )
     {
         return;
     }
 
     // local vars
-    GList *element = NULL;
+    guint idx = 0;
+    entity_bounds_s visible;
+    const entity_bounds_s *cull_region = NULL;
+
+
+    if( stats != NULL )
+    {
+        memset( stats, 0, sizeof(*stats) );
+    }
+
+    // cull against the visible region, entities are only drawn in birdseye
+    if( (gui->config.view_mode == VIEW_MODE_BIRDSEYE) && (render_get_visible_bounds( &visible ) == 0) )
+    {
+        cull_region = &visible;
+    }
 
+    // past scans under the live ones
+    draw_trails( gui );
+
+    // start a new frame of instances
+    render_batch_clear( gui->render_batch );
 
     // for each parent
-    element = (GList*) parent_list;
-    while( element != NULL )
+    for( idx = 0; idx < store->parents->len; idx++ )
+    {
+        // draw parent, queues its primitives
+        entity_draw_parent( gui, (object_container_parent_s*) g_ptr_array_index( store->parents, idx ), cull_region, stats );
+    }
+
+    // one draw per primitive kind
+    draw_batches( gui );
+}
+
+
+//
+void entity_draw_snapshot( const gui_context_s * const gui, const entity_snapshot_s * const snapshot, GHashTable * const points_gpu, cull_stats_s * const stats )
+{
+    if( (gui == NULL) || (snapshot == NULL) || (points_gpu == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+    const entity_snapshot_object_s *entry = NULL;
+    const GLdouble *color = NULL;
+    snapshot_points_gpu_s *points = NULL;
+    entity_bounds_s visible;
+    const entity_bounds_s *cull_region = NULL;
+    unsigned long long sequence = snapshot->sequence;
+
+
+    if( stats != NULL )
+    {
+        memset( stats, 0, sizeof(*stats) );
+    }
+
+    // cull against the visible region, entities are only drawn in birdseye
+    if( (gui->config.view_mode == VIEW_MODE_BIRDSEYE) && (render_get_visible_bounds( &visible ) == 0) )
+    {
+        cull_region = &visible;
+    }
+
+    // upload only the containers whose point set changed, visible or not
+    for( idx = 0; idx < snapshot->objects->len; idx++ )
+    {
+        entry = &g_array_index( snapshot->objects, entity_snapshot_object_s, idx );
+
+        if( (entry->point_set == NULL) || ((points = get_snapshot_points( points_gpu, &entry->object )) == NULL) )
+        {
+            continue;
+        }
+
+        points->sequence = sequence;
+
+        if( points->gpu.generation != entry->point_set->id )
+        {
+            render_point_cloud_upload( &points->gpu, entry->point_set->points, entry->point_set->num_points );
+            points->gpu.generation = entry->point_set->id;
+        }
+
+        // add new scans to their trails, trails ignore generations they already have
+        if( entry->object.primitive == PRIMITIVE_POINTS )
+        {
+            push_trail(
+                    gui,
+                    &entry->object,
+                    entry->points_generation,
+                    &entry->point_set->points[ entry->point_offset ],
+                    get_snapshot_color( gui, entry ) );
+        }
+    }
+
+    // containers no longer in the snapshot
+    (void) g_hash_table_foreach_remove( points_gpu, snapshot_points_is_stale, &sequence );
+
+    // past scans under the live ones
+    draw_trails( gui );
+
+    // start a new frame of instances
+    render_batch_clear( gui->render_batch );
+
+    // for each object
+    for( idx = 0; idx < snapshot->objects->len; idx++ )
     {
-        // draw parent
-        entity_draw_parent( gui, (const object_container_parent_s*) element->data );
+        entry = &g_array_index( snapshot->objects, entity_snapshot_object_s, idx );
+
+        // cull objects outside the visible region, snapshots carry per object bounds
+        if( (cull_region != NULL) && (entity_bounds_overlap( &entry->bounds, cull_region ) == 0) )
+        {
+            if( stats != NULL )
+            {
+                stats->objects_culled += 1;
+            }
+
+            continue;
+        }
+
+        if( stats != NULL )
+        {
+            stats->objects_drawn += 1;
+        }
 
-        // next element
-        element = element->next;
+        // check color mode
+        color = get_snapshot_color( gui, entry );
+
+        if( entry->object.primitive == PRIMITIVE_POINTS )
+        {
+            // points are drawn from their container's vertex buffer
+            if( (gui->config.points_visible != 0)
+                    && (gui->config.view_mode == VIEW_MODE_BIRDSEYE)
+                    && (entry->point_set != NULL)
+                    && ((points = get_snapshot_points( points_gpu, &entry->object )) != NULL) )
+            {
+                glColor4dv( color );
+                glPointSize( (GLfloat) (entry->object.radius * 2.0) );
+                render_point_cloud_draw_range( &points->gpu, entry->point_offset, entry->object.num_points );
+            }
+        }
+        else if( gui->render_batch != NULL )
+        {
+            batch_object( gui, &entry->object, color );
+        }
+        else
+        {
+            entity_draw_object( gui, &entry->object, color );
+        }
     }
+
+    // one draw per primitive kind
+    draw_batches( gui );
 }
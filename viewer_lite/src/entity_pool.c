@@ -0,0 +1,230 @@
+/**
+ * @file entity_pool.c
+ * @brief Entity Slab Pool Interface Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "entity_pool.h"
+
+
+
+
+// *****************************************************
+// static global structures
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Grow an entity pool by one slab.
+ *
+ * Threads the new slab's elements onto the free list.
+ *
+ * @param [in] pool A pointer to \ref entity_pool_s which specifies the pool.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+static int pool_grow( entity_pool_s * const pool );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static int pool_grow( entity_pool_s * const pool )
+{
+    // local vars
+    unsigned char *slab = NULL;
+    unsigned long idx = 0;
+
+
+    // create slab
+    if( (slab = g_try_malloc( pool->element_size * pool->slab_elements )) == NULL )
+    {
+        return 1;
+    }
+
+    // keep slab
+    g_ptr_array_add( pool->slabs, slab );
+
+    // push each element, in reverse so allocations walk the slab forward
+    idx = pool->slab_elements;
+    while( idx > 0 )
+    {
+        idx -= 1;
+
+        // link element to current head
+        *((void**) &slab[ idx * pool->element_size ]) = pool->free_list;
+
+        // new head
+        pool->free_list = &slab[ idx * pool->element_size ];
+    }
+
+    // update stats
+    pool->stats.slabs += 1;
+    pool->stats.capacity += pool->slab_elements;
+
+
+    return 0;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+void entity_pool_init( entity_pool_s * const pool, const size_t element_size, const unsigned long slab_elements )
+{
+    if( pool == NULL )
+    {
+        return;
+    }
+
+
+    // zero
+    memset( pool, 0, sizeof(*pool) );
+
+    // element must hold the free list link, round up to pointer alignment
+    pool->element_size = element_size;
+    if( pool->element_size < sizeof(void*) )
+    {
+        pool->element_size = sizeof(void*);
+    }
+    pool->element_size = ((pool->element_size + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*);
+
+    // at least one element per slab
+    pool->slab_elements = slab_elements;
+    if( pool->slab_elements == 0 )
+    {
+        pool->slab_elements = 1;
+    }
+
+    // create slab list
+    pool->slabs = g_ptr_array_new();
+}
+
+
+//
+void entity_pool_release( entity_pool_s * const pool )
+{
+    if( (pool == NULL) || (pool->slabs == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+
+
+    // free each slab
+    for( idx = 0; idx < pool->slabs->len; idx++ )
+    {
+        g_free( g_ptr_array_index( pool->slabs, idx ) );
+    }
+
+    // free slab list
+    (void) g_ptr_array_free( pool->slabs, TRUE );
+
+    // zero
+    memset( pool, 0, sizeof(*pool) );
+}
+
+
+//
+void *entity_pool_alloc( entity_pool_s * const pool )
+{
+    if( (pool == NULL) || (pool->slabs == NULL) )
+    {
+        return NULL;
+    }
+
+    // local vars
+    void *element = NULL;
+
+
+    // grow if empty
+    if( pool->free_list == NULL )
+    {
+        if( pool_grow( pool ) != 0 )
+        {
+            return NULL;
+        }
+    }
+
+    // pop head
+    element = pool->free_list;
+    pool->free_list = *((void**) element);
+
+    // zero
+    memset( element, 0, pool->element_size );
+
+    // update stats
+    pool->stats.in_use += 1;
+    pool->stats.allocations += 1;
+    if( pool->stats.in_use > pool->stats.high_water )
+    {
+        pool->stats.high_water = pool->stats.in_use;
+    }
+
+
+    // return element memory
+    return element;
+}
+
+
+//
+void entity_pool_free( entity_pool_s * const pool, void * const element )
+{
+    if( (pool == NULL) || (element == NULL) )
+    {
+        return;
+    }
+
+
+    // push head
+    *((void**) element) = pool->free_list;
+    pool->free_list = element;
+
+    // update stats
+    pool->stats.in_use -= 1;
+}
+
+
+//
+void entity_pool_get_stats( const entity_pool_s * const pool, entity_pool_stats_s * const stats )
+{
+    if( (pool == NULL) || (stats == NULL) )
+    {
+        return;
+    }
+
+
+    // copy
+    memcpy( stats, &pool->stats, sizeof(*stats) );
+}
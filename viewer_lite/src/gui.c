@@ -137,6 +137,45 @@ static void on_resize( int w, int h );
 static void on_draw( void );
 
 
+/**
+ * @brief Draw a frame of the global GUI context into the current GL context.
+ *
+ * Does not swap buffers.
+ *
+ */
+static void draw_frame( void );
+
+
+/**
+ * @brief Create a GUI context with the default configuration and its entity resources.
+ *
+ * @param [in] win_title A pointer to char which specifies the window title string buffer
+ * @param [in] win_width Window width.
+ * @param [in] win_height Window height.
+ * @param [in] grid_scale Grid surface scale, see \ref GUI_DEFAULT_GRID_SCALE. [meters]
+ *
+ * @return A newly created GUI context on success, NULL on failure.
+ *
+ */
+static gui_context_s *create_context( const char *win_title, const unsigned int win_width, const unsigned int win_height, const double grid_scale );
+
+
+/**
+ * @brief Free a GUI context created by \ref create_context before any GL resources were made.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the context.
+ *
+ */
+static void free_context( gui_context_s * const gui );
+
+
+/**
+ * @brief Set the GL state shared by all frames in the current GL context.
+ *
+ */
+static void init_gl_state( void );
+
+
 
 
 // *****************************************************
@@ -335,6 +374,36 @@ static void on_key( unsigned char key, const int x, int y )
         // toggle visibility
         global_gui_context->config.points_visible = !global_gui_context->config.points_visible;
 
+        // redraw
+        glutPostRedisplay();
+    }
+    else if( key == GUI_KEY_POINTS_DOWNSAMPLE )
+    {
+        // change downsampling mode
+        global_gui_context->config.points_downsample += 1;
+
+        // roll over
+        if( global_gui_context->config.points_downsample == POINTS_DOWNSAMPLE_KIND_COUNT )
+        {
+            global_gui_context->config.points_downsample = 0;
+        }
+
+        // redraw
+        glutPostRedisplay();
+    }
+    else if( key == GUI_KEY_POINTS_TRAILS )
+    {
+        // toggle visibility
+        global_gui_context->config.points_trails_visible = !global_gui_context->config.points_trails_visible;
+
+        // redraw
+        glutPostRedisplay();
+    }
+    else if( key == GUI_KEY_STATS_VISIBLE )
+    {
+        // toggle visibility
+        global_gui_context->config.stats_visible = !global_gui_context->config.stats_visible;
+
         // redraw
         glutPostRedisplay();
     }
@@ -719,12 +788,22 @@ static void on_resize( int w, int h )
 
 //
 static void on_draw( void )
+{
+    // draw
+    draw_frame();
+
+    // swap buffers
+    glutSwapBuffers();
+}
+
+
+//
+static void draw_frame( void )
 {
     // ignore if no reference
     if( global_gui_context == NULL )
     {
         // nothing to do
-        glutSwapBuffers();
         return;
     }
 
@@ -773,7 +852,6 @@ static void on_draw( void )
     else
     {
         // nothing to do
-        glutSwapBuffers();
         return;
     }
 
@@ -848,8 +926,15 @@ static void on_draw( void )
     // draw origin model
     origin_model_draw( global_gui_context, &global_gui_context->platform );
 
-    // draw entities
-    entity_draw_all( global_gui_context, global_gui_context->entity_list );
+    // draw entities, from the latest snapshot in pipeline mode
+    if( global_gui_context->snapshot != NULL )
+    {
+        entity_draw_snapshot( global_gui_context, global_gui_context->snapshot, global_gui_context->snapshot_points, &global_gui_context->cull_stats );
+    }
+    else
+    {
+        entity_draw_all( global_gui_context, global_gui_context->entity_store, &global_gui_context->cull_stats );
+    }
 
     // draw ruler
     if( global_gui_context->config.ruler != 0 )
@@ -948,6 +1033,30 @@ static void on_draw( void )
                 global_gui_context->config.points_visible ? "ON" : "OFF" );
         render_text_2d( 5.0, text_y, string, NULL );
         text_y -= text_delta;
+        if( global_gui_context->config.points_downsample == POINTS_DOWNSAMPLE_MAX_INTENSITY )
+        {
+            snprintf( string, sizeof(string), "'%c' - %s - %s (%.2f m)", GUI_KEY_POINTS_DOWNSAMPLE, "points downsampling", "MAX_INTENSITY",
+                    global_gui_context->config.points_cell_size );
+        }
+        else if( global_gui_context->config.points_downsample == POINTS_DOWNSAMPLE_CENTROID )
+        {
+            snprintf( string, sizeof(string), "'%c' - %s - %s (%.2f m)", GUI_KEY_POINTS_DOWNSAMPLE, "points downsampling", "CENTROID",
+                    global_gui_context->config.points_cell_size );
+        }
+        else
+        {
+            snprintf( string, sizeof(string), "'%c' - %s - %s", GUI_KEY_POINTS_DOWNSAMPLE, "points downsampling", "OFF" );
+        }
+        render_text_2d( 5.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "'%c' - %s - %s", GUI_KEY_POINTS_TRAILS, "points trails",
+                global_gui_context->config.points_trails_visible ? "ON" : "OFF" );
+        render_text_2d( 5.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "'%c' - %s - %s", GUI_KEY_STATS_VISIBLE, "statistics visible",
+                global_gui_context->config.stats_visible ? "ON" : "OFF" );
+        render_text_2d( 5.0, text_y, string, NULL );
+        text_y -= text_delta;
         text_y -= text_delta;
 
         // mouse logic
@@ -970,6 +1079,37 @@ static void on_draw( void )
         text_y -= text_delta;
     }
 
+    // draw statistics text
+    if( global_gui_context->config.stats_visible != 0 )
+    {
+        text_y = height - text_delta;
+
+        snprintf( string, sizeof(string), "fps: %.1f", global_gui_context->rendered_fps );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "queue depth: %lu", global_gui_context->ingest_stats.queue_depth );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "last batch: %lu", global_gui_context->ingest_stats.last_batch );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "parsed: %llu", global_gui_context->ingest_stats.parsed );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "dropped: %llu", global_gui_context->ingest_stats.dropped );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "overflowed: %llu", global_gui_context->ingest_stats.overflowed );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "objects drawn: %lu", global_gui_context->cull_stats.objects_drawn );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+        snprintf( string, sizeof(string), "objects culled: %lu", global_gui_context->cull_stats.objects_culled );
+        render_text_2d( width - 220.0, text_y, string, NULL );
+        text_y -= text_delta;
+    }
+
     // draw ruler text
     if( global_gui_context->config.ruler != 0 )
     {
@@ -981,20 +1121,11 @@ static void on_draw( void )
         render_text_2d( 5.0, 30.0, global_gui_context->ruler.p2_string, NULL );
         render_text_2d( 5.0, 50.0, global_gui_context->ruler.distance_string, NULL );
     }
-
-    // swap buffers
-    glutSwapBuffers();
 }
 
 
-
-
-// *****************************************************
-// public definitions
-// *****************************************************
-
 //
-gui_context_s *gui_init( const char *win_title, const unsigned int win_width, const unsigned int win_height, const double grid_scale )
+static gui_context_s *create_context( const char *win_title, const unsigned int win_width, const unsigned int win_height, const double grid_scale )
 {
     if( (win_title == NULL) || (win_width < 1) || (win_height < 1) || (grid_scale < 1.0) )
     {
@@ -1013,6 +1144,7 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
 
     // zero
     memset( gui, 0, sizeof(*gui) );
+    gui->win_id = GUI_WINDOW_ID_INVALID;
 
     // default configurations
     gui->config.wireframe_width = GUI_DEFAULT_WIRE_LINE_WIDTH;
@@ -1023,7 +1155,37 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     gui->config.rectangle_visible = 1;
     gui->config.ellipse_visible = 1;
     gui->config.points_visible = 1;
+    gui->config.points_downsample = POINTS_DOWNSAMPLE_OFF;
+    gui->config.points_cell_size = GUI_DEFAULT_POINTS_CELL_PIXELS / gui->config.zoom_scale;
     gui->config.help_visible = 1;
+    gui->config.stats_visible = 1;
+
+    // create entity store
+    if( (gui->entity_store = entity_store_new()) == NULL )
+    {
+        free( gui );
+        return NULL;
+    }
+
+    // create primitive batch
+    if( (gui->render_batch = render_batch_new()) == NULL )
+    {
+        entity_release_all( gui->entity_store );
+        free( gui );
+        return NULL;
+    }
+
+    // create point trails
+    if( (gui->point_trails = point_trails_new( POINT_TRAILS_DEFAULT_DURATION, POINT_TRAILS_DEFAULT_BUDGET )) == NULL )
+    {
+        render_batch_free( gui->render_batch );
+        entity_release_all( gui->entity_store );
+        free( gui );
+        return NULL;
+    }
+
+    // vertex buffers are created when a snapshot is drawn
+    gui->snapshot_points = entity_snapshot_points_new();
 
     // platform color
     gui->platform.color_rgba[ 1 ] = 1.0;
@@ -1067,6 +1229,71 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     // FPS max
     gui->max_fps = GUI_DEFAULT_MAX_FPS;
 
+    // draw the first frame
+    gui->scene_dirty = 1;
+
+    // return new memory
+    return gui;
+}
+
+
+//
+static void free_context( gui_context_s * const gui )
+{
+    if( gui->snapshot_points != NULL )
+    {
+        g_hash_table_destroy( gui->snapshot_points );
+    }
+
+    point_trails_free( gui->point_trails );
+    render_batch_free( gui->render_batch );
+    entity_release_all( gui->entity_store );
+    free( gui );
+}
+
+
+//
+static void init_gl_state( void )
+{
+    // set config flags
+    glDisable( GL_DEPTH );
+    glDisable( GL_LIGHTING );
+    glShadeModel( GL_SMOOTH );
+    glDisable( GL_DEPTH_TEST );
+
+    // smoothness
+    glEnable( GL_LINE_SMOOTH );
+    glEnable( GL_POLYGON_SMOOTH );
+    glHint( GL_LINE_SMOOTH_HINT, GL_NICEST );
+
+    // alpha blending config
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+    // clear the color buffer, background, to black, RGBA
+    glClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+gui_context_s *gui_init( const char *win_title, const unsigned int win_width, const unsigned int win_height, const double grid_scale )
+{
+    // local vars
+    gui_context_s *gui = NULL;
+
+
+    // create
+    if( (gui = create_context( win_title, win_width, win_height, grid_scale )) == NULL )
+    {
+        return NULL;
+    }
+
     // init GL
     glutInit( &gui->gl_argc, gui->gl_argv );
 
@@ -1079,7 +1306,7 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     // create display window
     if( (gui->win_id = glutCreateWindow( gui->win_title )) < 0 )
     {
-        free( gui );
+        free_context( gui );
         return NULL;
     }
 
@@ -1093,26 +1320,11 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
     glutDisplayFunc( on_draw );
 
     // set config flags
-    glDisable( GL_DEPTH );
-    glDisable( GL_LIGHTING );
-    glShadeModel( GL_SMOOTH );
-    glDisable( GL_DEPTH_TEST );
-
-    // smoothness
-    glEnable( GL_LINE_SMOOTH );
-    glEnable( GL_POLYGON_SMOOTH );
-    glHint( GL_LINE_SMOOTH_HINT, GL_NICEST );
-
-    // alpha blending config
-    glEnable( GL_BLEND );
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    init_gl_state();
 
     // main loop returns on window exit
     glutSetOption( GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS );
 
-    // clear the color buffer, background, to black, RGBA
-    glClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
-
     // set global reference
     global_gui_context = gui;
 
@@ -1127,6 +1339,56 @@ gui_context_s *gui_init( const char *win_title, const unsigned int win_width, co
 }
 
 
+//
+gui_context_s *gui_init_headless( const unsigned int win_width, const unsigned int win_height, const double grid_scale )
+{
+    // local vars
+    gui_context_s *gui = NULL;
+
+
+    // create
+    if( (gui = create_context( "headless", win_width, win_height, grid_scale )) == NULL )
+    {
+        return NULL;
+    }
+
+    // screen text is drawn with GLUT, which isn't initialized
+    gui->config.help_visible = 0;
+    gui->config.stats_visible = 0;
+
+    // set config flags
+    init_gl_state();
+
+    // set global reference
+    global_gui_context = gui;
+
+    // return new memory
+    return gui;
+}
+
+
+//
+void gui_render_frame( gui_context_s * const gui, const ps_timestamp update_time )
+{
+    if( gui == NULL )
+    {
+        return;
+    }
+
+
+    // update global reference
+    global_gui_context = gui;
+
+    // update timestamp
+    gui->last_render_time = update_time;
+
+    // point downsampling cell size follows the zoom level
+    gui->config.points_cell_size = GUI_DEFAULT_POINTS_CELL_PIXELS / gui->config.zoom_scale;
+
+    draw_frame();
+}
+
+
 //
 void gui_release( gui_context_s * const gui )
 {
@@ -1139,8 +1401,27 @@ void gui_release( gui_context_s * const gui )
     // update global reference
     global_gui_context = gui;
 
-    // signal GL exit
-    glutExit();
+    // release primitive batch
+    render_batch_free( gui->render_batch );
+    gui->render_batch = NULL;
+
+    // release snapshot vertex buffers
+    if( gui->snapshot_points != NULL )
+    {
+        g_hash_table_destroy( gui->snapshot_points );
+        gui->snapshot_points = NULL;
+    }
+    gui->snapshot = NULL;
+
+    // release point trails
+    point_trails_free( gui->point_trails );
+    gui->point_trails = NULL;
+
+    // signal GL exit, headless contexts never initialized GLUT
+    if( gui->win_id != GUI_WINDOW_ID_INVALID )
+    {
+        glutExit();
+    }
 
     // de-ref
     global_gui_context = NULL;
@@ -1157,6 +1438,7 @@ void gui_update( gui_context_s * const gui, const ps_timestamp update_time, ps_t
 
     // local vars
     ps_timestamp render_wait = 0;
+    Display *display = NULL;
 
 
     // update global reference
@@ -1165,10 +1447,19 @@ void gui_update( gui_context_s * const gui, const ps_timestamp update_time, ps_t
     // get wait interval
     render_wait = (ps_timestamp) SEC_2_MICRO( (1.0 / (double) gui->max_fps) );
 
-    // check if force-redraw set
-    if( (*time_to_redraw) == GUI_FORCE_REDRAW )
+    // trails fade with time, keep redrawing while any are shown
+    if( (gui->config.points_trails_visible != 0)
+            && (gui->point_trails != NULL)
+            && (g_hash_table_size( gui->point_trails->trails ) != 0) )
     {
-        // force redraw
+        gui->scene_dirty = 1;
+    }
+
+    // check if force-redraw set, or the scene changed and the frame rate interval is met
+    if( ((*time_to_redraw) == GUI_FORCE_REDRAW)
+            || ((gui->scene_dirty != 0) && ((update_time - gui->last_render_time) > render_wait)) )
+    {
+        // do redraw
 
         // set time to next render
         (*time_to_redraw) = render_wait;
@@ -1179,40 +1470,56 @@ void gui_update( gui_context_s * const gui, const ps_timestamp update_time, ps_t
         // update timestamp
         gui->last_render_time = update_time;
 
+        // drawn
+        gui->scene_dirty = 0;
+
         // signal redraw
         glutPostRedisplay();
+    }
+    else if( gui->scene_dirty != 0 )
+    {
+        // interval not met
 
-        // process glut events
-        glutMainLoopEvent();
+        // update time to render
+        (*time_to_redraw) = render_wait - (update_time - gui->last_render_time);
     }
     else
     {
-        // check frame rate
-        if( (update_time - gui->last_render_time) > render_wait )
-        {
-            // interval met, do redraw
+        // nothing to redraw, input redraws on its own
+        (*time_to_redraw) = GUI_IDLE_WAIT;
+    }
 
-            // set time to next render
-            (*time_to_redraw) = render_wait;
+    // process glut events, input and the redraw if signaled
+    glutMainLoopEvent();
 
-            // update rendered fps
-            gui->rendered_fps = 1.0 / MICRO_2_SEC( (double) (update_time - gui->last_render_time) );
+    // events already read off the connection won't wake a poll on it
+    if( ((display = glXGetCurrentDisplay()) != NULL) && (XEventsQueued( display, QueuedAlready ) > 0) )
+    {
+        (*time_to_redraw) = 0;
+    }
 
-            // update timestamp
-            gui->last_render_time = update_time;
+    // point downsampling cell size follows the zoom level
+    gui->config.points_cell_size = GUI_DEFAULT_POINTS_CELL_PIXELS / gui->config.zoom_scale;
+}
 
-            // signal redraw
-            glutPostRedisplay();
 
-            // process glut events
-            glutMainLoopEvent();
-        }
-        else
-        {
-            // interval not met
+//
+int gui_get_event_fd( const gui_context_s * const gui )
+{
+    if( (gui == NULL) || (gui->win_id == GUI_WINDOW_ID_INVALID) )
+    {
+        return -1;
+    }
 
-            // update time to render
-            (*time_to_redraw) = render_wait - (update_time - gui->last_render_time);
-        }
+    // local vars
+    Display * const display = glXGetCurrentDisplay();
+
+
+    if( display == NULL )
+    {
+        return -1;
     }
+
+
+    return ConnectionNumber( display );
 }
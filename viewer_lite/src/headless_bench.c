@@ -0,0 +1,658 @@
+/**
+ * @file headless_bench.c
+ * @brief Headless Benchmark Interface Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/resource.h>
+#include <glib-2.0/glib.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "polysync_core.h"
+#include "gl_headers.h"
+#include "common.h"
+#include "drawable_type.h"
+#include "ps_interface.h"
+#include "gui.h"
+#include "entity_manager.h"
+#include "headless_bench.h"
+
+
+
+
+// *****************************************************
+// static global structures
+// *****************************************************
+
+/**
+ * @brief Offscreen rendering context.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    EGLDisplay              display; /*!< EGL display. */
+    //
+    //
+    EGLContext              context; /*!< EGL desktop GL context, current without a surface. */
+    //
+    //
+    GLuint                  framebuffer; /*!< Framebuffer object drawn into. */
+    //
+    //
+    GLuint                  color_buffer; /*!< Color renderbuffer of the framebuffer. */
+} offscreen_context_s;
+
+
+/**
+ * @brief Synthetic messages of a scene.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    ps_lidar_points_msg     lidar_points; /*!< LiDAR scan. */
+    //
+    //
+    ps_radar_targets_msg    radar_targets; /*!< Radar tracks. */
+    //
+    //
+    ps_objects_msg          objects; /*!< Objects. */
+} scene_messages_s;
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+/**
+ * @brief Built-in scenes, smallest first so the peak RSS of each scene is its own.
+ *
+ */
+static const headless_bench_scene_s SCENES[] =
+{
+    { "small", 10000, 32, 16 },
+    { "medium", 100000, 128, 64 },
+    { "large", 400000, 512, 256 },
+};
+
+
+/**
+ * @brief Synthetic source GUID.
+ *
+ */
+static const ps_guid BENCH_SRC_GUID = 0x100;
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Create an offscreen context and make it current.
+ *
+ * Uses the Mesa surfaceless EGL platform when available, so no display or GPU is needed.
+ *
+ * @param [out] offscreen A pointer to \ref offscreen_context_s which receives the context.
+ * @param [in] width Framebuffer width. [pixels]
+ * @param [in] height Framebuffer height. [pixels]
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+static int offscreen_create( offscreen_context_s * const offscreen, const unsigned int width, const unsigned int height );
+
+
+/**
+ * @brief Release an offscreen context.
+ *
+ * @param [in] offscreen A pointer to \ref offscreen_context_s which specifies the context.
+ *
+ */
+static void offscreen_release( offscreen_context_s * const offscreen );
+
+
+/**
+ * @brief Allocate the synthetic messages of a scene.
+ *
+ * @param [in] scene A pointer to \ref headless_bench_scene_s which specifies the scene.
+ * @param [out] messages A pointer to \ref scene_messages_s which receives the messages.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+static int scene_messages_init( const headless_bench_scene_s * const scene, scene_messages_s * const messages );
+
+
+/**
+ * @brief Free the synthetic messages of a scene.
+ *
+ * @param [in] messages A pointer to \ref scene_messages_s which specifies the messages.
+ *
+ */
+static void scene_messages_release( scene_messages_s * const messages );
+
+
+/**
+ * @brief Move the synthetic messages to a frame.
+ *
+ * @param [in] messages A pointer to \ref scene_messages_s which specifies the messages.
+ * @param [in] frame Frame index.
+ *
+ */
+static void scene_messages_update( scene_messages_s * const messages, const unsigned int frame );
+
+
+/**
+ * @brief Run a scene.
+ *
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the ingest resources.
+ * @param [in] scene A pointer to \ref headless_bench_scene_s which specifies the scene.
+ * @param [in] num_frames Number of measured frames.
+ * @param [out] result A pointer to \ref headless_bench_result_s which receives the result.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+static int run_scene( node_data_s * const node_data, const headless_bench_scene_s * const scene, const unsigned int num_frames, headless_bench_result_s * const result );
+
+
+/**
+ * @brief Compare two timestamps for qsort.
+ *
+ * @param [in] a A pointer to \ref ps_timestamp.
+ * @param [in] b A pointer to \ref ps_timestamp.
+ *
+ * @return Negative, zero or positive if a is less, equal or greater than b.
+ *
+ */
+static int compare_timestamps( const void *a, const void *b );
+
+
+/**
+ * @brief Get a percentile of sorted samples.
+ *
+ * @param [in] samples A pointer to \ref ps_timestamp which specifies the sorted samples.
+ * @param [in] num_samples Number of samples.
+ * @param [in] percentile Percentile. [0.0, 1.0]
+ *
+ * @return Sample value.
+ *
+ */
+static ps_timestamp get_percentile( const ps_timestamp * const samples, const unsigned int num_samples, const double percentile );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static int offscreen_create( offscreen_context_s * const offscreen, const unsigned int width, const unsigned int height )
+{
+    // local vars
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = NULL;
+    EGLConfig config = NULL;
+    EGLint num_configs = 0;
+    EGLint major = 0;
+    EGLint minor = 0;
+    const EGLint config_attributes[] =
+    {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+
+    memset( offscreen, 0, sizeof(*offscreen) );
+    offscreen->display = EGL_NO_DISPLAY;
+    offscreen->context = EGL_NO_CONTEXT;
+
+    // prefer the surfaceless platform, works without X or a GPU
+    get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+    if( get_platform_display != NULL )
+    {
+        offscreen->display = get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+    }
+
+    if( offscreen->display == EGL_NO_DISPLAY )
+    {
+        offscreen->display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+    }
+
+    if( (offscreen->display == EGL_NO_DISPLAY) || (eglInitialize( offscreen->display, &major, &minor ) != EGL_TRUE) )
+    {
+        printf( "headless bench -- failed to initialize EGL\n" );
+        return 1;
+    }
+
+    // desktop GL, the viewer draws with the fixed-function pipeline
+    if( (eglBindAPI( EGL_OPENGL_API ) != EGL_TRUE)
+            || (eglChooseConfig( offscreen->display, config_attributes, &config, 1, &num_configs ) != EGL_TRUE)
+            || (num_configs < 1) )
+    {
+        printf( "headless bench -- no EGL desktop GL config\n" );
+        offscreen_release( offscreen );
+        return 1;
+    }
+
+    if( (offscreen->context = eglCreateContext( offscreen->display, config, EGL_NO_CONTEXT, NULL )) == EGL_NO_CONTEXT )
+    {
+        printf( "headless bench -- failed to create EGL context\n" );
+        offscreen_release( offscreen );
+        return 1;
+    }
+
+    // no surface, draw into a framebuffer object
+    if( eglMakeCurrent( offscreen->display, EGL_NO_SURFACE, EGL_NO_SURFACE, offscreen->context ) != EGL_TRUE )
+    {
+        printf( "headless bench -- failed to make EGL context current\n" );
+        offscreen_release( offscreen );
+        return 1;
+    }
+
+    glGenRenderbuffers( 1, &offscreen->color_buffer );
+    glBindRenderbuffer( GL_RENDERBUFFER, offscreen->color_buffer );
+    glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, (GLsizei) width, (GLsizei) height );
+
+    glGenFramebuffers( 1, &offscreen->framebuffer );
+    glBindFramebuffer( GL_FRAMEBUFFER, offscreen->framebuffer );
+    glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen->color_buffer );
+
+    if( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+    {
+        printf( "headless bench -- incomplete framebuffer\n" );
+        offscreen_release( offscreen );
+        return 1;
+    }
+
+    glViewport( 0, 0, (GLsizei) width, (GLsizei) height );
+
+    printf( "headless bench -- EGL %d.%d, %s, %s\n",
+            (int) major,
+            (int) minor,
+            (const char*) glGetString( GL_RENDERER ),
+            (const char*) glGetString( GL_VERSION ) );
+
+
+    return 0;
+}
+
+
+//
+static void offscreen_release( offscreen_context_s * const offscreen )
+{
+    if( offscreen->context != EGL_NO_CONTEXT )
+    {
+        if( offscreen->framebuffer != 0 )
+        {
+            glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+            glDeleteFramebuffers( 1, &offscreen->framebuffer );
+            offscreen->framebuffer = 0;
+        }
+
+        if( offscreen->color_buffer != 0 )
+        {
+            glDeleteRenderbuffers( 1, &offscreen->color_buffer );
+            offscreen->color_buffer = 0;
+        }
+
+        (void) eglMakeCurrent( offscreen->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+        (void) eglDestroyContext( offscreen->display, offscreen->context );
+        offscreen->context = EGL_NO_CONTEXT;
+    }
+
+    if( offscreen->display != EGL_NO_DISPLAY )
+    {
+        (void) eglTerminate( offscreen->display );
+        offscreen->display = EGL_NO_DISPLAY;
+    }
+}
+
+
+//
+static int scene_messages_init( const headless_bench_scene_s * const scene, scene_messages_s * const messages )
+{
+    // local vars
+    unsigned long idx = 0;
+
+
+    memset( messages, 0, sizeof(*messages) );
+
+    messages->lidar_points.header.src_guid = BENCH_SRC_GUID;
+    messages->lidar_points.sensor_descriptor.id = 1;
+    messages->lidar_points.points._length = scene->num_points;
+    messages->lidar_points.points._maximum = scene->num_points;
+    messages->lidar_points.points._buffer = g_try_new0( ps_lidar_point, scene->num_points );
+
+    messages->radar_targets.header.src_guid = BENCH_SRC_GUID;
+    messages->radar_targets.sensor_descriptor.id = 2;
+    messages->radar_targets.targets._length = scene->num_targets;
+    messages->radar_targets.targets._maximum = scene->num_targets;
+    messages->radar_targets.targets._buffer = g_try_new0( ps_radar_target, scene->num_targets );
+
+    messages->objects.header.src_guid = BENCH_SRC_GUID;
+    messages->objects.sensor_descriptor.id = 3;
+    messages->objects.objects._length = scene->num_objects;
+    messages->objects.objects._maximum = scene->num_objects;
+    messages->objects.objects._buffer = g_try_new0( ps_object, scene->num_objects );
+
+    if( (messages->lidar_points.points._buffer == NULL)
+            || (messages->radar_targets.targets._buffer == NULL)
+            || (messages->objects.objects._buffer == NULL) )
+    {
+        scene_messages_release( messages );
+        return 1;
+    }
+
+    // fields that don't move
+    for( idx = 0; idx < scene->num_targets; idx++ )
+    {
+        messages->radar_targets.targets._buffer[ idx ].id = (ps_identifier) (idx + 1);
+        messages->radar_targets.targets._buffer[ idx ].track_status = TRACK_STATUS_ACTIVE;
+        messages->radar_targets.targets._buffer[ idx ].amplitude = PSYNC_AMPLITUDE_NOT_AVAILABLE;
+        messages->radar_targets.targets._buffer[ idx ].cross_section = 1.0 + (double) (idx % 16);
+        messages->radar_targets.targets._buffer[ idx ].size[ 0 ] = PSYNC_SIZE_NOT_AVAILABLE;
+        messages->radar_targets.targets._buffer[ idx ].size[ 1 ] = PSYNC_SIZE_NOT_AVAILABLE;
+        messages->radar_targets.targets._buffer[ idx ].size[ 2 ] = PSYNC_SIZE_NOT_AVAILABLE;
+    }
+
+    for( idx = 0; idx < scene->num_objects; idx++ )
+    {
+        messages->objects.objects._buffer[ idx ].id = (ps_identifier) (idx + 1);
+        messages->objects.objects._buffer[ idx ].size[ 0 ] = 4.5;
+        messages->objects.objects._buffer[ idx ].size[ 1 ] = 1.8;
+        messages->objects.objects._buffer[ idx ].size[ 2 ] = 1.5;
+    }
+
+
+    return 0;
+}
+
+
+//
+static void scene_messages_release( scene_messages_s * const messages )
+{
+    g_free( messages->lidar_points.points._buffer );
+    g_free( messages->radar_targets.targets._buffer );
+    g_free( messages->objects.objects._buffer );
+
+    memset( messages, 0, sizeof(*messages) );
+}
+
+
+//
+static void scene_messages_update( scene_messages_s * const messages, const unsigned int frame )
+{
+    // local vars
+    unsigned long idx = 0;
+    double angle = 0.0;
+    double range = 0.0;
+    const double spin = 0.01 * (double) frame;
+    ps_lidar_point *point = NULL;
+    ps_radar_target *target = NULL;
+    ps_object *object = NULL;
+
+
+    // LiDAR, concentric rings sweeping around the origin
+    for( idx = 0; idx < messages->lidar_points.points._length; idx++ )
+    {
+        point = &messages->lidar_points.points._buffer[ idx ];
+
+        angle = spin + ((2.0 * M_PI * (double) idx) / (double) messages->lidar_points.points._length);
+        range = 5.0 + (45.0 * (double) (idx % 64) / 64.0);
+
+        point->position[ 0 ] = (float) (range * cos( angle ));
+        point->position[ 1 ] = (float) (range * sin( angle ));
+        point->position[ 2 ] = (float) (0.05 * (double) (idx % 64));
+        point->intensity = (float) (idx % 256);
+    }
+
+    // radar, tracks ahead of the origin drifting toward it
+    for( idx = 0; idx < messages->radar_targets.targets._length; idx++ )
+    {
+        target = &messages->radar_targets.targets._buffer[ idx ];
+
+        target->position[ 0 ] = 10.0 + fmod( (double) (idx * 7) + (0.2 * (double) frame), 150.0 );
+        target->position[ 1 ] = -40.0 + fmod( (double) (idx * 13), 80.0 );
+        target->velocity[ 0 ] = -2.0;
+        target->velocity[ 1 ] = 0.0;
+    }
+
+    // objects, vehicles circling the origin
+    for( idx = 0; idx < messages->objects.objects._length; idx++ )
+    {
+        object = &messages->objects.objects._buffer[ idx ];
+
+        angle = spin + ((2.0 * M_PI * (double) idx) / (double) messages->objects.objects._length);
+        range = 15.0 + (double) (idx % 8) * 5.0;
+
+        object->position[ 0 ] = range * cos( angle );
+        object->position[ 1 ] = range * sin( angle );
+        object->position[ 2 ] = 0.0;
+        object->velocity[ 0 ] = -sin( angle );
+        object->velocity[ 1 ] = cos( angle );
+        object->course_angle = angle + (M_PI / 2.0);
+    }
+}
+
+
+//
+static int run_scene( node_data_s * const node_data, const headless_bench_scene_s * const scene, const unsigned int num_frames, headless_bench_result_s * const result )
+{
+    // local vars
+    gui_context_s *gui = NULL;
+    scene_messages_s messages;
+    ps_timestamp *frame_times = NULL;
+    ps_timestamp *draw_times = NULL;
+    ps_timestamp ingest_time = 0;
+    ps_timestamp start = 0;
+    ps_timestamp ingested = 0;
+    ps_timestamp drawn = 0;
+    unsigned int frame = 0;
+    unsigned int measured = 0;
+    unsigned int msg_read = 0;
+    struct rusage usage;
+
+
+    memset( result, 0, sizeof(*result) );
+
+    if( scene_messages_init( scene, &messages ) != 0 )
+    {
+        return 1;
+    }
+
+    frame_times = g_try_new0( ps_timestamp, num_frames );
+    draw_times = g_try_new0( ps_timestamp, num_frames );
+
+    if( (frame_times == NULL) || (draw_times == NULL)
+            || ((gui = gui_init_headless( GUI_DEFAULT_WIDTH, GUI_DEFAULT_HEIGHT, GUI_DEFAULT_GRID_SCALE )) == NULL) )
+    {
+        g_free( frame_times );
+        g_free( draw_times );
+        scene_messages_release( &messages );
+        return 1;
+    }
+
+    for( frame = 0; frame < (HEADLESS_BENCH_WARMUP_FRAMES + num_frames); frame++ )
+    {
+        // new data, generating it is not measured
+        scene_messages_update( &messages, frame );
+
+        // ingest, from handler entry so copying the data out of the messages is included
+        start = get_micro_tick();
+        ps_push_message( node_data, PS_OFFLINE_MSG_TYPE_LIDAR_POINTS, &messages.lidar_points );
+        ps_push_message( node_data, PS_OFFLINE_MSG_TYPE_RADAR_TARGETS, &messages.radar_targets );
+        ps_push_message( node_data, PS_OFFLINE_MSG_TYPE_OBJECTS, &messages.objects );
+        ps_process_message( node_data, gui, gui->entity_store, start, &msg_read );
+        (void) entity_update_timeouts( gui->entity_store, start );
+        ingested = get_micro_tick();
+
+        // draw, finish so the GL work is inside the frame
+        gui_render_frame( gui, ingested );
+        glFinish();
+        drawn = get_micro_tick();
+
+        if( frame >= HEADLESS_BENCH_WARMUP_FRAMES )
+        {
+            frame_times[ measured ] = drawn - start;
+            draw_times[ measured ] = drawn - ingested;
+            ingest_time += ingested - start;
+            measured += 1;
+        }
+    }
+
+    qsort( frame_times, measured, sizeof(*frame_times), compare_timestamps );
+    qsort( draw_times, measured, sizeof(*draw_times), compare_timestamps );
+
+    result->frame_p50 = get_percentile( frame_times, measured, 0.50 );
+    result->frame_p99 = get_percentile( frame_times, measured, 0.99 );
+    result->draw_p50 = get_percentile( draw_times, measured, 0.50 );
+
+    if( ingest_time > 0 )
+    {
+        result->messages_per_sec = (3.0 * (double) measured) / MICRO_2_SEC( (double) ingest_time );
+        result->points_per_sec = ((double) scene->num_points * (double) measured) / MICRO_2_SEC( (double) ingest_time );
+    }
+
+    memset( &usage, 0, sizeof(usage) );
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+    {
+        result->peak_rss = usage.ru_maxrss;
+    }
+
+    entity_release_all( gui->entity_store );
+    gui_release( gui );
+    free( gui );
+
+    g_free( frame_times );
+    g_free( draw_times );
+    scene_messages_release( &messages );
+
+
+    return 0;
+}
+
+
+//
+static int compare_timestamps( const void *a, const void *b )
+{
+    // local vars
+    const ps_timestamp ta = *((const ps_timestamp*) a);
+    const ps_timestamp tb = *((const ps_timestamp*) b);
+
+
+    return (ta > tb) - (ta < tb);
+}
+
+
+//
+static ps_timestamp get_percentile( const ps_timestamp * const samples, const unsigned int num_samples, const double percentile )
+{
+    // local vars
+    unsigned int index = 0;
+
+
+    if( num_samples == 0 )
+    {
+        return 0;
+    }
+
+    // nearest rank
+    index = (unsigned int) ceil( percentile * (double) num_samples );
+    if( index > 0 )
+    {
+        index -= 1;
+    }
+    if( index >= num_samples )
+    {
+        index = num_samples - 1;
+    }
+
+
+    return samples[ index ];
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+int headless_bench_run( const unsigned int num_frames )
+{
+    if( num_frames == 0 )
+    {
+        return 1;
+    }
+
+    // local vars
+    offscreen_context_s offscreen;
+    node_data_s *node_data = NULL;
+    headless_bench_result_s result;
+    unsigned int idx = 0;
+    int ret = 0;
+
+
+    if( offscreen_create( &offscreen, GUI_DEFAULT_WIDTH, GUI_DEFAULT_HEIGHT ) != 0 )
+    {
+        return 1;
+    }
+
+    if( (node_data = init_polysync_offline()) == NULL )
+    {
+        offscreen_release( &offscreen );
+        return 1;
+    }
+
+    printf( "headless bench -- %u frames per scene, %ux%u\n", num_frames, GUI_DEFAULT_WIDTH, GUI_DEFAULT_HEIGHT );
+
+    // for each scene
+    for( idx = 0; (idx < (sizeof(SCENES) / sizeof(SCENES[ 0 ]))) && (ret == 0); idx++ )
+    {
+        if( run_scene( node_data, &SCENES[ idx ], num_frames, &result ) != 0 )
+        {
+            printf( "headless bench -- scene '%s' failed\n", SCENES[ idx ].name );
+            ret = 1;
+        }
+        else
+        {
+            printf( "scene %-8s points %7lu targets %5lu objects %5lu -- frame p50 %7.2f ms, p99 %7.2f ms, draw p50 %7.2f ms, ingest %9.0f msg/s %7.2f Mpts/s, peak RSS %ld KiB\n",
+                    SCENES[ idx ].name,
+                    SCENES[ idx ].num_points,
+                    SCENES[ idx ].num_targets,
+                    SCENES[ idx ].num_objects,
+                    (double) result.frame_p50 / 1000.0,
+                    (double) result.frame_p99 / 1000.0,
+                    (double) result.draw_p50 / 1000.0,
+                    result.messages_per_sec,
+                    result.points_per_sec / 1.0e6,
+                    result.peak_rss );
+        }
+    }
+
+    release_polysync( node_data );
+    free( node_data );
+
+    offscreen_release( &offscreen );
+
+
+    return ret;
+}
@@ -0,0 +1,358 @@
+/**
+ * @file ingest_pipeline.c
+ * @brief Ingest Pipeline Interface Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <glib-2.0/glib.h>
+
+#include "polysync_core.h"
+#include "common.h"
+#include "drawable_type.h"
+#include "ps_interface.h"
+#include "gui.h"
+#include "entity_manager.h"
+#include "ingest_pipeline.h"
+
+
+
+
+// *****************************************************
+// static global structures
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Publish the write slot as the ready slot.
+ *
+ * Ingest thread only. Takes the previous ready slot as the new write slot
+ * and signals \ref snapshot_triple_buffer_s.notify_fd.
+ *
+ * @param [in] buffer A pointer to \ref snapshot_triple_buffer_s which specifies the triple buffer.
+ *
+ */
+static void snapshot_publish( snapshot_triple_buffer_s * const buffer );
+
+
+/**
+ * @brief Ingest thread entry.
+ *
+ * Drains the drawable record ring into the pipeline's entity store, expires entities,
+ * and publishes a snapshot whenever the store changed. Sleeps on the ring until
+ * records are committed or the next entity expires.
+ *
+ * @param [in] user_data A pointer to \ref ingest_pipeline_s.
+ *
+ * @return NULL.
+ *
+ */
+static gpointer ingest_thread( gpointer user_data );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static void snapshot_publish( snapshot_triple_buffer_s * const buffer )
+{
+    // local vars
+    gint old_ready = 0;
+    const gint new_ready = (gint) buffer->write | INGEST_SNAPSHOT_DIRTY;
+    const uint64_t value = 1;
+
+
+    // swap the write slot in as ready, dirty
+    do
+    {
+        old_ready = g_atomic_int_get( &buffer->ready );
+    }
+    while( g_atomic_int_compare_and_exchange( &buffer->ready, old_ready, new_ready ) == FALSE );
+
+    // previous ready slot is free to build into, whether or not it was taken
+    buffer->write = (unsigned int) (old_ready & INGEST_SNAPSHOT_INDEX_MASK);
+
+    // wake the render thread
+    (void) write( buffer->notify_fd, &value, sizeof(value) );
+}
+
+
+//
+static gpointer ingest_thread( gpointer user_data )
+{
+    // local vars
+    ingest_pipeline_s * const pipeline = (ingest_pipeline_s*) user_data;
+    entity_snapshot_s *snapshot = NULL;
+    ps_timestamp timestamp = 0;
+    ps_timestamp deadline = 0;
+    ps_timestamp wait = 0;
+    unsigned int msg_read = 0;
+    unsigned int expired = 0;
+
+
+    while( g_atomic_int_get( &pipeline->quit ) == 0 )
+    {
+        // zero
+        msg_read = 0;
+        expired = 0;
+
+        // get timestamp
+        timestamp = get_micro_tick();
+
+        // mirror the GUI configuration
+        g_mutex_lock( &pipeline->config_lock );
+        pipeline->ingest_gui.config = pipeline->config;
+        g_mutex_unlock( &pipeline->config_lock );
+
+        // check and process drawable records
+        ps_process_message( pipeline->node_data, &pipeline->ingest_gui, pipeline->store, timestamp, &msg_read );
+
+        // check timeouts if not in freeze-frame
+        if( pipeline->ingest_gui.config.freeze_frame == 0 )
+        {
+            expired = entity_update_timeouts( pipeline->store, timestamp );
+        }
+
+        // publish if anything changed
+        if( (msg_read != 0) || (expired != 0) )
+        {
+            snapshot = &pipeline->snapshots.slots[ pipeline->snapshots.write ];
+
+            entity_snapshot_build( pipeline->store, snapshot );
+
+            pipeline->sequence += 1;
+            snapshot->sequence = pipeline->sequence;
+            snapshot->stats = pipeline->node_data->stats;
+
+            snapshot_publish( &pipeline->snapshots );
+        }
+        else
+        {
+            // idle, sleep until records are committed or the next entity expires
+            wait = INGEST_IDLE_WAIT;
+
+            if( (pipeline->ingest_gui.config.freeze_frame == 0)
+                    && ((deadline = entity_store_get_next_deadline( pipeline->store )) != 0) )
+            {
+                wait = MIN( wait, (deadline > timestamp) ? (deadline - timestamp) : 0 );
+            }
+
+            (void) drawable_ring_wait( pipeline->node_data->ring, wait );
+        }
+    }
+
+
+    return NULL;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+ingest_pipeline_s *ingest_pipeline_start( node_data_s * const node_data )
+{
+    if( node_data == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+    ingest_pipeline_s *pipeline = NULL;
+
+
+    // create
+    if( (pipeline = malloc( sizeof(*pipeline) )) == NULL )
+    {
+        return NULL;
+    }
+
+    // zero
+    memset( pipeline, 0, sizeof(*pipeline) );
+
+    pipeline->node_data = node_data;
+
+    g_mutex_init( &pipeline->config_lock );
+
+    // create entity store
+    if( (pipeline->store = entity_store_new()) == NULL )
+    {
+        free( pipeline );
+        return NULL;
+    }
+
+    // snapshot slots, write 0, ready 1 (not dirty), read 2
+    for( idx = 0; idx < INGEST_SNAPSHOT_SLOTS; idx++ )
+    {
+        entity_snapshot_init( &pipeline->snapshots.slots[ idx ] );
+    }
+    pipeline->snapshots.write = 0;
+    pipeline->snapshots.ready = 1;
+    pipeline->snapshots.read = 2;
+
+    // non-blocking so clearing never waits
+    pipeline->snapshots.notify_fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    // start ingest thread
+    if( (pipeline->snapshots.notify_fd < 0)
+            || ((pipeline->thread = g_thread_try_new( "ingest", ingest_thread, pipeline, NULL )) == NULL) )
+    {
+        if( pipeline->snapshots.notify_fd >= 0 )
+        {
+            (void) close( pipeline->snapshots.notify_fd );
+        }
+        for( idx = 0; idx < INGEST_SNAPSHOT_SLOTS; idx++ )
+        {
+            entity_snapshot_release( &pipeline->snapshots.slots[ idx ] );
+        }
+        entity_release_all( pipeline->store );
+        g_mutex_clear( &pipeline->config_lock );
+        free( pipeline );
+        return NULL;
+    }
+
+
+    return pipeline;
+}
+
+
+//
+void ingest_pipeline_stop( ingest_pipeline_s * const pipeline )
+{
+    if( pipeline == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+
+
+    // signal exit, wake and wait for the ingest thread
+    g_atomic_int_set( &pipeline->quit, 1 );
+    drawable_ring_notify( pipeline->node_data->ring );
+    g_thread_join( pipeline->thread );
+
+    (void) close( pipeline->snapshots.notify_fd );
+
+    for( idx = 0; idx < INGEST_SNAPSHOT_SLOTS; idx++ )
+    {
+        entity_snapshot_release( &pipeline->snapshots.slots[ idx ] );
+    }
+
+    entity_release_all( pipeline->store );
+
+    g_mutex_clear( &pipeline->config_lock );
+
+    free( pipeline );
+}
+
+
+//
+void ingest_pipeline_set_config( ingest_pipeline_s * const pipeline, const gui_configuration_s * const config )
+{
+    if( (pipeline == NULL) || (config == NULL) )
+    {
+        return;
+    }
+
+
+    g_mutex_lock( &pipeline->config_lock );
+    pipeline->config = (*config);
+    g_mutex_unlock( &pipeline->config_lock );
+}
+
+
+//
+const entity_snapshot_s *ingest_pipeline_acquire( ingest_pipeline_s * const pipeline, unsigned int * const updated )
+{
+    if( pipeline == NULL )
+    {
+        return NULL;
+    }
+
+    // local vars
+    snapshot_triple_buffer_s * const buffer = &pipeline->snapshots;
+    gint old_ready = 0;
+    uint64_t value = 0;
+
+
+    if( updated != NULL )
+    {
+        (*updated) = 0;
+    }
+
+    // clear before taking, a later publish signals again
+    (void) read( buffer->notify_fd, &value, sizeof(value) );
+
+    // take the ready slot if it holds a newer snapshot, hand back the read slot
+    do
+    {
+        old_ready = g_atomic_int_get( &buffer->ready );
+
+        if( (old_ready & INGEST_SNAPSHOT_DIRTY) == 0 )
+        {
+            break;
+        }
+    }
+    while( g_atomic_int_compare_and_exchange( &buffer->ready, old_ready, (gint) buffer->read ) == FALSE );
+
+    if( (old_ready & INGEST_SNAPSHOT_DIRTY) != 0 )
+    {
+        buffer->read = (unsigned int) (old_ready & INGEST_SNAPSHOT_INDEX_MASK);
+        buffer->read_valid = 1;
+
+        if( updated != NULL )
+        {
+            (*updated) = 1;
+        }
+    }
+
+    if( buffer->read_valid == 0 )
+    {
+        return NULL;
+    }
+
+
+    return &buffer->slots[ buffer->read ];
+}
+
+
+//
+int ingest_pipeline_get_notify_fd( const ingest_pipeline_s * const pipeline )
+{
+    if( pipeline == NULL )
+    {
+        return -1;
+    }
+
+
+    return pipeline->snapshots.notify_fd;
+}
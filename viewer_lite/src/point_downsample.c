@@ -0,0 +1,309 @@
+/**
+ * @file point_downsample.c
+ * @brief LiDAR Point Downsampling Interface Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib-2.0/glib.h>
+
+#include "polysync_core.h"
+#include "drawable_type.h"
+#include "point_downsample.h"
+
+
+
+
+// *****************************************************
+// static global structures
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Size the cell table for a number of points and mark every slot free.
+ *
+ * Keeps the load factor at or below one half.
+ *
+ * @param [in] downsample A pointer to \ref point_downsample_s which specifies the scratch data.
+ * @param [in] num_points Number of points that will be binned.
+ *
+ */
+static void reset_table( point_downsample_s * const downsample, const unsigned long num_points );
+
+
+/**
+ * @brief Get the table slot of a cell, claiming a free slot if the cell is new.
+ *
+ * @param [in] downsample A pointer to \ref point_downsample_s which specifies the scratch data.
+ * @param [in] key Packed cell coordinates.
+ *
+ * @return Slot index.
+ *
+ */
+static guint find_slot( point_downsample_s * const downsample, const guint64 key );
+
+
+/**
+ * @brief Get the cell coordinate of a position.
+ *
+ * Cells past the 32 bit range are clamped to its ends.
+ *
+ * @param [in] value Finite position. [meters]
+ * @param [in] inv_cell Inverse cell edge length. [1/meters]
+ *
+ * @return Signed cell coordinate.
+ *
+ */
+static gint32 cell_coordinate( const double value, const double inv_cell );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static void reset_table( point_downsample_s * const downsample, const unsigned long num_points )
+{
+    // local vars
+    guint bits = 4;
+
+
+    // at least twice as many slots as points
+    while( ((guint64) 1 << bits) < ((guint64) num_points * 2) )
+    {
+        bits += 1;
+    }
+
+    downsample->bits = bits;
+
+    g_array_set_size( downsample->keys, 1U << bits );
+    g_array_set_size( downsample->slots, 1U << bits );
+
+    // all bits set is POINT_DOWNSAMPLE_EMPTY_SLOT
+    memset( downsample->slots->data, 0xFF, (1U << bits) * sizeof(guint) );
+}
+
+
+//
+static guint find_slot( point_downsample_s * const downsample, const guint64 key )
+{
+    // local vars
+    const guint mask = (1U << downsample->bits) - 1;
+    guint64 * const keys = (guint64*) downsample->keys->data;
+    const guint * const slots = (const guint*) downsample->slots->data;
+
+    // Fibonacci hash, top bits
+    guint slot = (guint) ((key * 0x9E3779B97F4A7C15ULL) >> (64 - downsample->bits));
+
+
+    // linear probe, the table is never more than half full
+    while( (slots[ slot ] != POINT_DOWNSAMPLE_EMPTY_SLOT) && (keys[ slot ] != key) )
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    keys[ slot ] = key;
+
+
+    return slot;
+}
+
+
+
+
+//
+static gint32 cell_coordinate( const double value, const double inv_cell )
+{
+    // local vars
+    const double cell = floor( value * inv_cell );
+
+
+    // the cast is undefined out of range
+    if( cell <= (double) G_MININT32 )
+    {
+        return G_MININT32;
+    }
+
+    if( cell >= (double) G_MAXINT32 )
+    {
+        return G_MAXINT32;
+    }
+
+
+    return (gint32) cell;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+point_downsample_s *point_downsample_new( void )
+{
+    // local vars
+    point_downsample_s *downsample = NULL;
+
+
+    // create
+    if( (downsample = g_try_new0( point_downsample_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    downsample->keys = g_array_new( FALSE, FALSE, sizeof(guint64) );
+    downsample->slots = g_array_new( FALSE, FALSE, sizeof(guint) );
+    downsample->sums = g_array_new( FALSE, FALSE, sizeof(gdouble) );
+
+
+    return downsample;
+}
+
+
+//
+void point_downsample_free( point_downsample_s * const downsample )
+{
+    if( downsample == NULL )
+    {
+        return;
+    }
+
+
+    g_array_free( downsample->keys, TRUE );
+    g_array_free( downsample->slots, TRUE );
+    g_array_free( downsample->sums, TRUE );
+
+    g_free( downsample );
+}
+
+
+//
+unsigned long point_downsample_apply( point_downsample_s * const downsample, ps_lidar_point * const points, const unsigned long num_points, const double cell_size, const points_downsample_kind mode )
+{
+    if( (downsample == NULL) || (points == NULL) || (num_points == 0) )
+    {
+        return 0;
+    }
+
+    if( (mode == POINTS_DOWNSAMPLE_OFF) || (mode >= POINTS_DOWNSAMPLE_KIND_COUNT) || (cell_size <= 0.0) )
+    {
+        return num_points;
+    }
+
+    // local vars
+    unsigned long idx = 0;
+    unsigned long kept = 0;
+    guint slot = 0;
+    guint out = 0;
+    guint64 key = 0;
+    gdouble *sum = NULL;
+    guint *slots = NULL;
+    const double inv_cell = 1.0 / cell_size;
+
+
+    reset_table( downsample, num_points );
+    slots = (guint*) downsample->slots->data;
+
+    if( mode == POINTS_DOWNSAMPLE_CENTROID )
+    {
+        g_array_set_size( downsample->sums, 0 );
+    }
+
+    for( idx = 0; idx < num_points; idx++ )
+    {
+        // no cell to put it in
+        if( (isfinite( points[ idx ].position[ 0 ] ) == 0) || (isfinite( points[ idx ].position[ 1 ] ) == 0) )
+        {
+            continue;
+        }
+
+        // pack signed cell coordinates
+        key = ((guint64) (guint32) cell_coordinate( points[ idx ].position[ 0 ], inv_cell ) << 32)
+                | (guint64) (guint32) cell_coordinate( points[ idx ].position[ 1 ], inv_cell );
+
+        slot = find_slot( downsample, key );
+        out = slots[ slot ];
+
+        if( out == POINT_DOWNSAMPLE_EMPTY_SLOT )
+        {
+            // new cell, compact to the front, never ahead of idx
+            out = (guint) kept;
+            slots[ slot ] = out;
+            kept += 1;
+
+            if( out != idx )
+            {
+                points[ out ] = points[ idx ];
+            }
+
+            if( mode == POINTS_DOWNSAMPLE_CENTROID )
+            {
+                g_array_set_size( downsample->sums, downsample->sums->len + 5 );
+                sum = &g_array_index( downsample->sums, gdouble, out * 5 );
+
+                sum[ 0 ] = points[ out ].position[ 0 ];
+                sum[ 1 ] = points[ out ].position[ 1 ];
+                sum[ 2 ] = points[ out ].position[ 2 ];
+                sum[ 3 ] = points[ out ].intensity;
+                sum[ 4 ] = 1.0;
+            }
+        }
+        else if( mode == POINTS_DOWNSAMPLE_MAX_INTENSITY )
+        {
+            if( points[ idx ].intensity > points[ out ].intensity )
+            {
+                points[ out ] = points[ idx ];
+            }
+        }
+        else
+        {
+            sum = &g_array_index( downsample->sums, gdouble, out * 5 );
+
+            sum[ 0 ] += points[ idx ].position[ 0 ];
+            sum[ 1 ] += points[ idx ].position[ 1 ];
+            sum[ 2 ] += points[ idx ].position[ 2 ];
+            sum[ 3 ] += points[ idx ].intensity;
+            sum[ 4 ] += 1.0;
+        }
+    }
+
+    // centroids
+    if( mode == POINTS_DOWNSAMPLE_CENTROID )
+    {
+        for( idx = 0; idx < kept; idx++ )
+        {
+            sum = &g_array_index( downsample->sums, gdouble, idx * 5 );
+
+            points[ idx ].position[ 0 ] = sum[ 0 ] / sum[ 4 ];
+            points[ idx ].position[ 1 ] = sum[ 1 ] / sum[ 4 ];
+            points[ idx ].position[ 2 ] = sum[ 2 ] / sum[ 4 ];
+            points[ idx ].intensity = sum[ 3 ] / sum[ 4 ];
+        }
+    }
+
+
+    return kept;
+}
@@ -0,0 +1,464 @@
+/**
+ * @file point_trails.c
+ * @brief LiDAR Point Trails Interface Source.
+ *
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+#include "polysync_core.h"
+#include "drawable_type.h"
+#include "render.h"
+#include "point_trails.h"
+
+
+
+
+// *****************************************************
+// static global structures
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static global data
+// *****************************************************
+
+
+
+
+// *****************************************************
+// static declarations
+// *****************************************************
+
+/**
+ * @brief Hash a \ref point_trail_key_s.
+ *
+ * @param [in] key A pointer to \ref point_trail_key_s.
+ *
+ * @return Hash value.
+ *
+ */
+static guint trail_key_hash( gconstpointer key );
+
+
+/**
+ * @brief Compare two \ref point_trail_key_s.
+ *
+ * @param [in] a A pointer to \ref point_trail_key_s.
+ * @param [in] b A pointer to \ref point_trail_key_s.
+ *
+ * @return TRUE if equal, FALSE otherwise.
+ *
+ */
+static gboolean trail_key_equal( gconstpointer a, gconstpointer b );
+
+
+/**
+ * @brief Free a \ref point_trail_s and its scans.
+ *
+ * @param [in] data A pointer to \ref point_trail_s.
+ *
+ */
+static void trail_free( gpointer data );
+
+
+/**
+ * @brief Release the host and vertex buffer storage of a scan.
+ *
+ * @param [in] scan A pointer to \ref point_trail_scan_s which specifies the scan.
+ *
+ */
+static void scan_release( point_trail_scan_s * const scan );
+
+
+/**
+ * @brief Drop the oldest scan of a trail.
+ *
+ * @param [in] trail A pointer to \ref point_trail_s which specifies the trail.
+ *
+ */
+static void trail_drop_oldest( point_trail_s * const trail );
+
+
+/**
+ * @brief Thin a scan to a level of detail.
+ *
+ * Keeps every 2^(level - scan level) point in place, shrinks the host copy
+ * and re-uploads a smaller vertex buffer.
+ *
+ * @param [in] trail A pointer to \ref point_trail_s which specifies the trail holding the scan.
+ * @param [in] scan A pointer to \ref point_trail_scan_s which specifies the scan.
+ * @param [in] level Level of detail, greater than the scan level.
+ *
+ */
+static void scan_set_level( point_trail_s * const trail, point_trail_scan_s * const scan, const unsigned int level );
+
+
+/**
+ * @brief Get the level of detail of a scan age.
+ *
+ * @param [in] trails A pointer to \ref point_trails_s which specifies the trail duration.
+ * @param [in] age Scan age. [microseconds]
+ *
+ * @return Level of detail.
+ *
+ */
+static unsigned int get_level( const point_trails_s * const trails, const ps_timestamp age );
+
+
+
+
+// *****************************************************
+// static definitions
+// *****************************************************
+
+//
+static guint trail_key_hash( gconstpointer key )
+{
+    // local vars
+    const point_trail_key_s * const trail_key = (const point_trail_key_s*) key;
+    guint64 hash = 0;
+
+
+    hash = (guint64) trail_key->parent_id * 0x9E3779B97F4A7C15ULL;
+    hash ^= (guint64) trail_key->container_id + (hash << 6) + (hash >> 2);
+
+
+    return (guint) (hash ^ (hash >> 32));
+}
+
+
+//
+static gboolean trail_key_equal( gconstpointer a, gconstpointer b )
+{
+    // local vars
+    const point_trail_key_s * const key_a = (const point_trail_key_s*) a;
+    const point_trail_key_s * const key_b = (const point_trail_key_s*) b;
+
+
+    return (key_a->parent_id == key_b->parent_id) && (key_a->container_id == key_b->container_id);
+}
+
+
+//
+static void trail_free( gpointer data )
+{
+    // local vars
+    point_trail_s * const trail = (point_trail_s*) data;
+
+
+    while( trail->count > 0 )
+    {
+        trail_drop_oldest( trail );
+    }
+
+    g_free( trail );
+}
+
+
+//
+static void scan_release( point_trail_scan_s * const scan )
+{
+    g_free( scan->points );
+    scan->points = NULL;
+    scan->num_points = 0;
+
+    render_point_cloud_release( &scan->gpu );
+}
+
+
+//
+static void trail_drop_oldest( point_trail_s * const trail )
+{
+    // local vars
+    point_trail_scan_s * const scan = &trail->scans[ trail->head ];
+
+
+    trail->total_points -= scan->num_points;
+    scan_release( scan );
+
+    trail->head = (trail->head + 1) % POINT_TRAILS_MAX_SCANS;
+    trail->count -= 1;
+}
+
+
+//
+static void scan_set_level( point_trail_s * const trail, point_trail_scan_s * const scan, const unsigned int level )
+{
+    // local vars
+    const unsigned long stride = 1UL << (level - scan->level);
+    unsigned long src = 0;
+    unsigned long dst = 0;
+    ps_lidar_point *points = NULL;
+
+
+    // keep every stride'th point, scans are in sweep order so this stays spread out
+    for( src = 0; src < scan->num_points; src += stride )
+    {
+        scan->points[ dst ] = scan->points[ src ];
+        dst += 1;
+    }
+
+    trail->total_points -= (scan->num_points - dst);
+    scan->num_points = dst;
+    scan->level = level;
+
+    // give the memory back
+    if( (dst > 0) && ((points = g_try_renew( ps_lidar_point, scan->points, dst )) != NULL) )
+    {
+        scan->points = points;
+    }
+
+    // a fresh buffer so the GPU storage shrinks too
+    render_point_cloud_release( &scan->gpu );
+    render_point_cloud_upload( &scan->gpu, scan->points, scan->num_points );
+}
+
+
+//
+static unsigned int get_level( const point_trails_s * const trails, const ps_timestamp age )
+{
+    // local vars
+    unsigned int level = 0;
+
+
+    if( trails->duration > 0 )
+    {
+        level = (unsigned int) ((age * POINT_TRAILS_LOD_LEVELS) / trails->duration);
+    }
+
+    if( level >= POINT_TRAILS_LOD_LEVELS )
+    {
+        level = POINT_TRAILS_LOD_LEVELS - 1;
+    }
+
+
+    return level;
+}
+
+
+
+
+// *****************************************************
+// public definitions
+// *****************************************************
+
+//
+point_trails_s *point_trails_new( const ps_timestamp duration, const unsigned long point_budget )
+{
+    // local vars
+    point_trails_s *trails = NULL;
+
+
+    if( (trails = g_try_new0( point_trails_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    trails->trails = g_hash_table_new_full( trail_key_hash, trail_key_equal, NULL, trail_free );
+    trails->duration = duration;
+    trails->point_budget = point_budget;
+
+
+    return trails;
+}
+
+
+//
+void point_trails_free( point_trails_s * const trails )
+{
+    if( trails == NULL )
+    {
+        return;
+    }
+
+
+    g_hash_table_destroy( trails->trails );
+
+    g_free( trails );
+}
+
+
+//
+void point_trails_clear( point_trails_s * const trails )
+{
+    if( trails == NULL )
+    {
+        return;
+    }
+
+
+    g_hash_table_remove_all( trails->trails );
+}
+
+
+//
+void point_trails_push( point_trails_s * const trails, const point_trail_key_s * const key, const unsigned long long generation, const ps_lidar_point * const points, const unsigned long num_points, const ps_timestamp timestamp, const GLdouble * const color_rgba, const GLfloat point_size )
+{
+    if( (trails == NULL) || (key == NULL) || (points == NULL) || (num_points == 0) || (color_rgba == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    point_trail_s *trail = NULL;
+    point_trail_scan_s *scan = NULL;
+    guint idx = 0;
+    unsigned int level = 0;
+
+
+    // get or create the sensor's trail
+    if( (trail = (point_trail_s*) g_hash_table_lookup( trails->trails, key )) == NULL )
+    {
+        if( (trail = g_try_new0( point_trail_s, 1 )) == NULL )
+        {
+            return;
+        }
+
+        trail->key = (*key);
+        g_hash_table_insert( trails->trails, &trail->key, trail );
+    }
+    else if( (trail->count > 0) && (trail->generation == generation) )
+    {
+        // already have this scan
+        return;
+    }
+
+    // make room
+    if( trail->count == POINT_TRAILS_MAX_SCANS )
+    {
+        trail_drop_oldest( trail );
+    }
+
+    // copy the scan
+    scan = &trail->scans[ (trail->head + trail->count) % POINT_TRAILS_MAX_SCANS ];
+
+    if( (scan->points = g_try_new( ps_lidar_point, num_points )) == NULL )
+    {
+        return;
+    }
+
+    memcpy( scan->points, points, num_points * sizeof(*points) );
+    scan->num_points = num_points;
+    scan->timestamp = timestamp;
+    scan->level = 0;
+
+    // upload once, the buffer is only redrawn from here on
+    render_point_cloud_upload( &scan->gpu, scan->points, scan->num_points );
+
+    trail->count += 1;
+    trail->total_points += num_points;
+    trail->generation = generation;
+    trail->point_size = point_size;
+    memcpy( trail->color_rgba, color_rgba, sizeof(trail->color_rgba) );
+
+    // thin older scans as they age, each scan is thinned at most once per level
+    for( idx = 0; idx < (trail->count - 1); idx++ )
+    {
+        scan = &trail->scans[ (trail->head + idx) % POINT_TRAILS_MAX_SCANS ];
+
+        level = get_level( trails, (timestamp > scan->timestamp) ? (timestamp - scan->timestamp) : 0 );
+
+        if( level > scan->level )
+        {
+            scan_set_level( trail, scan, level );
+        }
+    }
+
+    // hold the budget, thin the oldest scans further before dropping any, always keeping the newest scan
+    idx = 0;
+    while( (trail->total_points > trails->point_budget) && (trail->count > 1) )
+    {
+        scan = &trail->scans[ (trail->head + idx) % POINT_TRAILS_MAX_SCANS ];
+
+        if( (idx < (trail->count - 1)) && (scan->level < (POINT_TRAILS_LOD_LEVELS - 1)) )
+        {
+            scan_set_level( trail, scan, scan->level + 1 );
+        }
+        else if( idx < (trail->count - 1) )
+        {
+            idx += 1;
+        }
+        else
+        {
+            trail_drop_oldest( trail );
+            idx = 0;
+        }
+    }
+}
+
+
+//
+void point_trails_draw( point_trails_s * const trails, const ps_timestamp draw_time )
+{
+    if( trails == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    GHashTableIter iter;
+    gpointer value = NULL;
+    point_trail_s *trail = NULL;
+    const point_trail_scan_s *scan = NULL;
+    ps_timestamp age = 0;
+    guint idx = 0;
+    const GLboolean blend_enabled = glIsEnabled( GL_BLEND );
+
+
+    // trails fade over the background
+    glEnable( GL_BLEND );
+
+    g_hash_table_iter_init( &iter, trails->trails );
+    while( g_hash_table_iter_next( &iter, NULL, &value ) )
+    {
+        trail = (point_trail_s*) value;
+
+        // drop expired scans
+        while( (trail->count > 0)
+                && (draw_time > trail->scans[ trail->head ].timestamp)
+                && ((draw_time - trail->scans[ trail->head ].timestamp) > trails->duration) )
+        {
+            trail_drop_oldest( trail );
+        }
+
+        // drop the trail once its sensor is gone
+        if( trail->count == 0 )
+        {
+            g_hash_table_iter_remove( &iter );
+            continue;
+        }
+
+        glPointSize( trail->point_size );
+
+        // oldest first, the newest scan is the live one
+        for( idx = 0; idx < (trail->count - 1); idx++ )
+        {
+            scan = &trail->scans[ (trail->head + idx) % POINT_TRAILS_MAX_SCANS ];
+
+            age = (draw_time > scan->timestamp) ? (draw_time - scan->timestamp) : 0;
+
+            glColor4d(
+                    trail->color_rgba[ 0 ],
+                    trail->color_rgba[ 1 ],
+                    trail->color_rgba[ 2 ],
+                    trail->color_rgba[ 3 ] * (1.0 - ((double) age / (double) trails->duration)) );
+
+            render_point_cloud_draw( &scan->gpu );
+        }
+    }
+
+    // leave blending as the caller had it
+    if( blend_enabled == GL_FALSE )
+    {
+        glDisable( GL_BLEND );
+    }
+}
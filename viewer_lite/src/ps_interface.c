@@ -23,6 +23,8 @@
 #include "drawable_type.h"
 #include "gui.h"
 #include "entity_manager.h"
+#include "point_downsample.h"
+#include "drawable_ring.h"
 #include "ps_interface.h"
 
 
@@ -32,6 +34,23 @@
 // static global structures
 // *****************************************************
 
+/**
+ * @brief Sensor stream key used to coalesce messages in a batch.
+ *
+ */
+typedef struct
+{
+    //
+    //
+    drawable_record_kind    kind; /*!< Record kind. */
+    //
+    //
+    ps_guid                 src_guid; /*!< Source node GUID. */
+    //
+    //
+    unsigned long long      sensor_id; /*!< Sensor identifier. */
+} stream_key_s;
+
 
 
 
@@ -84,7 +103,8 @@ static double db_to_cross_section( const double db );
 /**
  * @brief PolySync message on-data handler.
  *
- * Enqueues new PolySync messages.
+ * Extracts the fields the viewer needs from new PolySync messages into the next
+ * record of the drawable ring. Messages are dropped if the ring is full.
  *
  * @param [in] msg_type Message type identifier for the message, as seen by the data model.
  * @param [in] message Message reference to be handled by the function.
@@ -95,53 +115,131 @@ static void psync_default_handler( const ps_msg_type msg_type, const ps_msg_ref
 
 
 /**
- * @brief Parse \ref ps_radar_targets_msg into GUI entities.
+ * @brief Allocate node data and its message handling resources.
+ *
+ * No PolySync node is created.
+ *
+ * @return A newly created node data on success, NULL on failure.
+ *
+ */
+static node_data_s *node_data_new( void );
+
+
+/**
+ * @brief Release the message handling resources of node data.
+ *
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the resources to release.
+ *
+ */
+static void node_data_release( node_data_s * const node_data );
+
+
+/**
+ * @brief Extract \ref ps_radar_targets_msg into a drawable record.
+ *
+ * Invalid tracks are skipped.
+ *
+ * @param [in] msg A pointer to \ref ps_radar_targets_msg which specifies the message.
+ * @param [out] record A pointer to \ref drawable_record_s which receives the targets.
+ *
+ */
+static void extract_radar_targets( const ps_radar_targets_msg * const msg, drawable_record_s * const record );
+
+
+/**
+ * @brief Extract \ref ps_lidar_points_msg into a drawable record.
+ *
+ * @param [in] msg A pointer to \ref ps_lidar_points_msg which specifies the message.
+ * @param [in] ring A pointer to \ref drawable_ring_s which specifies the ring holding the record.
+ * @param [out] record A pointer to \ref drawable_record_s which receives the points.
+ *
+ * @return Zero on success, one on failure.
+ *
+ */
+static int extract_lidar_points( const ps_lidar_points_msg * const msg, drawable_ring_s * const ring, drawable_record_s * const record );
+
+
+/**
+ * @brief Extract \ref ps_objects_msg into a drawable record.
+ *
+ * @param [in] msg A pointer to \ref ps_objects_msg which specifies the message.
+ * @param [out] record A pointer to \ref drawable_record_s which receives the objects.
+ *
+ */
+static void extract_objects( const ps_objects_msg * const msg, drawable_record_s * const record );
+
+
+/**
+ * @brief Check whether a stream was already seen in the current batch, add it if not.
+ *
+ * @param [in] streams A pointer to GArray of \ref stream_key_s which specifies the streams seen so far.
+ * @param [in] key A pointer to \ref stream_key_s which specifies the stream to check.
  *
- * Adds/updates the entities list with the message data.
+ * @return One if the stream was already seen, zero if it was added.
+ *
+ */
+static int check_add_stream( GArray * const streams, const stream_key_s * const key );
+
+
+/**
+ * @brief Parse a drawable record into GUI entities based on its kind.
  *
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the parsing resources.
  * @param [in] gui A pointer to \ref gui_context_s which specifies the configuration(s).
- * @param [in] msg A pointer to \ref ps_radar_targets_msg which specifies the message to parse.
- * @param [in] parent_list A pointer to GList which specifies the parent entities list.
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the record to parse.
+ * @param [in] store A pointer to \ref entity_store_s which specifies the entity store to update.
  * @param [in] update_time Update timestamp to give objects.
  *
- * @return The (possibly new) parent entities list, NULL means empty list.
- *
  */
-static GList *ps_parse_push_radar_targets( const gui_context_s * const gui, const ps_radar_targets_msg * const msg, GList * const parent_list, const unsigned long long update_time );
+static void parse_record( const node_data_s * const node_data, const gui_context_s * const gui, drawable_record_s * const record, entity_store_s * const store, const unsigned long long update_time );
 
 
 /**
- * @brief Parse \ref ps_lidar_points_msg into GUI entities.
+ * @brief Parse radar target records into GUI entities.
  *
- * Adds/updates the entities list with the message data.
+ * Adds/updates the entity store with the record data.
  *
  * @param [in] gui A pointer to \ref gui_context_s which specifies the configuration(s).
- * @param [in] msg A pointer to \ref ps_radar_targets_msg which specifies the message to parse.
- * @param [in] parent_list A pointer to GList which specifies the parent entities list.
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the record to parse.
+ * @param [in] store A pointer to \ref entity_store_s which specifies the entity store to update.
  * @param [in] update_time Update timestamp to give objects.
  *
- * @return The (possibly new) parent entities list, NULL means empty list.
+ */
+static void ps_parse_push_radar_targets( const gui_context_s * const gui, const drawable_record_s * const record, entity_store_s * const store, const unsigned long long update_time );
+
+
+/**
+ * @brief Parse LiDAR point records into GUI entities.
+ *
+ * Adds/updates the entity store with the record data. The record's point storage
+ * is exchanged with the container's back buffer instead of copied.
+ *
+ * Points are downsampled to one per grid cell when \ref gui_configuration_s.points_downsample is enabled.
+ *
+ * @param [in] gui A pointer to \ref gui_context_s which specifies the configuration(s).
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the record to parse.
+ * @param [in] downsample A pointer to \ref point_downsample_s which specifies the downsampling scratch data.
+ * @param [in] store A pointer to \ref entity_store_s which specifies the entity store to update.
+ * @param [in] update_time Update timestamp to give objects.
  *
  */
-static GList *ps_parse_push_lidar_points( const gui_context_s * const gui, const ps_lidar_points_msg * const msg, GList * const parent_list, const unsigned long long update_time );
+static void ps_parse_push_lidar_points( const gui_context_s * const gui, drawable_record_s * const record, point_downsample_s * const downsample, entity_store_s * const store, const unsigned long long update_time );
 
 
 /**
- * @brief Parse \ref ps_objects_msg into GUI entities.
+ * @brief Parse object records into GUI entities.
  *
- * Adds/updates the entities list with the message data.
+ * Adds/updates the entity store with the record data.
  *
  * @note Assumes objects have valid x/y position values.
  *
  * @param [in] gui A pointer to \ref gui_context_s which specifies the configuration(s).
- * @param [in] msg A pointer to \ref ps_objects_msg which specifies the message to parse.
- * @param [in] parent_list A pointer to GList which specifies the parent entities list.
+ * @param [in] record A pointer to \ref drawable_record_s which specifies the record to parse.
+ * @param [in] store A pointer to \ref entity_store_s which specifies the entity store to update.
  * @param [in] update_time Update timestamp to give objects.
  *
- * @return The (possibly new) parent entities list, NULL means empty list.
- *
  */
-static GList *ps_parse_push_objects( const gui_context_s * const gui, const ps_objects_msg * const msg, GList * const parent_list, const unsigned long long update_time );
+static void ps_parse_push_objects( const gui_context_s * const gui, const drawable_record_s * const record, entity_store_s * const store, const unsigned long long update_time );
 
 
 
@@ -183,18 +281,17 @@ static double db_to_cross_section( const double db )
 static void psync_default_handler( const ps_msg_type msg_type, const ps_msg_ref const message, void * const user_data )
 {
     // local vars
-    node_data_s     *node_data  = NULL;
-    ps_msg_ref      msg_copy    = PSYNC_MSG_REF_INVALID;
-    ps_guid         node_guid   = PSYNC_GUID_INVALID;
-    ps_guid         src_guid    = PSYNC_GUID_INVALID;
-    ps_node_flags   node_flags  = 0;
+    node_data_s         *node_data  = NULL;
+    ps_guid             node_guid   = PSYNC_GUID_INVALID;
+    ps_guid             src_guid    = PSYNC_GUID_INVALID;
+    ps_node_flags       node_flags  = 0;
 
 
     // cast
     node_data = (node_data_s*) user_data;
 
     // ignore if not valid
-    if( (node_data == NULL) || (message == NULL) || (node_data->msg_queue == NULL) )
+    if( (node_data == NULL) || (message == NULL) || (node_data->ring == NULL) )
     {
         return;
     }
@@ -229,40 +326,95 @@ static void psync_default_handler( const ps_msg_type msg_type, const ps_msg_ref
         return;
     }
 
-    // get an instance
-    if( psync_message_alloc( node_data->node, msg_type, &msg_copy ) != DTC_NONE )
+    // hand to the consumer
+    ps_push_message( node_data, msg_type, message );
+}
+
+
+//
+static node_data_s *node_data_new( void )
+{
+    // local vars
+    node_data_s *node_data = NULL;
+
+
+    // create
+    if( (node_data = malloc( sizeof(*node_data) )) == NULL )
     {
-        return;
+        return NULL;
     }
 
-    // copy message into new message
-    if( psync_message_copy( node_data->node, message, msg_copy ) != DTC_NONE )
+    // zero
+    memset( node_data, 0, sizeof(*node_data) );
+    node_data->node = PSYNC_NODE_REF_INVALID;
+    node_data->msg_type_radar_targets = PSYNC_MSG_TYPE_INVALID;
+    node_data->msg_type_lidar_points = PSYNC_MSG_TYPE_INVALID;
+    node_data->msg_type_objects = PSYNC_MSG_TYPE_INVALID;
+
+    // batch resources
+    node_data->max_batch = PS_DEFAULT_MAX_BATCH;
+    node_data->batch_budget = PS_DEFAULT_BATCH_BUDGET;
+    node_data->batch = g_ptr_array_sized_new( node_data->max_batch );
+    node_data->batch_streams = g_array_new( FALSE, FALSE, sizeof(stream_key_s) );
+
+    // create drawable record ring
+    if( (node_data->ring = drawable_ring_new( PS_DEFAULT_RING_SIZE )) == NULL )
     {
-        return;
+        node_data_release( node_data );
+        free( node_data );
+        return NULL;
+    }
+
+    // point downsampling scratch
+    if( (node_data->point_downsample = point_downsample_new()) == NULL )
+    {
+        node_data_release( node_data );
+        free( node_data );
+        return NULL;
     }
 
-    // enque
-    g_async_queue_push( node_data->msg_queue, (gpointer) msg_copy );
+
+    return node_data;
 }
 
 
 //
-static GList *ps_parse_push_radar_targets( const gui_context_s * const gui, const ps_radar_targets_msg * const msg, GList * const parent_list, const unsigned long long update_time )
+static void node_data_release( node_data_s * const node_data )
 {
-    if( (gui == NULL) || (msg == NULL) )
+    // free ring and any records in it
+    drawable_ring_free( node_data->ring );
+    node_data->ring = NULL;
+
+    // free batch resources
+    if( node_data->batch != NULL )
     {
-        return NULL;
+        (void) g_ptr_array_free( node_data->batch, TRUE );
+        node_data->batch = NULL;
+    }
+    if( node_data->batch_streams != NULL )
+    {
+        (void) g_array_free( node_data->batch_streams, TRUE );
+        node_data->batch_streams = NULL;
     }
 
+    // free downsampling scratch
+    point_downsample_free( node_data->point_downsample );
+    node_data->point_downsample = NULL;
+}
+
+
+//
+static void extract_radar_targets( const ps_radar_targets_msg * const msg, drawable_record_s * const record )
+{
     // local vars
-    object_s                object;
-    GList                   *list       = NULL;
     unsigned long           idx         = 0;
-    ps_radar_target         *target     = NULL;
+    const ps_radar_target   *target     = NULL;
+    drawable_item_s         *item       = NULL;
 
 
-    // set list
-    list = parent_list;
+    record->kind = DRAWABLE_RECORD_RADAR_TARGETS;
+    record->src_guid = msg->header.src_guid;
+    record->sensor_id = (unsigned long long) msg->sensor_descriptor.id;
 
     // for each track
     for( idx = 0; idx < (unsigned long) msg->targets._length; idx++ )
@@ -271,124 +423,314 @@ static GList *ps_parse_push_radar_targets( const gui_context_s * const gui, cons
         target = &msg->targets._buffer[ idx ];
 
         // ignore invalid targets
-        if(
-                (target->track_status == TRACK_STATUS_NO_TRACK)
-                || (target->track_status == TRACK_STATUS_NO_TRACK)
-                )
+        if( target->track_status == TRACK_STATUS_NO_TRACK )
         {
             continue;
         }
 
-        // init, object ID = track ID
-        entity_object_init( (unsigned long long) target->id, &object );
+        // append item, storage is recycled
+        g_array_set_size( record->items, record->items->len + 1 );
+        item = &g_array_index( record->items, drawable_item_s, record->items->len - 1 );
+        memset( item, 0, sizeof(*item) );
 
-        // parent ID = node GUID
-        object.parent_id = (unsigned long long) msg->header.src_guid;
-
-        // container ID = sensor SN
-        object.container_id = (unsigned long long) msg->sensor_descriptor.id;
-
-        // timeout interval
-        object.timeout_interval = 230000;
-
-        // update time
-        object.update_time = update_time;
-
-        // primitive
-        object.primitive = PRIMITIVE_CIRCLE;
-
-        // default radius
-        object.radius = 1.25;
+        // track ID
+        item->id = (unsigned long long) target->id;
 
         // if amplitude provided
         if( target->cross_section != PSYNC_RADAR_CROSS_SECTION_NOT_AVAILABLE )
         {
             // use rcs
-            object.adjusted_radius = clamp_cross_section( sqrt( target->cross_section ) );
+            item->adjusted_radius = clamp_cross_section( sqrt( target->cross_section ) );
         }
         else if( target->amplitude != PSYNC_AMPLITUDE_NOT_AVAILABLE )
         {
-            object.adjusted_radius = db_to_cross_section( target->amplitude );
+            item->adjusted_radius = db_to_cross_section( target->amplitude );
         }
         else
         {
-            object.adjusted_radius = 0.3;
+            item->adjusted_radius = 0.3;
         }
 
         // position x,y,z
-        object.x = target->position[ 0 ];
-        object.y = target->position[ 1 ];
-        object.z = target->position[ 2 ];
+        item->position[ 0 ] = target->position[ 0 ];
+        item->position[ 1 ] = target->position[ 1 ];
+        item->position[ 2 ] = target->position[ 2 ];
 
         // size x,y,z
         if( target->size[ 0 ] != PSYNC_SIZE_NOT_AVAILABLE )
         {
-            object.length = target->size[ 0 ];
+            item->size[ 0 ] = target->size[ 0 ];
         }
         if( target->size[ 1 ] != PSYNC_SIZE_NOT_AVAILABLE )
         {
-            object.width = target->size[ 1 ];
+            item->size[ 1 ] = target->size[ 1 ];
         }
         if( target->size[ 2 ] != PSYNC_SIZE_NOT_AVAILABLE )
         {
-            object.height = target->size[ 2 ];
+            item->size[ 2 ] = target->size[ 2 ];
         }
 
         // velocity  x,y,z
         if( target->velocity[ 0 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
         {
-            object.vx = target->velocity[ 0 ];
+            item->velocity[ 0 ] = target->velocity[ 0 ];
         }
         if( target->velocity[ 1 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
         {
-            object.vy = target->velocity[ 1 ];
+            item->velocity[ 1 ] = target->velocity[ 1 ];
         }
         if( target->velocity[ 2 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
         {
-            object.vz = target->velocity[ 2 ];
+            item->velocity[ 2 ] = target->velocity[ 2 ];
         }
+    }
+}
+
 
-        // add/update list with object
-        list = entity_object_update_copy( list, object.parent_id, object.container_id, &object );
+//
+static int extract_lidar_points( const ps_lidar_points_msg * const msg, drawable_ring_s * const ring, drawable_record_s * const record )
+{
+    record->kind = DRAWABLE_RECORD_LIDAR_POINTS;
+    record->src_guid = msg->header.src_guid;
+    record->sensor_id = (unsigned long long) msg->sensor_descriptor.id;
+
+    // ignore if no points
+    if( msg->points._length == 0 )
+    {
+        return 0;
     }
 
+    // reuses the record's or a spare buffer, grows only on the largest scan seen so far
+    if( drawable_record_reserve_points( ring, record, (unsigned long) msg->points._length ) != 0 )
+    {
+        return 1;
+    }
+
+    // message points share the display layout, bulk copy
+    record->num_points = (unsigned long) msg->points._length;
+    memcpy( record->points, msg->points._buffer, record->num_points * sizeof(*record->points) );
 
-    // return parent list
-    return list;
+
+    return 0;
 }
 
 
 //
-static GList *ps_parse_push_lidar_points( const gui_context_s * const gui, const ps_lidar_points_msg * const msg, GList * const parent_list, const unsigned long long update_time )
+static void extract_objects( const ps_objects_msg * const msg, drawable_record_s * const record )
 {
-    if( (gui == NULL) || (msg == NULL) )
+    // local vars
+    unsigned long           idx         = 0;
+    const ps_object         *obj        = NULL;
+    drawable_item_s         *item       = NULL;
+
+
+    record->kind = DRAWABLE_RECORD_OBJECTS;
+    record->src_guid = msg->header.src_guid;
+    record->sensor_id = (unsigned long long) msg->sensor_descriptor.id;
+
+    // for each object
+    for( idx = 0; idx < (unsigned long) msg->objects._length; idx++ )
     {
-        return NULL;
+        // cast
+        obj = &msg->objects._buffer[ idx ];
+
+        // append item, storage is recycled
+        g_array_set_size( record->items, record->items->len + 1 );
+        item = &g_array_index( record->items, drawable_item_s, record->items->len - 1 );
+        memset( item, 0, sizeof(*item) );
+
+        // obj ID
+        item->id = (unsigned long long) obj->id;
+
+        // defaults/unused
+        item->adjusted_radius = 1.25;
+
+        // position x,y,z
+        item->position[ 0 ] = obj->position[ 0 ];
+        item->position[ 1 ] = obj->position[ 1 ];
+
+        // if z valid
+        if( obj->position[ 2 ] != PSYNC_POSITION_NOT_AVAILABLE )
+        {
+            item->position[ 2 ] = obj->position[ 2 ];
+        }
+
+        // size x,y,z
+        if( obj->size[ 0 ] != PSYNC_SIZE_NOT_AVAILABLE )
+        {
+            item->size[ 0 ] = obj->size[ 0 ];
+        }
+        if( obj->size[ 1 ] != PSYNC_SIZE_NOT_AVAILABLE )
+        {
+            item->size[ 1 ] = obj->size[ 1 ];
+        }
+        if( obj->size[ 2 ] != PSYNC_SIZE_NOT_AVAILABLE )
+        {
+            item->size[ 2 ] = obj->size[ 2 ];
+        }
+
+        // velocity  x,y,z
+        if( obj->velocity[ 0 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
+        {
+            item->velocity[ 0 ] = obj->velocity[ 0 ];
+        }
+        if( obj->velocity[ 1 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
+        {
+            item->velocity[ 1 ] = obj->velocity[ 1 ];
+        }
+        if( obj->velocity[ 2 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
+        {
+            item->velocity[ 2 ] = obj->velocity[ 2 ];
+        }
+
+        // if valid
+        if( obj->course_angle != PSYNC_ANGLE_NOT_AVAILABLE )
+        {
+            // orientation radians
+            item->orientation = obj->course_angle;
+        }
+    }
+}
+
+
+//
+static int check_add_stream( GArray * const streams, const stream_key_s * const key )
+{
+    // local vars
+    guint idx = 0;
+    const stream_key_s *seen = NULL;
+
+
+    // few sensors per batch, linear search
+    for( idx = 0; idx < streams->len; idx++ )
+    {
+        seen = &g_array_index( streams, stream_key_s, idx );
+
+        if( (seen->kind == key->kind) && (seen->src_guid == key->src_guid) && (seen->sensor_id == key->sensor_id) )
+        {
+            return 1;
+        }
+    }
+
+    // add
+    g_array_append_val( streams, *key );
+
+
+    return 0;
+}
+
+
+//
+static void parse_record( const node_data_s * const node_data, const gui_context_s * const gui, drawable_record_s * const record, entity_store_s * const store, const unsigned long long update_time )
+{
+    // process known kinds
+    if( record->kind == DRAWABLE_RECORD_RADAR_TARGETS )
+    {
+        ps_parse_push_radar_targets( gui, record, store, update_time );
+    }
+    else if( record->kind == DRAWABLE_RECORD_LIDAR_POINTS )
+    {
+        ps_parse_push_lidar_points( gui, record, node_data->point_downsample, store, update_time );
+    }
+    else if( record->kind == DRAWABLE_RECORD_OBJECTS )
+    {
+        ps_parse_push_objects( gui, record, store, update_time );
+    }
+}
+
+
+//
+static void ps_parse_push_radar_targets( const gui_context_s * const gui, const drawable_record_s * const record, entity_store_s * const store, const unsigned long long update_time )
+{
+    if( (gui == NULL) || (record == NULL) || (store == NULL) )
+    {
+        return;
     }
 
     // local vars
     object_s                object;
-    GList                   *list       = NULL;
-    unsigned long           idx         = 0;
+    guint                   idx         = 0;
+    const drawable_item_s   *item       = NULL;
 
 
-    // ignore if no points
-    if( msg->points._length == 0 )
+    // for each track
+    for( idx = 0; idx < record->items->len; idx++ )
+    {
+        // cast
+        item = &g_array_index( record->items, drawable_item_s, idx );
+
+        // init, object ID = track ID
+        entity_object_init( item->id, &object );
+
+        // parent ID = node GUID
+        object.parent_id = (unsigned long long) record->src_guid;
+
+        // container ID = sensor SN
+        object.container_id = record->sensor_id;
+
+        // timeout interval
+        object.timeout_interval = 230000;
+
+        // update time
+        object.update_time = update_time;
+
+        // primitive
+        object.primitive = PRIMITIVE_CIRCLE;
+
+        // default radius
+        object.radius = 1.25;
+
+        // amplitude mapped radius
+        object.adjusted_radius = item->adjusted_radius;
+
+        // position x,y,z
+        object.x = item->position[ 0 ];
+        object.y = item->position[ 1 ];
+        object.z = item->position[ 2 ];
+
+        // size x,y,z
+        object.length = item->size[ 0 ];
+        object.width = item->size[ 1 ];
+        object.height = item->size[ 2 ];
+
+        // velocity  x,y,z
+        object.vx = item->velocity[ 0 ];
+        object.vy = item->velocity[ 1 ];
+        object.vz = item->velocity[ 2 ];
+
+        // add/update store with object
+        (void) entity_object_update_copy( store, object.parent_id, object.container_id, &object );
+    }
+}
+
+
+//
+static void ps_parse_push_lidar_points( const gui_context_s * const gui, drawable_record_s * const record, point_downsample_s * const downsample, entity_store_s * const store, const unsigned long long update_time )
+{
+    if( (gui == NULL) || (record == NULL) || (downsample == NULL) || (store == NULL) )
     {
-        return parent_list;
+        return;
     }
 
-    // set list
-    list = parent_list;
+    // local vars
+    object_s                object;
+    const object_s          *obj        = NULL;
+
+
+    // ignore if no points
+    if( record->num_points == 0 )
+    {
+        return;
+    }
 
     // init, object ID = 0
     entity_object_init( 0, &object );
 
     // parent ID = node GUID
-    object.parent_id = (unsigned long long) msg->header.src_guid;
+    object.parent_id = (unsigned long long) record->src_guid;
 
     // container ID = sensor SN
-    object.container_id = (unsigned long long) msg->sensor_descriptor.id;
+    object.container_id = record->sensor_id;
 
     // timeout interval
     object.timeout_interval = DEFAULT_OBJECT_TIMEOUT;
@@ -402,70 +744,70 @@ static GList *ps_parse_push_lidar_points( const gui_context_s * const gui, const
     // radius = point size / 2.0
     object.radius = 0.5;
 
-    // create points
-    if( (object.points_3d = g_try_new0( ps_lidar_point, msg->points._length )) == NULL)
-    {
-        return list;
-    }
-
     // num points
-    object.num_points = (unsigned long) msg->points._length;
+    object.num_points = record->num_points;
 
-    // for each point
-    for( idx = 0; idx < object.num_points; idx++ )
+    // swap the record's points in as the container's back buffer, the record recycles the old one
+    if( (object.points_3d = entity_container_exchange_point_buffer( store, object.parent_id, object.container_id, &record->points, &record->point_capacity )) == NULL )
     {
-        // copy
-        object.points_3d[ idx ].position[ 0 ] = msg->points._buffer[ idx ].position[ 0 ];
-        object.points_3d[ idx ].position[ 1 ] = msg->points._buffer[ idx ].position[ 1 ];
-        object.points_3d[ idx ].position[ 2 ] = msg->points._buffer[ idx ].position[ 2 ];
-        object.points_3d[ idx ].intensity = msg->points._buffer[ idx ].intensity;
+        return;
     }
+    record->num_points = 0;
 
-    // add/update list with object
-    list = entity_object_update_copy( list, object.parent_id, object.container_id, &object );
+    // keep one point per display cell
+    if( gui->config.points_downsample != POINTS_DOWNSAMPLE_OFF )
+    {
+        object.num_points = point_downsample_apply(
+                downsample,
+                object.points_3d,
+                object.num_points,
+                gui->config.points_cell_size,
+                gui->config.points_downsample );
+    }
 
+    // add/update store with object, swaps the point buffer in
+    if( (obj = entity_object_update_copy( store, object.parent_id, object.container_id, &object )) == NULL )
+    {
+        return;
+    }
 
-    // return parent list
-    return list;
+    // new scan, add it to the sensor's trail whether or not the sensor is in view
+    entity_object_push_trail( gui, store, obj );
 }
 
 
 //
-static GList *ps_parse_push_objects( const gui_context_s * const gui, const ps_objects_msg * const msg, GList * const parent_list, const unsigned long long update_time )
+static void ps_parse_push_objects( const gui_context_s * const gui, const drawable_record_s * const record, entity_store_s * const store, const unsigned long long update_time )
 {
-    if( (gui == NULL) || (msg == NULL) )
+    if( (gui == NULL) || (record == NULL) || (store == NULL) )
     {
-        return NULL;
+        return;
     }
 
     // local vars
     object_s                object;
-    GList                   *list       = NULL;
-    unsigned long           idx         = 0;
-    ps_object               *obj        = NULL;
+    guint                   idx         = 0;
+    const drawable_item_s   *item       = NULL;
 
 
-    // set list
-    list = parent_list;
-
     // for each object
-    for( idx = 0; idx < (unsigned long) msg->objects._length; idx++ )
+    for( idx = 0; idx < record->items->len; idx++ )
     {
         // cast
-        obj = &msg->objects._buffer[ idx ];
+        item = &g_array_index( record->items, drawable_item_s, idx );
 
         // init, object ID = obj ID
-        entity_object_init( (unsigned long long) obj->id, &object );
+        entity_object_init( item->id, &object );
 
         // defaults/unused
         object.radius = 1.25;
-        object.adjusted_radius = 1.25;
+        object.adjusted_radius = item->adjusted_radius;
 
         // parent ID = node GUID
-        object.parent_id = (unsigned long long) msg->header.src_guid;
+        object.parent_id = (unsigned long long) record->src_guid;
 
         // container ID = sensor SN
-        object.container_id = (unsigned long long) msg->sensor_descriptor.id;
+        object.container_id = record->sensor_id;
 
         // timeout interval
         object.timeout_interval = DEFAULT_OBJECT_TIMEOUT;
@@ -477,57 +819,26 @@ static GList *ps_parse_push_objects( const gui_context_s * const gui, const ps_o
         object.primitive = PRIMITIVE_RECTANGLE;
 
         // position x,y,z
-        object.x = obj->position[ 0 ];
-        object.y = obj->position[ 1 ];
-
-        // if z valid
-        if( obj->position[ 2 ] != PSYNC_POSITION_NOT_AVAILABLE )
-        {
-            object.z = obj->position[ 2 ];
-        }
+        object.x = item->position[ 0 ];
+        object.y = item->position[ 1 ];
+        object.z = item->position[ 2 ];
 
         // size x,y,z
-        if( obj->size[ 0 ] != PSYNC_SIZE_NOT_AVAILABLE )
-        {
-            object.length = obj->size[ 0 ];
-        }
-        if( obj->size[ 1 ] != PSYNC_SIZE_NOT_AVAILABLE )
-        {
-            object.width = obj->size[ 1 ];
-        }
-        if( obj->size[ 2 ] != PSYNC_SIZE_NOT_AVAILABLE )
-        {
-            object.height = obj->size[ 2 ];
-        }
+        object.length = item->size[ 0 ];
+        object.width = item->size[ 1 ];
+        object.height = item->size[ 2 ];
 
         // velocity  x,y,z
-        if( obj->velocity[ 0 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
-        {
-            object.vx = obj->velocity[ 0 ];
-        }
-        if( obj->velocity[ 1 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
-        {
-            object.vy = obj->velocity[ 1 ];
-        }
-        if( obj->velocity[ 2 ] != PSYNC_VELOCITY_NOT_AVAILABLE )
-        {
-            object.vz = obj->velocity[ 2 ];
-        }
+        object.vx = item->velocity[ 0 ];
+        object.vy = item->velocity[ 1 ];
+        object.vz = item->velocity[ 2 ];
 
-        // if valid
-        if( obj->course_angle != PSYNC_ANGLE_NOT_AVAILABLE )
-        {
-            // orientation radians
-            object.orientation = obj->course_angle;
-        }
+        // orientation radians
+        object.orientation = item->orientation;
 
-        // add/update list with object
-        list = entity_object_update_copy( list, object.parent_id, object.container_id, &object );
+        // add/update store with object
+        (void) entity_object_update_copy( store, object.parent_id, object.container_id, &object );
     }
-
-
-    // return parent list
-    return list;
 }
 
 
@@ -544,16 +855,11 @@ node_data_s *init_polysync( void )
     node_data_s *node_data = NULL;
 
     // create
-    if( (node_data = malloc( sizeof(*node_data) )) == NULL )
+    if( (node_data = node_data_new()) == NULL )
     {
         return NULL;
     }
 
-    // zero
-    memset( node_data, 0, sizeof(*node_data) );
-    node_data->node = PSYNC_NODE_REF_INVALID;
-    node_data->msg_type_radar_targets = PSYNC_MSG_TYPE_INVALID;
-
     // init polysync
     if( psync_init(
             PS_NODE_NAME,
@@ -563,14 +869,7 @@ node_data_s *init_polysync( void )
             PSYNC_INIT_FLAG_STDOUT_LOGGING,
             &node_data->node ) != DTC_NONE )
     {
-        free( node_data );
-        return NULL;
-    }
-
-    // create queue
-    if( (node_data->msg_queue = g_async_queue_new()) == NULL )
-    {
-        (void) psync_release( &node_data->node );
+        node_data_release( node_data );
         free( node_data );
         return NULL;
     }
@@ -578,8 +877,7 @@ node_data_s *init_polysync( void )
     // disable handlers
     if( psync_node_set_flag( node_data->node, NODE_FLAG_HANDLERS_ENABLED, 0 ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -587,8 +885,7 @@ node_data_s *init_polysync( void )
     // get type
     if( psync_message_get_type_by_name( node_data->node, PS_RADAR_TARGETS_MSG_NAME, &node_data->msg_type_radar_targets ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -596,8 +893,7 @@ node_data_s *init_polysync( void )
     // get type
     if( psync_message_get_type_by_name( node_data->node, PS_LIDAR_POINTS_MSG_NAME, &node_data->msg_type_lidar_points ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -605,8 +901,7 @@ node_data_s *init_polysync( void )
     // get type
     if( psync_message_get_type_by_name( node_data->node, PS_OBJECTS_MSG_NAME, &node_data->msg_type_objects ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -614,8 +909,7 @@ node_data_s *init_polysync( void )
     // register listener
     if( psync_message_register_listener( node_data->node, node_data->msg_type_radar_targets , psync_default_handler, node_data ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -623,8 +917,7 @@ node_data_s *init_polysync( void )
     // register listener
     if( psync_message_register_listener( node_data->node, node_data->msg_type_lidar_points , psync_default_handler, node_data ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -632,8 +925,7 @@ node_data_s *init_polysync( void )
     // register listener
     if( psync_message_register_listener( node_data->node, node_data->msg_type_objects , psync_default_handler, node_data ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -641,8 +933,7 @@ node_data_s *init_polysync( void )
     // enable handlers
     if( psync_node_set_flag( node_data->node, NODE_FLAG_HANDLERS_ENABLED, 1 ) != DTC_NONE )
     {
-        (void) psync_release( &node_data->node );
-        g_async_queue_unref( node_data->msg_queue );
+        release_polysync( node_data );
         free( node_data );
         return NULL;
     }
@@ -653,6 +944,29 @@ node_data_s *init_polysync( void )
 }
 
 
+//
+node_data_s *init_polysync_offline( void )
+{
+    // local vars
+    node_data_s *node_data = NULL;
+
+    // create
+    if( (node_data = node_data_new()) == NULL )
+    {
+        return NULL;
+    }
+
+    // no node to resolve types with, messages are only given through ps_push_message
+    node_data->msg_type_radar_targets = PS_OFFLINE_MSG_TYPE_RADAR_TARGETS;
+    node_data->msg_type_lidar_points = PS_OFFLINE_MSG_TYPE_LIDAR_POINTS;
+    node_data->msg_type_objects = PS_OFFLINE_MSG_TYPE_OBJECTS;
+
+
+    // return new node data
+    return node_data;
+}
+
+
 //
 void release_polysync( node_data_s * const node_data )
 {
@@ -661,91 +975,142 @@ void release_polysync( node_data_s * const node_data )
         return;
     }
 
-    // local vars
-    ps_msg_ref msg = PSYNC_MSG_REF_INVALID;
+    // check for a node
+    if( node_data->node != PSYNC_NODE_REF_INVALID )
+    {
+        // disable handlers
+        (void) psync_node_set_flag( node_data->node, NODE_FLAG_HANDLERS_ENABLED, 0 );
+
+        // wait a little
+        usleep( 100000 );
+    }
 
+    // free ring, batch and downsampling resources
+    node_data_release( node_data );
 
-    // disable handlers
-    (void) psync_node_set_flag( node_data->node, NODE_FLAG_HANDLERS_ENABLED, 0 );
+    // release polysync
+    if( node_data->node != PSYNC_NODE_REF_INVALID )
+    {
+        (void) psync_release( &node_data->node );
+    }
+}
 
-    // wait a little
-    usleep( 100000 );
 
-    // flush queue
-    if( node_data->msg_queue != NULL )
+//
+void ps_push_message( node_data_s * const node_data, const ps_msg_type msg_type, const ps_msg_ref const message )
+{
+    if( (node_data == NULL) || (message == NULL) || (node_data->ring == NULL) )
     {
-        // get elements in queue
-        while( (msg = g_async_queue_try_pop( node_data->msg_queue )) != NULL )
+        return;
+    }
+
+    // local vars
+    drawable_record_s   *record     = NULL;
+
+
+    // get a record, overwrites the oldest waiting one if the consumer is behind
+    if( (record = drawable_ring_reserve( node_data->ring )) == NULL )
+    {
+        return;
+    }
+
+    // extract only what the viewer draws, a failed extract commits an empty record
+    if( msg_type == node_data->msg_type_radar_targets )
+    {
+        extract_radar_targets( (const ps_radar_targets_msg*) message, record );
+    }
+    else if( msg_type == node_data->msg_type_lidar_points )
+    {
+        if( extract_lidar_points( (const ps_lidar_points_msg*) message, node_data->ring, record ) != 0 )
         {
-            // release message
-            (void) psync_message_free( node_data->node, &msg );
+            record->num_points = 0;
         }
-
-        // unref
-        g_async_queue_unref( node_data->msg_queue );
+    }
+    else if( msg_type == node_data->msg_type_objects )
+    {
+        extract_objects( (const ps_objects_msg*) message, record );
     }
 
-    // release polysync
-    (void) psync_release( &node_data->node );
+    // hand to the consumer
+    drawable_ring_commit( node_data->ring, record );
 }
 
 
 //
-GList *ps_process_message( node_data_s * const node_data, const gui_context_s * const gui, GList * const parent_list, const unsigned long long update_time, unsigned int * const msg_read )
+void ps_process_message( node_data_s * const node_data, const gui_context_s * const gui, entity_store_s * const store, const unsigned long long update_time, unsigned int * const msg_read )
 {
-    if( (node_data == NULL) || (gui == NULL) || (msg_read == NULL) )
+    if( (node_data == NULL) || (gui == NULL) || (store == NULL) || (msg_read == NULL) )
     {
         raise( SIGINT );
-        return NULL;
+        return;
     }
 
-    if( node_data->msg_queue == NULL )
+    if( node_data->ring == NULL )
     {
         // nothing to do
-        return parent_list;
+        return;
     }
 
     // local vars
-    ps_msg_ref   msg    = PSYNC_MSG_REF_INVALID;
-    GList       *list   = NULL;
-    ps_msg_type type    = 0;
+    drawable_record_s   *record     = NULL;
+    stream_key_s        key;
+    guint               idx         = 0;
+    guint               depth       = 0;
+    const ps_timestamp  start_time  = get_micro_tick();
 
 
-    // set list
-    list = parent_list;
+    // zero
+    (*msg_read) = 0;
+    node_data->stats.last_batch = 0;
 
-    // check for message
-    if( (msg = g_async_queue_try_pop( node_data->msg_queue )) != NULL )
+    // drain in batches until empty or out of time
+    do
     {
-        // get message type
-        if( psync_message_get_type( msg, &type ) == DTC_NONE )
+        // take a batch of ready records
+        g_ptr_array_set_size( node_data->batch, 0 );
+        if( drawable_ring_acquire( node_data->ring, node_data->batch, node_data->max_batch ) == 0 )
         {
-            // success
+            break;
+        }
+
+        // update status
+        (*msg_read) = 1;
+        node_data->stats.last_batch += node_data->batch->len;
 
-            // if not in freeze-frame
-            if( gui->config.freeze_frame == 0 )
+        // newest first so only the latest record of each stream is parsed
+        g_array_set_size( node_data->batch_streams, 0 );
+        idx = node_data->batch->len;
+        while( idx > 0 )
+        {
+            idx -= 1;
+            record = (drawable_record_s*) g_ptr_array_index( node_data->batch, idx );
+
+            // if not in freeze-frame and kind is known
+            if( (gui->config.freeze_frame == 0) && (record->kind < DRAWABLE_RECORD_KIND_COUNT) )
             {
-                // process known types
-                if( type == node_data->msg_type_radar_targets )
-                {
-                    list = ps_parse_push_radar_targets( gui, (const ps_radar_targets_msg*) msg, list, update_time );
-                }
-                else if( type == node_data->msg_type_lidar_points )
+                key.kind = record->kind;
+                key.src_guid = record->src_guid;
+                key.sensor_id = record->sensor_id;
+
+                // drop if a newer record from this stream was parsed
+                if( check_add_stream( node_data->batch_streams, &key ) != 0 )
                 {
-                    list = ps_parse_push_lidar_points( gui, (const ps_lidar_points_msg*) msg, list, update_time );
+                    node_data->stats.dropped += 1;
                 }
-                else if( type == node_data->msg_type_objects )
+                else
                 {
-                    list = ps_parse_push_objects( gui, (const ps_objects_msg*) msg, list, update_time );
+                    parse_record( node_data, gui, record, store, update_time );
+                    node_data->stats.parsed += 1;
                 }
             }
         }
 
-        // release
-        (void) psync_message_free( node_data->node, &msg );
+        // hand the records back to the subscriber
+        drawable_ring_release( node_data->ring );
     }
+    while( (get_micro_tick() - start_time) < node_data->batch_budget );
 
-
-    // return parent list
-    return list;
+    // records left for the next call
+    drawable_ring_get_stats( node_data->ring, &depth, &node_data->stats.overflowed );
+    node_data->stats.queue_depth = (unsigned long) depth;
 }
@@ -31,6 +31,36 @@
 // static global data
 // *****************************************************
 
+// unit cross, line vertex pairs
+static const GLfloat UNIT_CROSS[] =
+{
+    -0.5f, 0.0f,    0.5f, 0.0f,
+    0.0f, -0.5f,    0.0f, 0.5f
+};
+
+
+// unit rectangle, quad vertices
+static const GLfloat UNIT_RECTANGLE[] =
+{
+    -0.5f, 0.5f,    -0.5f, -0.5f,
+    0.5f, -0.5f,    0.5f, 0.5f
+};
+
+
+// unit triangle, triangle vertices
+static const GLfloat UNIT_TRIANGLE[] =
+{
+    -0.5f, 0.5f,    -0.5f, -0.5f,
+    0.5f, 0.0f
+};
+
+
+// unit vector, line vertex pair
+static const GLfloat UNIT_VECTOR[] =
+{
+    0.0f, 0.0f,     1.0f, 1.0f
+};
+
 
 
 
@@ -38,6 +68,19 @@
 // static declarations
 // *****************************************************
 
+/**
+ * @brief Get the cached unit circle mesh for a segment count.
+ *
+ * Builds the mesh on first use. The mesh is \ref GL_LINES vertex pairs, two per segment.
+ *
+ * @param [in] batch A pointer to \ref render_batch_s which owns the mesh cache.
+ * @param [in] segments Number of segments, [3, \ref RENDER_MAX_CIRCLE_SEGMENTS].
+ *
+ * @return A pointer to the unit circle mesh.
+ *
+ */
+static const GLfloat *get_circle_mesh( render_batch_s * const batch, const GLuint segments );
+
 
 
 
@@ -52,6 +95,40 @@ GLuint render_get_circle_segments( const GLdouble r )
 }
 
 
+//
+static const GLfloat *get_circle_mesh( render_batch_s * const batch, const GLuint segments )
+{
+    // local vars
+    GLuint idx = 0;
+    GLfloat *mesh = batch->circle_meshes[ segments ];
+
+
+    // already built
+    if( mesh != NULL )
+    {
+        return mesh;
+    }
+
+    // two xy vertices per segment
+    mesh = g_malloc( segments * 4 * sizeof(*mesh) );
+
+    for( idx = 0; idx < segments; idx++ )
+    {
+        const double t0 = (2.0 * M_PI * (double) idx) / (double) segments;
+        const double t1 = (2.0 * M_PI * (double) (idx + 1)) / (double) segments;
+
+        mesh[ (idx * 4) + 0 ] = (GLfloat) cos( t0 );
+        mesh[ (idx * 4) + 1 ] = (GLfloat) sin( t0 );
+        mesh[ (idx * 4) + 2 ] = (GLfloat) cos( t1 );
+        mesh[ (idx * 4) + 3 ] = (GLfloat) sin( t1 );
+    }
+
+    batch->circle_meshes[ segments ] = mesh;
+
+    return mesh;
+}
+
+
 
 
 // *****************************************************
@@ -203,3 +280,409 @@ void render_text_2d( const GLdouble cx, const GLdouble cy, const char * const te
     // restore state
     glPopMatrix();
 }
+
+
+//
+int render_get_visible_bounds( entity_bounds_s * const bounds )
+{
+    if( bounds == NULL )
+    {
+        return 1;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+    GLint viewport[ 4 ];
+    GLdouble modelview[ 16 ];
+    GLdouble projection[ 16 ];
+    GLdouble wx = 0.0;
+    GLdouble wy = 0.0;
+    GLdouble wz = 0.0;
+
+
+    glGetIntegerv( GL_VIEWPORT, viewport );
+    glGetDoublev( GL_MODELVIEW_MATRIX, modelview );
+    glGetDoublev( GL_PROJECTION_MATRIX, projection );
+
+    bounds->min_x = 0.0;
+    bounds->min_y = 0.0;
+    bounds->max_x = 0.0;
+    bounds->max_y = 0.0;
+
+    // unproject the viewport corners, the view may be rotated
+    for( idx = 0; idx < 4; idx++ )
+    {
+        const GLdouble sx = (GLdouble) viewport[ 0 ] + (((idx & 1) != 0) ? (GLdouble) viewport[ 2 ] : 0.0);
+        const GLdouble sy = (GLdouble) viewport[ 1 ] + (((idx & 2) != 0) ? (GLdouble) viewport[ 3 ] : 0.0);
+
+        if( gluUnProject( sx, sy, 0.0, modelview, projection, viewport, &wx, &wy, &wz ) == GL_FALSE )
+        {
+            return 1;
+        }
+
+        if( (idx == 0) || (wx < bounds->min_x) )
+        {
+            bounds->min_x = wx;
+        }
+        if( (idx == 0) || (wy < bounds->min_y) )
+        {
+            bounds->min_y = wy;
+        }
+        if( (idx == 0) || (wx > bounds->max_x) )
+        {
+            bounds->max_x = wx;
+        }
+        if( (idx == 0) || (wy > bounds->max_y) )
+        {
+            bounds->max_y = wy;
+        }
+    }
+
+
+    return 0;
+}
+
+
+//
+void render_point_cloud_upload( point_cloud_buffer_s * const buffer, const ps_lidar_point * const points, const unsigned long num_points )
+{
+    if( buffer == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    GLfloat *vertex = NULL;
+    unsigned long idx = 0;
+
+
+    // nothing drawable until uploaded
+    buffer->num_points = 0;
+
+    if( (points == NULL) || (num_points == 0) )
+    {
+        return;
+    }
+
+    // create buffer object
+    if( buffer->vbo == 0 )
+    {
+        glGenBuffers( 1, &buffer->vbo );
+        buffer->capacity = 0;
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, buffer->vbo );
+
+    // grow with headroom, otherwise orphan the old storage so the driver doesn't stall on it
+    if( num_points > buffer->capacity )
+    {
+        buffer->capacity = num_points + (num_points / 4);
+    }
+    glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr) (buffer->capacity * 4 * sizeof(GLfloat)), NULL, GL_STREAM_DRAW );
+
+    // write vertices straight into the buffer
+    if( (vertex = (GLfloat*) glMapBuffer( GL_ARRAY_BUFFER, GL_WRITE_ONLY )) != NULL )
+    {
+        for( idx = 0; idx < num_points; idx++ )
+        {
+            vertex[ 0 ] = (GLfloat) points[ idx ].position[ 0 ];
+            vertex[ 1 ] = (GLfloat) points[ idx ].position[ 1 ];
+            vertex[ 2 ] = (GLfloat) points[ idx ].position[ 2 ];
+            vertex[ 3 ] = (GLfloat) points[ idx ].intensity;
+            vertex += 4;
+        }
+
+        if( glUnmapBuffer( GL_ARRAY_BUFFER ) == GL_TRUE )
+        {
+            buffer->num_points = num_points;
+        }
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+
+//
+void render_point_cloud_draw( const point_cloud_buffer_s * const buffer )
+{
+    if( buffer == NULL )
+    {
+        return;
+    }
+
+
+    render_point_cloud_draw_range( buffer, 0, buffer->num_points );
+}
+
+
+//
+void render_point_cloud_draw_range( const point_cloud_buffer_s * const buffer, const unsigned long first, const unsigned long count )
+{
+    if( (buffer == NULL) || (buffer->vbo == 0) || (count == 0) || ((first + count) > buffer->num_points) )
+    {
+        return;
+    }
+
+
+    glBindBuffer( GL_ARRAY_BUFFER, buffer->vbo );
+    glEnableClientState( GL_VERTEX_ARRAY );
+
+    // xy of each xyz + intensity vertex, the birdseye projection has a depth range
+    // of [-1, 1] and would clip points more than a meter above or below the origin
+    glVertexPointer( 2, GL_FLOAT, (GLsizei) (4 * sizeof(GLfloat)), NULL );
+
+    glDrawArrays( GL_POINTS, (GLint) first, (GLsizei) count );
+
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+
+//
+void render_point_cloud_release( point_cloud_buffer_s * const buffer )
+{
+    if( buffer == NULL )
+    {
+        return;
+    }
+
+
+    if( buffer->vbo != 0 )
+    {
+        glDeleteBuffers( 1, &buffer->vbo );
+    }
+
+    // zero
+    memset( buffer, 0, sizeof(*buffer) );
+}
+
+
+//
+render_batch_s *render_batch_new( void )
+{
+    // local vars
+    unsigned int idx = 0;
+    render_batch_s *batch = NULL;
+
+
+    // create
+    if( (batch = g_try_new0( render_batch_s, 1 )) == NULL )
+    {
+        return NULL;
+    }
+
+    // instance arrays
+    for( idx = 0; idx < (unsigned int) RENDER_BATCH_KIND_COUNT; idx++ )
+    {
+        batch->instances[ idx ] = g_array_new( FALSE, FALSE, sizeof(render_instance_s) );
+    }
+
+    // scratch arrays
+    batch->vertices = g_array_new( FALSE, FALSE, sizeof(GLfloat) );
+    batch->colors = g_array_new( FALSE, FALSE, sizeof(GLfloat) );
+
+    return batch;
+}
+
+
+//
+void render_batch_free( render_batch_s * const batch )
+{
+    if( batch == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+
+
+    for( idx = 0; idx < (unsigned int) RENDER_BATCH_KIND_COUNT; idx++ )
+    {
+        g_array_free( batch->instances[ idx ], TRUE );
+    }
+
+    for( idx = 0; idx <= RENDER_MAX_CIRCLE_SEGMENTS; idx++ )
+    {
+        g_free( batch->circle_meshes[ idx ] );
+    }
+
+    g_array_free( batch->vertices, TRUE );
+    g_array_free( batch->colors, TRUE );
+
+    g_free( batch );
+}
+
+
+//
+void render_batch_clear( render_batch_s * const batch )
+{
+    if( batch == NULL )
+    {
+        return;
+    }
+
+    // local vars
+    unsigned int idx = 0;
+
+
+    for( idx = 0; idx < (unsigned int) RENDER_BATCH_KIND_COUNT; idx++ )
+    {
+        g_array_set_size( batch->instances[ idx ], 0 );
+    }
+}
+
+
+//
+void render_batch_add( render_batch_s * const batch, const render_batch_kind kind, const GLdouble cx, const GLdouble cy, const GLdouble orientation, const GLdouble length, const GLdouble width, const GLdouble * const color_rgba )
+{
+    if( (batch == NULL) || (kind >= RENDER_BATCH_KIND_COUNT) || (color_rgba == NULL) )
+    {
+        return;
+    }
+
+    // local vars
+    render_instance_s instance;
+
+
+    instance.x = (GLfloat) cx;
+    instance.y = (GLfloat) cy;
+    instance.orientation = (GLfloat) orientation;
+    instance.length = (GLfloat) length;
+    instance.width = (GLfloat) width;
+    instance.segments = 0;
+    instance.color_rgba[ 0 ] = (GLfloat) color_rgba[ 0 ];
+    instance.color_rgba[ 1 ] = (GLfloat) color_rgba[ 1 ];
+    instance.color_rgba[ 2 ] = (GLfloat) color_rgba[ 2 ];
+    instance.color_rgba[ 3 ] = (GLfloat) color_rgba[ 3 ];
+
+    // circle segments follow the radius, same as render_circle_2d
+    if( kind == RENDER_BATCH_CIRCLE )
+    {
+        instance.segments = render_get_circle_segments( length );
+
+        if( instance.segments < 3 )
+        {
+            instance.segments = 3;
+        }
+        else if( instance.segments > RENDER_MAX_CIRCLE_SEGMENTS )
+        {
+            instance.segments = RENDER_MAX_CIRCLE_SEGMENTS;
+        }
+    }
+
+    g_array_append_val( batch->instances[ kind ], instance );
+}
+
+
+//
+void render_batch_draw( render_batch_s * const batch, const render_batch_kind kind )
+{
+    if( (batch == NULL) || (kind >= RENDER_BATCH_KIND_COUNT) )
+    {
+        return;
+    }
+
+    // local vars
+    guint idx = 0;
+    guint vdx = 0;
+    guint num_vertices = 0;
+    guint mesh_vertices = 0;
+    GLenum mode = GL_LINES;
+    const GLfloat *mesh = NULL;
+    GLfloat *vertex = NULL;
+    GLfloat *color = NULL;
+    GArray * const instances = batch->instances[ kind ];
+
+
+    if( instances->len == 0 )
+    {
+        return;
+    }
+
+    // unit mesh and draw mode of the kind
+    if( kind == RENDER_BATCH_CROSS )
+    {
+        mesh = UNIT_CROSS;
+        mesh_vertices = 4;
+    }
+    else if( kind == RENDER_BATCH_RECTANGLE )
+    {
+        mesh = UNIT_RECTANGLE;
+        mesh_vertices = 4;
+        mode = GL_QUADS;
+    }
+    else if( kind == RENDER_BATCH_TRIANGLE )
+    {
+        mesh = UNIT_TRIANGLE;
+        mesh_vertices = 3;
+        mode = GL_TRIANGLES;
+    }
+    else if( kind == RENDER_BATCH_VECTOR )
+    {
+        mesh = UNIT_VECTOR;
+        mesh_vertices = 2;
+    }
+
+    // count vertices
+    if( kind == RENDER_BATCH_CIRCLE )
+    {
+        for( idx = 0; idx < instances->len; idx++ )
+        {
+            num_vertices += 2 * g_array_index( instances, render_instance_s, idx ).segments;
+        }
+    }
+    else
+    {
+        num_vertices = instances->len * mesh_vertices;
+    }
+
+    // size scratch arrays
+    g_array_set_size( batch->vertices, num_vertices * 2 );
+    g_array_set_size( batch->colors, num_vertices * 4 );
+
+    vertex = (GLfloat*) batch->vertices->data;
+    color = (GLfloat*) batch->colors->data;
+
+    // expand each instance into its transformed unit mesh
+    for( idx = 0; idx < instances->len; idx++ )
+    {
+        const render_instance_s * const instance = &g_array_index( instances, render_instance_s, idx );
+        const GLfloat c = cosf( instance->orientation );
+        const GLfloat s = sinf( instance->orientation );
+
+        if( kind == RENDER_BATCH_CIRCLE )
+        {
+            mesh = get_circle_mesh( batch, instance->segments );
+            mesh_vertices = 2 * instance->segments;
+        }
+
+        for( vdx = 0; vdx < mesh_vertices; vdx++ )
+        {
+            const GLfloat ux = mesh[ (vdx * 2) + 0 ] * instance->length;
+            const GLfloat uy = mesh[ (vdx * 2) + 1 ] * instance->width;
+
+            vertex[ 0 ] = instance->x + (c * ux) - (s * uy);
+            vertex[ 1 ] = instance->y + (s * ux) + (c * uy);
+            vertex += 2;
+
+            memcpy( color, instance->color_rgba, sizeof(instance->color_rgba) );
+            color += 4;
+        }
+    }
+
+    // one draw for the whole kind
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+
+    glVertexPointer( 2, GL_FLOAT, 0, batch->vertices->data );
+    glColorPointer( 4, GL_FLOAT, 0, batch->colors->data );
+
+    glDrawArrays( mode, 0, (GLsizei) num_vertices );
+
+    glDisableClientState( GL_COLOR_ARRAY );
+    glDisableClientState( GL_VERTEX_ARRAY );
+
+    // consumed
+    g_array_set_size( instances, 0 );
+}
@@ -15,7 +15,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <signal.h>
+#include <poll.h>
 #include <glib-2.0/glib.h>
 
 #include "polysync_core.h"
@@ -24,6 +26,8 @@
 #include "ps_interface.h"
 #include "gui.h"
 #include "entity_manager.h"
+#include "ingest_pipeline.h"
+#include "headless_bench.h"
 
 
 
@@ -62,10 +66,33 @@ static void sig_handler( int sig );
  * @brief Graceful release routine.
  *
  * @param [in] gui A pointer to \ref gui_context_s which specifies the context to free. NULL is acceptable.
- * @param [in] data_queue A pointer to GAsyncQueue which specifies the PolySync message queue to free. NULL is acceptable.
+ * @param [in] node_data A pointer to \ref node_data_s which specifies the PolySync resources to free. NULL is acceptable.
+ * @param [in] pipeline A pointer to \ref ingest_pipeline_s which specifies the ingest pipeline to stop. NULL is acceptable.
  *
  */
-static void release( gui_context_s * const gui, node_data_s * const node_data );
+static void release( gui_context_s * const gui, node_data_s * const node_data, ingest_pipeline_s * const pipeline );
+
+
+/**
+ * @brief Print entity pool statistics.
+ *
+ * @param [in] store A pointer to \ref entity_store_s which specifies the entity store.
+ *
+ */
+static void print_pool_stats( const entity_store_s * const store );
+
+
+/**
+ * @brief Sleep until input or data arrives, or a timeout.
+ *
+ * Returns early when a signal is caught.
+ *
+ * @param [in] gui_fd Window system connection file descriptor, see \ref gui_get_event_fd. Negative values are ignored.
+ * @param [in] data_fd Drawable record ring or snapshot file descriptor. Negative values are ignored.
+ * @param [in] timeout Maximum time to wait. [microseconds]
+ *
+ */
+static void wait_for_events( const int gui_fd, const int data_fd, const ps_timestamp timeout );
 
 
 
@@ -86,8 +113,78 @@ static void sig_handler( int sig )
 
 
 //
-static void release( gui_context_s * const gui, node_data_s * const node_data )
+static void print_pool_stats( const entity_store_s * const store )
+{
+    // local vars
+    const char * const names[ ENTITY_KIND_COUNT ] = { "object", "container", "parent" };
+    entity_pool_stats_s stats;
+    unsigned int idx = 0;
+
+
+    // for each entity kind
+    for( idx = 0; idx < ENTITY_KIND_COUNT; idx++ )
+    {
+        // get stats
+        memset( &stats, 0, sizeof(stats) );
+        entity_store_get_pool_stats( store, (entity_kind) idx, &stats );
+
+        printf( "%s pool -- in use: %lu, capacity: %lu, high water: %lu, slabs: %lu, allocations: %llu\n",
+                names[ idx ],
+                stats.in_use,
+                stats.capacity,
+                stats.high_water,
+                stats.slabs,
+                stats.allocations );
+    }
+}
+
+
+//
+static void wait_for_events( const int gui_fd, const int data_fd, const ps_timestamp timeout )
+{
+    // local vars
+    struct pollfd pfds[ 2 ];
+    nfds_t num_fds = 0;
+
+
+    if( gui_fd >= 0 )
+    {
+        pfds[ num_fds ].fd = gui_fd;
+        pfds[ num_fds ].events = POLLIN;
+        num_fds += 1;
+    }
+
+    if( data_fd >= 0 )
+    {
+        pfds[ num_fds ].fd = data_fd;
+        pfds[ num_fds ].events = POLLIN;
+        num_fds += 1;
+    }
+
+    // round up so short waits don't spin
+    (void) poll( pfds, num_fds, (int) ((MIN( timeout, (ps_timestamp) G_MAXINT / 1000 ) + 999) / 1000) );
+}
+
+
+//
+static void release( gui_context_s * const gui, node_data_s * const node_data, ingest_pipeline_s * const pipeline )
 {
+    // check pipeline, must stop before the node data it drains is released
+    if( pipeline != NULL )
+    {
+        // report pool usage
+        printf( "ingest pipeline store:\n" );
+        print_pool_stats( pipeline->store );
+
+        // snapshots are freed with the pipeline
+        if( gui != NULL )
+        {
+            gui->snapshot = NULL;
+        }
+
+        ingest_pipeline_stop( pipeline );
+    }
+
     // check node data
     if( node_data != NULL )
     {
@@ -100,8 +197,11 @@ static void release( gui_context_s * const gui, node_data_s * const node_data )
     // check GUI
     if( gui != NULL )
     {
+        // report pool usage
+        print_pool_stats( gui->entity_store );
+
         // release entities
-        entity_release_all( gui->entity_list );
+        entity_release_all( gui->entity_store );
 
         // release
         gui_release( gui );
@@ -146,6 +246,13 @@ ps_timestamp get_micro_tick( void )
  *
  * Starts the application.
  *
+ * Options:
+ * \li -p Pipeline mode, messages are parsed on a dedicated ingest thread and the
+ * render thread only draws the latest published entity snapshot.
+ * \li --headless-bench Run synthetic scenes through the ingest and draw path into
+ * an offscreen context and print frame time, ingest rate and peak RSS, see \ref headless_bench_run.
+ * Doesn't use PolySync or a window.
+ *
  * @param [in] argc Number of arguments in the argv argument list.
  * @param [in] argv Argument list.
  *
@@ -159,10 +266,45 @@ int main( int argc, char *argv[] )
     node_data_s     *node_data      = NULL;
     ps_timestamp    timestamp       = 0;
     ps_timestamp    time_to_draw    = 0;
-    size_t          sleep_tick      = 0;
+    ps_timestamp    deadline        = 0;
     unsigned int    msg_read        = 0;
+    unsigned int    expired         = 0;
+    int             data_fd         = -1;
+    int             optret          = 0;
+    unsigned int    pipeline_mode   = 0;
+    unsigned int    headless_bench  = 0;
+    ingest_pipeline_s *pipeline     = NULL;
+    const struct option long_options[] =
+    {
+        { "headless-bench", no_argument, NULL, 'b' },
+        { NULL, 0, NULL, 0 }
+    };
 
 
+    // parse options
+    while( (optret = getopt_long( argc, argv, "p", long_options, NULL )) != -1 )
+    {
+        if( optret == 'p' )
+        {
+            pipeline_mode = 1;
+        }
+        else if( optret == 'b' )
+        {
+            headless_bench = 1;
+        }
+        else
+        {
+            printf( "usage: %s [-p] [--headless-bench]\n", argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    // benchmark runs on its own and exits
+    if( headless_bench != 0 )
+    {
+        return (headless_bench_run( HEADLESS_BENCH_DEFAULT_FRAMES ) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     // hook up the control-c signal handler, sets exit_signaled flag
     signal( SIGINT, sig_handler );
 
@@ -173,7 +315,7 @@ int main( int argc, char *argv[] )
     if( (node_data = init_polysync()) == NULL )
     {
         printf( "failed to initialize PolySync\n" );
-        release( gui, node_data );
+        release( gui, node_data, pipeline );
         return EXIT_FAILURE;
     }
 
@@ -181,71 +323,96 @@ int main( int argc, char *argv[] )
     if( (gui = gui_init( PS_NODE_NAME, GUI_DEFAULT_WIDTH, GUI_DEFAULT_HEIGHT, GUI_DEFAULT_GRID_SCALE )) == NULL )
     {
         printf( "failed to initialize GUI\n" );
-        release( gui, node_data );
+        release( gui, node_data, pipeline );
         return EXIT_FAILURE;
     }
 
+    // start the ingest thread in pipeline mode
+    if( pipeline_mode != 0 )
+    {
+        if( (pipeline = ingest_pipeline_start( node_data )) == NULL )
+        {
+            printf( "failed to start ingest pipeline\n" );
+            release( gui, node_data, pipeline );
+            return EXIT_FAILURE;
+        }
+    }
+
+    // wake on new snapshots in pipeline mode, on new records otherwise
+    data_fd = (pipeline != NULL) ? ingest_pipeline_get_notify_fd( pipeline ) : drawable_ring_get_notify_fd( node_data->ring );
+
     // main event loop
     while( 1 )
     {
         // zero
         time_to_draw = 0;
         msg_read = 0;
+        expired = 0;
 
         // check for an exit signal
         if( global_exit_signal != 0 )
         {
-            release( gui, node_data );
+            release( gui, node_data, pipeline );
             return EXIT_SUCCESS;
         }
 
         // get timestamp
         timestamp = get_micro_tick();
 
-        // check and process message queue
-        gui->entity_list = ps_process_message( node_data, gui, gui->entity_list, timestamp, &msg_read );
+        if( pipeline != NULL )
+        {
+            // ingest thread does the parsing and timeouts
+            ingest_pipeline_set_config( pipeline, &gui->config );
+
+            // take the latest complete snapshot
+            gui->snapshot = ingest_pipeline_acquire( pipeline, &msg_read );
 
-        // if message processed
-        if( msg_read != 0 )
+            // update ingest statistics
+            if( gui->snapshot != NULL )
+            {
+                gui->ingest_stats = gui->snapshot->stats;
+            }
+        }
+        else
         {
-            // reset ticker
-            sleep_tick = 0;
+            // check and process drawable records
+            ps_process_message( node_data, gui, gui->entity_store, timestamp, &msg_read );
+
+            // update ingest statistics
+            gui->ingest_stats = node_data->stats;
+
+            // check timeouts if not in freeze-frame
+            if( gui->config.freeze_frame == 0 )
+            {
+                expired = entity_update_timeouts( gui->entity_store, timestamp );
+            }
         }
 
-        // check timeouts if not in freeze-frame
-        if( gui->config.freeze_frame == 0 )
+        // redraw only if the scene changed
+        if( (msg_read != 0) || (expired != 0) )
         {
-            gui->entity_list = entity_update_timeouts( gui->entity_list, timestamp );
+            gui->scene_dirty = 1;
         }
 
         // update gui
         gui_update( gui, timestamp, &time_to_draw );
 
-        // disable sleep ticker if redraw time is less than 5 ms
-        if( time_to_draw < 5000 )
+        // wake for the next entity timeout, the ingest thread handles them in pipeline mode
+        if( (pipeline == NULL)
+                && (gui->config.freeze_frame == 0)
+                && ((deadline = entity_store_get_next_deadline( gui->entity_store )) != 0) )
         {
-            // reset ticker
-            sleep_tick = 0;
-        }
-
-        // check sleep ticker
-        if( sleep_tick >= 10 )
-        {
-            // sleep ~1 ms
-            usleep( 1000 );
-
-            // reset to enabled
-            sleep_tick = 10;
+            time_to_draw = MIN( time_to_draw, (deadline > timestamp) ? (deadline - timestamp) : 0 );
         }
 
-        // increment sleep ticker
-        sleep_tick++;
+        // sleep until input, data, the next redraw or timeout
+        wait_for_events( gui_get_event_fd( gui ), data_fd, time_to_draw );
     }
 
     // shouldn't get here
 
     // release
-    release( gui, node_data );
+    release( gui, node_data, pipeline );
 
 
     // exit